@@ -0,0 +1,47 @@
+//
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include "backend/common/memory_tracker.h"
+
+#include <algorithm>
+#include <cstdint>
+
+#include "absl/status/status.h"
+#include "common/errors.h"
+
+namespace google {
+namespace spanner {
+namespace emulator {
+namespace backend {
+
+absl::Status MemoryTracker::Allocate(int64_t bytes) {
+  used_bytes_ += bytes;
+  peak_bytes_ = std::max(peak_bytes_, used_bytes_);
+  if (used_bytes_ > limit_bytes_) {
+    return error::MemoryLimitExceeded(limit_bytes_);
+  }
+  return absl::OkStatus();
+}
+
+void MemoryTracker::Release(int64_t bytes) {
+  used_bytes_ = std::max<int64_t>(used_bytes_ - bytes, 0);
+}
+
+}  // namespace backend
+}  // namespace emulator
+}  // namespace spanner
+}  // namespace google
@@ -0,0 +1,63 @@
+//
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#ifndef THIRD_PARTY_CLOUD_SPANNER_EMULATOR_BACKEND_COMMON_MEMORY_TRACKER_H_
+#define THIRD_PARTY_CLOUD_SPANNER_EMULATOR_BACKEND_COMMON_MEMORY_TRACKER_H_
+
+#include <cstdint>
+
+#include "absl/status/status.h"
+
+namespace google {
+namespace spanner {
+namespace emulator {
+namespace backend {
+
+// MemoryTracker accounts for the memory which a single request holds on to
+// while it materializes results, e.g. the rows of a non-streaming response.
+// Once the memory in use exceeds the budget of the request, the request fails
+// with RESOURCE_EXHAUSTED instead of growing further.
+//
+// A MemoryTracker belongs to one request and is not thread-safe.
+class MemoryTracker {
+ public:
+  explicit MemoryTracker(int64_t limit_bytes) : limit_bytes_(limit_bytes) {}
+
+  // Accounts for 'bytes' more memory. Returns RESOURCE_EXHAUSTED if that takes
+  // the memory in use over the limit, in which case the memory is still
+  // accounted for.
+  absl::Status Allocate(int64_t bytes);
+
+  // Accounts for 'bytes' of memory being freed.
+  void Release(int64_t bytes);
+
+  int64_t limit_bytes() const { return limit_bytes_; }
+  int64_t used_bytes() const { return used_bytes_; }
+  int64_t peak_bytes() const { return peak_bytes_; }
+
+ private:
+  const int64_t limit_bytes_;
+  int64_t used_bytes_ = 0;
+  int64_t peak_bytes_ = 0;
+};
+
+}  // namespace backend
+}  // namespace emulator
+}  // namespace spanner
+}  // namespace google
+
+#endif  // THIRD_PARTY_CLOUD_SPANNER_EMULATOR_BACKEND_COMMON_MEMORY_TRACKER_H_
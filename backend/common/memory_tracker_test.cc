@@ -0,0 +1,64 @@
+//
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include "backend/common/memory_tracker.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "zetasql/base/testing/status_matchers.h"
+#include "absl/status/status.h"
+
+namespace google {
+namespace spanner {
+namespace emulator {
+namespace backend {
+
+namespace {
+
+using zetasql_base::testing::StatusIs;
+
+TEST(MemoryTrackerTest, AllocatesWithinLimit) {
+  MemoryTracker tracker(/*limit_bytes=*/100);
+  ZETASQL_EXPECT_OK(tracker.Allocate(60));
+  ZETASQL_EXPECT_OK(tracker.Allocate(40));
+  EXPECT_EQ(tracker.used_bytes(), 100);
+  EXPECT_EQ(tracker.peak_bytes(), 100);
+}
+
+TEST(MemoryTrackerTest, FailsOnceOverLimit) {
+  MemoryTracker tracker(/*limit_bytes=*/100);
+  ZETASQL_EXPECT_OK(tracker.Allocate(60));
+  EXPECT_THAT(tracker.Allocate(41),
+              StatusIs(absl::StatusCode::kResourceExhausted));
+  EXPECT_EQ(tracker.used_bytes(), 101);
+}
+
+TEST(MemoryTrackerTest, ReleasedMemoryCanBeAllocatedAgain) {
+  MemoryTracker tracker(/*limit_bytes=*/100);
+  ZETASQL_EXPECT_OK(tracker.Allocate(80));
+  tracker.Release(50);
+  ZETASQL_EXPECT_OK(tracker.Allocate(70));
+  EXPECT_EQ(tracker.used_bytes(), 100);
+  EXPECT_EQ(tracker.peak_bytes(), 100);
+}
+
+}  // namespace
+
+}  // namespace backend
+}  // namespace emulator
+}  // namespace spanner
+}  // namespace google
@@ -18,12 +18,14 @@
 
 #include <memory>
 #include <string>
+#include <thread>  // NOLINT(build/c++11)
 #include <utility>
 #include <vector>
 
 #include "absl/memory/memory.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
 #include "absl/time/time.h"
 #include "absl/types/variant.h"
 #include "backend/actions/manager.h"
@@ -34,7 +36,9 @@
 #include "backend/schema/updater/schema_updater.h"
 #include "backend/schema/updater/scoped_schema_change_lock.h"
 #include "backend/storage/in_memory_storage.h"
+#include "backend/transaction/group_committer.h"
 #include "backend/transaction/options.h"
+#include "common/config.h"
 #include "absl/status/status.h"
 #include "zetasql/base/status_macros.h"
 
@@ -53,6 +57,9 @@ absl::StatusOr<std::unique_ptr<Database>> Database::Create(
   database->clock_ = clock;
   database->storage_ = std::make_unique<InMemoryStorage>();
   database->lock_manager_ = std::make_unique<LockManager>(clock);
+  database->group_committer_ = std::make_unique<GroupCommitter>(
+      database->lock_manager_.get(), database->storage_.get(),
+      config::commit_group_window());
   database->type_factory_ = std::make_unique<zetasql::TypeFactory>();
   database->query_engine_ =
       std::make_unique<QueryEngine>(database->type_factory_.get());
@@ -74,10 +81,35 @@ absl::StatusOr<std::unique_ptr<Database>> Database::Create(
       database->versioned_catalog_->GetLatestSchema(),
       database->query_engine_->function_catalog(),
       database->query_engine_->type_factory());
+  database->query_engine_->AddCatalogForSchema(
+      database->versioned_catalog_->GetLatestSchema());
 
+  database->gc_thread_ = std::thread(&Database::CollectGarbage, database.get());
   return database;
 }
 
+Database::~Database() {
+  {
+    absl::MutexLock lock(&gc_mu_);
+    stopping_ = true;
+  }
+  if (gc_thread_.joinable()) {
+    gc_thread_.join();
+  }
+}
+
+void Database::CollectGarbage() {
+  absl::MutexLock lock(&gc_mu_);
+  while (!gc_mu_.AwaitWithTimeout(
+      absl::Condition(&stopping_),
+      InMemoryStorage::kDefaultGarbageCollectionInterval)) {
+    gc_mu_.Unlock();
+    storage_->GarbageCollect(clock_->Now() - kMaxStaleReadDuration)
+        .IgnoreError();
+    gc_mu_.Lock();
+  }
+}
+
 absl::StatusOr<std::unique_ptr<ReadOnlyTransaction>>
 Database::CreateReadOnlyTransaction(const ReadOnlyOptions& options) {
   return std::make_unique<ReadOnlyTransaction>(
@@ -90,8 +122,8 @@ Database::CreateReadWriteTransaction(const ReadWriteOptions& options,
                                      const RetryState& retry_state) {
   return std::make_unique<ReadWriteTransaction>(
       options, retry_state, transaction_id_generator_.NextId(), clock_,
-      storage_.get(), lock_manager_.get(), versioned_catalog_.get(),
-      action_manager_.get());
+      storage_.get(), lock_manager_.get(), group_committer_.get(),
+      versioned_catalog_.get(), action_manager_.get());
 }
 
 SchemaChangeContext Database::GetSchemaChangeContext() {
@@ -142,6 +174,7 @@ absl::Status Database::UpdateSchema(
     action_manager_->AddActionsForSchema(versioned_catalog_->GetLatestSchema(),
                                          query_engine_->function_catalog(),
                                          query_engine_->type_factory());
+    query_engine_->AddCatalogForSchema(versioned_catalog_->GetLatestSchema());
   }
   return absl::OkStatus();
 }
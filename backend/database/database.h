@@ -19,12 +19,14 @@
 
 #include <memory>
 #include <string>
+#include <thread>  // NOLINT(build/c++11)
 #include <vector>
 
 #include "zetasql/public/type.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
 #include "absl/time/time.h"
 #include "absl/types/variant.h"
 #include "backend/actions/manager.h"
@@ -37,6 +39,7 @@
 #include "backend/storage/storage.h"
 #include "backend/transaction/options.h"
 #include "backend/transaction/read_only_transaction.h"
+#include "backend/transaction/group_committer.h"
 #include "backend/transaction/read_write_transaction.h"
 #include "common/clock.h"
 #include "absl/status/status.h"
@@ -58,6 +61,9 @@ class Database {
   static absl::StatusOr<std::unique_ptr<Database>> Create(
       Clock* clock, const SchemaChangeOperation& schema_change_operation);
 
+  // Stops garbage collection of the database's storage.
+  ~Database();
+
   // Creates a read only transaction attached to this database.
   absl::StatusOr<std::unique_ptr<ReadOnlyTransaction>>
   CreateReadOnlyTransaction(const ReadOnlyOptions& options);
@@ -115,6 +121,11 @@ class Database {
 
   SchemaChangeContext GetSchemaChangeContext();
 
+  // Periodically garbage collects versions which have become too old to be
+  // read, until the database is destroyed. Runs on gc_thread_, so sweeps never
+  // hold up commits.
+  void CollectGarbage() ABSL_LOCKS_EXCLUDED(gc_mu_);
+
   // Clock to provide commit timestamps.
   Clock* clock_;
 
@@ -133,6 +144,9 @@ class Database {
   // Lock management.
   std::unique_ptr<LockManager> lock_manager_;
 
+  // Groups concurrent read-write commits into a single storage write.
+  std::unique_ptr<GroupCommitter> group_committer_;
+
   // Type factory used for all ZetaSQL operations on this database.
   std::unique_ptr<zetasql::TypeFactory> type_factory_;
 
@@ -144,6 +158,13 @@ class Database {
 
   // Maintains an action registry per schema.
   std::unique_ptr<ActionManager> action_manager_;
+
+  // Guards the shutdown of the garbage collection thread.
+  absl::Mutex gc_mu_;
+  bool stopping_ ABSL_GUARDED_BY(gc_mu_) = false;
+
+  // Runs CollectGarbage, started once the database is fully initialized.
+  std::thread gc_thread_;
 };
 
 }  // namespace backend
@@ -16,6 +16,7 @@
 
 #include "backend/datamodel/key.h"
 
+#include <iterator>
 #include <ostream>
 #include <sstream>
 #include <string>
@@ -62,12 +63,44 @@ int64_t LogicalBytesInternal(const zetasql::Value& value) {
   }
 }
 
+// Performs a three-way comparison of two column values of the same type, in
+// ascending order.
+int CompareColumnValues(const zetasql::Value& v1, const zetasql::Value& v2) {
+  // The most common key column types are compared directly, which saves the
+  // type dispatch and the second pass of zetasql::Value::LessThan followed by
+  // zetasql::Value::Equals.
+  if (!v1.is_null() && !v2.is_null() && v1.type_kind() == v2.type_kind()) {
+    switch (v1.type_kind()) {
+      case zetasql::TYPE_INT64:
+        return v1.int64_value() < v2.int64_value()
+                   ? -1
+                   : (v1.int64_value() > v2.int64_value() ? 1 : 0);
+      case zetasql::TYPE_STRING: {
+        int result = v1.string_value().compare(v2.string_value());
+        return result < 0 ? -1 : (result > 0 ? 1 : 0);
+      }
+      case zetasql::TYPE_BYTES: {
+        int result = v1.bytes_value().compare(v2.bytes_value());
+        return result < 0 ? -1 : (result > 0 ? 1 : 0);
+      }
+      default:
+        break;
+    }
+  }
+  if (v1.LessThan(v2)) {
+    return -1;
+  }
+  return v1.Equals(v2) ? 0 : 1;
+}
+
 }  // namespace
 
 Key::Key() = default;
 
 Key::Key(std::vector<zetasql::Value> columns)
-    : columns_(std::move(columns)), is_descending_(columns_.size()) {}
+    : columns_(std::make_move_iterator(columns.begin()),
+               std::make_move_iterator(columns.end())),
+      is_descending_(columns_.size()) {}
 
 void Key::AddColumn(zetasql::Value value, bool desc) {
   columns_.emplace_back(std::move(value));
@@ -102,15 +135,10 @@ int Key::Compare(const Key& other) const {
       return other.is_prefix_limit_ ? -1 : 1;
     }
 
-    if (columns_[i].LessThan(other.columns_[i])) {
-      return is_descending_[i] ? 1 : -1;
-    }
-
-    if (columns_[i].Equals(other.columns_[i])) {
-      continue;
+    int result = CompareColumnValues(columns_[i], other.columns_[i]);
+    if (result != 0) {
+      return is_descending_[i] ? -result : result;
     }
-
-    return is_descending_[i] ? -1 : 1;
   }
 
   // If we reached here, *this is a prefix of other.
@@ -17,11 +17,14 @@
 #ifndef THIRD_PARTY_CLOUD_SPANNER_EMULATOR_BACKEND_DATAMODEL_KEY_H_
 #define THIRD_PARTY_CLOUD_SPANNER_EMULATOR_BACKEND_DATAMODEL_KEY_H_
 
+#include <cstdint>
 #include <ostream>
 #include <string>
 #include <vector>
 
 #include "zetasql/public/value.h"
+#include "absl/container/inlined_vector.h"
+#include "absl/types/span.h"
 
 namespace google {
 namespace spanner {
@@ -42,8 +45,16 @@ namespace backend {
 // prefix limit key K+ (obtained by Key::ToPrefixLimit()) is a point in the key
 // space larger than any key with prefix K. This is useful in implementing
 // prefix ranges as the range [K, K+) will cover all keys with prefix K.
+//
+// Keys are compared on every step of the ordered maps in storage, in the
+// transaction buffer and in the lock tables, and are copied into them. Columns
+// are therefore stored inline for keys of up to kInlineColumns columns, so
+// copying such a key does not allocate.
 class Key {
  public:
+  // Number of columns stored without a heap allocation.
+  static constexpr int kInlineColumns = 4;
+
   // Constructs an empty key.
   Key();
 
@@ -65,9 +76,7 @@ class Key {
   bool IsColumnDescending(int i) const;
 
   // Returns all column values in the key.
-  const std::vector<zetasql::Value>& column_values() const {
-    return columns_;
-  }
+  absl::Span<const zetasql::Value> column_values() const { return columns_; }
 
   // Performs a three-way comparison against another key.
   // k1.Compare(k2) returns
@@ -94,6 +103,12 @@ class Key {
   // Returns true if the key does not have any columns.
   bool IsEmpty() const { return columns_.empty(); }
 
+  // Returns true if this is Key::Infinity().
+  bool IsInfinity() const { return is_infinity_; }
+
+  // Returns true if this is a prefix limit key (see ToPrefixLimit()).
+  bool IsPrefixLimit() const { return is_prefix_limit_; }
+
   // Returns the logical size of the key in bytes.
   int64_t LogicalSizeInBytes() const;
 
@@ -102,14 +117,14 @@ class Key {
 
  private:
   // Individual columns that make up the key.
-  std::vector<zetasql::Value> columns_;
+  absl::InlinedVector<zetasql::Value, kInlineColumns> columns_;
 
   // Key metadata.
   bool is_infinity_ = false;
   bool is_prefix_limit_ = false;
 
   // Column metadata.
-  std::vector<bool> is_descending_;
+  absl::InlinedVector<bool, kInlineColumns> is_descending_;
 
   // Friend for member access.
   friend std::ostream& operator<<(std::ostream& out, const Key& k);
@@ -0,0 +1,320 @@
+//
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "backend/datamodel/key_encoding.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <utility>
+
+#include "zetasql/public/numeric_value.h"
+#include "zetasql/public/type.h"
+#include "zetasql/public/value.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/escaping.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+#include "absl/types/span.h"
+#include "zetasql/base/status_macros.h"
+#include "common/errors.h"
+
+namespace google {
+namespace spanner {
+namespace emulator {
+namespace backend {
+
+namespace {
+
+// Header bytes of an encoded column (before inversion for descending columns).
+constexpr uint8_t kNullHeader = 0x01;
+constexpr uint8_t kValueHeader = 0x02;
+
+// Marks the end of a prefix limit key. Encoded columns never start with it.
+constexpr uint8_t kPrefixLimitMarker = 0xFF;
+
+// Encoding of Key::Infinity(), which sorts after all other encodings.
+constexpr absl::string_view kInfinity = "\xFF\xFF";
+
+// Strings are terminated by kStringTerminator. Zero bytes within a string are
+// escaped as kStringEscape, which sorts after the terminator so that a string
+// sorts before any longer string which it is a prefix of.
+constexpr char kStringTerminator[] = {'\x00', '\x01'};
+constexpr char kStringEscape[] = {'\x00', '\xFF'};
+
+constexpr uint64_t kSignBit = uint64_t{1} << 63;
+
+void AppendBigEndian(uint64_t value, int num_bytes, std::string* out) {
+  for (int shift = (num_bytes - 1) * 8; shift >= 0; shift -= 8) {
+    out->push_back(static_cast<char>((value >> shift) & 0xFF));
+  }
+}
+
+uint64_t EncodeDouble(double value) {
+  if (std::isnan(value)) {
+    return 0;
+  }
+  if (value == 0) {
+    // Encode -0.0 and 0.0 identically, as they compare equal.
+    value = 0;
+  }
+  uint64_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  return (bits & kSignBit) ? ~bits : bits | kSignBit;
+}
+
+double DecodeDouble(uint64_t bits) {
+  if (bits == 0) {
+    return std::nan("");
+  }
+  bits = (bits & kSignBit) ? bits & ~kSignBit : ~bits;
+  double value;
+  std::memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+void AppendString(absl::string_view value, std::string* out) {
+  for (char c : value) {
+    if (c == '\0') {
+      out->append(kStringEscape, sizeof(kStringEscape));
+    } else {
+      out->push_back(c);
+    }
+  }
+  out->append(kStringTerminator, sizeof(kStringTerminator));
+}
+
+absl::Status AppendColumn(const zetasql::Value& value, std::string* out) {
+  if (value.is_null()) {
+    out->push_back(kNullHeader);
+    return absl::OkStatus();
+  }
+  out->push_back(kValueHeader);
+  switch (value.type_kind()) {
+    case zetasql::TYPE_BOOL:
+      out->push_back(value.bool_value() ? 1 : 0);
+      break;
+    case zetasql::TYPE_INT64:
+      AppendBigEndian(static_cast<uint64_t>(value.int64_value()) ^ kSignBit, 8,
+                      out);
+      break;
+    case zetasql::TYPE_DATE:
+      AppendBigEndian(static_cast<uint32_t>(value.date_value()) ^ 0x80000000u,
+                      4, out);
+      break;
+    case zetasql::TYPE_DOUBLE:
+      AppendBigEndian(EncodeDouble(value.double_value()), 8, out);
+      break;
+    case zetasql::TYPE_TIMESTAMP: {
+      absl::Time time = value.ToTime();
+      int64_t seconds = absl::ToUnixSeconds(time);
+      int64_t nanos =
+          absl::ToInt64Nanoseconds(time - absl::FromUnixSeconds(seconds));
+      AppendBigEndian(static_cast<uint64_t>(seconds) ^ kSignBit, 8, out);
+      AppendBigEndian(nanos, 4, out);
+      break;
+    }
+    case zetasql::TYPE_NUMERIC: {
+      unsigned __int128 packed =
+          static_cast<unsigned __int128>(
+              value.numeric_value().as_packed_int()) ^
+          (static_cast<unsigned __int128>(1) << 127);
+      AppendBigEndian(static_cast<uint64_t>(packed >> 64), 8, out);
+      AppendBigEndian(static_cast<uint64_t>(packed), 8, out);
+      break;
+    }
+    case zetasql::TYPE_STRING:
+      AppendString(value.string_value(), out);
+      break;
+    case zetasql::TYPE_BYTES:
+      AppendString(value.bytes_value(), out);
+      break;
+    default:
+      return error::Internal(absl::StrCat("Cannot encode key column of type ",
+                                          value.type()->DebugString()));
+  }
+  return absl::OkStatus();
+}
+
+// Reads the encoding of a single column, undoing the byte inversion of
+// descending columns.
+class ColumnReader {
+ public:
+  ColumnReader(absl::string_view* input, bool is_descending)
+      : input_(input), is_descending_(is_descending) {}
+
+  absl::StatusOr<uint8_t> ReadByte() {
+    if (input_->empty()) {
+      return Truncated();
+    }
+    uint8_t byte = static_cast<uint8_t>(input_->front());
+    input_->remove_prefix(1);
+    return is_descending_ ? static_cast<uint8_t>(~byte) : byte;
+  }
+
+  absl::StatusOr<uint64_t> ReadBigEndian(int num_bytes) {
+    uint64_t value = 0;
+    for (int i = 0; i < num_bytes; ++i) {
+      ZETASQL_ASSIGN_OR_RETURN(uint8_t byte, ReadByte());
+      value = (value << 8) | byte;
+    }
+    return value;
+  }
+
+  absl::StatusOr<std::string> ReadString() {
+    std::string value;
+    while (true) {
+      ZETASQL_ASSIGN_OR_RETURN(uint8_t byte, ReadByte());
+      if (byte != 0) {
+        value.push_back(static_cast<char>(byte));
+        continue;
+      }
+      ZETASQL_ASSIGN_OR_RETURN(byte, ReadByte());
+      if (byte == static_cast<uint8_t>(kStringTerminator[1])) {
+        return value;
+      }
+      if (byte != static_cast<uint8_t>(kStringEscape[1])) {
+        return error::Internal("Invalid string in encoded key.");
+      }
+      value.push_back('\0');
+    }
+  }
+
+ private:
+  absl::Status Truncated() const {
+    return error::Internal("Encoded key is truncated.");
+  }
+
+  absl::string_view* input_;
+  const bool is_descending_;
+};
+
+absl::StatusOr<zetasql::Value> ReadColumn(const zetasql::Type* type,
+                                            ColumnReader* reader) {
+  ZETASQL_ASSIGN_OR_RETURN(uint8_t header, reader->ReadByte());
+  if (header == kNullHeader) {
+    return zetasql::values::Null(type);
+  }
+  if (header != kValueHeader) {
+    return error::Internal(
+        absl::StrCat("Invalid column header in encoded key: ",
+                     static_cast<int>(header)));
+  }
+  switch (type->kind()) {
+    case zetasql::TYPE_BOOL: {
+      ZETASQL_ASSIGN_OR_RETURN(uint8_t value, reader->ReadByte());
+      return zetasql::values::Bool(value != 0);
+    }
+    case zetasql::TYPE_INT64: {
+      ZETASQL_ASSIGN_OR_RETURN(uint64_t value, reader->ReadBigEndian(8));
+      return zetasql::values::Int64(static_cast<int64_t>(value ^ kSignBit));
+    }
+    case zetasql::TYPE_DATE: {
+      ZETASQL_ASSIGN_OR_RETURN(uint64_t value, reader->ReadBigEndian(4));
+      return zetasql::values::Date(
+          static_cast<int32_t>(static_cast<uint32_t>(value) ^ 0x80000000u));
+    }
+    case zetasql::TYPE_DOUBLE: {
+      ZETASQL_ASSIGN_OR_RETURN(uint64_t value, reader->ReadBigEndian(8));
+      return zetasql::values::Double(DecodeDouble(value));
+    }
+    case zetasql::TYPE_TIMESTAMP: {
+      ZETASQL_ASSIGN_OR_RETURN(uint64_t seconds, reader->ReadBigEndian(8));
+      ZETASQL_ASSIGN_OR_RETURN(uint64_t nanos, reader->ReadBigEndian(4));
+      return zetasql::values::Timestamp(
+          absl::FromUnixSeconds(static_cast<int64_t>(seconds ^ kSignBit)) +
+          absl::Nanoseconds(nanos));
+    }
+    case zetasql::TYPE_NUMERIC: {
+      ZETASQL_ASSIGN_OR_RETURN(uint64_t high, reader->ReadBigEndian(8));
+      ZETASQL_ASSIGN_OR_RETURN(uint64_t low, reader->ReadBigEndian(8));
+      unsigned __int128 packed =
+          ((static_cast<unsigned __int128>(high) << 64) | low) ^
+          (static_cast<unsigned __int128>(1) << 127);
+      ZETASQL_ASSIGN_OR_RETURN(zetasql::NumericValue value,
+                       zetasql::NumericValue::FromPackedInt(
+                           static_cast<__int128>(packed)));
+      return zetasql::values::Numeric(value);
+    }
+    case zetasql::TYPE_STRING: {
+      ZETASQL_ASSIGN_OR_RETURN(std::string value, reader->ReadString());
+      return zetasql::values::String(value);
+    }
+    case zetasql::TYPE_BYTES: {
+      ZETASQL_ASSIGN_OR_RETURN(std::string value, reader->ReadString());
+      return zetasql::values::Bytes(value);
+    }
+    default:
+      return error::Internal(absl::StrCat("Cannot decode key column of type ",
+                                          type->DebugString()));
+  }
+}
+
+}  // namespace
+
+absl::StatusOr<std::string> EncodeKey(const Key& key) {
+  if (key.IsInfinity()) {
+    return std::string(kInfinity);
+  }
+  std::string encoded_key;
+  for (int i = 0; i < key.NumColumns(); ++i) {
+    size_t start = encoded_key.size();
+    ZETASQL_RETURN_IF_ERROR(AppendColumn(key.ColumnValue(i), &encoded_key));
+    if (key.IsColumnDescending(i)) {
+      for (size_t j = start; j < encoded_key.size(); ++j) {
+        encoded_key[j] = static_cast<char>(~encoded_key[j]);
+      }
+    }
+  }
+  if (key.IsPrefixLimit()) {
+    encoded_key.push_back(kPrefixLimitMarker);
+  }
+  return encoded_key;
+}
+
+absl::StatusOr<Key> DecodeKey(absl::string_view encoded_key,
+                              absl::Span<const zetasql::Type* const> types,
+                              absl::Span<const bool> is_descending) {
+  if (encoded_key == kInfinity) {
+    return Key::Infinity();
+  }
+  Key key;
+  absl::string_view input = encoded_key;
+  while (!input.empty()) {
+    if (input.size() == 1 &&
+        static_cast<uint8_t>(input.front()) == kPrefixLimitMarker) {
+      return key.ToPrefixLimit();
+    }
+    int i = key.NumColumns();
+    if (i >= types.size() || i >= is_descending.size()) {
+      return error::Internal(
+          absl::StrCat("Encoded key has more than ", types.size(),
+                       " columns: ", absl::CEscape(encoded_key)));
+    }
+    ColumnReader reader(&input, is_descending[i]);
+    ZETASQL_ASSIGN_OR_RETURN(zetasql::Value value, ReadColumn(types[i], &reader));
+    key.AddColumn(std::move(value), is_descending[i]);
+  }
+  return key;
+}
+
+}  // namespace backend
+}  // namespace emulator
+}  // namespace spanner
+}  // namespace google
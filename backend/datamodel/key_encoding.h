@@ -0,0 +1,71 @@
+//
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef THIRD_PARTY_CLOUD_SPANNER_EMULATOR_BACKEND_DATAMODEL_KEY_ENCODING_H_
+#define THIRD_PARTY_CLOUD_SPANNER_EMULATOR_BACKEND_DATAMODEL_KEY_ENCODING_H_
+
+#include <string>
+
+#include "zetasql/public/type.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "backend/datamodel/key.h"
+
+namespace google {
+namespace spanner {
+namespace emulator {
+namespace backend {
+
+// Key encoding maps a Key to a byte string such that the lexicographic order of
+// encoded keys (as compared by memcmp or std::string::compare) is the order of
+// the keys as defined by Key::Compare, so encoded keys can be compared without
+// decoding them. StreamingRead resume tokens use it to record the key of the
+// last row returned, which a resumed read decodes to continue after it.
+//
+// Each column is encoded as a header byte, which distinguishes NULL from other
+// values, followed by an order-preserving encoding of the value:
+//   BOOL, INT64, DATE   big-endian, with the sign bit flipped
+//   DOUBLE              big-endian IEEE 754 bits, adjusted so that negative
+//                       values sort first; NaN sorts before all other values
+//                       and -0.0 is encoded as 0.0
+//   TIMESTAMP           seconds and nanoseconds since the Unix epoch
+//   NUMERIC             big-endian packed representation
+//   STRING, BYTES       escaped contents, followed by a terminator
+// All bytes of a descending column are inverted. Prefix limit keys are followed
+// by a trailing 0xFF byte and Key::Infinity() is encoded as two 0xFF bytes,
+// neither of which can start an encoded column.
+//
+// Encoded keys do not carry column types, which must be supplied to decode
+// them.
+
+// Returns the encoding of the given key. Returns an error if the key contains a
+// column of a type which cannot be used in keys.
+absl::StatusOr<std::string> EncodeKey(const Key& key);
+
+// Decodes a key encoded by EncodeKey. The given column types and sort orders
+// must match those of the encoded key, and may describe additional trailing
+// columns which are not present in it (e.g. for a prefix of a primary key).
+absl::StatusOr<Key> DecodeKey(absl::string_view encoded_key,
+                              absl::Span<const zetasql::Type* const> types,
+                              absl::Span<const bool> is_descending);
+
+}  // namespace backend
+}  // namespace emulator
+}  // namespace spanner
+}  // namespace google
+
+#endif  // THIRD_PARTY_CLOUD_SPANNER_EMULATOR_BACKEND_DATAMODEL_KEY_ENCODING_H_
@@ -0,0 +1,213 @@
+//
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "backend/datamodel/key_encoding.h"
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "zetasql/base/testing/status_matchers.h"
+#include "tests/common/proto_matchers.h"
+#include "absl/status/status.h"
+#include "absl/time/time.h"
+#include "backend/datamodel/key.h"
+#include "backend/datamodel/value.h"
+
+namespace google {
+namespace spanner {
+namespace emulator {
+namespace backend {
+
+namespace {
+
+using zetasql::types::DoubleType;
+using zetasql::types::Int64Type;
+using zetasql::types::StringType;
+using zetasql::values::Bool;
+using zetasql::values::Bytes;
+using zetasql::values::Date;
+using zetasql::values::Double;
+using zetasql::values::Int64;
+using zetasql::values::Null;
+using zetasql::values::String;
+using zetasql::values::Timestamp;
+using zetasql_base::testing::IsOkAndHolds;
+using zetasql_base::testing::StatusIs;
+
+// Returns a key with an ascending STRING column and a descending INT64 column.
+Key StringInt64DescKey(zetasql::Value string_value,
+                       zetasql::Value int64_value) {
+  Key key;
+  key.AddColumn(string_value, /*desc=*/false);
+  key.AddColumn(int64_value, /*desc=*/true);
+  return key;
+}
+
+// Checks that encoded keys compare like the keys themselves.
+void ExpectEncodingPreservesOrder(const std::vector<Key>& keys) {
+  for (const Key& k1 : keys) {
+    std::string e1 = EncodeKey(k1).value();
+    for (const Key& k2 : keys) {
+      std::string e2 = EncodeKey(k2).value();
+      int compare = e1.compare(e2);
+      EXPECT_EQ(k1.Compare(k2), compare < 0 ? -1 : (compare > 0 ? 1 : 0))
+          << k1 << " vs " << k2;
+    }
+  }
+}
+
+TEST(KeyEncoding, PreservesOrderOfMultiColumnKeys) {
+  constexpr int64_t kMax = std::numeric_limits<int64_t>::max();
+  constexpr int64_t kMin = std::numeric_limits<int64_t>::min();
+  Key prefix_a;
+  prefix_a.AddColumn(String("a"));
+
+  ExpectEncodingPreservesOrder({
+      Key::Empty(),
+      Key::Empty().ToPrefixLimit(),
+      Key::Infinity(),
+      prefix_a,
+      prefix_a.ToPrefixLimit(),
+      StringInt64DescKey(Null(StringType()), Int64(1)),
+      StringInt64DescKey(String(""), Int64(1)),
+      StringInt64DescKey(String(""), Null(Int64Type())),
+      StringInt64DescKey(String("a"), Int64(kMax)),
+      StringInt64DescKey(String("a"), Int64(1)),
+      StringInt64DescKey(String("a"), Int64(0)),
+      StringInt64DescKey(String("a"), Int64(-1)),
+      StringInt64DescKey(String("a"), Int64(kMin)),
+      StringInt64DescKey(String("a"), Null(Int64Type())),
+      StringInt64DescKey(String(std::string("a\0", 2)), Int64(1)),
+      StringInt64DescKey(String(std::string("a\0b", 3)), Int64(1)),
+      StringInt64DescKey(String("a\x01"), Int64(1)),
+      StringInt64DescKey(String("ab"), Int64(1)),
+      StringInt64DescKey(String("b"), Int64(1)),
+      StringInt64DescKey(String("b"), Int64(1)).ToPrefixLimit(),
+  });
+}
+
+TEST(KeyEncoding, PreservesOrderOfDescendingStrings) {
+  std::vector<Key> keys;
+  for (const std::string& value :
+       {std::string(""), std::string("\0", 1), std::string("a"),
+        std::string("a\0", 2), std::string("a\xff"), std::string("ab")}) {
+    keys.emplace_back();
+    keys.back().AddColumn(String(value), /*desc=*/true);
+  }
+  ExpectEncodingPreservesOrder(keys);
+}
+
+TEST(KeyEncoding, PreservesOrderOfDoubles) {
+  std::vector<Key> keys;
+  for (double value : {-std::numeric_limits<double>::infinity(), -1.5,
+                       -std::numeric_limits<double>::min(), -0.0, 0.0,
+                       std::numeric_limits<double>::denorm_min(), 2.0,
+                       std::numeric_limits<double>::infinity(), std::nan("")}) {
+    keys.push_back(Key({Double(value)}));
+  }
+  keys.push_back(Key({Null(DoubleType())}));
+  ExpectEncodingPreservesOrder(keys);
+}
+
+TEST(KeyEncoding, PreservesOrderOfOtherTypes) {
+  ExpectEncodingPreservesOrder({
+      Key({Bool(false)}),
+      Key({Bool(true)}),
+  });
+  ExpectEncodingPreservesOrder({
+      Key({Date(-1)}),
+      Key({Date(0)}),
+      Key({Date(1)}),
+  });
+  absl::Time t = absl::FromUnixSeconds(0);
+  ExpectEncodingPreservesOrder({
+      Key({Timestamp(t - absl::Seconds(1))}),
+      Key({Timestamp(t - absl::Nanoseconds(1))}),
+      Key({Timestamp(t)}),
+      Key({Timestamp(t + absl::Nanoseconds(1))}),
+      Key({Timestamp(t + absl::Hours(24 * 365 * 1000))}),
+  });
+  ExpectEncodingPreservesOrder({
+      Key({Bytes("")}),
+      Key({Bytes(std::string("\0", 1))}),
+      Key({Bytes("\xff")}),
+  });
+}
+
+TEST(KeyEncoding, DecodesEncodedKeys) {
+  const zetasql::Type* types[] = {StringType(), Int64Type()};
+  const bool is_descending[] = {false, true};
+  for (const Key& key :
+       {Key::Empty(), Key::Infinity(),
+        StringInt64DescKey(String(std::string("a\0b", 3)), Int64(-7)),
+        StringInt64DescKey(Null(StringType()), Null(Int64Type())),
+        StringInt64DescKey(String("a"), Int64(1)).Prefix(1),
+        StringInt64DescKey(String("a"), Int64(1)).ToPrefixLimit()}) {
+    std::string encoded_key = EncodeKey(key).value();
+    absl::StatusOr<Key> decoded_key =
+        DecodeKey(encoded_key, types, is_descending);
+    ZETASQL_ASSERT_OK(decoded_key.status());
+    EXPECT_EQ(decoded_key->DebugString(), key.DebugString());
+  }
+}
+
+TEST(KeyEncoding, DecodesOtherTypes) {
+  absl::Time t = absl::FromUnixSeconds(-1) + absl::Nanoseconds(999999999);
+  const zetasql::Type* types[] = {zetasql::types::BoolType(),
+                                    zetasql::types::DateType(),
+                                    zetasql::types::TimestampType(),
+                                    zetasql::types::BytesType(), DoubleType()};
+  const bool is_descending[] = {true, false, true, false, true};
+  Key key;
+  key.AddColumn(Bool(true), /*desc=*/true);
+  key.AddColumn(Date(-365), /*desc=*/false);
+  key.AddColumn(Timestamp(t), /*desc=*/true);
+  key.AddColumn(Bytes(std::string("\0\xff", 2)), /*desc=*/false);
+  key.AddColumn(Double(-2.5), /*desc=*/true);
+  EXPECT_THAT(DecodeKey(EncodeKey(key).value(), types, is_descending),
+              IsOkAndHolds(key));
+}
+
+TEST(KeyEncoding, RejectsInvalidEncodings) {
+  const zetasql::Type* types[] = {Int64Type()};
+  const bool is_descending[] = {false};
+  std::string encoded_key = EncodeKey(Key({Int64(1)})).value();
+
+  // Truncated keys.
+  EXPECT_THAT(DecodeKey(encoded_key.substr(0, encoded_key.size() - 1), types,
+                        is_descending),
+              StatusIs(absl::StatusCode::kInternal));
+
+  // Keys with more columns than expected.
+  EXPECT_THAT(DecodeKey(encoded_key + encoded_key, types, is_descending),
+              StatusIs(absl::StatusCode::kInternal));
+
+  // Keys with an invalid column header.
+  EXPECT_THAT(DecodeKey("\x03", types, is_descending),
+              StatusIs(absl::StatusCode::kInternal));
+}
+
+}  // namespace
+
+}  // namespace backend
+}  // namespace emulator
+}  // namespace spanner
+}  // namespace google
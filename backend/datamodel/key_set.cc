@@ -141,6 +141,29 @@ void MakeDisjointKeyRanges(const KeySet& set, std::vector<KeyRange>* ranges) {
   ranges->erase(last + 1, next);
 }
 
+void IntersectDisjointKeyRanges(const std::vector<KeyRange>& ranges1,
+                                const std::vector<KeyRange>& ranges2,
+                                std::vector<KeyRange>* intersection) {
+  intersection->clear();
+  auto itr1 = ranges1.begin();
+  auto itr2 = ranges2.begin();
+  while (itr1 != ranges1.end() && itr2 != ranges2.end()) {
+    const Key& start_key = std::max(itr1->start_key(), itr2->start_key());
+    const Key& limit_key = std::min(itr1->limit_key(), itr2->limit_key());
+    if (start_key < limit_key) {
+      intersection->push_back(KeyRange::ClosedOpen(start_key, limit_key));
+    }
+
+    // The range which ends first cannot overlap any later range of the other
+    // list.
+    if (itr1->limit_key() < itr2->limit_key()) {
+      ++itr1;
+    } else {
+      ++itr2;
+    }
+  }
+}
+
 }  // namespace backend
 }  // namespace emulator
 }  // namespace spanner
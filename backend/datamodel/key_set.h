@@ -76,6 +76,12 @@ std::ostream& operator<<(std::ostream& out, const KeySet& set);
 // Converts a key set to a sorted list of disjoint closed-open key ranges.
 void MakeDisjointKeyRanges(const KeySet& set, std::vector<KeyRange>* ranges);
 
+// Computes the intersection of two sorted lists of disjoint closed-open key
+// ranges (as returned by MakeDisjointKeyRanges) as a list of the same form.
+void IntersectDisjointKeyRanges(const std::vector<KeyRange>& ranges1,
+                                const std::vector<KeyRange>& ranges2,
+                                std::vector<KeyRange>* intersection);
+
 }  // namespace backend
 }  // namespace emulator
 }  // namespace spanner
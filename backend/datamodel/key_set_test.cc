@@ -410,6 +410,27 @@ bool Contains(const KeySet& keyset, const Key& input) {
   return false;
 }
 
+TEST(KeySet, IntersectsDisjointKeyRanges) {
+  std::vector<KeyRange> ranges1{MakeClosedOpenRange(1, 4),
+                                MakeClosedOpenRange(6, 9)};
+  std::vector<KeyRange> ranges2{MakeClosedOpenRange(0, 2),
+                                MakeClosedOpenRange(3, 7),
+                                MakeClosedOpenRange(9, 10)};
+  std::vector<KeyRange> expected_ranges{MakeClosedOpenRange(1, 2),
+                                        MakeClosedOpenRange(3, 4),
+                                        MakeClosedOpenRange(6, 7)};
+
+  std::vector<KeyRange> actual_ranges;
+  IntersectDisjointKeyRanges(ranges1, ranges2, &actual_ranges);
+  EXPECT_THAT(actual_ranges, testing::ElementsAreArray(expected_ranges));
+
+  IntersectDisjointKeyRanges(ranges2, ranges1, &actual_ranges);
+  EXPECT_THAT(actual_ranges, testing::ElementsAreArray(expected_ranges));
+
+  IntersectDisjointKeyRanges(ranges1, {}, &actual_ranges);
+  EXPECT_THAT(actual_ranges, testing::IsEmpty());
+}
+
 TEST(KeySet, CanonicalizesRandomKeySet) {
   // Choose a random seed unless one is explicitly provided by the test.
   int seed = absl::GetFlag(
@@ -118,6 +118,20 @@ TEST(Key, OrdersKeysOfDifferentLength) {
   EXPECT_GT(Key({String("B"), Int64(1)}), Key({String("A")}));
 }
 
+TEST(Key, OrdersKeysWithMoreColumnsThanStoredInline) {
+  Key key;
+  for (int i = 0; i <= Key::kInlineColumns; ++i) {
+    key.AddColumn(Int64(i), /*desc=*/i % 2 == 1);
+  }
+  Key copy = key;
+  EXPECT_EQ(copy, key);
+  EXPECT_TRUE(copy.IsColumnDescending(Key::kInlineColumns - 1));
+
+  copy.SetColumnValue(Key::kInlineColumns, Int64(-1));
+  EXPECT_LT(copy, key);
+  EXPECT_LT(key.Prefix(Key::kInlineColumns), copy);
+}
+
 TEST(Key, OrdersSpecialKeys) {
   EXPECT_EQ(Key::Empty(), Key());
   EXPECT_EQ(Key::Empty(), Key::Empty());
@@ -18,6 +18,8 @@
 
 #include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
+#include "absl/time/time.h"
+#include "absl/types/span.h"
 #include "backend/locking/manager.h"
 
 namespace google {
@@ -29,7 +31,10 @@ LockHandle::LockHandle(LockManager* manager, TransactionID tid,
                        TransactionPriority priority)
     : manager_(manager), tid_(tid), priority_(priority) {}
 
-LockHandle::~LockHandle() = default;
+LockHandle::~LockHandle() {
+  // Make sure the lock manager does not keep references to this handle.
+  manager_->UnlockAll(this);
+}
 
 void LockHandle::EnqueueLock(const LockRequest& request) {
   manager_->EnqueueLock(this, request);
@@ -37,11 +42,7 @@ void LockHandle::EnqueueLock(const LockRequest& request) {
 
 void LockHandle::UnlockAll() { manager_->UnlockAll(this); }
 
-bool LockHandle::IsBlocked() {
-  // The current implementation never blocks.
-  absl::MutexLock lock(&mu_);
-  return false;
-}
+bool LockHandle::IsBlocked() { return manager_->IsBlocked(this); }
 
 bool LockHandle::IsAborted() {
   absl::MutexLock lock(&mu_);
@@ -49,7 +50,7 @@ bool LockHandle::IsAborted() {
 }
 
 absl::Status LockHandle::Wait() {
-  // The current implementation never blocks.
+  manager_->Wait(this);
   absl::MutexLock lock(&mu_);
   return status_;
 }
@@ -59,6 +60,11 @@ void LockHandle::Abort(const absl::Status& status) {
   status_ = status;
 }
 
+absl::Status LockHandle::status() {
+  absl::MutexLock lock(&mu_);
+  return status_;
+}
+
 void LockHandle::Reset() {
   absl::MutexLock lock(&mu_);
   status_ = absl::OkStatus();
@@ -76,6 +82,11 @@ void LockHandle::WaitForSafeRead(absl::Time read_time) {
   manager_->WaitForSafeRead(read_time);
 }
 
+void LockHandle::WaitForSafeRead(absl::Time read_time,
+                                 absl::Span<const TableID> table_ids) {
+  manager_->WaitForSafeRead(read_time, table_ids);
+}
+
 }  // namespace backend
 }  // namespace emulator
 }  // namespace spanner
@@ -21,6 +21,7 @@
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/time/time.h"
+#include "absl/types/span.h"
 #include "backend/common/ids.h"
 #include "backend/locking/request.h"
 #include "absl/status/status.h"
@@ -43,7 +44,8 @@ class LockManager;
 // EnqueueLock() is non-blocking and only enqueues the lock request. The
 // transaction can subsequently query whether the requests have completed by
 // checking IsBlocked() or perform a blocking Wait() to find out the final
-// state of the lock requests.
+// state of the lock requests. A handle may be aborted (wounded) by the lock
+// manager at any time when a higher priority transaction needs its locks.
 //
 // Usage (happy path, error handling skipped):
 //    // Get a handle.
@@ -81,11 +83,11 @@ class LockHandle {
   void UnlockAll();
 
   // Returns true if this handle is waiting on any lock requests to complete.
-  bool IsBlocked() ABSL_LOCKS_EXCLUDED(mu_);
+  bool IsBlocked();
 
-  // Returns true if this handle has been aborted by the lock manager. Previous
-  // locks acquired by the handle are not release automatically. The handle must
-  // explicitly call UnlockAll().
+  // Returns true if this handle has been aborted by the lock manager. Locks
+  // acquired by an aborted handle are released by the lock manager, but the
+  // handle must still explicitly call UnlockAll() before it can be reused.
   bool IsAborted() ABSL_LOCKS_EXCLUDED(mu_);
 
   // Waits till all locks requested via this handle have either all been granted
@@ -104,6 +106,12 @@ class LockHandle {
   // commits.
   void WaitForSafeRead(absl::Time read_time);
 
+  // Waits for the intended read timestamp to be safe from in-progress commits
+  // which write any of the given tables, and from schema changes. Commits which
+  // only write other tables do not hold up the read.
+  void WaitForSafeRead(absl::Time read_time,
+                       absl::Span<const TableID> table_ids);
+
  private:
   // Only the LockManager is allowed to create and destroy LockHandles.
   friend class LockManager;
@@ -115,6 +123,9 @@ class LockHandle {
   // Aborts the requests made by this handle (and puts it in a final state).
   void Abort(const absl::Status& status) ABSL_LOCKS_EXCLUDED(mu_);
 
+  // Returns the status of the lock handle requests.
+  absl::Status status() ABSL_LOCKS_EXCLUDED(mu_);
+
   // Resets the state of this handle.
   void Reset() ABSL_LOCKS_EXCLUDED(mu_);
 
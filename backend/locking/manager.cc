@@ -16,20 +16,94 @@
 
 #include "backend/locking/manager.h"
 
+#include <algorithm>
 #include <memory>
+#include <set>
+#include <utility>
+#include <vector>
 
+#include "absl/container/flat_hash_set.h"
+#include "absl/memory/memory.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/substitute.h"
 #include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
 #include "absl/time/time.h"
+#include "absl/types/span.h"
 #include "backend/common/ids.h"
+#include "backend/datamodel/key.h"
+#include "backend/datamodel/key_range.h"
+#include "backend/locking/handle.h"
+#include "backend/locking/request.h"
 #include "common/errors.h"
+#include "zetasql/base/ret_check.h"
 
 namespace google {
 namespace spanner {
 namespace emulator {
 namespace backend {
 
+namespace {
+
+// Returns true if the transaction owning handle 'a' is older (and thus has
+// higher priority) than the one owning handle 'b'.
+bool IsOlder(LockHandle* a, LockHandle* b) {
+  if (a->priority() != b->priority()) {
+    return a->priority() < b->priority();
+  }
+  return a->tid() < b->tid();
+}
+
+// Returns true if the closed-open range is a single key (or key prefix) range
+// [K, K+).
+bool IsPointRange(const KeyRange& range) {
+  return range.limit_key() == range.start_key().ToPrefixLimit();
+}
+
+// Returns true if the closed-open ranges overlap.
+bool Overlaps(const KeyRange& a, const KeyRange& b) {
+  return a.start_key() < b.limit_key() && b.start_key() < a.limit_key() &&
+         a.start_key() < a.limit_key() && b.start_key() < b.limit_key();
+}
+
+// Returns true if the column sets overlap. An empty set covers all columns.
+bool Overlaps(const std::vector<ColumnID>& a, const std::vector<ColumnID>& b) {
+  if (a.empty() || b.empty()) {
+    return true;
+  }
+  for (const ColumnID& column_id : a) {
+    if (std::find(b.begin(), b.end(), column_id) != b.end()) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Returns true if 'timestamps' holds a timestamp before 'read_time'.
+bool HasTimestampBefore(const std::set<absl::Time>& timestamps,
+                        absl::Time read_time) {
+  return !timestamps.empty() && *timestamps.begin() < read_time;
+}
+
+// Adds the columns in 'from' to 'to'. An empty set covers all columns.
+void MergeColumns(const std::vector<ColumnID>& from,
+                  std::vector<ColumnID>* to) {
+  if (to->empty()) {
+    return;
+  }
+  if (from.empty()) {
+    to->clear();
+    return;
+  }
+  for (const ColumnID& column_id : from) {
+    if (std::find(to->begin(), to->end(), column_id) == to->end()) {
+      to->push_back(column_id);
+    }
+  }
+}
+
+}  // namespace
+
 std::unique_ptr<LockHandle> LockManager::CreateHandle(
     TransactionID tid, TransactionPriority priority) {
   return absl::WrapUnique(new LockHandle(this, tid, priority));
@@ -43,80 +117,459 @@ void LockManager::EnqueueLock(LockHandle* handle, const LockRequest& request) {
     return;
   }
 
-  // If there is no transaction holding the lock, we grant it.
-  if (active_tid_ == kInvalidTransactionID) {
-    active_tid_ = handle->tid();
+  // Requests are granted in order, so queue up behind earlier waiting requests.
+  HandleState& state = handles_[handle];
+  if (!state.waiting_requests.empty()) {
+    state.waiting_requests.push_back(request);
     return;
   }
 
-  // If the requesting transaction is already holding the lock, we grant it.
-  if (active_tid_ == handle->tid()) {
-    return;
+  LockHandle* blocker = nullptr;
+  if (!TryAcquire(handle, request, &blocker)) {
+    state.waiting_requests.push_back(request);
   }
+}
 
-  // If we reached here, another transaction is already holding the lock, deny.
-  handle->Abort(error::AbortConcurrentTransaction(handle->tid(), active_tid_));
+void LockManager::Wait(LockHandle* handle) {
+  absl::MutexLock lock(&mu_);
+
+  absl::Time deadline = absl::Now() + lock_wait_timeout_;
+  while (!handle->IsAborted()) {
+    LockHandle* blocker = GrantWaitingRequests(handle);
+    if (blocker == nullptr) {
+      return;
+    }
+
+    // Give up if the holder did not release its locks in time.
+    if (locks_released_cvar_.WaitWithDeadline(&mu_, deadline) &&
+        !handle->IsAborted()) {
+      blocker = GrantWaitingRequests(handle);
+      if (blocker != nullptr) {
+        AbortHandle(handle, error::AbortConcurrentTransaction(handle->tid(),
+                                                              blocker->tid()));
+      }
+      return;
+    }
+  }
 }
 
-void LockManager::UnlockAll(LockHandle* handle) {
+bool LockManager::IsBlocked(LockHandle* handle) {
   absl::MutexLock lock(&mu_);
+  auto itr = handles_.find(handle);
+  return itr != handles_.end() && !itr->second.waiting_requests.empty();
+}
 
-  // If the transaction does not hold the lock, there is nothing to do.
-  if (active_tid_ != handle->tid()) {
-    handle->Reset();
+LockHandle* LockManager::GrantWaitingRequests(LockHandle* handle) {
+  auto itr = handles_.find(handle);
+  if (itr == handles_.end()) {
+    return nullptr;
+  }
+  std::vector<LockRequest>& waiting_requests = itr->second.waiting_requests;
+  while (!waiting_requests.empty()) {
+    LockRequest request = waiting_requests.front();
+    LockHandle* blocker = nullptr;
+    if (!TryAcquire(handle, request, &blocker)) {
+      return blocker;
+    }
+    // Aborting the handle already dropped its waiting requests.
+    if (handle->IsAborted()) {
+      return nullptr;
+    }
+    waiting_requests.erase(waiting_requests.begin());
+  }
+  return nullptr;
+}
+
+bool LockManager::TryAcquire(LockHandle* handle, const LockRequest& request,
+                             LockHandle** blocker) {
+  absl::flat_hash_set<LockHandle*> conflicts = FindConflicts(handle, request);
+
+  // Database locks never wait and are never waited on.
+  if (!conflicts.empty() &&
+      (request.IsDatabaseLock() || database_lock_holder_ != nullptr)) {
+    LockHandle* holder = database_lock_holder_ != nullptr
+                             ? database_lock_holder_
+                             : *conflicts.begin();
+    AbortHandle(handle, error::AbortConcurrentTransaction(handle->tid(),
+                                                          holder->tid()));
+    return true;
+  }
+
+  // Wound younger holders which have not started committing, wait for others.
+  *blocker = nullptr;
+  for (LockHandle* holder : conflicts) {
+    auto holder_itr = handles_.find(holder);
+    bool committing =
+        holder_itr != handles_.end() && holder_itr->second.committing;
+    if (IsOlder(handle, holder) && !committing) {
+      AbortHandle(holder,
+                  error::AbortWoundedTransaction(holder->tid(), handle->tid()));
+    } else {
+      *blocker = holder;
+    }
+  }
+  if (*blocker != nullptr) {
+    return false;
+  }
+
+  Grant(handle, request);
+  return true;
+}
+
+absl::flat_hash_set<LockHandle*> LockManager::FindConflicts(
+    LockHandle* handle, const LockRequest& request) {
+  absl::flat_hash_set<LockHandle*> conflicts;
+
+  // A database lock conflicts with every other active transaction.
+  if (request.IsDatabaseLock()) {
+    for (const auto& [holder, state] : handles_) {
+      if (holder != handle && IsActive(holder)) {
+        conflicts.insert(const_cast<LockHandle*>(holder));
+      }
+    }
+    return conflicts;
+  }
+  if (database_lock_holder_ != nullptr && database_lock_holder_ != handle) {
+    conflicts.insert(database_lock_holder_);
+    return conflicts;
+  }
+
+  auto table_itr = table_locks_.find(request.table_id());
+  if (table_itr == table_locks_.end()) {
+    return conflicts;
+  }
+  const TableLocks& table_locks = table_itr->second;
+  const KeyRange& range = request.key_range();
+  auto check = [&](const Lock& lock) {
+    if (lock.holder != handle &&
+        (lock.mode == LockMode::kExclusive ||
+         request.mode() == LockMode::kExclusive) &&
+        Overlaps(lock.column_ids, request.column_ids()) &&
+        Overlaps(lock.key_range, range)) {
+      conflicts.insert(lock.holder);
+    }
+  };
+
+  // Point locks with keys inside the range.
+  for (auto itr = table_locks.point_locks.lower_bound(range.start_key());
+       itr != table_locks.point_locks.end() && itr->first < range.limit_key();
+       ++itr) {
+    for (const Lock& lock : itr->second) {
+      check(lock);
+    }
+  }
+
+  // Point locks on proper prefixes of the range start also cover its start.
+  Key prefix;
+  for (int i = 0; i < range.start_key().NumColumns(); ++i) {
+    auto itr = table_locks.point_locks.find(prefix);
+    if (itr != table_locks.point_locks.end()) {
+      for (const Lock& lock : itr->second) {
+        check(lock);
+      }
+    }
+    prefix.AddColumn(range.start_key().ColumnValue(i),
+                     range.start_key().IsColumnDescending(i));
+  }
+
+  for (const Lock& lock : table_locks.range_locks) {
+    check(lock);
+  }
+  return conflicts;
+}
+
+void LockManager::Grant(LockHandle* handle, const LockRequest& request) {
+  HandleState& state = handles_[handle];
+  if (request.IsDatabaseLock()) {
+    database_lock_holder_ = handle;
+    return;
+  }
+  if (database_lock_holder_ == handle) {
+    // The database lock already covers every other lock.
     return;
   }
 
-  // Clear the active transaction if it holds the lock.
-  active_tid_ = kInvalidTransactionID;
+  // Extend an existing lock of the handle in the same mode if possible.
+  TableLocks& table_locks = table_locks_[request.table_id()];
+  const KeyRange& range = request.key_range();
+  auto extend = [&](std::vector<Lock>* locks) {
+    for (Lock& lock : *locks) {
+      if (lock.holder == handle && lock.mode == request.mode() &&
+          lock.key_range == range) {
+        MergeColumns(request.column_ids(), &lock.column_ids);
+        return true;
+      }
+    }
+    return false;
+  };
+
+  Lock lock{handle, request.mode(), range, request.column_ids()};
+  if (IsPointRange(range)) {
+    std::vector<Lock>& locks = table_locks.point_locks[range.start_key()];
+    if (!extend(&locks)) {
+      if (std::none_of(locks.begin(), locks.end(), [&](const Lock& lock) {
+            return lock.holder == handle;
+          })) {
+        state.point_locks.emplace_back(request.table_id(), range.start_key());
+      }
+      locks.push_back(std::move(lock));
+    }
+  } else if (!extend(&table_locks.range_locks)) {
+    table_locks.range_locks.push_back(std::move(lock));
+    state.range_lock_tables.insert(request.table_id());
+  }
+}
+
+void LockManager::AbortHandle(LockHandle* handle, const absl::Status& status) {
+  handle->Abort(status);
+  ReleaseLocks(handle);
+}
+
+void LockManager::ReleaseLocks(LockHandle* handle) {
+  auto itr = handles_.find(handle);
+  if (itr == handles_.end()) {
+    return;
+  }
+  HandleState& state = itr->second;
+  auto held_by_handle = [handle](const Lock& lock) {
+    return lock.holder == handle;
+  };
+
+  for (const auto& [table_id, key] : state.point_locks) {
+    auto table_itr = table_locks_.find(table_id);
+    if (table_itr == table_locks_.end()) {
+      continue;
+    }
+    auto& point_locks = table_itr->second.point_locks;
+    auto lock_itr = point_locks.find(key);
+    if (lock_itr == point_locks.end()) {
+      continue;
+    }
+    std::vector<Lock>& locks = lock_itr->second;
+    locks.erase(std::remove_if(locks.begin(), locks.end(), held_by_handle),
+                locks.end());
+    if (locks.empty()) {
+      point_locks.erase(lock_itr);
+    }
+  }
+  for (const TableID& table_id : state.range_lock_tables) {
+    auto table_itr = table_locks_.find(table_id);
+    if (table_itr == table_locks_.end()) {
+      continue;
+    }
+    std::vector<Lock>& locks = table_itr->second.range_locks;
+    locks.erase(std::remove_if(locks.begin(), locks.end(), held_by_handle),
+                locks.end());
+  }
+  state.point_locks.clear();
+  state.range_lock_tables.clear();
+  state.waiting_requests.clear();
+  if (database_lock_holder_ == handle) {
+    database_lock_holder_ = nullptr;
+  }
+  locks_released_cvar_.SignalAll();
+}
+
+bool LockManager::IsActive(const LockHandle* handle) const {
+  auto itr = handles_.find(handle);
+  if (itr == handles_.end()) {
+    return false;
+  }
+  const HandleState& state = itr->second;
+  return database_lock_holder_ == handle || !state.point_locks.empty() ||
+         !state.range_lock_tables.empty() || state.committing;
+}
+
+void LockManager::UnlockAll(LockHandle* handle) {
+  absl::MutexLock lock(&mu_);
+
+  auto itr = handles_.find(handle);
+  if (itr != handles_.end()) {
+    // A commit which never completed should no longer hold up readers.
+    if (itr->second.pending_commit_timestamp != absl::InfiniteFuture()) {
+      ClearPendingCommit(&itr->second);
+      pending_commit_cvar_.SignalAll();
+    }
+    ReleaseLocks(handle);
+    handles_.erase(handle);
+  }
   handle->Reset();
 }
 
 absl::StatusOr<absl::Time> LockManager::ReserveCommitTimestamp(
     LockHandle* handle) {
   absl::MutexLock lock(&mu_);
+  return ReserveCommitTimestampLocked(handle);
+}
 
-  // If there is no transaction holding the lock, we grant it to the transaction
-  // requesting commit timestamp. This can happen if transaction has empty
-  // mutations and write locks weren't thus acquired yet.
-  if (active_tid_ == kInvalidTransactionID) {
-    active_tid_ = handle->tid();
-  } else if (active_tid_ != handle->tid()) {
-    // There is another active transaction, abort this transaction.
-    return error::AbortConcurrentTransaction(handle->tid(), active_tid_);
+std::vector<absl::StatusOr<absl::Time>> LockManager::ReserveCommitTimestamps(
+    absl::Span<LockHandle* const> handles) {
+  absl::MutexLock lock(&mu_);
+  std::vector<absl::StatusOr<absl::Time>> timestamps;
+  timestamps.reserve(handles.size());
+  for (LockHandle* handle : handles) {
+    timestamps.push_back(ReserveCommitTimestampLocked(handle));
   }
+  return timestamps;
+}
 
-  pending_commit_timestamp_ = clock_->Now();
-  return pending_commit_timestamp_;
+absl::StatusOr<absl::Time> LockManager::ReserveCommitTimestampLocked(
+    LockHandle* handle) {
+  // A wounded transaction must not commit.
+  if (handle->IsAborted()) {
+    return handle->status();
+  }
+
+  // Commits cannot proceed concurrently with a schema change. This also
+  // covers transactions with empty mutations which never acquired any locks.
+  if (database_lock_holder_ != nullptr && database_lock_holder_ != handle) {
+    return error::AbortConcurrentTransaction(handle->tid(),
+                                             database_lock_holder_->tid());
+  }
+
+  HandleState& state = handles_[handle];
+  state.committing = true;
+  state.pending_commit_timestamp = clock_->Now();
+  pending_commit_timestamps_.insert(state.pending_commit_timestamp);
+
+  // Every write of a transaction is covered by an exclusive lock, which is held
+  // until after the commit, so readers of other tables need not wait for it.
+  if (database_lock_holder_ == handle) {
+    pending_database_commit_timestamps_.insert(state.pending_commit_timestamp);
+  } else {
+    state.pending_commit_tables = ExclusivelyLockedTables(handle, state);
+    for (const TableID& table_id : state.pending_commit_tables) {
+      pending_table_commit_timestamps_[table_id].insert(
+          state.pending_commit_timestamp);
+    }
+  }
+  return state.pending_commit_timestamp;
 }
 
-absl::Status LockManager::MarkCommitted(LockHandle* handle) {
-  absl::MutexLock lock(&mu_);
+std::vector<TableID> LockManager::ExclusivelyLockedTables(
+    const LockHandle* handle, const HandleState& state) const {
+  auto is_exclusive_lock_of_handle = [handle](const Lock& lock) {
+    return lock.holder == handle && lock.mode == LockMode::kExclusive;
+  };
+  absl::flat_hash_set<TableID> tables;
+  for (const auto& [table_id, key] : state.point_locks) {
+    auto table_itr = table_locks_.find(table_id);
+    if (tables.contains(table_id) || table_itr == table_locks_.end()) {
+      continue;
+    }
+    auto lock_itr = table_itr->second.point_locks.find(key);
+    if (lock_itr != table_itr->second.point_locks.end() &&
+        std::any_of(lock_itr->second.begin(), lock_itr->second.end(),
+                    is_exclusive_lock_of_handle)) {
+      tables.insert(table_id);
+    }
+  }
+  for (const TableID& table_id : state.range_lock_tables) {
+    auto table_itr = table_locks_.find(table_id);
+    if (table_itr == table_locks_.end()) {
+      continue;
+    }
+    const std::vector<Lock>& locks = table_itr->second.range_locks;
+    if (std::any_of(locks.begin(), locks.end(), is_exclusive_lock_of_handle)) {
+      tables.insert(table_id);
+    }
+  }
+  return std::vector<TableID>(tables.begin(), tables.end());
+}
 
-  // This transaction should have been set as the active transaction.
-  ZETASQL_RET_CHECK_EQ(active_tid_, handle->tid())
-      << absl::Substitute("Transaction $0 is not active.", handle->tid());
+void LockManager::ClearPendingCommit(HandleState* state) {
+  const absl::Time timestamp = state->pending_commit_timestamp;
+  pending_commit_timestamps_.erase(timestamp);
+  pending_database_commit_timestamps_.erase(timestamp);
+  for (const TableID& table_id : state->pending_commit_tables) {
+    auto itr = pending_table_commit_timestamps_.find(table_id);
+    if (itr == pending_table_commit_timestamps_.end()) {
+      continue;
+    }
+    itr->second.erase(timestamp);
+    if (itr->second.empty()) {
+      pending_table_commit_timestamps_.erase(itr);
+    }
+  }
+  state->pending_commit_tables.clear();
+  state->pending_commit_timestamp = absl::InfiniteFuture();
+}
 
-  last_commit_timestamp_ = pending_commit_timestamp_;
-  pending_commit_timestamp_ = absl::InfiniteFuture();
+absl::Status LockManager::MarkCommitted(LockHandle* handle) {
+  absl::MutexLock lock(&mu_);
+  absl::Status status = MarkCommittedLocked(handle);
   pending_commit_cvar_.SignalAll();
-  return absl::OkStatus();
+  return status;
 }
 
-void LockManager::WaitForSafeRead(absl::Time read_time) {
+std::vector<absl::Status> LockManager::MarkGroupCommitted(
+    absl::Span<LockHandle* const> handles) {
   absl::MutexLock lock(&mu_);
+  std::vector<absl::Status> statuses;
+  statuses.reserve(handles.size());
+  for (LockHandle* handle : handles) {
+    statuses.push_back(MarkCommittedLocked(handle));
+  }
+  pending_commit_cvar_.SignalAll();
+  return statuses;
+}
+
+absl::Status LockManager::MarkCommittedLocked(LockHandle* handle) {
+  // This transaction should have reserved a commit timestamp.
+  auto itr = handles_.find(handle);
+  ZETASQL_RET_CHECK(itr != handles_.end() && itr->second.committing)
+      << absl::Substitute("Transaction $0 is not committing.", handle->tid());
+  HandleState& state = itr->second;
+
+  if (state.pending_commit_timestamp != absl::InfiniteFuture()) {
+    last_commit_timestamp_ =
+        std::max(last_commit_timestamp_, state.pending_commit_timestamp);
+    ClearPendingCommit(&state);
+  }
+  return absl::OkStatus();
+}
 
-  // Wait for read time to become current if passed a future timestamp  for the
+void LockManager::WaitForReadTime(absl::Time read_time) {
+  // Wait for read time to become current if passed a future timestamp for the
   // case of exact timestamp bound for snapshot read.
   // https://cloud.google.com/spanner/docs/timestamp-bounds#introduction
-  bool f = false;
-  mu_.AwaitWithDeadline(absl::Condition(&f), read_time);
+  for (absl::Time now = clock_->Now(); now < read_time; now = clock_->Now()) {
+    absl::SleepFor(read_time - now);
+  }
+}
 
-  while (pending_commit_timestamp_ < read_time) {
+void LockManager::WaitForSafeRead(absl::Time read_time) {
+  WaitForReadTime(read_time);
+  absl::MutexLock lock(&mu_);
+  while (HasTimestampBefore(pending_commit_timestamps_, read_time)) {
     pending_commit_cvar_.Wait(&mu_);
   }
 }
 
+void LockManager::WaitForSafeRead(absl::Time read_time,
+                                  absl::Span<const TableID> table_ids) {
+  WaitForReadTime(read_time);
+  absl::MutexLock lock(&mu_);
+  while (HasPendingCommitOnTables(read_time, table_ids)) {
+    pending_commit_cvar_.Wait(&mu_);
+  }
+}
+
+bool LockManager::HasPendingCommitOnTables(
+    absl::Time read_time, absl::Span<const TableID> table_ids) const {
+  if (HasTimestampBefore(pending_database_commit_timestamps_, read_time)) {
+    return true;
+  }
+  for (const TableID& table_id : table_ids) {
+    auto itr = pending_table_commit_timestamps_.find(table_id);
+    if (itr != pending_table_commit_timestamps_.end() &&
+        HasTimestampBefore(itr->second, read_time)) {
+      return true;
+    }
+  }
+  return false;
+}
+
 absl::Time LockManager::LastCommitTimestamp() {
   absl::ReaderMutexLock lock(&mu_);
   return last_commit_timestamp_;
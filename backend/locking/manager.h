@@ -17,15 +17,25 @@
 #ifndef THIRD_PARTY_CLOUD_SPANNER_EMULATOR_BACKEND_LOCKING_MANAGER_H_
 #define THIRD_PARTY_CLOUD_SPANNER_EMULATOR_BACKEND_LOCKING_MANAGER_H_
 
+#include <map>
 #include <memory>
+#include <set>
+#include <utility>
+#include <vector>
 
 #include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/synchronization/mutex.h"
 #include "absl/time/time.h"
+#include "absl/types/span.h"
 #include "backend/common/ids.h"
+#include "backend/datamodel/key.h"
+#include "backend/datamodel/key_range.h"
 #include "backend/locking/handle.h"
+#include "backend/locking/request.h"
 #include "common/clock.h"
 
 namespace google {
@@ -40,12 +50,32 @@ namespace backend {
 // happens via the LockHandle. See LockHandle methods for more details about
 // this interaction.
 //
-// We currently only implement a whole-database lock. The interface is generic
-// to avoid irreversibly baking the single-lock assumption into the rest of the
-// system.
+// Locks are held in shared or exclusive mode on a set of columns within a key
+// range of a table. Two requests from different transactions conflict if they
+// lock overlapping key ranges of the same table with overlapping columns, and
+// at least one of them is exclusive. Non-conflicting transactions proceed
+// concurrently.
+//
+// Conflicts are resolved with wound-wait based on the transaction priority
+// (lower values are older and win, ties are broken by transaction id):
+//   - an older requester wounds (aborts) younger lock holders and takes over
+//     their locks, unless the holder is already committing.
+//   - a younger requester waits for older lock holders to release their locks,
+//     and is aborted if that takes longer than the lock wait timeout.
+// Waits only ever happen from younger to older transactions (or on committing
+// transactions which do not acquire new locks), so deadlocks are impossible.
+//
+// A request with an empty table id locks the whole database (used by schema
+// changes). Database locks never wait: conflicts between a database lock and
+// any other lock abort the requester immediately.
 class LockManager {
  public:
-  explicit LockManager(Clock* clock) : clock_(clock) {}
+  // Default for the maximum time a transaction waits on a conflicting lock.
+  static constexpr absl::Duration kDefaultLockWaitTimeout = absl::Seconds(10);
+
+  explicit LockManager(
+      Clock* clock, absl::Duration lock_wait_timeout = kDefaultLockWaitTimeout)
+      : clock_(clock), lock_wait_timeout_(lock_wait_timeout) {}
 
   // Returns a handle for a single transaction with the given id and priority.
   // Subsequent communication between the transaction and the lock manager
@@ -56,34 +86,173 @@ class LockManager {
   // Returns the timestamp at which last schema update or commit completed.
   absl::Time LastCommitTimestamp();
 
+  // Reserves commit timestamps for the transactions owning 'handles', in order,
+  // under a single acquisition of the lock manager's mutex. Timestamps come
+  // from the clock, so they increase with the position of the handle. Each
+  // result is as returned by LockHandle::ReserveCommitTimestamp.
+  std::vector<absl::StatusOr<absl::Time>> ReserveCommitTimestamps(
+      absl::Span<LockHandle* const> handles) ABSL_LOCKS_EXCLUDED(mu_);
+
+  // Marks the transactions owning 'handles', which all reserved a commit
+  // timestamp, as committed. Readers waiting on their commits are woken once
+  // for the whole group. Returns the status of each handle, in order, as
+  // returned by MarkCommitted.
+  std::vector<absl::Status> MarkGroupCommitted(
+      absl::Span<LockHandle* const> handles) ABSL_LOCKS_EXCLUDED(mu_);
+
  private:
+  // A lock granted to a transaction.
+  struct Lock {
+    LockHandle* holder;
+    LockMode mode;
+    KeyRange key_range;
+    std::vector<ColumnID> column_ids;
+  };
+
+  // Locks granted on a single table. Locks on a single key (or key prefix) K,
+  // i.e. the range [K, K+), are indexed by K since these make up the bulk of
+  // the locks taken by reads and writes. All other ranges are kept in a list.
+  struct TableLocks {
+    std::map<Key, std::vector<Lock>> point_locks;
+    std::vector<Lock> range_locks;
+  };
+
+  // Lock manager state tracked for a single handle.
+  struct HandleState {
+    // Keys of the point locks held by the handle, by table.
+    std::vector<std::pair<TableID, Key>> point_locks;
+
+    // Tables on which the handle holds range locks.
+    absl::flat_hash_set<TableID> range_lock_tables;
+
+    // Requests which could not be granted yet, in the order they were made.
+    std::vector<LockRequest> waiting_requests;
+
+    // True if the handle reserved a commit timestamp. Committing handles are
+    // never wounded.
+    bool committing = false;
+
+    // Commit timestamp reserved by the handle and not yet marked committed.
+    absl::Time pending_commit_timestamp = absl::InfiniteFuture();
+
+    // Tables written by the pending commit, i.e. the tables on which the
+    // handle holds exclusive locks. Unused if the handle holds the database
+    // lock, in which case the commit may write any table.
+    std::vector<TableID> pending_commit_tables;
+  };
+
   // LockHandle simply forwards requests to the LockManager.
   friend class LockHandle;
   void EnqueueLock(LockHandle* handle, const LockRequest& request)
       ABSL_LOCKS_EXCLUDED(mu_);
   void UnlockAll(LockHandle* handle) ABSL_LOCKS_EXCLUDED(mu_);
+  bool IsBlocked(LockHandle* handle) ABSL_LOCKS_EXCLUDED(mu_);
+  void Wait(LockHandle* handle) ABSL_LOCKS_EXCLUDED(mu_);
   absl::StatusOr<absl::Time> ReserveCommitTimestamp(LockHandle* handle)
       ABSL_LOCKS_EXCLUDED(mu_);
   absl::Status MarkCommitted(LockHandle* handle) ABSL_LOCKS_EXCLUDED(mu_);
+
+  // Implementations of ReserveCommitTimestamp and MarkCommitted for callers
+  // which hold the mutex. MarkCommittedLocked does not wake waiting readers.
+  absl::StatusOr<absl::Time> ReserveCommitTimestampLocked(LockHandle* handle)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  absl::Status MarkCommittedLocked(LockHandle* handle)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_);
   void WaitForSafeRead(absl::Time read_time) ABSL_LOCKS_EXCLUDED(mu_);
+  void WaitForSafeRead(absl::Time read_time,
+                       absl::Span<const TableID> table_ids)
+      ABSL_LOCKS_EXCLUDED(mu_);
+
+  // Sleeps until the clock has passed 'read_time', without holding the mutex.
+  // Commits which have not reserved a timestamp by then commit after
+  // 'read_time'.
+  void WaitForReadTime(absl::Time read_time) ABSL_LOCKS_EXCLUDED(mu_);
+
+  // Returns true if a pending commit with a timestamp before 'read_time' may
+  // write one of the tables in 'table_ids'.
+  bool HasPendingCommitOnTables(absl::Time read_time,
+                                absl::Span<const TableID> table_ids) const
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Returns the tables on which the handle holds exclusive locks.
+  std::vector<TableID> ExclusivelyLockedTables(const LockHandle* handle,
+                                               const HandleState& state) const
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Stops tracking the pending commit of the handle, if any.
+  void ClearPendingCommit(HandleState* state)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Attempts to grant the request to the handle, wounding younger conflicting
+  // holders. Returns false and sets the blocking holder if the request has to
+  // wait. Returns true if the request was granted or the handle was aborted.
+  bool TryAcquire(LockHandle* handle, const LockRequest& request,
+                  LockHandle** blocker) ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Grants as many of the waiting requests of the handle as possible, in
+  // order. Returns the holder blocking the first request which cannot be
+  // granted, or nullptr if no requests are left waiting.
+  LockHandle* GrantWaitingRequests(LockHandle* handle)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Returns the handles other than 'handle' holding locks which conflict with
+  // the request.
+  absl::flat_hash_set<LockHandle*> FindConflicts(LockHandle* handle,
+                                                 const LockRequest& request)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Records the request as granted to the handle.
+  void Grant(LockHandle* handle, const LockRequest& request)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Aborts the handle with the given status and releases all its locks.
+  void AbortHandle(LockHandle* handle, const absl::Status& status)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Releases all locks held by the handle and drops its waiting requests.
+  void ReleaseLocks(LockHandle* handle) ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Returns true if the handle holds any locks or is committing.
+  bool IsActive(const LockHandle* handle) const
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_);
 
   // Mutex to guard state below.
   absl::Mutex mu_;
 
-  // The currently active transaction ID (only one transaction can be active).
-  TransactionID active_tid_ ABSL_GUARDED_BY(mu_) = kInvalidTransactionID;
-
   // System wide monotonic clock used to provide commit and read timestamps.
   Clock* clock_;
 
+  // Maximum time a transaction waits on a conflicting lock before aborting.
+  const absl::Duration lock_wait_timeout_;
+
+  // Locks granted on each table.
+  absl::flat_hash_map<TableID, TableLocks> table_locks_ ABSL_GUARDED_BY(mu_);
+
+  // The handle holding the database lock, if any.
+  LockHandle* database_lock_holder_ ABSL_GUARDED_BY(mu_) = nullptr;
+
+  // State for handles which hold, wait on or committed with locks.
+  absl::flat_hash_map<const LockHandle*, HandleState> handles_
+      ABSL_GUARDED_BY(mu_);
+
+  // Signals that locks have been released.
+  absl::CondVar locks_released_cvar_ ABSL_GUARDED_BY(mu_);
+
   // Timestamp at which last schema update or commit completed.
   absl::Time last_commit_timestamp_ ABSL_GUARDED_BY(mu_) = absl::InfinitePast();
 
-  // Commit timestamp being used by an in-progress commit.
-  absl::Time pending_commit_timestamp_ ABSL_GUARDED_BY(mu_) =
-      absl::InfiniteFuture();
+  // Commit timestamps being used by in-progress commits.
+  std::set<absl::Time> pending_commit_timestamps_ ABSL_GUARDED_BY(mu_);
+
+  // Commit timestamps of in-progress commits which hold the database lock, i.e.
+  // schema changes. These may affect reads of any table.
+  std::set<absl::Time> pending_database_commit_timestamps_ ABSL_GUARDED_BY(mu_);
+
+  // Commit timestamps of other in-progress commits, by the tables they write.
+  absl::flat_hash_map<TableID, std::set<absl::Time>>
+      pending_table_commit_timestamps_ ABSL_GUARDED_BY(mu_);
 
-  // Signals completion of pending commit.
+  // Signals completion of a pending commit.
   absl::CondVar pending_commit_cvar_ ABSL_GUARDED_BY(mu_);
 };
 
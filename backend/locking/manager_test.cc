@@ -26,7 +26,11 @@
 #include "gtest/gtest.h"
 #include "zetasql/base/testing/status_matchers.h"
 #include "tests/common/proto_matchers.h"
+#include "absl/synchronization/mutex.h"
 #include "absl/time/clock.h"
+#include "backend/datamodel/key.h"
+#include "backend/datamodel/key_range.h"
+#include "backend/datamodel/value.h"
 
 namespace google {
 namespace spanner {
@@ -35,6 +39,9 @@ namespace backend {
 
 namespace {
 
+using zetasql::values::Int64;
+using zetasql_base::testing::StatusIs;
+
 class LockManagerTest : public testing::Test {
  public:
   LockManagerTest()
@@ -46,10 +53,16 @@ class LockManagerTest : public testing::Test {
 
  private:
   Clock clock_;
-  LockManager manager_ = LockManager(&clock_);
+  LockManager manager_ = LockManager(&clock_, absl::Milliseconds(100));
   LockRequest request_;
 };
 
+LockRequest PointRequest(LockMode mode, int64_t key,
+                         const std::vector<ColumnID>& column_ids = {}) {
+  return LockRequest(mode, "table", KeyRange::Point(Key({Int64(key)})),
+                     column_ids);
+}
+
 TEST_F(LockManagerTest, SingleTransactionAcquiresLock) {
   std::unique_ptr<LockHandle> lh =
       manager()->CreateHandle(TransactionID(1), TransactionPriority(1));
@@ -71,13 +84,255 @@ TEST_F(LockManagerTest, ConcurrentTransactionIsAborted) {
   EXPECT_FALSE(lh1->IsBlocked());
   EXPECT_FALSE(lh1->IsAborted());
 
-  // Second transaction does not get the lock.
+  // Second (younger) transaction waits for the lock and gives up when the
+  // first transaction does not release it in time.
   lh2->EnqueueLock(request());
+  EXPECT_TRUE(lh2->IsBlocked());
+  EXPECT_THAT(lh2->Wait(), StatusIs(absl::StatusCode::kAborted));
   EXPECT_FALSE(lh2->IsBlocked());
   EXPECT_TRUE(lh2->IsAborted());
-  EXPECT_THAT(lh2->Wait(),
-              zetasql_base::testing::StatusIs(absl::StatusCode::kAborted));
-  EXPECT_TRUE(lh2->IsAborted());
+  EXPECT_FALSE(lh1->IsAborted());
+}
+
+TEST_F(LockManagerTest, YoungerTransactionWaitsForOlderTransaction) {
+  std::unique_ptr<LockHandle> lh1 =
+      manager()->CreateHandle(TransactionID(1), TransactionPriority(1));
+  std::unique_ptr<LockHandle> lh2 =
+      manager()->CreateHandle(TransactionID(2), TransactionPriority(2));
+
+  lh1->EnqueueLock(request());
+  ZETASQL_EXPECT_OK(lh1->Wait());
+
+  lh2->EnqueueLock(request());
+  EXPECT_TRUE(lh2->IsBlocked());
+
+  // The waiting transaction gets the lock once the holder releases it.
+  lh1->UnlockAll();
+  ZETASQL_EXPECT_OK(lh2->Wait());
+  EXPECT_FALSE(lh2->IsBlocked());
+}
+
+TEST_F(LockManagerTest, OlderTransactionWoundsYoungerTransaction) {
+  std::unique_ptr<LockHandle> lh1 =
+      manager()->CreateHandle(TransactionID(1), TransactionPriority(2));
+  std::unique_ptr<LockHandle> lh2 =
+      manager()->CreateHandle(TransactionID(2), TransactionPriority(1));
+
+  lh1->EnqueueLock(request());
+  ZETASQL_EXPECT_OK(lh1->Wait());
+
+  // The older transaction takes over the lock and aborts the younger one.
+  lh2->EnqueueLock(request());
+  EXPECT_FALSE(lh2->IsBlocked());
+  ZETASQL_EXPECT_OK(lh2->Wait());
+  EXPECT_TRUE(lh1->IsAborted());
+  EXPECT_THAT(lh1->Wait(), StatusIs(absl::StatusCode::kAborted));
+
+  // The wounded transaction cannot commit.
+  EXPECT_THAT(lh1->ReserveCommitTimestamp(),
+              StatusIs(absl::StatusCode::kAborted));
+
+  // After unlocking, the wounded transaction can be retried.
+  lh1->UnlockAll();
+  EXPECT_FALSE(lh1->IsAborted());
+  lh1->EnqueueLock(request());
+  EXPECT_TRUE(lh1->IsBlocked());
+}
+
+TEST_F(LockManagerTest, CommittingTransactionIsNotWounded) {
+  std::unique_ptr<LockHandle> lh1 =
+      manager()->CreateHandle(TransactionID(1), TransactionPriority(2));
+  std::unique_ptr<LockHandle> lh2 =
+      manager()->CreateHandle(TransactionID(2), TransactionPriority(1));
+
+  lh1->EnqueueLock(request());
+  ZETASQL_EXPECT_OK(lh1->Wait());
+  ZETASQL_EXPECT_OK(lh1->ReserveCommitTimestamp());
+
+  // The older transaction waits for the commit to finish.
+  lh2->EnqueueLock(request());
+  EXPECT_TRUE(lh2->IsBlocked());
+  EXPECT_FALSE(lh1->IsAborted());
+
+  ZETASQL_EXPECT_OK(lh1->MarkCommitted());
+  lh1->UnlockAll();
+  ZETASQL_EXPECT_OK(lh2->Wait());
+}
+
+TEST_F(LockManagerTest, NonConflictingTransactionsProceedConcurrently) {
+  std::unique_ptr<LockHandle> lh1 =
+      manager()->CreateHandle(TransactionID(1), TransactionPriority(1));
+  std::unique_ptr<LockHandle> lh2 =
+      manager()->CreateHandle(TransactionID(2), TransactionPriority(1));
+
+  // Disjoint keys.
+  lh1->EnqueueLock(PointRequest(LockMode::kExclusive, 1));
+  lh2->EnqueueLock(PointRequest(LockMode::kExclusive, 2));
+
+  // Disjoint tables.
+  lh1->EnqueueLock(
+      LockRequest(LockMode::kExclusive, "table1", KeyRange::All(), {}));
+  lh2->EnqueueLock(
+      LockRequest(LockMode::kExclusive, "table2", KeyRange::All(), {}));
+
+  // Disjoint columns.
+  lh1->EnqueueLock(PointRequest(LockMode::kExclusive, 3, {"c1"}));
+  lh2->EnqueueLock(PointRequest(LockMode::kExclusive, 3, {"c2"}));
+
+  // Shared locks.
+  lh1->EnqueueLock(PointRequest(LockMode::kShared, 4));
+  lh2->EnqueueLock(PointRequest(LockMode::kShared, 4));
+
+  EXPECT_FALSE(lh1->IsBlocked());
+  EXPECT_FALSE(lh2->IsBlocked());
+  ZETASQL_EXPECT_OK(lh1->Wait());
+  ZETASQL_EXPECT_OK(lh2->Wait());
+}
+
+TEST_F(LockManagerTest, ConflictingKeyRangesBlock) {
+  std::unique_ptr<LockHandle> lh1 =
+      manager()->CreateHandle(TransactionID(1), TransactionPriority(1));
+  std::unique_ptr<LockHandle> lh2 =
+      manager()->CreateHandle(TransactionID(2), TransactionPriority(1));
+  std::unique_ptr<LockHandle> lh3 =
+      manager()->CreateHandle(TransactionID(3), TransactionPriority(1));
+
+  lh1->EnqueueLock(PointRequest(LockMode::kExclusive, 5, {"c1"}));
+  lh1->EnqueueLock(LockRequest(LockMode::kShared, "table",
+                               KeyRange::Prefix(Key({Int64(7)})), {}));
+  ZETASQL_EXPECT_OK(lh1->Wait());
+
+  // A range read over the locked key conflicts.
+  lh2->EnqueueLock(
+      LockRequest(LockMode::kShared, "table",
+                  KeyRange::ClosedOpen(Key({Int64(1)}), Key({Int64(10)})),
+                  {"c1", "c2"}));
+  EXPECT_TRUE(lh2->IsBlocked());
+
+  // A write to a key covered by the locked prefix conflicts.
+  lh3->EnqueueLock(LockRequest(LockMode::kExclusive, "table",
+                               KeyRange::Point(Key({Int64(7), Int64(1)})),
+                               {"c3"}));
+  EXPECT_TRUE(lh3->IsBlocked());
+
+  lh1->UnlockAll();
+  ZETASQL_EXPECT_OK(lh2->Wait());
+  ZETASQL_EXPECT_OK(lh3->Wait());
+}
+
+TEST_F(LockManagerTest, DatabaseLockConflictsWithAllLocks) {
+  LockRequest database_request(LockMode::kExclusive, "", KeyRange::All(), {});
+  std::unique_ptr<LockHandle> lh1 =
+      manager()->CreateHandle(TransactionID(1), TransactionPriority(2));
+  std::unique_ptr<LockHandle> lh2 =
+      manager()->CreateHandle(TransactionID(2), TransactionPriority(1));
+
+  // Database locks do not wait on, nor wound, active transactions.
+  lh1->EnqueueLock(PointRequest(LockMode::kShared, 1, {"c1"}));
+  ZETASQL_EXPECT_OK(lh1->Wait());
+  lh2->EnqueueLock(database_request);
+  EXPECT_FALSE(lh2->IsBlocked());
+  EXPECT_THAT(lh2->Wait(), StatusIs(absl::StatusCode::kAborted));
+  EXPECT_FALSE(lh1->IsAborted());
+  lh1->UnlockAll();
+  lh2->UnlockAll();
+
+  // Active transactions do not wait on a database lock either.
+  lh2->EnqueueLock(database_request);
+  ZETASQL_EXPECT_OK(lh2->Wait());
+  lh1->EnqueueLock(PointRequest(LockMode::kShared, 1, {"c1"}));
+  EXPECT_FALSE(lh1->IsBlocked());
+  EXPECT_THAT(lh1->Wait(), StatusIs(absl::StatusCode::kAborted));
+  lh1->UnlockAll();
+  EXPECT_THAT(lh1->ReserveCommitTimestamp(),
+              StatusIs(absl::StatusCode::kAborted));
+}
+
+TEST_F(LockManagerTest, LastCommitTimestampTracksLatestCommit) {
+  std::unique_ptr<LockHandle> lh1 =
+      manager()->CreateHandle(TransactionID(1), TransactionPriority(1));
+  std::unique_ptr<LockHandle> lh2 =
+      manager()->CreateHandle(TransactionID(2), TransactionPriority(1));
+
+  lh1->EnqueueLock(PointRequest(LockMode::kExclusive, 1));
+  lh2->EnqueueLock(PointRequest(LockMode::kExclusive, 2));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(absl::Time ts1, lh1->ReserveCommitTimestamp());
+  ZETASQL_ASSERT_OK_AND_ASSIGN(absl::Time ts2, lh2->ReserveCommitTimestamp());
+  EXPECT_LT(ts1, ts2);
+
+  // Commits may complete out of timestamp order.
+  ZETASQL_EXPECT_OK(lh2->MarkCommitted());
+  EXPECT_EQ(manager()->LastCommitTimestamp(), ts2);
+  ZETASQL_EXPECT_OK(lh1->MarkCommitted());
+  EXPECT_EQ(manager()->LastCommitTimestamp(), ts2);
+
+  // Reads at any timestamp are safe once both commits completed.
+  lh1->WaitForSafeRead(ts2);
+}
+
+TEST_F(LockManagerTest, ReadWaitsOnlyForCommitsWritingItsTables) {
+  std::unique_ptr<LockHandle> writer =
+      manager()->CreateHandle(TransactionID(1), TransactionPriority(1));
+  std::unique_ptr<LockHandle> reader =
+      manager()->CreateHandle(TransactionID(2), TransactionPriority(1));
+
+  writer->EnqueueLock(PointRequest(LockMode::kExclusive, 1));
+  writer->EnqueueLock(LockRequest(LockMode::kShared, "read_table",
+                                  KeyRange::All(), {}));
+  ZETASQL_ASSERT_OK(writer->Wait());
+  ZETASQL_ASSERT_OK(writer->ReserveCommitTimestamp());
+  absl::Time read_time = clock()->Now();
+
+  // Tables which the committing transaction only read or did not touch at all
+  // are safe to read.
+  reader->WaitForSafeRead(read_time, {"read_table", "other_table"});
+  reader->WaitForSafeRead(read_time, /*table_ids=*/{});
+
+  std::atomic<bool> read_done(false);
+  std::thread read_thread([&]() {
+    reader->WaitForSafeRead(read_time, {"table"});
+    read_done = true;
+  });
+  absl::SleepFor(absl::Milliseconds(10));
+  EXPECT_FALSE(read_done);
+  ZETASQL_EXPECT_OK(writer->MarkCommitted());
+  read_thread.join();
+  EXPECT_TRUE(read_done);
+}
+
+TEST_F(LockManagerTest, ReadWaitsForSchemaChangeOnAnyTable) {
+  std::unique_ptr<LockHandle> schema_change =
+      manager()->CreateHandle(TransactionID(1), TransactionPriority(1));
+  std::unique_ptr<LockHandle> reader =
+      manager()->CreateHandle(TransactionID(2), TransactionPriority(1));
+
+  schema_change->EnqueueLock(
+      LockRequest(LockMode::kExclusive, "", KeyRange::All(), {}));
+  ZETASQL_ASSERT_OK(schema_change->Wait());
+  ZETASQL_ASSERT_OK(schema_change->ReserveCommitTimestamp());
+  absl::Time read_time = clock()->Now();
+
+  std::atomic<bool> read_done(false);
+  std::thread read_thread([&]() {
+    reader->WaitForSafeRead(read_time, /*table_ids=*/{});
+    read_done = true;
+  });
+  absl::SleepFor(absl::Milliseconds(10));
+  EXPECT_FALSE(read_done);
+
+  // An abandoned commit no longer holds up readers either.
+  schema_change->UnlockAll();
+  read_thread.join();
+  EXPECT_TRUE(read_done);
+}
+
+TEST_F(LockManagerTest, ReadAtFutureTimestampWaitsForTimestamp) {
+  std::unique_ptr<LockHandle> reader =
+      manager()->CreateHandle(TransactionID(1), TransactionPriority(1));
+  absl::Time read_time = clock()->Now() + absl::Milliseconds(20);
+
+  reader->WaitForSafeRead(read_time, {"table"});
+  EXPECT_GT(clock()->Now(), read_time);
 }
 
 TEST_F(LockManagerTest, SequentialTransactionAcquiresLock) {
@@ -92,7 +347,7 @@ TEST_F(LockManagerTest, SequentialTransactionAcquiresLock) {
   lh1->EnqueueLock(request());
   ZETASQL_EXPECT_OK(lh1->Wait());
 
-  // Second transaction does not get the lock yet.
+  // Second transaction does not get the lock in time.
   lh2->EnqueueLock(request());
   EXPECT_THAT(lh2->Wait(),
               zetasql_base::testing::StatusIs(absl::StatusCode::kAborted));
@@ -124,10 +379,16 @@ TEST_F(LockManagerTest, TransactionsThatDidNotAcquireLockCanReleaseIt) {
 TEST_F(LockManagerTest, EnsuresSerializationWithParallelTransactions) {
   // Simulate a thread-safe mvcc store with a single key. Even though multiple
   // threads access this store, they are synchronized by the lock manager.
-  // Concurrent access issues are expected to be caught by tsan.
+  // Transactions which were wounded after reading the value are caught when
+  // they try to reserve a commit timestamp, just like real transactions.
+  absl::Mutex mu;
   std::map<absl::Time, int> value{{absl::InfinitePast(), 0}};
-  auto SetValue = [&value](absl::Time t, int i) { value[t] = i; };
-  auto GetValue = [&value](absl::Time t) {
+  auto SetValue = [&mu, &value](absl::Time t, int i) {
+    absl::MutexLock lock(&mu);
+    value[t] = i;
+  };
+  auto GetValue = [&mu, &value](absl::Time t) {
+    absl::MutexLock lock(&mu);
     auto itr = value.upper_bound(t);
     --itr;
     return itr->second;
@@ -151,6 +412,7 @@ TEST_F(LockManagerTest, EnsuresSerializationWithParallelTransactions) {
 
               // Retry on aborts.
               if (status.code() == absl::StatusCode::kAborted) {
+                lh->UnlockAll();
                 continue;
               } else {
                 ZETASQL_ASSERT_OK(status);
@@ -159,7 +421,16 @@ TEST_F(LockManagerTest, EnsuresSerializationWithParallelTransactions) {
               // We got the lock, increment the counter.
               int cur_value = GetValue(absl::InfiniteFuture());
               int new_value = cur_value + 1;
-              SetValue(clock()->Now(), new_value);
+              absl::StatusOr<absl::Time> commit_timestamp =
+                  lh->ReserveCommitTimestamp();
+              if (commit_timestamp.status().code() ==
+                  absl::StatusCode::kAborted) {
+                lh->UnlockAll();
+                continue;
+              }
+              ZETASQL_ASSERT_OK(commit_timestamp);
+              SetValue(*commit_timestamp, new_value);
+              ZETASQL_ASSERT_OK(lh->MarkCommitted());
 
               // Unlock the lock.
               lh->UnlockAll();
@@ -28,7 +28,8 @@ LockRequest::LockRequest(LockMode mode, TableID table_id,
                          const std::vector<ColumnID>& column_ids)
     : mode_(mode),
       table_id_(table_id),
-      key_range_(key_range),
+      key_range_(key_range.IsClosedOpen() ? key_range
+                                          : key_range.ToClosedOpen()),
       column_ids_(column_ids) {}
 
 }  // namespace backend
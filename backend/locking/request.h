@@ -33,12 +33,31 @@ enum class LockMode {
   kExclusive,
 };
 
+// A pseudo column which represents the existence of a row. Requests which
+// depend on or change whether a row exists include it in their column set, so
+// that they conflict with each other even if their other columns are disjoint.
+// An empty column set already covers all columns including this one.
+constexpr char kRowExistenceColumnID[] = "_exists";
+
 // LockRequest encapsulates a single lock request from a transaction.
+//
+// A request covers the given columns of all rows in the given key range of a
+// table. An empty set of columns covers whole rows. A request with an empty
+// table id represents a lock on the whole database.
 class LockRequest {
  public:
   LockRequest(LockMode mode, TableID table_id, const KeyRange& key_range,
               const std::vector<ColumnID>& column_ids);
 
+  // Accessors.
+  LockMode mode() const { return mode_; }
+  const TableID& table_id() const { return table_id_; }
+  const KeyRange& key_range() const { return key_range_; }
+  const std::vector<ColumnID>& column_ids() const { return column_ids_; }
+
+  // Returns true if this request locks the whole database.
+  bool IsDatabaseLock() const { return table_id_.empty(); }
+
  private:
   // The mode in which we want to acquire the lock.
   LockMode mode_;
@@ -46,7 +65,7 @@ class LockRequest {
   // The table which we want to lock.
   TableID table_id_;
 
-  // The range of keys we want to lock.
+  // The range of keys we want to lock, in closed-open form.
   KeyRange key_range_;
 
   // The columns in this range that we want to lock.
@@ -91,8 +91,22 @@ Catalog::Catalog(const Schema* schema, const FunctionCatalog* function_catalog,
   for (const auto* view : schema->views()) {
     views_[view->Name()] = std::make_unique<QueryableView>(view);
   }
+
+  for (const auto* table : schema->tables()) {
+    for (const auto* index : table->indexes()) {
+      index_tables_[index->Name()] =
+          std::make_unique<QueryableTable>(index, reader);
+    }
+  }
 }
 
+Catalog::Catalog(const Catalog* schema_catalog, RowReader* reader)
+    : schema_(schema_catalog->schema_),
+      schema_catalog_(schema_catalog),
+      reader_(reader),
+      function_catalog_(schema_catalog->function_catalog_),
+      type_factory_(schema_catalog->type_factory_) {}
+
 absl::Status Catalog::GetCatalog(const std::string& name,
                                  zetasql::Catalog** catalog,
                                  const FindOptions& options) {
@@ -108,13 +122,13 @@ absl::Status Catalog::GetTable(const std::string& name,
                                const zetasql::Table** table,
                                const FindOptions& options) {
   *table = nullptr;
-  if (auto it = views_.find(name); it != views_.end()) {
+  if (auto it = views().find(name); it != views().end()) {
     *table = it->second.get();
     return absl::OkStatus();
   }
 
-  if (auto it = tables_.find(name); it != tables_.end()) {
-    *table = it->second.get();
+  if (auto it = tables().find(name); it != tables().end()) {
+    *table = GetBoundTable(it->second.get());
     return absl::OkStatus();
   }
 
@@ -137,8 +151,8 @@ absl::Status Catalog::GetCatalogs(
 
 absl::Status Catalog::GetTables(
     absl::flat_hash_set<const zetasql::Table*>* output) const {
-  for (auto iter = tables_.begin(); iter != tables_.end(); ++iter) {
-    output->insert(iter->second.get());
+  for (auto iter = tables().begin(); iter != tables().end(); ++iter) {
+    output->insert(GetBoundTable(iter->second.get()));
   }
   return absl::OkStatus();
 }
@@ -156,6 +170,9 @@ absl::Status Catalog::GetFunctions(
 }
 
 zetasql::Catalog* Catalog::GetInformationSchemaCatalog() const {
+  if (schema_catalog_ != nullptr) {
+    return schema_catalog_->GetInformationSchemaCatalog();
+  }
   absl::MutexLock lock(&mu_);
   if (!information_schema_catalog_) {
     information_schema_catalog_ =
@@ -165,6 +182,9 @@ zetasql::Catalog* Catalog::GetInformationSchemaCatalog() const {
 }
 
 zetasql::Catalog* Catalog::GetNetFunctionsCatalog() const {
+  if (schema_catalog_ != nullptr) {
+    return schema_catalog_->GetNetFunctionsCatalog();
+  }
   absl::MutexLock lock(&mu_);
   if (!net_catalog_) {
     net_catalog_ = std::make_unique<NetCatalog>(const_cast<Catalog*>(this));
@@ -172,6 +192,28 @@ zetasql::Catalog* Catalog::GetNetFunctionsCatalog() const {
   return net_catalog_.get();
 }
 
+const QueryableTable* Catalog::GetIndexTable(const Index* index) const {
+  auto it = index_tables().find(index->Name());
+  if (it == index_tables().end() || it->second->index() != index) {
+    return nullptr;
+  }
+  return GetBoundTable(it->second.get());
+}
+
+const QueryableTable* Catalog::GetBoundTable(
+    const QueryableTable* table) const {
+  if (schema_catalog_ == nullptr) {
+    return table;
+  }
+  absl::MutexLock lock(&mu_);
+  std::unique_ptr<const QueryableTable>& bound_table =
+      bound_tables_[table->Name()];
+  if (bound_table == nullptr) {
+    bound_table = std::make_unique<QueryableTable>(*table, reader_);
+  }
+  return bound_table.get();
+}
+
 }  // namespace backend
 }  // namespace emulator
 }  // namespace spanner
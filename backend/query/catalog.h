@@ -33,6 +33,7 @@
 #include "backend/query/function_catalog.h"
 #include "backend/query/queryable_table.h"
 #include "backend/query/queryable_view.h"
+#include "backend/schema/catalog/index.h"
 #include "backend/schema/catalog/schema.h"
 #include "absl/status/status.h"
 
@@ -55,11 +56,22 @@ class Catalog : public zetasql::EnumerableCatalog {
               MakeGoogleSqlAnalyzerOptions(),
           RowReader* reader = nullptr);
 
+  // Constructs a catalog which shares the tables, views and sub-catalogs of
+  // 'schema_catalog', but reads table data through 'reader'. Tables are bound
+  // to the reader as they are looked up, so construction is cheap regardless of
+  // the size of the schema. 'schema_catalog' must outlive this catalog.
+  Catalog(const Catalog* schema_catalog, RowReader* reader);
+
   std::string FullName() const final {
     // The name of the root catalog is "".
     return "";
   }
 
+  // Returns the table which reads the data of 'index' through the reader of
+  // this catalog, or nullptr if 'index' is not in the schema of this catalog.
+  const QueryableTable* GetIndexTable(const Index* index) const
+      ABSL_LOCKS_EXCLUDED(mu_);
+
  private:
   friend class NetCatalog;
 
@@ -89,13 +101,46 @@ class Catalog : public zetasql::EnumerableCatalog {
   // Returns the NET catalog.
   zetasql::Catalog* GetNetFunctionsCatalog() const ABSL_LOCKS_EXCLUDED(mu_);
 
+  // Returns the tables and views of the schema, which are owned by
+  // schema_catalog_ if set.
+  const CaseInsensitiveStringMap<std::unique_ptr<const QueryableTable>>&
+  tables() const {
+    return schema_catalog_ != nullptr ? schema_catalog_->tables_ : tables_;
+  }
+  const CaseInsensitiveStringMap<std::unique_ptr<const QueryableView>>& views()
+      const {
+    return schema_catalog_ != nullptr ? schema_catalog_->views_ : views_;
+  }
+  const CaseInsensitiveStringMap<std::unique_ptr<const QueryableTable>>&
+  index_tables() const {
+    return schema_catalog_ != nullptr ? schema_catalog_->index_tables_
+                                      : index_tables_;
+  }
+
+  // Returns the given table of schema_catalog_ bound to reader_ (creating one
+  // if needed).
+  const QueryableTable* GetBoundTable(const QueryableTable* table) const
+      ABSL_LOCKS_EXCLUDED(mu_);
+
   // The backend schema (which is the default schema in this catalog).
   const Schema* schema_ = nullptr;
 
+  // The catalog whose tables, views and sub-catalogs are shared by this one,
+  // or nullptr if this catalog owns them.
+  const Catalog* schema_catalog_ = nullptr;
+
+  // The reader which tables of schema_catalog_ are bound to.
+  RowReader* reader_ = nullptr;
+
   // Tables available in the default schema.
   CaseInsensitiveStringMap<std::unique_ptr<const QueryableTable>> tables_;
   CaseInsensitiveStringMap<std::unique_ptr<const QueryableView>> views_;
 
+  // Tables over the data tables of indexes, keyed by index name. These are
+  // not visible to queries by name.
+  CaseInsensitiveStringMap<std::unique_ptr<const QueryableTable>>
+      index_tables_;
+
   // Functions available in the default schema.
   const FunctionCatalog* function_catalog_ = nullptr;
   zetasql::TypeFactory* type_factory_ = nullptr;
@@ -109,6 +154,10 @@ class Catalog : public zetasql::EnumerableCatalog {
 
   // Sub-catalog for resolving NET function lookup.
   mutable std::unique_ptr<zetasql::Catalog> net_catalog_ ABSL_GUARDED_BY(mu_);
+
+  // Tables of schema_catalog_ bound to reader_ (created only if accessed).
+  mutable CaseInsensitiveStringMap<std::unique_ptr<const QueryableTable>>
+      bound_tables_ ABSL_GUARDED_BY(mu_);
 };
 
 }  // namespace backend
@@ -148,6 +148,36 @@ TEST_F(CatalogTest, GetTablesGetsTheOnlyTable) {
   EXPECT_THAT(output, Contains(Property(&Table::Name, "test_table")));
 }
 
+TEST_F(CatalogTest, CatalogBoundToReaderSharesTables) {
+  Catalog catalog_with_reader(static_cast<const Catalog*>(&catalog()),
+                              /*reader=*/nullptr);
+  zetasql::EnumerableCatalog& bound_catalog = catalog_with_reader;
+
+  const zetasql::Table* table;
+  ZETASQL_ASSERT_OK(catalog().FindTable({"test_table"}, &table, {}));
+  const zetasql::Table* bound_table;
+  ZETASQL_ASSERT_OK(bound_catalog.FindTable({"TEST_TABLE"}, &bound_table, {}));
+
+  // The bound catalog has its own table object, which shares the columns of
+  // the original table and is reused by subsequent lookups.
+  EXPECT_NE(bound_table, table);
+  ASSERT_EQ(bound_table->NumColumns(), table->NumColumns());
+  for (int i = 0; i < table->NumColumns(); ++i) {
+    EXPECT_EQ(bound_table->GetColumn(i), table->GetColumn(i));
+  }
+  const zetasql::Table* bound_table_again;
+  ZETASQL_ASSERT_OK(
+      bound_catalog.FindTable({"test_table"}, &bound_table_again, {}));
+  EXPECT_EQ(bound_table_again, bound_table);
+
+  absl::flat_hash_set<const zetasql::Table*> tables;
+  ZETASQL_EXPECT_OK(bound_catalog.GetTables(&tables));
+  EXPECT_THAT(tables, testing::ElementsAre(bound_table));
+
+  const zetasql::Function* function;
+  ZETASQL_EXPECT_OK(bound_catalog.FindFunction({"COUNT"}, &function, {}));
+}
+
 TEST_F(CatalogTest, FindViewTable) {
   test::ScopedEmulatorFeatureFlagsSetter flag_setter({
       .enable_views = true,
@@ -0,0 +1,270 @@
+//
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "backend/query/index_selection_rewriter.h"
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "zetasql/resolved_ast/resolved_ast.h"
+#include "zetasql/resolved_ast/resolved_column.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+#include "absl/types/span.h"
+#include "backend/query/queryable_column.h"
+#include "backend/query/queryable_table.h"
+#include "backend/schema/catalog/column.h"
+#include "backend/schema/catalog/index.h"
+#include "backend/schema/catalog/table.h"
+#include "zetasql/base/status_macros.h"
+
+namespace google {
+namespace spanner {
+namespace emulator {
+namespace backend {
+
+namespace {
+
+// How tightly a filter constrains a column. Larger values are tighter.
+enum class ColumnConstraint { kNone = 0, kRange = 1, kEquality = 2 };
+
+using ColumnConstraintMap =
+    absl::flat_hash_map<const Column*, ColumnConstraint>;
+
+// Returns true if 'expr' has a single value for the whole scan.
+bool IsConstant(const zetasql::ResolvedExpr* expr) {
+  return expr->node_kind() == zetasql::RESOLVED_LITERAL ||
+         expr->node_kind() == zetasql::RESOLVED_PARAMETER;
+}
+
+// Returns the column of the scan that 'expr' refers to, if 'expr' is a
+// reference to a column of the scan.
+const Column* GetScanColumn(
+    const zetasql::ResolvedExpr* expr,
+    const absl::flat_hash_map<int, const Column*>& scan_columns) {
+  if (expr->node_kind() != zetasql::RESOLVED_COLUMN_REF) {
+    return nullptr;
+  }
+  const auto* column_ref = expr->GetAs<zetasql::ResolvedColumnRef>();
+  auto it = scan_columns.find(column_ref->column().column_id());
+  return it == scan_columns.end() ? nullptr : it->second;
+}
+
+// Records in 'constraints' how the conjunct 'expr' constrains the scan columns.
+// Only comparisons of a column with a constant of the same type are
+// considered, as those are the ones which can be turned into key ranges.
+void CollectConstraints(
+    const zetasql::ResolvedExpr* expr,
+    const absl::flat_hash_map<int, const Column*>& scan_columns,
+    ColumnConstraintMap* constraints) {
+  if (expr->node_kind() != zetasql::RESOLVED_FUNCTION_CALL) {
+    return;
+  }
+  const auto* call = expr->GetAs<zetasql::ResolvedFunctionCall>();
+  const std::string& name = call->function()->Name();
+  const auto& args = call->argument_list();
+  if (name == "$and") {
+    for (const auto& arg : args) {
+      CollectConstraints(arg.get(), scan_columns, constraints);
+    }
+    return;
+  }
+
+  ColumnConstraint constraint;
+  if (name == "$equal" || name == "$in") {
+    constraint = ColumnConstraint::kEquality;
+  } else if (name == "$less" || name == "$less_or_equal" ||
+             name == "$greater" || name == "$greater_or_equal" ||
+             name == "$between") {
+    constraint = ColumnConstraint::kRange;
+  } else {
+    return;
+  }
+  if (args.size() < 2) {
+    return;
+  }
+
+  // The column is the first argument, or the second argument of a binary
+  // comparison written with the constant first.
+  int column_arg = 0;
+  if (args.size() == 2 && IsConstant(args[0].get())) {
+    column_arg = 1;
+  }
+  const Column* column = GetScanColumn(args[column_arg].get(), scan_columns);
+  if (column == nullptr) {
+    return;
+  }
+  for (int i = 0; i < static_cast<int>(args.size()); ++i) {
+    if (i == column_arg) {
+      continue;
+    }
+    if (!IsConstant(args[i].get()) ||
+        !args[i]->type()->Equals(args[column_arg]->type())) {
+      return;
+    }
+  }
+  ColumnConstraint& existing = (*constraints)[column];
+  existing = std::max(existing, constraint);
+}
+
+// Returns the column of the indexed table which 'key_column' refers to.
+const Column* SourceColumn(const KeyColumn* key_column, bool is_index) {
+  return is_index ? key_column->column()->source_column()
+                  : key_column->column();
+}
+
+// Returns how many leading columns of 'key' are constrained by equality,
+// counting one more if the next column is constrained by a range.
+int KeyPrefixScore(absl::Span<const KeyColumn* const> key, bool is_index,
+                   const ColumnConstraintMap& constraints) {
+  int score = 0;
+  for (const KeyColumn* key_column : key) {
+    auto it = constraints.find(SourceColumn(key_column, is_index));
+    if (it == constraints.end()) {
+      break;
+    }
+    ++score;
+    if (it->second != ColumnConstraint::kEquality) {
+      break;
+    }
+  }
+  return score;
+}
+
+// Returns true if reading 'index' returns every row of its indexed table which
+// satisfies the filter.
+bool IndexHasAllFilteredRows(const Index* index,
+                             const ColumnConstraintMap& constraints) {
+  if (!index->is_null_filtered()) {
+    return true;
+  }
+  for (const KeyColumn* key_column : index->key_columns()) {
+    const Column* column = key_column->column()->source_column();
+    if (column->is_nullable() && !constraints.contains(column)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Returns the indexes of the columns of 'index' which store 'columns', or an
+// empty vector if the index does not store all of them.
+std::vector<int> IndexColumnIndexes(const Index* index,
+                                    const std::vector<const Column*>& columns) {
+  absl::Span<const Column* const> index_columns =
+      index->index_data_table()->columns();
+  std::vector<int> column_indexes;
+  column_indexes.reserve(columns.size());
+  for (const Column* column : columns) {
+    auto it = std::find_if(index_columns.begin(), index_columns.end(),
+                           [column](const Column* index_column) {
+                             return index_column->source_column() == column;
+                           });
+    if (it == index_columns.end()) {
+      return {};
+    }
+    column_indexes.push_back(it - index_columns.begin());
+  }
+  return column_indexes;
+}
+
+}  // namespace
+
+absl::Status IndexSelectionRewriter::VisitResolvedFilterScan(
+    const zetasql::ResolvedFilterScan* node) {
+  ZETASQL_RETURN_IF_ERROR(CopyVisitResolvedFilterScan(node));
+  auto* filter_scan = GetUnownedTopOfStack<zetasql::ResolvedFilterScan>();
+
+  const zetasql::ResolvedScan* input_scan = filter_scan->input_scan();
+  if (input_scan->node_kind() != zetasql::RESOLVED_TABLE_SCAN ||
+      input_scan->hint_list_size() > 0) {
+    return absl::OkStatus();
+  }
+  const auto* table_scan = input_scan->GetAs<zetasql::ResolvedTableScan>();
+  if (table_scan->for_system_time_expr() != nullptr ||
+      table_scan->column_index_list_size() != table_scan->column_list_size() ||
+      !table_scan->table()->Is<QueryableTable>()) {
+    return absl::OkStatus();
+  }
+  const auto* queryable_table = table_scan->table()->GetAs<QueryableTable>();
+  if (queryable_table->index() != nullptr) {
+    return absl::OkStatus();
+  }
+  const Table* table = queryable_table->wrapped_table();
+  if (table->indexes().empty()) {
+    return absl::OkStatus();
+  }
+
+  // Map the columns produced by the scan to the columns of the table.
+  std::vector<const Column*> columns;
+  absl::flat_hash_map<int, const Column*> scan_columns;
+  for (int i = 0; i < table_scan->column_list_size(); ++i) {
+    const Column* column =
+        queryable_table->GetColumn(table_scan->column_index_list(i))
+            ->GetAs<QueryableColumn>()
+            ->wrapped_column();
+    columns.push_back(column);
+    scan_columns[table_scan->column_list(i).column_id()] = column;
+  }
+
+  ColumnConstraintMap constraints;
+  CollectConstraints(filter_scan->filter_expr(), scan_columns, &constraints);
+  if (constraints.empty()) {
+    return absl::OkStatus();
+  }
+
+  // Pick the index whose key is constrained the most, if that beats the
+  // primary key.
+  int best_score =
+      KeyPrefixScore(table->primary_key(), /*is_index=*/false, constraints);
+  const Index* best_index = nullptr;
+  std::vector<int> best_column_indexes;
+  for (const Index* index : table->indexes()) {
+    int score = KeyPrefixScore(index->index_data_table()->primary_key(),
+                               /*is_index=*/true, constraints);
+    if (score <= best_score || !IndexHasAllFilteredRows(index, constraints)) {
+      continue;
+    }
+    std::vector<int> column_indexes = IndexColumnIndexes(index, columns);
+    if (column_indexes.size() != columns.size()) {
+      continue;
+    }
+    best_score = score;
+    best_index = index;
+    best_column_indexes = std::move(column_indexes);
+  }
+  if (best_index == nullptr) {
+    return absl::OkStatus();
+  }
+  const QueryableTable* index_table = catalog_->GetIndexTable(best_index);
+  if (index_table == nullptr) {
+    return absl::OkStatus();
+  }
+
+  auto index_scan = zetasql::MakeResolvedTableScan(
+      table_scan->column_list(), index_table, /*for_system_time_expr=*/nullptr);
+  index_scan->set_alias(table_scan->alias());
+  index_scan->set_column_index_list(best_column_indexes);
+  filter_scan->set_input_scan(std::move(index_scan));
+  return absl::OkStatus();
+}
+
+}  // namespace backend
+}  // namespace emulator
+}  // namespace spanner
+}  // namespace google
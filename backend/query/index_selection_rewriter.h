@@ -0,0 +1,56 @@
+//
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef THIRD_PARTY_CLOUD_SPANNER_EMULATOR_BACKEND_QUERY_INDEX_SELECTION_REWRITER_H_
+#define THIRD_PARTY_CLOUD_SPANNER_EMULATOR_BACKEND_QUERY_INDEX_SELECTION_REWRITER_H_
+
+#include "zetasql/resolved_ast/resolved_ast.h"
+#include "zetasql/resolved_ast/resolved_ast_deep_copy_visitor.h"
+#include "absl/status/status.h"
+#include "backend/query/catalog.h"
+
+namespace google {
+namespace spanner {
+namespace emulator {
+namespace backend {
+
+// Implements ResolvedASTDeepCopyVisitor to read filtered table scans from a
+// secondary index when the filter constrains a longer prefix of the index key
+// than of the primary key, and the index stores every column the scan reads.
+//
+// Only scans without hints are rewritten, so FORCE_INDEX always takes
+// precedence. A null-filtered index is only used if none of its key columns
+// can be NULL in the scanned rows: either the column is not nullable or the
+// filter constrains it with a comparison, which is never true for NULL.
+class IndexSelectionRewriter : public zetasql::ResolvedASTDeepCopyVisitor {
+ public:
+  // Index tables are looked up in 'catalog', which must outlive the rewritten
+  // statement.
+  explicit IndexSelectionRewriter(const Catalog* catalog) : catalog_(catalog) {}
+
+  absl::Status VisitResolvedFilterScan(
+      const zetasql::ResolvedFilterScan* node) override;
+
+ private:
+  const Catalog* catalog_;
+};
+
+}  // namespace backend
+}  // namespace emulator
+}  // namespace spanner
+}  // namespace google
+
+#endif  // THIRD_PARTY_CLOUD_SPANNER_EMULATOR_BACKEND_QUERY_INDEX_SELECTION_REWRITER_H_
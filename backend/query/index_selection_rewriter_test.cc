@@ -0,0 +1,149 @@
+//
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "backend/query/index_selection_rewriter.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "zetasql/public/analyzer.h"
+#include "zetasql/public/analyzer_output.h"
+#include "zetasql/public/type.h"
+#include "zetasql/resolved_ast/resolved_ast.h"
+#include "zetasql/resolved_ast/resolved_node_kind.pb.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "zetasql/base/testing/status_matchers.h"
+#include "zetasql/base/ret_check.h"
+#include "absl/status/statusor.h"
+#include "backend/query/analyzer_options.h"
+#include "backend/query/catalog.h"
+#include "backend/query/function_catalog.h"
+#include "backend/query/queryable_table.h"
+#include "backend/schema/catalog/schema.h"
+#include "tests/common/schema_constructor.h"
+#include "zetasql/base/status_macros.h"
+
+namespace google {
+namespace spanner {
+namespace emulator {
+namespace backend {
+
+namespace {
+
+using zetasql_base::testing::IsOkAndHolds;
+
+class IndexSelectionRewriterTest : public testing::Test {
+ protected:
+  // Returns the name of the index the table scan of 'sql' reads after index
+  // selection, or the name of the table if it reads the base table.
+  absl::StatusOr<std::string> ScannedIndexOrTable(const std::string& sql) {
+    // Queries are analyzed with unused columns pruned, as in QueryEngine, so
+    // that scans only read the columns which indexes need to cover.
+    zetasql::AnalyzerOptions options = analyzer_options_;
+    options.set_prune_unused_columns(true);
+    std::unique_ptr<const zetasql::AnalyzerOutput> output;
+    ZETASQL_RETURN_IF_ERROR(zetasql::AnalyzeStatement(sql, options, &catalog_,
+                                                &type_factory_, &output));
+
+    IndexSelectionRewriter rewriter(&catalog_);
+    ZETASQL_RETURN_IF_ERROR(output->resolved_statement()->Accept(&rewriter));
+    ZETASQL_ASSIGN_OR_RETURN(auto statement,
+                     rewriter.ConsumeRootNode<zetasql::ResolvedStatement>());
+
+    std::vector<const zetasql::ResolvedNode*> table_scans;
+    statement->GetDescendantsWithKinds({zetasql::RESOLVED_TABLE_SCAN},
+                                       &table_scans);
+    ZETASQL_RET_CHECK_EQ(table_scans.size(), 1);
+    const auto* table = table_scans[0]
+                            ->GetAs<zetasql::ResolvedTableScan>()
+                            ->table()
+                            ->GetAs<QueryableTable>();
+    return table->index() != nullptr ? table->index()->Name() : table->Name();
+  }
+
+ private:
+  zetasql::TypeFactory type_factory_;
+  std::unique_ptr<const Schema> schema_ =
+      test::CreateSchemaFromDDL(
+          {
+              R"(
+                CREATE TABLE T (
+                  k INT64 NOT NULL,
+                  a INT64,
+                  b STRING(MAX),
+                  c STRING(MAX)
+                ) PRIMARY KEY (k)
+              )",
+              R"(
+                CREATE INDEX TByA ON T(a) STORING (b)
+              )",
+              R"(
+                CREATE NULL_FILTERED INDEX TByB ON T(b)
+              )",
+          },
+          &type_factory_)
+          .value();
+  FunctionCatalog function_catalog_{&type_factory_};
+  zetasql::AnalyzerOptions analyzer_options_ = MakeGoogleSqlAnalyzerOptions();
+  Catalog catalog_{schema_.get(), &function_catalog_, &type_factory_,
+                   analyzer_options_};
+};
+
+TEST_F(IndexSelectionRewriterTest, ReadsCoveringIndexForEqualityOnIndexKey) {
+  EXPECT_THAT(ScannedIndexOrTable("SELECT k, b FROM T WHERE a = 1"),
+              IsOkAndHolds("TByA"));
+  EXPECT_THAT(ScannedIndexOrTable("SELECT k FROM T WHERE a IN (1, 2)"),
+              IsOkAndHolds("TByA"));
+}
+
+TEST_F(IndexSelectionRewriterTest, ReadsCoveringIndexForRangeOnIndexKey) {
+  EXPECT_THAT(ScannedIndexOrTable("SELECT b FROM T WHERE a > 1 AND b != 'x'"),
+              IsOkAndHolds("TByA"));
+}
+
+TEST_F(IndexSelectionRewriterTest, ReadsBaseTableIfIndexDoesNotCover) {
+  EXPECT_THAT(ScannedIndexOrTable("SELECT c FROM T WHERE a = 1"),
+              IsOkAndHolds("T"));
+}
+
+TEST_F(IndexSelectionRewriterTest, ReadsBaseTableIfPrimaryKeyIsAsSelective) {
+  EXPECT_THAT(ScannedIndexOrTable("SELECT b FROM T WHERE k = 1 AND a = 1"),
+              IsOkAndHolds("T"));
+  EXPECT_THAT(ScannedIndexOrTable("SELECT b FROM T WHERE a = k"),
+              IsOkAndHolds("T"));
+}
+
+TEST_F(IndexSelectionRewriterTest, ReadsBaseTableIfScanHasHints) {
+  EXPECT_THAT(ScannedIndexOrTable(
+                  "SELECT b FROM T@{force_index=_base_table} WHERE a = 1"),
+              IsOkAndHolds("T"));
+}
+
+TEST_F(IndexSelectionRewriterTest, ReadsNullFilteredIndexOnlyIfFilterIsStrict) {
+  EXPECT_THAT(ScannedIndexOrTable("SELECT k FROM T WHERE b = 'x'"),
+              IsOkAndHolds("TByB"));
+  EXPECT_THAT(ScannedIndexOrTable("SELECT k FROM T WHERE b IS NULL"),
+              IsOkAndHolds("T"));
+}
+
+}  // namespace
+
+}  // namespace backend
+}  // namespace emulator
+}  // namespace spanner
+}  // namespace google
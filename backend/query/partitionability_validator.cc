@@ -22,6 +22,7 @@
 #include "zetasql/resolved_ast/resolved_node.h"
 #include "zetasql/resolved_ast/resolved_node_kind.pb.h"
 #include "absl/status/status.h"
+#include "backend/query/queryable_table.h"
 #include "common/errors.h"
 #include "zetasql/base/status_macros.h"
 
@@ -85,8 +86,15 @@ absl::Status PartitionabilityValidator::ValidateSimpleScan(
           break;
         }
         return error_status;
-      case zetasql::RESOLVED_TABLE_SCAN:
+      case zetasql::RESOLVED_TABLE_SCAN: {
+        const zetasql::Table* table =
+            current_node->GetAs<zetasql::ResolvedTableScan>()->table();
+        if (table->Is<QueryableTable>() &&
+            table->GetAs<QueryableTable>()->index() == nullptr) {
+          root_table_ = table->Name();
+        }
         return absl::OkStatus();
+      }
       default:
         return error_status;
     }
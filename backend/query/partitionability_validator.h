@@ -17,6 +17,8 @@
 #ifndef THIRD_PARTY_CLOUD_SPANNER_EMULATOR_BACKEND_QUERY_PARTITIONABILITY_VALIDATOR_H_
 #define THIRD_PARTY_CLOUD_SPANNER_EMULATOR_BACKEND_QUERY_PARTITIONABILITY_VALIDATOR_H_
 
+#include <string>
+
 #include "zetasql/resolved_ast/resolved_ast.h"
 #include "zetasql/resolved_ast/resolved_ast_visitor.h"
 #include "absl/status/status.h"
@@ -42,6 +44,11 @@ class PartitionabilityValidator : public zetasql::ResolvedASTVisitor {
     return zetasql::ResolvedASTVisitor::DefaultVisit(node);
   }
 
+  // Returns the name of the table scanned by a partitionable query, if the
+  // scan reads the rows of the table itself rather than of an index. Rows of a
+  // partition of the query are those in a key range of this table.
+  const std::string& root_table() const { return root_table_; }
+
  private:
   // Returns OK if query is partitionable.
   absl::Status ValidatePartitionability(const zetasql::ResolvedNode* node);
@@ -53,6 +60,8 @@ class PartitionabilityValidator : public zetasql::ResolvedASTVisitor {
   bool HasSubquery(const zetasql::ResolvedNode* node);
 
   const Schema* schema_;
+
+  std::string root_table_;
 };
 
 }  // namespace backend
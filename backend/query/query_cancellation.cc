@@ -0,0 +1,57 @@
+//
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include "backend/query/query_cancellation.h"
+
+#include "absl/status/status.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "backend/access/read.h"
+#include "common/errors.h"
+
+namespace google {
+namespace spanner {
+namespace emulator {
+namespace backend {
+
+absl::Status QueryCancellation::Check() const {
+  if (deadline_ != absl::InfiniteFuture() && absl::Now() >= deadline_) {
+    return error::QueryDeadlineExceeded();
+  }
+  if (is_cancelled_ && is_cancelled_()) {
+    return error::QueryCancelled();
+  }
+  return absl::OkStatus();
+}
+
+bool CancellableRowCursor::Next() {
+  if (!status_.ok()) {
+    return false;
+  }
+  if (num_rows_++ % QueryCancellation::kRowsBetweenChecks == 0) {
+    status_ = cancellation_.Check();
+    if (!status_.ok()) {
+      return false;
+    }
+  }
+  return cursor_->Next();
+}
+
+}  // namespace backend
+}  // namespace emulator
+}  // namespace spanner
+}  // namespace google
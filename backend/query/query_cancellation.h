@@ -0,0 +1,119 @@
+//
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#ifndef THIRD_PARTY_CLOUD_SPANNER_EMULATOR_BACKEND_QUERY_QUERY_CANCELLATION_H_
+#define THIRD_PARTY_CLOUD_SPANNER_EMULATOR_BACKEND_QUERY_QUERY_CANCELLATION_H_
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "zetasql/public/type.h"
+#include "zetasql/public/value.h"
+#include "absl/status/status.h"
+#include "absl/time/time.h"
+#include "backend/access/read.h"
+
+namespace google {
+namespace spanner {
+namespace emulator {
+namespace backend {
+
+// QueryCancellation tells a statement when to stop evaluating: once its
+// deadline passes, or once its caller cancels it (e.g. because the client
+// cancelled the RPC which executes the statement).
+//
+// Evaluation polls Check() as rows are read, so a cancelled statement stops
+// reading rows and releases its resources within a bounded number of rows.
+class QueryCancellation {
+ public:
+  // The number of rows read between two calls to Check().
+  static constexpr int kRowsBetweenChecks = 64;
+
+  // A cancellation which never fires.
+  QueryCancellation() = default;
+
+  // 'is_cancelled' may be empty. Otherwise it is called from the thread which
+  // evaluates the statement, and must remain valid while the statement runs.
+  QueryCancellation(absl::Time deadline, std::function<bool()> is_cancelled)
+      : deadline_(deadline), is_cancelled_(std::move(is_cancelled)) {}
+
+  // The time after which evaluation is aborted.
+  absl::Time deadline() const { return deadline_; }
+
+  // Returns DEADLINE_EXCEEDED if the deadline has passed, CANCELLED if the
+  // caller cancelled the statement and OK otherwise.
+  absl::Status Check() const;
+
+  // Returns false if Check() can never fail, in which case callers may skip
+  // polling it.
+  bool can_fire() const {
+    return deadline_ != absl::InfiniteFuture() || is_cancelled_ != nullptr;
+  }
+
+ private:
+  absl::Time deadline_ = absl::InfiniteFuture();
+  std::function<bool()> is_cancelled_;
+};
+
+// A RowCursor which stops returning the rows of another cursor once a
+// QueryCancellation fires. The cancellation is checked before the first row
+// and then every QueryCancellation::kRowsBetweenChecks rows.
+class CancellableRowCursor : public RowCursor {
+ public:
+  CancellableRowCursor(std::unique_ptr<RowCursor> cursor,
+                       QueryCancellation cancellation)
+      : cursor_(std::move(cursor)), cancellation_(std::move(cancellation)) {}
+
+  bool Next() override;
+
+  absl::Status Status() const override {
+    return status_.ok() ? cursor_->Status() : status_;
+  }
+
+  int NumColumns() const override { return cursor_->NumColumns(); }
+
+  const std::string ColumnName(int i) const override {
+    return cursor_->ColumnName(i);
+  }
+
+  const zetasql::Value ColumnValue(int i) const override {
+    return cursor_->ColumnValue(i);
+  }
+
+  const zetasql::Type* ColumnType(int i) const override {
+    return cursor_->ColumnType(i);
+  }
+
+ private:
+  std::unique_ptr<RowCursor> cursor_;
+  QueryCancellation cancellation_;
+
+  // The number of calls to Next() so far, and the error returned by the
+  // cancellation, if it fired.
+  int64_t num_rows_ = 0;
+  absl::Status status_;
+};
+
+}  // namespace backend
+}  // namespace emulator
+}  // namespace spanner
+}  // namespace google
+
+#endif  // THIRD_PARTY_CLOUD_SPANNER_EMULATOR_BACKEND_QUERY_QUERY_CANCELLATION_H_
@@ -0,0 +1,95 @@
+//
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include "backend/query/query_cancellation.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "zetasql/public/type.h"
+#include "zetasql/public/value.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "zetasql/base/testing/status_matchers.h"
+#include "absl/status/status.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "tests/common/row_cursor.h"
+
+namespace google {
+namespace spanner {
+namespace emulator {
+namespace backend {
+
+namespace {
+
+using zetasql_base::testing::StatusIs;
+
+TEST(QueryCancellationTest, DefaultNeverFires) {
+  QueryCancellation cancellation;
+  EXPECT_EQ(cancellation.deadline(), absl::InfiniteFuture());
+  ZETASQL_EXPECT_OK(cancellation.Check());
+}
+
+TEST(QueryCancellationTest, FiresOncePastDeadline) {
+  ZETASQL_EXPECT_OK(
+      QueryCancellation(absl::Now() + absl::Hours(1), nullptr).Check());
+  EXPECT_THAT(QueryCancellation(absl::Now() - absl::Seconds(1), nullptr).Check(),
+              StatusIs(absl::StatusCode::kDeadlineExceeded));
+}
+
+TEST(QueryCancellationTest, FiresOnceCallerCancels) {
+  bool cancelled = false;
+  QueryCancellation cancellation(absl::InfiniteFuture(),
+                                 [&cancelled] { return cancelled; });
+  ZETASQL_EXPECT_OK(cancellation.Check());
+  cancelled = true;
+  EXPECT_THAT(cancellation.Check(), StatusIs(absl::StatusCode::kCancelled));
+}
+
+TEST(CancellableRowCursorTest, StopsReadingRowsOnceCancelled) {
+  std::vector<std::vector<zetasql::Value>> rows;
+  for (int i = 0; i < 2 * QueryCancellation::kRowsBetweenChecks; ++i) {
+    rows.push_back({zetasql::values::Int64(i)});
+  }
+  bool cancelled = false;
+  CancellableRowCursor cursor(
+      std::make_unique<test::TestRowCursor>(
+          std::vector<std::string>{"k"},
+          std::vector<const zetasql::Type*>{zetasql::types::Int64Type()},
+          rows),
+      QueryCancellation(absl::InfiniteFuture(),
+                        [&cancelled] { return cancelled; }));
+
+  // Rows keep being returned until the next check of the cancellation.
+  ASSERT_TRUE(cursor.Next());
+  cancelled = true;
+  for (int i = 1; i < QueryCancellation::kRowsBetweenChecks; ++i) {
+    ASSERT_TRUE(cursor.Next());
+  }
+  EXPECT_FALSE(cursor.Next());
+  EXPECT_THAT(cursor.Status(), StatusIs(absl::StatusCode::kCancelled));
+  EXPECT_FALSE(cursor.Next());
+}
+
+}  // namespace
+
+}  // namespace backend
+}  // namespace emulator
+}  // namespace spanner
+}  // namespace google
@@ -17,6 +17,7 @@
 #include "backend/query/query_engine.h"
 
 #include <cstddef>
+#include <cstdint>
 #include <map>
 #include <memory>
 #include <optional>
@@ -41,11 +42,16 @@
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/substitute.h"
+#include "absl/time/clock.h"
 #include "absl/time/time.h"
 #include "backend/access/read.h"
 #include "backend/access/write.h"
 #include "backend/common/case.h"
+#include "backend/common/memory_tracker.h"
+#include "backend/datamodel/key_range.h"
+#include "backend/datamodel/key_set.h"
 #include "backend/datamodel/value.h"
 #include "backend/query/analyzer_options.h"
 #include "backend/query/catalog.h"
@@ -53,9 +59,13 @@
 #include "backend/query/feature_filter/query_size_limits_checker.h"
 #include "backend/query/hint_rewriter.h"
 #include "backend/query/index_hint_validator.h"
+#include "backend/query/index_selection_rewriter.h"
 #include "backend/query/partitionability_validator.h"
 #include "backend/query/partitioned_dml_validator.h"
+#include "backend/query/query_cancellation.h"
 #include "backend/query/query_engine_options.h"
+#include "backend/query/query_plan_cache.h"
+#include "backend/query/query_stats.h"
 #include "backend/query/query_validator.h"
 #include "backend/query/queryable_column.h"
 #include "backend/query/queryable_table.h"
@@ -115,6 +125,86 @@ class VectorsRowCursor : public RowCursor {
   std::vector<std::vector<zetasql::Value>> column_values_;
 };
 
+// A RowCursor which evaluates a query as its rows are read, so that rows are
+// never all held in memory at once. The cursor keeps the plan of the query
+// alive until it is destroyed.
+//
+// Evaluation is cancelled once 'cancellation' fires. The evaluator enforces the
+// deadline itself, including within operators such as joins which do not
+// return rows for a while, and the cursor polls for cancellation by the caller
+// as rows are returned.
+class EvaluatorRowCursor : public RowCursor {
+ public:
+  EvaluatorRowCursor(
+      std::shared_ptr<const QueryPlan> plan,
+      std::unique_ptr<zetasql::EvaluatorTableIterator> iterator,
+      QueryCancellation cancellation, QueryStats* stats)
+      : plan_(std::move(plan)),
+        iterator_(std::move(iterator)),
+        cancellation_(std::move(cancellation)),
+        stats_(stats) {
+    if (cancellation_.deadline() != absl::InfiniteFuture()) {
+      iterator_->SetDeadline(cancellation_.deadline());
+    }
+  }
+
+  bool Next() override {
+    if (!status_.ok()) {
+      return false;
+    }
+    if (cancellation_.can_fire() &&
+        num_rows_++ % QueryCancellation::kRowsBetweenChecks == 0) {
+      status_ = cancellation_.Check();
+      if (!status_.ok()) {
+        // Cancel is best-effort, the status above is returned regardless.
+        iterator_->Cancel().IgnoreError();
+        return false;
+      }
+    }
+    if (stats_ == nullptr) {
+      return iterator_->NextRow();
+    }
+    absl::Time start = absl::Now();
+    bool has_row = iterator_->NextRow();
+    stats_->evaluation_time += absl::Now() - start;
+    return has_row;
+  }
+
+  absl::Status Status() const override {
+    return status_.ok() ? iterator_->Status() : status_;
+  }
+
+  int NumColumns() const override { return iterator_->NumColumns(); }
+
+  const std::string ColumnName(int i) const override {
+    return iterator_->GetColumnName(i);
+  }
+
+  const zetasql::Type* ColumnType(int i) const override {
+    return iterator_->GetColumnType(i);
+  }
+
+  const zetasql::Value ColumnValue(int i) const override {
+    return iterator_->GetValue(i);
+  }
+
+ private:
+  // The iterator refers to the prepared query of the plan, so it is declared
+  // after the plan to be destroyed first.
+  std::shared_ptr<const QueryPlan> plan_;
+  std::unique_ptr<zetasql::EvaluatorTableIterator> iterator_;
+
+  QueryCancellation cancellation_;
+
+  // Accumulates the time spent evaluating rows, if not null.
+  QueryStats* stats_;
+
+  // The number of calls to Next() so far, and the error returned by the
+  // cancellation, if it fired.
+  int64_t num_rows_ = 0;
+  absl::Status status_;
+};
+
 zetasql::EvaluatorOptions CommonEvaluatorOptions(
     zetasql::TypeFactory* type_factory) {
   zetasql::EvaluatorOptions options;
@@ -123,6 +213,7 @@ zetasql::EvaluatorOptions CommonEvaluatorOptions(
   absl::LoadTimeZone(kDefaultTimeZone, &time_zone);
   options.default_time_zone = time_zone;
   options.scramble_undefined_orderings = true;
+  options.max_intermediate_byte_size = config::max_query_intermediate_bytes();
   return options;
 }
 
@@ -190,8 +281,11 @@ struct ExecuteUpdateResult {
   std::unique_ptr<RowCursor> returning_row_cursor;
 };
 
+// Materializes the rows returned by a THEN RETURN clause, accounting for them
+// in 'memory_tracker' if it is not null.
 absl::StatusOr<std::unique_ptr<RowCursor>> BuildReturningRowResult(
-    std::unique_ptr<zetasql::EvaluatorTableIterator> iterator) {
+    std::unique_ptr<zetasql::EvaluatorTableIterator> iterator,
+    MemoryTracker* memory_tracker) {
   if (iterator == nullptr) {
     return nullptr;
   }
@@ -199,8 +293,13 @@ absl::StatusOr<std::unique_ptr<RowCursor>> BuildReturningRowResult(
   while (iterator->NextRow()) {
     values.emplace_back();
     values.back().reserve(iterator->NumColumns());
+    int64_t row_bytes = 0;
     for (int i = 0; i < iterator->NumColumns(); ++i) {
       values.back().push_back(iterator->GetValue(i));
+      row_bytes += values.back().back().physical_byte_size();
+    }
+    if (memory_tracker != nullptr) {
+      ZETASQL_RETURN_IF_ERROR(memory_tracker->Allocate(row_bytes));
     }
   }
   ZETASQL_RETURN_IF_ERROR(iterator->Status());
@@ -376,19 +475,14 @@ absl::StatusOr<CaseInsensitiveStringSet> PendingCommitTimestampColumnsInUpdate(
 
 absl::StatusOr<ExecuteUpdateResult> EvaluateResolvedInsert(
     const zetasql::ResolvedInsertStmt* insert_statement,
+    zetasql::PreparedModify* prepared_insert,
     const zetasql::ParameterValueMap& parameters,
-    zetasql::TypeFactory* type_factory) {
+    MemoryTracker* memory_tracker) {
   ZETASQL_ASSIGN_OR_RETURN(auto pending_ts_columns,
                    PendingCommitTimestampColumnsInInsert(
                        insert_statement->insert_column_list(),
                        insert_statement->row_list()));
 
-  auto prepared_insert = std::make_unique<zetasql::PreparedModify>(
-      insert_statement, CommonEvaluatorOptions(type_factory));
-  ZETASQL_ASSIGN_OR_RETURN(auto analyzer_options,
-                   MakeAnalyzerOptionsWithParameters(parameters));
-  ZETASQL_RETURN_IF_ERROR(prepared_insert->Prepare(analyzer_options));
-
   std::unique_ptr<zetasql::EvaluatorTableIterator> returning_iter;
   // `returning_iter` can be NULL if there is no THEN RETURN clause.
   auto status_or = prepared_insert->Execute(parameters, {}, &returning_iter);
@@ -397,7 +491,8 @@ absl::StatusOr<ExecuteUpdateResult> EvaluateResolvedInsert(
   }
   auto iterator = std::move(status_or).value();
   ZETASQL_ASSIGN_OR_RETURN(auto cursor,
-                   BuildReturningRowResult(std::move(returning_iter)));
+                   BuildReturningRowResult(std::move(returning_iter),
+                                           memory_tracker));
 
   const auto& mutation_and_count = BuildInsert(
       std::move(iterator), MutationOpType::kInsert, pending_ts_columns);
@@ -407,18 +502,13 @@ absl::StatusOr<ExecuteUpdateResult> EvaluateResolvedInsert(
 
 absl::StatusOr<ExecuteUpdateResult> EvaluateResolvedUpdate(
     const zetasql::ResolvedUpdateStmt* update_statement,
+    zetasql::PreparedModify* prepared_update,
     const zetasql::ParameterValueMap& parameters,
-    zetasql::TypeFactory* type_factory) {
+    MemoryTracker* memory_tracker) {
   ZETASQL_ASSIGN_OR_RETURN(auto pending_ts_columns,
                    PendingCommitTimestampColumnsInUpdate(
                        update_statement->update_item_list()));
 
-  auto prepared_update = std::make_unique<zetasql::PreparedModify>(
-      update_statement, CommonEvaluatorOptions(type_factory));
-  ZETASQL_ASSIGN_OR_RETURN(auto analyzer_options,
-                   MakeAnalyzerOptionsWithParameters(parameters));
-  ZETASQL_RETURN_IF_ERROR(prepared_update->Prepare(analyzer_options));
-
   std::unique_ptr<zetasql::EvaluatorTableIterator> returning_iter;
   auto status_or = prepared_update->Execute(parameters, {}, &returning_iter);
   if (!status_or.ok()) {
@@ -426,7 +516,8 @@ absl::StatusOr<ExecuteUpdateResult> EvaluateResolvedUpdate(
   }
   auto iterator = std::move(status_or).value();
   ZETASQL_ASSIGN_OR_RETURN(auto cursor,
-                   BuildReturningRowResult(std::move(returning_iter)));
+                   BuildReturningRowResult(std::move(returning_iter),
+                                           memory_tracker));
   const auto& mutation_and_count = BuildUpdate(
       std::move(iterator), MutationOpType::kUpdate, pending_ts_columns);
   return ExecuteUpdateResult{mutation_and_count.first,
@@ -434,45 +525,40 @@ absl::StatusOr<ExecuteUpdateResult> EvaluateResolvedUpdate(
 }
 
 absl::StatusOr<ExecuteUpdateResult> EvaluateResolvedDelete(
-    const zetasql::ResolvedDeleteStmt* delete_statement,
+    zetasql::PreparedModify* prepared_delete,
     const zetasql::ParameterValueMap& parameters,
-    zetasql::TypeFactory* type_factory) {
-  auto prepared_delete = std::make_unique<zetasql::PreparedModify>(
-      delete_statement, CommonEvaluatorOptions(type_factory));
-  ZETASQL_ASSIGN_OR_RETURN(auto analyzer_options,
-                   MakeAnalyzerOptionsWithParameters(parameters));
-  ZETASQL_RETURN_IF_ERROR(prepared_delete->Prepare(analyzer_options));
-
+    MemoryTracker* memory_tracker) {
   std::unique_ptr<zetasql::EvaluatorTableIterator> returning_iter;
   ZETASQL_ASSIGN_OR_RETURN(auto iterator,
                    prepared_delete->Execute(parameters, {}, &returning_iter));
   ZETASQL_ASSIGN_OR_RETURN(auto cursor,
-                   BuildReturningRowResult(std::move(returning_iter)));
+                   BuildReturningRowResult(std::move(returning_iter),
+                                           memory_tracker));
 
   const auto& mutation_and_count = BuildDelete(std::move(iterator));
   return ExecuteUpdateResult{mutation_and_count.first,
                              mutation_and_count.second, std::move(cursor)};
 }
 
-// Uses googlesql/public/evaluator to evaluate a DML statement represented by a
-// resolved AST and returns a pair of mutation and count of modified rows.
+// Uses googlesql/public/evaluator to evaluate a prepared DML statement and
+// returns a pair of mutation and count of modified rows.
 absl::StatusOr<ExecuteUpdateResult> EvaluateUpdate(
-    const zetasql::ResolvedStatement* resolved_statement,
-    zetasql::Catalog* catalog, const zetasql::ParameterValueMap& parameters,
-    zetasql::TypeFactory* type_factory) {
+    const QueryPlan& plan, const zetasql::ParameterValueMap& parameters,
+    MemoryTracker* memory_tracker) {
+  ZETASQL_RET_CHECK_NE(plan.prepared_modify, nullptr);
+  const zetasql::ResolvedStatement* resolved_statement = plan.statement.get();
   switch (resolved_statement->node_kind()) {
     case zetasql::RESOLVED_INSERT_STMT:
       return EvaluateResolvedInsert(
           resolved_statement->GetAs<zetasql::ResolvedInsertStmt>(),
-          parameters, type_factory);
+          plan.prepared_modify.get(), parameters, memory_tracker);
     case zetasql::RESOLVED_UPDATE_STMT:
       return EvaluateResolvedUpdate(
           resolved_statement->GetAs<zetasql::ResolvedUpdateStmt>(),
-          parameters, type_factory);
+          plan.prepared_modify.get(), parameters, memory_tracker);
     case zetasql::RESOLVED_DELETE_STMT:
-      return EvaluateResolvedDelete(
-          resolved_statement->GetAs<zetasql::ResolvedDeleteStmt>(),
-          parameters, type_factory);
+      return EvaluateResolvedDelete(plan.prepared_modify.get(), parameters,
+                                    memory_tracker);
     default:
       ZETASQL_RET_CHECK_FAIL() << "Unsupported support node kind "
                        << ResolvedNodeKind_Name(
@@ -481,43 +567,21 @@ absl::StatusOr<ExecuteUpdateResult> EvaluateUpdate(
   }
 }
 
-// Uses googlesql/public/evaluator to evaluate a query statement represented by
-// a resolved AST and returns a row cursor.
+// Uses googlesql/public/evaluator to evaluate a prepared query statement and
+// returns a row cursor which produces the result rows as they are read.
 absl::StatusOr<std::unique_ptr<RowCursor>> EvaluateQuery(
-    const zetasql::ResolvedStatement* resolved_statement,
+    std::shared_ptr<const QueryPlan> plan,
     const zetasql::ParameterValueMap& params,
-    zetasql::TypeFactory* type_factory, int64_t* num_output_rows) {
-  ZETASQL_RET_CHECK_EQ(resolved_statement->node_kind(), zetasql::RESOLVED_QUERY_STMT)
+    const QueryCancellation& cancellation, QueryStats* stats) {
+  ZETASQL_RET_CHECK_NE(plan->prepared_query, nullptr)
       << "input is not a query statement";
-
-  auto prepared_query = std::make_unique<zetasql::PreparedQuery>(
-      resolved_statement->GetAs<zetasql::ResolvedQueryStmt>(),
-      CommonEvaluatorOptions(type_factory));
-  // Call PrepareQuery to set the AnalyzerOptions that we used to Analyze the
-  // statement.
-  ZETASQL_ASSIGN_OR_RETURN(auto analyzer_options,
-                   MakeAnalyzerOptionsWithParameters(params));
-  ZETASQL_RETURN_IF_ERROR(prepared_query->Prepare(analyzer_options));
-  // Finally execute the query.
-  ZETASQL_ASSIGN_OR_RETURN(auto iterator, prepared_query->Execute(params));
-
-  std::vector<std::vector<zetasql::Value>> values;
-  while (iterator->NextRow()) {
-    values.emplace_back();
-    values.back().reserve(iterator->NumColumns());
-    for (int i = 0; i < iterator->NumColumns(); ++i) {
-      values.back().push_back(iterator->GetValue(i));
-    }
+  absl::Time start = absl::Now();
+  ZETASQL_ASSIGN_OR_RETURN(auto iterator, plan->prepared_query->Execute(params));
+  if (stats != nullptr) {
+    stats->evaluation_time += absl::Now() - start;
   }
-  ZETASQL_RETURN_IF_ERROR(iterator->Status());
-  *num_output_rows = values.size();
-  std::vector<std::string> names;
-  std::vector<const zetasql::Type*> types;
-  for (int i = 0; i < iterator->NumColumns(); ++i) {
-    names.push_back(iterator->GetColumnName(i));
-    types.push_back(iterator->GetColumnType(i));
-  }
-  return std::make_unique<VectorsRowCursor>(names, types, values);
+  return std::make_unique<EvaluatorRowCursor>(
+      std::move(plan), std::move(iterator), cancellation, stats);
 }
 
 absl::StatusOr<std::map<std::string, zetasql::Value>> ExtractParameters(
@@ -639,17 +703,156 @@ class ExtractDmlTargetTableVisitor : public zetasql::ResolvedASTVisitor {
   std::optional<std::string> target_table_;
 };
 
+// Returns the key of the plan of 'query' against 'schema'.
+QueryPlanKey MakeQueryPlanKey(const Query& query, const Schema* schema) {
+  QueryPlanKey key;
+  key.schema = schema;
+  key.sql = query.sql;
+  for (const auto& [name, value] : query.declared_params) {
+    absl::StrAppend(&key.declared_params, name, ":",
+                    value.type()->DebugString(), ";");
+  }
+  key.disable_query_null_filtered_index_check =
+      config::disable_query_null_filtered_index_check();
+  key.disable_query_index_selection =
+      config::disable_query_index_selection() || query.partition.has_value();
+  return key;
+}
+
 }  // namespace
 
+void QueryEngine::AddCatalogForSchema(const Schema* schema) {
+  // Cached query plans refer to the catalog of their schema, so an existing
+  // catalog is never replaced.
+  if (HasCatalogForSchema(schema)) {
+    return;
+  }
+  auto catalog = std::make_unique<const Catalog>(schema, &function_catalog_,
+                                                 type_factory_);
+  absl::MutexLock lock(&mu_);
+  catalogs_.try_emplace(schema, std::move(catalog));
+}
+
+std::unique_ptr<Catalog> QueryEngine::MakeCatalog(
+    const Schema* schema, const zetasql::AnalyzerOptions& analyzer_options,
+    RowReader* reader) const {
+  {
+    absl::ReaderMutexLock lock(&mu_);
+    auto itr = catalogs_.find(schema);
+    if (itr != catalogs_.end()) {
+      return std::make_unique<Catalog>(itr->second.get(), reader);
+    }
+  }
+  return std::make_unique<Catalog>(schema, &function_catalog_, type_factory_,
+                                   analyzer_options, reader);
+}
+
+bool QueryEngine::HasCatalogForSchema(const Schema* schema) const {
+  absl::ReaderMutexLock lock(&mu_);
+  return catalogs_.contains(schema);
+}
+
+absl::StatusOr<std::unique_ptr<QueryPlan>> QueryEngine::PrepareQueryPlan(
+    const Query& query, const Schema* schema) const {
+  ZETASQL_ASSIGN_OR_RETURN(auto analyzer_options,
+                   MakeAnalyzerOptionsWithParameters(query.declared_params));
+  // DML statements are evaluated against all columns of their target table, so
+  // unused columns are only pruned from queries.
+  analyzer_options.set_prune_unused_columns(!IsDMLQuery(query.sql));
+
+  absl::Time start = absl::Now();
+  auto plan = std::make_unique<QueryPlan>();
+  plan->catalog = MakeCatalog(schema, analyzer_options, &plan->reader);
+  ZETASQL_ASSIGN_OR_RETURN(
+      plan->analyzer_output,
+      Analyze(query.sql, plan->catalog.get(), analyzer_options, type_factory_));
+  if (IsDMLStmt(plan->analyzer_output->resolved_statement()->node_kind()) &&
+      analyzer_options.prune_unused_columns()) {
+    analyzer_options.set_prune_unused_columns(false);
+    ZETASQL_ASSIGN_OR_RETURN(plan->analyzer_output,
+                     Analyze(query.sql, plan->catalog.get(), analyzer_options,
+                             type_factory_));
+  }
+  absl::Time analyzed = absl::Now();
+  ZETASQL_ASSIGN_OR_RETURN(plan->statement,
+                   ExtractValidatedResolvedStatementAndOptions(
+                       plan->analyzer_output.get(), schema));
+  // Partitions of a query restrict the scan of its root table, so that scan
+  // must keep reading the root table rather than an index.
+  if (!config::disable_query_index_selection() &&
+      !query.partition.has_value()) {
+    IndexSelectionRewriter rewriter(plan->catalog.get());
+    ZETASQL_RETURN_IF_ERROR(plan->statement->Accept(&rewriter));
+    ZETASQL_ASSIGN_OR_RETURN(plan->statement,
+                     rewriter.ConsumeRootNode<zetasql::ResolvedStatement>());
+  }
+
+  absl::Time validated = absl::Now();
+
+  // Prepare the statement with the types of both the declared parameters and
+  // the undeclared parameters, as inferred by the analyzer.
+  ZETASQL_ASSIGN_OR_RETURN(auto evaluator_analyzer_options,
+                   MakeAnalyzerOptionsWithParameters(query.declared_params));
+  for (const auto& [name, type] :
+       plan->analyzer_output->undeclared_parameters()) {
+    ZETASQL_RETURN_IF_ERROR(evaluator_analyzer_options.AddQueryParameter(name, type));
+  }
+  if (IsDMLStmt(plan->statement->node_kind())) {
+    plan->prepared_modify = std::make_unique<zetasql::PreparedModify>(
+        plan->statement.get(), CommonEvaluatorOptions(type_factory_));
+    ZETASQL_RETURN_IF_ERROR(plan->prepared_modify->Prepare(evaluator_analyzer_options));
+  } else {
+    ZETASQL_RET_CHECK_EQ(plan->statement->node_kind(), zetasql::RESOLVED_QUERY_STMT)
+        << "input is not a query statement";
+    plan->prepared_query = std::make_unique<zetasql::PreparedQuery>(
+        plan->statement->GetAs<zetasql::ResolvedQueryStmt>(),
+        CommonEvaluatorOptions(type_factory_));
+    ZETASQL_RETURN_IF_ERROR(plan->prepared_query->Prepare(evaluator_analyzer_options));
+  }
+  if (query.stats != nullptr) {
+    query.stats->analysis_time += analyzed - start;
+    query.stats->validation_time += validated - analyzed;
+    query.stats->preparation_time += absl::Now() - validated;
+  }
+  return plan;
+}
+
+absl::StatusOr<QueryResult> QueryEngine::ExecuteQueryPlan(
+    std::shared_ptr<const QueryPlan> plan, const Query& query,
+    const QueryContext& context) const {
+  ZETASQL_ASSIGN_OR_RETURN(auto params,
+                   ExtractParameters(query, plan->analyzer_output.get()));
+
+  QueryResult result;
+  if (plan->prepared_query != nullptr) {
+    ZETASQL_ASSIGN_OR_RETURN(result.rows,
+                     EvaluateQuery(std::move(plan), params, query.cancellation,
+                                   query.stats));
+  } else {
+    ZETASQL_RET_CHECK_NE(context.writer, nullptr);
+    absl::Time start = absl::Now();
+    ZETASQL_ASSIGN_OR_RETURN(auto execute_update_result,
+                     EvaluateUpdate(*plan, params, query.memory_tracker));
+    ZETASQL_RETURN_IF_ERROR(context.writer->Write(execute_update_result.mutation));
+    if (query.stats != nullptr) {
+      query.stats->evaluation_time += absl::Now() - start;
+    }
+    result.modified_row_count = execute_update_result.modify_row_count;
+    result.rows = std::move(execute_update_result.returning_row_cursor);
+  }
+  return result;
+}
+
 absl::StatusOr<std::string> QueryEngine::GetDmlTargetTable(
     const Query& query, const Schema* schema) const {
   ZETASQL_ASSIGN_OR_RETURN(auto analyzer_options,
                    MakeAnalyzerOptionsWithParameters(query.declared_params));
   analyzer_options.set_prune_unused_columns(true);
-  Catalog catalog(schema, &function_catalog_, type_factory_, analyzer_options);
+  std::unique_ptr<Catalog> catalog =
+      MakeCatalog(schema, analyzer_options, /*reader=*/nullptr);
   ZETASQL_ASSIGN_OR_RETURN(
       auto analyzer_output,
-      Analyze(query.sql, &catalog, analyzer_options, type_factory_));
+      Analyze(query.sql, catalog.get(), analyzer_options, type_factory_));
   ZETASQL_ASSIGN_OR_RETURN(auto params,
                    ExtractParameters(query, analyzer_output.get()));
   ZETASQL_ASSIGN_OR_RETURN(auto statement, ExtractValidatedResolvedStatementAndOptions(
@@ -666,63 +869,68 @@ absl::StatusOr<std::string> QueryEngine::GetDmlTargetTable(
 
 absl::StatusOr<QueryResult> QueryEngine::ExecuteSql(
     const Query& query, const QueryContext& context) const {
-  absl::Time start_time = absl::Now();
-  ZETASQL_ASSIGN_OR_RETURN(auto analyzer_options,
-                   MakeAnalyzerOptionsWithParameters(query.declared_params));
-  analyzer_options.set_prune_unused_columns(true);
-
-  Catalog catalog{context.schema, &function_catalog_, type_factory_,
-                  analyzer_options, context.reader};
-
-  ZETASQL_ASSIGN_OR_RETURN(
-      auto analyzer_output,
-      Analyze(query.sql, &catalog, analyzer_options, type_factory_));
-
-  ZETASQL_ASSIGN_OR_RETURN(auto params,
-                   ExtractParameters(query, analyzer_output.get()));
-
-  ZETASQL_ASSIGN_OR_RETURN(auto resolved_statement,
-                   ExtractValidatedResolvedStatementAndOptions(
-                       analyzer_output.get(), context.schema));
-
-  QueryResult result;
-  if (!IsDMLStmt(analyzer_output->resolved_statement()->node_kind())) {
-    ZETASQL_ASSIGN_OR_RETURN(auto cursor,
-                     EvaluateQuery(resolved_statement.get(), params,
-                                   type_factory_, &result.num_output_rows));
-    result.rows = std::move(cursor);
-  } else {
-    ZETASQL_RET_CHECK_NE(context.writer, nullptr);
-    analyzer_options.set_prune_unused_columns(false);
-    ZETASQL_ASSIGN_OR_RETURN(
-        auto analyzer_output,
-        Analyze(query.sql, &catalog, analyzer_options, type_factory_));
-    ZETASQL_ASSIGN_OR_RETURN(auto resolved_statement,
-                     ExtractValidatedResolvedStatementAndOptions(
-                         analyzer_output.get(), context.schema));
+  ZETASQL_RETURN_IF_ERROR(query.cancellation.Check());
+
+  // Plans are only cached for schemas added with AddCatalogForSchema, which
+  // outlive this engine, so a cached plan never outlives its schema.
+  std::optional<QueryPlanKey> plan_key;
+  std::unique_ptr<QueryPlan> plan;
+  if (HasCatalogForSchema(context.schema)) {
+    plan_key = MakeQueryPlanKey(query, context.schema);
+    plan = plan_cache_.Take(*plan_key);
+  }
+  if (query.stats != nullptr) {
+    query.stats->plan_cache_hit = plan != nullptr;
+  }
+  if (plan == nullptr) {
+    ZETASQL_ASSIGN_OR_RETURN(plan, PrepareQueryPlan(query, context.schema));
+  }
+
+  // The plan is released once the statement no longer needs it, which for a
+  // query is when the caller destroys the result rows. Errors from executing a
+  // plan depend on its parameters and data rather than on the plan, so the
+  // plan is cached regardless.
+  plan->reader.set_reader(context.reader);
+  plan->reader.set_cancellation(query.cancellation);
+  plan->reader.set_stats(query.stats);
+  if (query.partition.has_value()) {
+    std::vector<KeyRange> key_ranges;
+    MakeDisjointKeyRanges(query.partition->key_set, &key_ranges);
+    plan->reader.RestrictTable(query.partition->root_table,
+                               std::move(key_ranges));
+  }
+  std::shared_ptr<QueryPlan> shared_plan(
+      plan.release(), [this, plan_key](QueryPlan* plan) {
+        ReleaseQueryPlan(plan_key, absl::WrapUnique(plan));
+      });
+  return ExecuteQueryPlan(std::move(shared_plan), query, context);
+}
 
-    ZETASQL_ASSIGN_OR_RETURN(auto execute_update_result,
-                     EvaluateUpdate(resolved_statement.get(), &catalog, params,
-                                    type_factory_));
-    ZETASQL_RETURN_IF_ERROR(context.writer->Write(execute_update_result.mutation));
-    result.modified_row_count = execute_update_result.modify_row_count;
-    result.rows = std::move(execute_update_result.returning_row_cursor);
+void QueryEngine::ReleaseQueryPlan(const std::optional<QueryPlanKey>& plan_key,
+                                   std::unique_ptr<QueryPlan> plan) const {
+  plan->reader.set_reader(nullptr);
+  plan->reader.set_cancellation(QueryCancellation());
+  plan->reader.set_stats(nullptr);
+  plan->reader.ClearTableRestriction();
+  if (plan_key.has_value()) {
+    plan_cache_.Put(*plan_key, std::move(plan));
   }
-
-  result.elapsed_time = absl::Now() - start_time;
-  return result;
 }
 
 absl::Status QueryEngine::IsPartitionable(const Query& query,
-                                          const QueryContext& context) const {
+                                          const QueryContext& context,
+                                          std::string* root_table) const {
+  if (root_table != nullptr) {
+    root_table->clear();
+  }
   ZETASQL_ASSIGN_OR_RETURN(auto analyzer_options,
                    MakeAnalyzerOptionsWithParameters(query.declared_params));
   analyzer_options.set_prune_unused_columns(true);
-  Catalog catalog{context.schema, &function_catalog_, type_factory_,
-                  analyzer_options};
+  std::unique_ptr<Catalog> catalog =
+      MakeCatalog(context.schema, analyzer_options, /*reader=*/nullptr);
   ZETASQL_ASSIGN_OR_RETURN(
       auto analyzer_output,
-      Analyze(query.sql, &catalog, analyzer_options, type_factory_));
+      Analyze(query.sql, catalog.get(), analyzer_options, type_factory_));
 
   QueryEngineOptions options;
   ZETASQL_ASSIGN_OR_RETURN(auto resolved_statement,
@@ -734,7 +942,11 @@ absl::Status QueryEngine::IsPartitionable(const Query& query,
 
   // Perform partitionability checks on the query
   PartitionabilityValidator part_validator{context.schema};
-  return resolved_statement->Accept(&part_validator);
+  ZETASQL_RETURN_IF_ERROR(resolved_statement->Accept(&part_validator));
+  if (root_table != nullptr) {
+    *root_table = part_validator.root_table();
+  }
+  return absl::OkStatus();
 }
 
 absl::Status QueryEngine::IsValidPartitionedDML(
@@ -746,11 +958,11 @@ absl::Status QueryEngine::IsValidPartitionedDML(
   ZETASQL_ASSIGN_OR_RETURN(auto analyzer_options,
                    MakeAnalyzerOptionsWithParameters(query.declared_params));
   analyzer_options.set_prune_unused_columns(true);
-  Catalog catalog{context.schema, &function_catalog_, type_factory_,
-                  analyzer_options};
+  std::unique_ptr<Catalog> catalog =
+      MakeCatalog(context.schema, analyzer_options, /*reader=*/nullptr);
   ZETASQL_ASSIGN_OR_RETURN(
       auto analyzer_output,
-      Analyze(query.sql, &catalog, analyzer_options, type_factory_));
+      Analyze(query.sql, catalog.get(), analyzer_options, type_factory_));
 
   ZETASQL_ASSIGN_OR_RETURN(auto resolved_statement,
                    ExtractValidatedResolvedStatementAndOptions(
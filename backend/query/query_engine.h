@@ -17,18 +17,30 @@
 #ifndef THIRD_PARTY_CLOUD_SPANNER_EMULATOR_BACKEND_QUERY_QUERY_ENGINE_H_
 #define THIRD_PARTY_CLOUD_SPANNER_EMULATOR_BACKEND_QUERY_QUERY_ENGINE_H_
 
+#include <map>
 #include <memory>
+#include <optional>
 #include <string>
 
 #include "google/protobuf/struct.pb.h"
+#include "zetasql/public/analyzer_options.h"
 #include "zetasql/public/type.h"
 #include "zetasql/public/value.h"
+#include "absl/base/thread_annotations.h"
+#include "absl/container/node_hash_map.h"
 #include "absl/memory/memory.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/synchronization/mutex.h"
 #include "backend/access/read.h"
 #include "backend/access/write.h"
+#include "backend/common/memory_tracker.h"
+#include "backend/datamodel/key_set.h"
+#include "backend/query/catalog.h"
 #include "backend/query/function_catalog.h"
+#include "backend/query/query_cancellation.h"
+#include "backend/query/query_plan_cache.h"
+#include "backend/query/query_stats.h"
 #include "backend/schema/catalog/schema.h"
 #include "absl/status/status.h"
 
@@ -37,6 +49,17 @@ namespace spanner {
 namespace emulator {
 namespace backend {
 
+// QueryPartition restricts a query to one partition of its rows, as returned
+// by PartitionQuery. Only the rows of the root table of a partitionable query
+// (see QueryEngine::IsPartitionable) with keys in key_set are read.
+struct QueryPartition {
+  // The name of the root table of the query.
+  std::string root_table;
+
+  // The keys of the root table within the partition.
+  KeySet key_set;
+};
+
 // Query specifies the input of a query request.
 struct Query {
   // The SQL string to be executed.
@@ -49,6 +72,24 @@ struct Query {
   // Parameters that did not have a type supplied. They will be deserialized in
   // the backend once the ZetaSQL analyzer provides types.
   std::map<std::string, google::protobuf::Value> undeclared_params;
+
+  // If set, the query is executed for a single partition of its rows.
+  std::optional<QueryPartition> partition;
+
+  // Aborts evaluation of the statement once it fires. For queries, this also
+  // applies to rows read from the QueryResult after ExecuteSql returns.
+  QueryCancellation cancellation;
+  // If not null, accounts for the results the statement materializes, such as
+  // the rows returned by a DML statement with a THEN RETURN clause. Rows of
+  // queries are evaluated as they are read and are not accounted for here.
+  // Intermediate results of the evaluator are limited separately, by
+  // config::max_query_intermediate_bytes().
+  MemoryTracker* memory_tracker = nullptr;
+
+  // If not null, collects execution statistics of the statement. For queries,
+  // statistics keep being collected as rows are read from the QueryResult, so
+  // 'stats' must outlive its rows.
+  QueryStats* stats = nullptr;
 };
 
 // Returns true if the given query is a DML statement.
@@ -57,16 +98,14 @@ bool IsDMLQuery(const std::string& query);
 // QueryResult specifies the output of a query request.
 struct QueryResult {
   // A row cursor containing the query result rows, null for DML requests.
+  // For queries, rows are evaluated as they are read from the cursor, so
+  // evaluation errors are returned by its Status(). The cursor reads through
+  // the reader of the QueryContext, and must be destroyed before that reader
+  // and the QueryEngine which returned it.
   std::unique_ptr<RowCursor> rows;
 
   // The number of modified rows.
   int64_t modified_row_count = 0;
-
-  // The number of rows in the returned row cursor.
-  int64_t num_output_rows = 0;
-
-  // Query execution elapsed time.
-  absl::Duration elapsed_time;
 };
 
 // QueryContext provides resources required to execute a query.
@@ -84,8 +123,22 @@ struct QueryContext {
 // QueryEngine handles SQL-related requests.
 class QueryEngine {
  public:
-  explicit QueryEngine(zetasql::TypeFactory* type_factory)
-      : type_factory_(type_factory), function_catalog_(type_factory) {}
+  // The default number of query plans cached by a QueryEngine.
+  static constexpr int kDefaultPlanCacheCapacity = 1024;
+
+  // Caches the plans of up to 'plan_cache_capacity' recently executed
+  // statements. Only statements against schemas added with
+  // AddCatalogForSchema are cached.
+  explicit QueryEngine(zetasql::TypeFactory* type_factory,
+                       int plan_cache_capacity = kDefaultPlanCacheCapacity)
+      : type_factory_(type_factory),
+        function_catalog_(type_factory),
+        plan_cache_(plan_cache_capacity) {}
+
+  // Builds the query catalog for the given schema. Requests against a schema
+  // added here share its catalog instead of building their own, which is
+  // costly for large schemas. The schema must outlive this engine.
+  void AddCatalogForSchema(const Schema* schema) ABSL_LOCKS_EXCLUDED(mu_);
 
   // Returns the name of the table that a given DML query modifies.
   absl::StatusOr<std::string> GetDmlTargetTable(const Query& query,
@@ -96,9 +149,11 @@ class QueryEngine {
   absl::StatusOr<QueryResult> ExecuteSql(const Query& query,
                                          const QueryContext& context) const;
 
-  // Returns OK if query is partitionable.
-  absl::Status IsPartitionable(const Query& query,
-                               const QueryContext& context) const;
+  // Returns OK if query is partitionable. If 'root_table' is not null, it is
+  // set to the name of the table whose key ranges partition the rows of the
+  // query, or cleared if the query can only be executed as a single partition.
+  absl::Status IsPartitionable(const Query& query, const QueryContext& context,
+                               std::string* root_table = nullptr) const;
 
   // Returns OK if the 'query' is a DML statement that can be executed through
   // partitioned DML.
@@ -109,9 +164,45 @@ class QueryEngine {
 
   const FunctionCatalog* function_catalog() const { return &function_catalog_; }
 
+  // Returns the hit and miss counts of the query plan cache.
+  QueryPlanCacheStats plan_cache_stats() const { return plan_cache_.stats(); }
+
  private:
+  // Returns a catalog for the given schema which reads table data through
+  // 'reader' (which may be null if no data is read).
+  std::unique_ptr<Catalog> MakeCatalog(
+      const Schema* schema, const zetasql::AnalyzerOptions& analyzer_options,
+      RowReader* reader) const ABSL_LOCKS_EXCLUDED(mu_);
+
+  // Returns true if a catalog was added for the given schema.
+  bool HasCatalogForSchema(const Schema* schema) const
+      ABSL_LOCKS_EXCLUDED(mu_);
+
+  // Analyzes, validates and prepares the given query against 'schema'.
+  absl::StatusOr<std::unique_ptr<QueryPlan>> PrepareQueryPlan(
+      const Query& query, const Schema* schema) const;
+
+  // Executes a prepared query plan, reading data through the reader of the
+  // plan. Query results keep the plan until their rows are destroyed.
+  absl::StatusOr<QueryResult> ExecuteQueryPlan(
+      std::shared_ptr<const QueryPlan> plan, const Query& query,
+      const QueryContext& context) const;
+
+  // Detaches a plan from the reader of the request which executed it, and
+  // returns it to the plan cache if it has a key.
+  void ReleaseQueryPlan(const std::optional<QueryPlanKey>& plan_key,
+                        std::unique_ptr<QueryPlan> plan) const;
+
   zetasql::TypeFactory* type_factory_;
   FunctionCatalog function_catalog_;
+
+  // Catalogs for the schemas added with AddCatalogForSchema.
+  mutable absl::Mutex mu_;
+  absl::node_hash_map<const Schema*, std::unique_ptr<const Catalog>> catalogs_
+      ABSL_GUARDED_BY(mu_);
+
+  // Plans of recently executed statements.
+  mutable QueryPlanCache plan_cache_;
 };
 
 }  // namespace backend
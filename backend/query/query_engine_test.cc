@@ -29,11 +29,17 @@
 #include "absl/status/statusor.h"
 #include "absl/strings/match.h"
 #include "absl/strings/str_cat.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
 #include "backend/access/read.h"
 #include "backend/access/write.h"
+#include "backend/common/memory_tracker.h"
+#include "backend/datamodel/key.h"
+#include "backend/datamodel/key_range.h"
 #include "backend/datamodel/key_set.h"
 #include "backend/datamodel/value.h"
 #include "backend/query/catalog.h"
+#include "backend/query/query_cancellation.h"
 #include "backend/schema/catalog/schema.h"
 #include "tests/common/row_reader.h"
 #include "tests/common/schema_constructor.h"
@@ -52,6 +58,7 @@ using testing::AllOf;
 using testing::ElementsAre;
 using testing::Field;
 using testing::IsTrue;
+using testing::Pair;
 using testing::Property;
 using testing::Return;
 using testing::UnorderedElementsAre;
@@ -101,6 +108,42 @@ absl::StatusOr<std::vector<std::vector<zetasql::Value>>> GetAllColumnValues(
   return all_values;
 }
 
+// A RowReader which counts the reads made through it.
+class CountingRowReader : public RowReader {
+ public:
+  explicit CountingRowReader(RowReader* reader) : reader_(reader) {}
+
+  absl::Status Read(const ReadArg& read_arg,
+                    std::unique_ptr<RowCursor>* cursor) override {
+    ++num_reads_;
+    return reader_->Read(read_arg, cursor);
+  }
+
+  int num_reads() const { return num_reads_; }
+
+ private:
+  RowReader* reader_;
+  int num_reads_ = 0;
+};
+
+// A RowReader which records the arguments of the reads made through it.
+class RecordingRowReader : public RowReader {
+ public:
+  explicit RecordingRowReader(RowReader* reader) : reader_(reader) {}
+
+  absl::Status Read(const ReadArg& read_arg,
+                    std::unique_ptr<RowCursor>* cursor) override {
+    read_args_.push_back(read_arg);
+    return reader_->Read(read_arg, cursor);
+  }
+
+  const std::vector<ReadArg>& read_args() const { return read_args_; }
+
+ private:
+  RowReader* reader_;
+  std::vector<ReadArg> read_args_;
+};
+
 class QueryEngineTest : public testing::Test {
  public:
   const Schema* schema() { return schema_.get(); }
@@ -146,6 +189,165 @@ TEST_F(QueryEngineTest, ExecuteSqlSelectsOneFromTable) {
                                ElementsAre(Int64(1)))));
 }
 
+TEST_F(QueryEngineTest, ExecuteSqlUsesCatalogAddedForSchema) {
+  query_engine().AddCatalogForSchema(schema());
+  for (int i = 0; i < 2; ++i) {
+    ZETASQL_ASSERT_OK_AND_ASSIGN(
+        QueryResult result,
+        query_engine().ExecuteSql(
+            Query{"SELECT int64_col FROM test_table WHERE int64_col > 1"},
+            QueryContext{schema(), reader()}));
+    EXPECT_THAT(GetAllColumnValues(std::move(result.rows)),
+                IsOkAndHolds(UnorderedElementsAre(ElementsAre(Int64(2)),
+                                                  ElementsAre(Int64(4)))));
+  }
+}
+
+TEST_F(QueryEngineTest, ExecuteSqlCachesQueryPlans) {
+  query_engine().AddCatalogForSchema(schema());
+  for (int64_t value : {1, 2}) {
+    ZETASQL_ASSERT_OK_AND_ASSIGN(
+        QueryResult result,
+        query_engine().ExecuteSql(
+            Query{"SELECT int64_col FROM test_table WHERE int64_col > @p",
+                  {{"p", Int64(value)}}},
+            QueryContext{schema(), reader()}));
+    EXPECT_THAT(GetAllColumnValues(std::move(result.rows)),
+                IsOkAndHolds(UnorderedElementsAre(ElementsAre(Int64(2)),
+                                                  ElementsAre(Int64(4)))));
+  }
+  EXPECT_THAT(query_engine().plan_cache_stats(),
+              AllOf(Field(&QueryPlanCacheStats::hits, 1),
+                    Field(&QueryPlanCacheStats::misses, 1)));
+
+  // A parameter of a different type needs a different plan.
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      QueryResult result,
+      query_engine().ExecuteSql(
+          Query{"SELECT int64_col FROM test_table WHERE int64_col > @p",
+                {{"p", zetasql::values::Double(3.5)}}},
+          QueryContext{schema(), reader()}));
+  EXPECT_THAT(GetAllColumnValues(std::move(result.rows)),
+              IsOkAndHolds(ElementsAre(ElementsAre(Int64(4)))));
+  EXPECT_THAT(query_engine().plan_cache_stats(),
+              AllOf(Field(&QueryPlanCacheStats::hits, 1),
+                    Field(&QueryPlanCacheStats::misses, 2)));
+}
+
+TEST_F(QueryEngineTest, ExecuteSqlKeepsPlanUntilRowsAreDestroyed) {
+  query_engine().AddCatalogForSchema(schema());
+  Query query{"SELECT int64_col FROM test_table"};
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      QueryResult result,
+      query_engine().ExecuteSql(query, QueryContext{schema(), reader()}));
+
+  // The plan is still in use by the first result, so it is not reused.
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      QueryResult other_result,
+      query_engine().ExecuteSql(query, QueryContext{schema(), reader()}));
+  EXPECT_THAT(query_engine().plan_cache_stats(),
+              Field(&QueryPlanCacheStats::hits, 0));
+
+  result.rows.reset();
+  other_result.rows.reset();
+  ZETASQL_ASSERT_OK(
+      query_engine().ExecuteSql(query, QueryContext{schema(), reader()}));
+  EXPECT_THAT(query_engine().plan_cache_stats(),
+              Field(&QueryPlanCacheStats::hits, 1));
+}
+
+TEST_F(QueryEngineTest, ExecuteSqlEvaluatesQueryAsRowsAreRead) {
+  CountingRowReader counting_reader(reader());
+  ZETASQL_ASSERT_OK_AND_ASSIGN(QueryResult result,
+                       query_engine().ExecuteSql(
+                           Query{"SELECT int64_col FROM test_table"},
+                           QueryContext{schema(), &counting_reader}));
+  EXPECT_EQ(counting_reader.num_reads(), 0);
+  ASSERT_TRUE(result.rows->Next());
+  EXPECT_EQ(counting_reader.num_reads(), 1);
+}
+
+TEST_F(QueryEngineTest, ExecuteSqlReturnsEvaluationErrorsFromRows) {
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      QueryResult result,
+      query_engine().ExecuteSql(
+          Query{"SELECT 1 / (int64_col - 2) FROM test_table"},
+          QueryContext{schema(), reader()}));
+  EXPECT_THAT(GetAllColumnValues(std::move(result.rows)),
+              zetasql_base::testing::StatusIs(absl::StatusCode::kOutOfRange));
+}
+
+TEST_F(QueryEngineTest, ExecuteSqlFailsOncePastDeadline) {
+  Query query{"SELECT int64_col FROM test_table"};
+  query.cancellation =
+      QueryCancellation(absl::Now() - absl::Seconds(1), nullptr);
+  EXPECT_THAT(
+      query_engine().ExecuteSql(query, QueryContext{schema(), reader()}),
+      zetasql_base::testing::StatusIs(absl::StatusCode::kDeadlineExceeded));
+}
+
+TEST_F(QueryEngineTest, ExecuteSqlStopsEvaluatingRowsOnceCancelled) {
+  // A cross join which produces more rows than are returned between two
+  // checks of the cancellation.
+  bool cancelled = false;
+  Query query{
+      "SELECT a.int64_col FROM test_table a, test_table b, test_table c, "
+      "test_table d, test_table e"};
+  query.cancellation =
+      QueryCancellation(absl::InfiniteFuture(), [&cancelled] {
+        return cancelled;
+      });
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      QueryResult result,
+      query_engine().ExecuteSql(query, QueryContext{schema(), reader()}));
+
+  ASSERT_TRUE(result.rows->Next());
+  cancelled = true;
+  int num_rows = 1;
+  while (result.rows->Next()) {
+    ++num_rows;
+  }
+  EXPECT_LE(num_rows, QueryCancellation::kRowsBetweenChecks);
+  EXPECT_THAT(result.rows->Status(),
+              zetasql_base::testing::StatusIs(absl::StatusCode::kCancelled));
+}
+
+TEST_F(QueryEngineTest, ExecuteSqlCollectsStatsAsRowsAreRead) {
+  query_engine().AddCatalogForSchema(schema());
+  for (bool plan_cache_hit : {false, true}) {
+    QueryStats stats;
+    Query query{"SELECT int64_col FROM test_table WHERE int64_col > 1"};
+    query.stats = &stats;
+    ZETASQL_ASSERT_OK_AND_ASSIGN(
+        QueryResult result,
+        query_engine().ExecuteSql(query, QueryContext{schema(), reader()}));
+    EXPECT_TRUE(stats.table_scans.empty());
+
+    ZETASQL_EXPECT_OK(GetAllColumnValues(std::move(result.rows)));
+    EXPECT_EQ(stats.plan_cache_hit, plan_cache_hit);
+    EXPECT_EQ(stats.analysis_time > absl::ZeroDuration(), !plan_cache_hit);
+    EXPECT_GT(stats.evaluation_time, absl::ZeroDuration());
+    EXPECT_THAT(stats.table_scans,
+                ElementsAre(Pair(
+                    "test_table",
+                    AllOf(Field(&TableScanStats::table, "test_table"),
+                          Field(&TableScanStats::index, ""),
+                          Field(&TableScanStats::num_scans, 1),
+                          Field(&TableScanStats::rows_read, 3)))));
+    EXPECT_EQ(stats.rows_scanned(), 3);
+  }
+}
+
+TEST_F(QueryEngineTest, ExecuteSqlDoesNotCachePlansForUnaddedSchemas) {
+  for (int i = 0; i < 2; ++i) {
+    ZETASQL_EXPECT_OK(query_engine().ExecuteSql(Query{"SELECT 1 FROM test_table"},
+                                        QueryContext{schema(), reader()}));
+  }
+  EXPECT_THAT(query_engine().plan_cache_stats(),
+              AllOf(Field(&QueryPlanCacheStats::hits, 0),
+                    Field(&QueryPlanCacheStats::misses, 0)));
+}
+
 TEST_F(QueryEngineTest, ExecuteSqlSelectsOneColumnFromTable) {
   ZETASQL_ASSERT_OK_AND_ASSIGN(
       QueryResult result,
@@ -241,8 +443,43 @@ TEST_F(QueryEngineTest, ExecuteSqlSelectsCountFromTable) {
 
 TEST_F(QueryEngineTest, PartitionableSimpleScan) {
   Query query{"SELECT string_col FROM test_table"};
+  std::string root_table;
   ZETASQL_ASSERT_OK(query_engine().IsPartitionable(
-      query, QueryContext{multi_table_schema(), reader()}));
+      query, QueryContext{multi_table_schema(), reader()}, &root_table));
+  EXPECT_EQ(root_table, "test_table");
+}
+
+TEST_F(QueryEngineTest, PartitionableScanOfIndexHasNoRootTable) {
+  Query query{"SELECT string_col FROM test_table@{force_index=test_index}"};
+  std::string root_table = "test_table";
+  ZETASQL_ASSERT_OK(query_engine().IsPartitionable(
+      query, QueryContext{schema(), reader()}, &root_table));
+  EXPECT_EQ(root_table, "");
+}
+
+TEST_F(QueryEngineTest, ExecuteSqlRestrictsRootTableScanToPartition) {
+  RecordingRowReader recording_reader(reader());
+  Query query{"SELECT int64_col FROM test_table WHERE string_col = 'two'"};
+  query.partition = QueryPartition{
+      .root_table = "test_table",
+      .key_set = KeySet(KeyRange::ClosedOpen(Key({Int64(1)}),
+                                             Key({Int64(3)})))};
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      QueryResult result,
+      query_engine().ExecuteSql(query,
+                                QueryContext{schema(), &recording_reader}));
+  ZETASQL_ASSERT_OK(GetAllColumnValues(std::move(result.rows)).status());
+
+  // The partition reads the base table even though the filter could be
+  // answered from test_index.
+  ASSERT_EQ(recording_reader.read_args().size(), 1);
+  const ReadArg& read_arg = recording_reader.read_args()[0];
+  EXPECT_EQ(read_arg.table, "test_table");
+  EXPECT_EQ(read_arg.index, "");
+  std::vector<KeyRange> key_ranges;
+  MakeDisjointKeyRanges(read_arg.key_set, &key_ranges);
+  EXPECT_THAT(key_ranges, ElementsAre(KeyRange::ClosedOpen(
+                              Key({Int64(1)}), Key({Int64(3)}))));
 }
 
 TEST_F(QueryEngineTest, PartitionableSimpleScanFilter) {
@@ -370,6 +607,31 @@ TEST_F(QueryEngineTest, ExecuteSqlDeleteRows) {
       IsOkAndHolds(Field(&QueryResult::modified_row_count, 2)));
 }
 
+TEST_F(QueryEngineTest, ExecuteSqlReusesCachedDmlPlan) {
+  query_engine().AddCatalogForSchema(schema());
+  MockRowWriter writer;
+  EXPECT_CALL(writer,
+              Write(Property(
+                  &Mutation::ops,
+                  UnorderedElementsAre(AllOf(
+                      Field(&MutationOp::type, MutationOpType::kDelete),
+                      Field(&MutationOp::key_set,
+                            Property(&KeySet::keys, UnorderedElementsAre(
+                                                        Key{{Int64(4)}}))))))))
+      .Times(2)
+      .WillRepeatedly(Return(absl::OkStatus()));
+  for (int i = 0; i < 2; ++i) {
+    EXPECT_THAT(
+        query_engine().ExecuteSql(
+            Query{"DELETE FROM test_table WHERE int64_col > @p",
+                  {{"p", Int64(2)}}},
+            QueryContext{schema(), reader(), &writer}),
+        IsOkAndHolds(Field(&QueryResult::modified_row_count, 1)));
+  }
+  EXPECT_THAT(query_engine().plan_cache_stats(),
+              Field(&QueryPlanCacheStats::hits, 1));
+}
+
 TEST_F(QueryEngineTest, ExecuteSqlUpdatesRows) {
   MockRowWriter writer;
   EXPECT_CALL(
@@ -578,6 +840,21 @@ TEST_F(DmlReturningTest, ExecuteSqlUpdatesReturning) {
                                         ValueList{Int64(4), String("foo")})));
 }
 
+TEST_F(DmlReturningTest, ExecuteSqlFailsIfReturnedRowsExceedMemoryLimit) {
+  MockRowWriter writer;
+  EXPECT_CALL(writer, Write(testing::_)).Times(0);
+
+  MemoryTracker memory_tracker(/*limit_bytes=*/1);
+  Query query{
+      "INSERT INTO test_table (int64_col, string_col) "
+      "VALUES(5, 'five') THEN RETURN *"};
+  query.memory_tracker = &memory_tracker;
+  EXPECT_THAT(
+      query_engine().ExecuteSql(query,
+                                QueryContext{schema(), reader(), &writer}),
+      zetasql_base::testing::StatusIs(absl::StatusCode::kResourceExhausted));
+}
+
 }  // namespace
 
 }  // namespace backend
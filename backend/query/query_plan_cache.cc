@@ -0,0 +1,126 @@
+//
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "backend/query/query_plan_cache.h"
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "zetasql/base/ret_check.h"
+#include "absl/status/status.h"
+#include "absl/synchronization/mutex.h"
+#include "backend/access/read.h"
+#include "backend/datamodel/key_range.h"
+#include "backend/datamodel/key_set.h"
+#include "backend/query/query_cancellation.h"
+#include "backend/query/query_stats.h"
+#include "zetasql/base/status_macros.h"
+
+namespace google {
+namespace spanner {
+namespace emulator {
+namespace backend {
+
+void ForwardingRowReader::RestrictTable(const std::string& table,
+                                        std::vector<KeyRange> key_ranges) {
+  restricted_table_ = table;
+  restricted_key_ranges_ = std::move(key_ranges);
+}
+
+absl::Status ForwardingRowReader::Read(const ReadArg& read_arg,
+                                       std::unique_ptr<RowCursor>* cursor) {
+  ZETASQL_RET_CHECK_NE(reader_, nullptr);
+  if (!restricted_table_.has_value() || read_arg.table != *restricted_table_ ||
+      !read_arg.index.empty()) {
+    ZETASQL_RETURN_IF_ERROR(reader_->Read(read_arg, cursor));
+  } else {
+    std::vector<KeyRange> key_ranges;
+    MakeDisjointKeyRanges(read_arg.key_set, &key_ranges);
+    std::vector<KeyRange> restricted_key_ranges;
+    IntersectDisjointKeyRanges(key_ranges, restricted_key_ranges_,
+                               &restricted_key_ranges);
+    ReadArg restricted_read_arg = read_arg;
+    restricted_read_arg.key_set = KeySet();
+    for (const KeyRange& key_range : restricted_key_ranges) {
+      restricted_read_arg.key_set.AddRange(key_range);
+    }
+    ZETASQL_RETURN_IF_ERROR(reader_->Read(restricted_read_arg, cursor));
+  }
+  if (stats_ != nullptr) {
+    *cursor = std::make_unique<ProfilingRowCursor>(
+        std::move(*cursor),
+        stats_->GetTableScanStats(read_arg.table, read_arg.index));
+  }
+  if (cancellation_.can_fire()) {
+    *cursor =
+        std::make_unique<CancellableRowCursor>(std::move(*cursor), cancellation_);
+  }
+  return absl::OkStatus();
+}
+
+std::unique_ptr<QueryPlan> QueryPlanCache::Take(const QueryPlanKey& key) {
+  absl::MutexLock lock(&mu_);
+  auto it = entries_.find(key);
+  if (it == entries_.end()) {
+    ++stats_.misses;
+    return nullptr;
+  }
+  ++stats_.hits;
+  std::unique_ptr<QueryPlan> plan = std::move(it->second.plan);
+  lru_.erase(it->second.lru_position);
+  entries_.erase(it);
+  return plan;
+}
+
+void QueryPlanCache::Put(const QueryPlanKey& key,
+                         std::unique_ptr<QueryPlan> plan) {
+  if (capacity_ <= 0) {
+    return;
+  }
+  // Plans evicted below are destroyed after the lock is released.
+  std::unique_ptr<QueryPlan> evicted_plan;
+  absl::MutexLock lock(&mu_);
+  auto [it, inserted] = entries_.try_emplace(key);
+  if (inserted) {
+    lru_.push_front(&it->first);
+    it->second.lru_position = lru_.begin();
+  } else {
+    // Another request prepared a plan for the same statement concurrently;
+    // keep the newer one.
+    evicted_plan = std::move(it->second.plan);
+    lru_.splice(lru_.begin(), lru_, it->second.lru_position);
+  }
+  it->second.plan = std::move(plan);
+
+  if (lru_.size() > static_cast<size_t>(capacity_)) {
+    auto lru_it = entries_.find(*lru_.back());
+    evicted_plan = std::move(lru_it->second.plan);
+    lru_.pop_back();
+    entries_.erase(lru_it);
+  }
+}
+
+QueryPlanCacheStats QueryPlanCache::stats() const {
+  absl::MutexLock lock(&mu_);
+  return stats_;
+}
+
+}  // namespace backend
+}  // namespace emulator
+}  // namespace spanner
+}  // namespace google
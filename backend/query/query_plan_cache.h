@@ -0,0 +1,201 @@
+//
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef THIRD_PARTY_CLOUD_SPANNER_EMULATOR_BACKEND_QUERY_QUERY_PLAN_CACHE_H_
+#define THIRD_PARTY_CLOUD_SPANNER_EMULATOR_BACKEND_QUERY_QUERY_PLAN_CACHE_H_
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "zetasql/public/analyzer_output.h"
+#include "zetasql/public/evaluator.h"
+#include "zetasql/resolved_ast/resolved_ast.h"
+#include "absl/base/thread_annotations.h"
+#include "absl/container/node_hash_map.h"
+#include "absl/status/status.h"
+#include "absl/synchronization/mutex.h"
+#include "backend/access/read.h"
+#include "backend/datamodel/key_range.h"
+#include "backend/query/catalog.h"
+#include "backend/query/query_cancellation.h"
+#include "backend/query/query_stats.h"
+#include "backend/schema/catalog/schema.h"
+
+namespace google {
+namespace spanner {
+namespace emulator {
+namespace backend {
+
+// Identifies the plan of a SQL statement.
+struct QueryPlanKey {
+  // The schema the statement was analyzed against. Schemas are immutable, so
+  // this also identifies the schema version.
+  const Schema* schema = nullptr;
+
+  // The SQL text of the statement.
+  std::string sql;
+
+  // The names and types of the declared parameters of the statement.
+  std::string declared_params;
+
+  // Whether the null-filtered index check was disabled when validating the
+  // statement.
+  bool disable_query_null_filtered_index_check = false;
+
+  // Whether filtered table scans were left reading their base tables.
+  bool disable_query_index_selection = false;
+
+  bool operator==(const QueryPlanKey& other) const {
+    return schema == other.schema && sql == other.sql &&
+           declared_params == other.declared_params &&
+           disable_query_null_filtered_index_check ==
+               other.disable_query_null_filtered_index_check &&
+           disable_query_index_selection ==
+               other.disable_query_index_selection;
+  }
+
+  template <typename H>
+  friend H AbslHashValue(H h, const QueryPlanKey& key) {
+    return H::combine(std::move(h), key.schema, key.sql, key.declared_params,
+                      key.disable_query_null_filtered_index_check,
+                      key.disable_query_index_selection);
+  }
+};
+
+// A RowReader which forwards reads to another reader that can be changed
+// between reads.
+//
+// Reads of a table can also be restricted to a set of key ranges, which is how
+// a partition of a root-partitionable query limits the scan of its root table.
+// Rows returned by reads stop once the cancellation of the statement fires,
+// and are recorded in the statistics of the statement if it has any.
+class ForwardingRowReader : public RowReader {
+ public:
+  void set_reader(RowReader* reader) { reader_ = reader; }
+
+  void set_cancellation(QueryCancellation cancellation) {
+    cancellation_ = std::move(cancellation);
+  }
+
+  // 'stats' may be null, and must otherwise outlive the cursors of later reads.
+  void set_stats(QueryStats* stats) { stats_ = stats; }
+
+  // Restricts reads of the rows of 'table' to 'key_ranges', which must be
+  // sorted, disjoint and closed-open. Reads through an index are unaffected.
+  void RestrictTable(const std::string& table,
+                     std::vector<KeyRange> key_ranges);
+
+  // Removes the restriction set by RestrictTable, if any.
+  void ClearTableRestriction() { restricted_table_.reset(); }
+
+  absl::Status Read(const ReadArg& read_arg,
+                    std::unique_ptr<RowCursor>* cursor) override;
+
+ private:
+  RowReader* reader_ = nullptr;
+  QueryCancellation cancellation_;
+  QueryStats* stats_ = nullptr;
+
+  // The name of the restricted table, and the key ranges its reads are
+  // restricted to.
+  std::optional<std::string> restricted_table_;
+  std::vector<KeyRange> restricted_key_ranges_;
+};
+
+// A SQL statement which has been analyzed, validated and prepared for
+// evaluation. The tables of the statement read their data through 'reader',
+// which is pointed at the reader of each request that executes the plan.
+//
+// Members are destroyed in reverse order, so each member only refers to the
+// members declared before it.
+struct QueryPlan {
+  ForwardingRowReader reader;
+
+  // The catalog the statement was analyzed against.
+  std::unique_ptr<Catalog> catalog;
+
+  // The output of the analyzer, which owns the column names and the
+  // undeclared parameters of the statement.
+  std::unique_ptr<const zetasql::AnalyzerOutput> analyzer_output;
+
+  // The validated statement, with hints rewritten and secondary indexes
+  // selected.
+  std::unique_ptr<const zetasql::ResolvedStatement> statement;
+
+  // The prepared statement. Exactly one of these is set, depending on whether
+  // the statement is a query or DML.
+  std::unique_ptr<zetasql::PreparedQuery> prepared_query;
+  std::unique_ptr<zetasql::PreparedModify> prepared_modify;
+};
+
+// Hit and miss counts of a QueryPlanCache.
+struct QueryPlanCacheStats {
+  int64_t hits = 0;
+  int64_t misses = 0;
+};
+
+// A thread-safe, least-recently-used cache of query plans.
+//
+// A plan is taken out of the cache while a request executes it and put back
+// afterwards, so a plan is never executed by two requests at once. Concurrent
+// requests for the same statement prepare plans of their own.
+class QueryPlanCache {
+ public:
+  // A 'capacity' of zero disables the cache.
+  explicit QueryPlanCache(int capacity) : capacity_(capacity) {}
+
+  // Removes the plan for 'key' from the cache and returns it, or returns
+  // nullptr if the cache has no such plan.
+  std::unique_ptr<QueryPlan> Take(const QueryPlanKey& key)
+      ABSL_LOCKS_EXCLUDED(mu_);
+
+  // Adds 'plan' to the cache as the most recently used plan for 'key', evicting
+  // the least recently used plan if the cache is full.
+  void Put(const QueryPlanKey& key, std::unique_ptr<QueryPlan> plan)
+      ABSL_LOCKS_EXCLUDED(mu_);
+
+  QueryPlanCacheStats stats() const ABSL_LOCKS_EXCLUDED(mu_);
+
+ private:
+  struct Entry {
+    std::unique_ptr<QueryPlan> plan;
+
+    // Position of the entry in lru_.
+    std::list<const QueryPlanKey*>::iterator lru_position;
+  };
+
+  const int capacity_;
+
+  mutable absl::Mutex mu_;
+
+  // Cached plans, and their keys ordered from most to least recently used.
+  absl::node_hash_map<QueryPlanKey, Entry> entries_ ABSL_GUARDED_BY(mu_);
+  std::list<const QueryPlanKey*> lru_ ABSL_GUARDED_BY(mu_);
+
+  QueryPlanCacheStats stats_ ABSL_GUARDED_BY(mu_);
+};
+
+}  // namespace backend
+}  // namespace emulator
+}  // namespace spanner
+}  // namespace google
+
+#endif  // THIRD_PARTY_CLOUD_SPANNER_EMULATOR_BACKEND_QUERY_QUERY_PLAN_CACHE_H_
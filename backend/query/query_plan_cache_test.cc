@@ -0,0 +1,155 @@
+//
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "backend/query/query_plan_cache.h"
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "zetasql/public/value.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "zetasql/base/testing/status_matchers.h"
+#include "absl/status/status.h"
+#include "backend/access/read.h"
+#include "backend/datamodel/key.h"
+#include "backend/datamodel/key_range.h"
+#include "backend/datamodel/key_set.h"
+
+namespace google {
+namespace spanner {
+namespace emulator {
+namespace backend {
+
+namespace {
+
+using testing::ElementsAre;
+using testing::Field;
+using testing::IsNull;
+using testing::NotNull;
+
+QueryPlanKey Key(const std::string& sql) {
+  QueryPlanKey key;
+  key.sql = sql;
+  return key;
+}
+
+TEST(QueryPlanCacheTest, TakeRemovesPlanFromCache) {
+  QueryPlanCache cache(/*capacity=*/2);
+  EXPECT_THAT(cache.Take(Key("SELECT 1")), IsNull());
+
+  cache.Put(Key("SELECT 1"), std::make_unique<QueryPlan>());
+  EXPECT_THAT(cache.Take(Key("SELECT 1")), NotNull());
+  EXPECT_THAT(cache.Take(Key("SELECT 1")), IsNull());
+
+  EXPECT_THAT(cache.stats(), Field(&QueryPlanCacheStats::hits, 1));
+  EXPECT_THAT(cache.stats(), Field(&QueryPlanCacheStats::misses, 2));
+}
+
+TEST(QueryPlanCacheTest, KeysDifferInDeclaredParams) {
+  QueryPlanCache cache(/*capacity=*/2);
+  QueryPlanKey int64_key = Key("SELECT @p");
+  int64_key.declared_params = "p:INT64;";
+  QueryPlanKey string_key = Key("SELECT @p");
+  string_key.declared_params = "p:STRING;";
+
+  cache.Put(int64_key, std::make_unique<QueryPlan>());
+  EXPECT_THAT(cache.Take(string_key), IsNull());
+  EXPECT_THAT(cache.Take(int64_key), NotNull());
+}
+
+TEST(QueryPlanCacheTest, EvictsLeastRecentlyUsedPlan) {
+  QueryPlanCache cache(/*capacity=*/2);
+  cache.Put(Key("SELECT 1"), std::make_unique<QueryPlan>());
+  cache.Put(Key("SELECT 2"), std::make_unique<QueryPlan>());
+
+  // Using the first plan makes the second the least recently used.
+  auto plan = cache.Take(Key("SELECT 1"));
+  cache.Put(Key("SELECT 1"), std::move(plan));
+  cache.Put(Key("SELECT 3"), std::make_unique<QueryPlan>());
+
+  EXPECT_THAT(cache.Take(Key("SELECT 2")), IsNull());
+  EXPECT_THAT(cache.Take(Key("SELECT 1")), NotNull());
+  EXPECT_THAT(cache.Take(Key("SELECT 3")), NotNull());
+}
+
+TEST(QueryPlanCacheTest, ZeroCapacityDisablesCache) {
+  QueryPlanCache cache(/*capacity=*/0);
+  cache.Put(Key("SELECT 1"), std::make_unique<QueryPlan>());
+  EXPECT_THAT(cache.Take(Key("SELECT 1")), IsNull());
+}
+
+// A RowReader which records the arguments of the last read.
+class RecordingRowReader : public RowReader {
+ public:
+  absl::Status Read(const ReadArg& read_arg,
+                    std::unique_ptr<RowCursor>* cursor) override {
+    last_read_arg_ = read_arg;
+    return absl::OkStatus();
+  }
+
+  const ReadArg& last_read_arg() const { return last_read_arg_; }
+
+ private:
+  ReadArg last_read_arg_;
+};
+
+TEST(ForwardingRowReaderTest, RestrictsReadsOfTable) {
+  RecordingRowReader recording_reader;
+  ForwardingRowReader reader;
+  reader.set_reader(&recording_reader);
+  reader.RestrictTable(
+      "T", {KeyRange::ClosedOpen(Key({zetasql::values::Int64(1)}),
+                                 Key({zetasql::values::Int64(5)}))});
+
+  ReadArg read_arg;
+  read_arg.table = "T";
+  read_arg.key_set = KeySet::All();
+  std::unique_ptr<RowCursor> cursor;
+  ZETASQL_EXPECT_OK(reader.Read(read_arg, &cursor));
+  std::vector<KeyRange> key_ranges;
+  MakeDisjointKeyRanges(recording_reader.last_read_arg().key_set, &key_ranges);
+  EXPECT_THAT(key_ranges,
+              ElementsAre(KeyRange::ClosedOpen(
+                  Key({zetasql::values::Int64(1)}),
+                  Key({zetasql::values::Int64(5)}))));
+
+  // Other tables and reads through indexes are not restricted.
+  read_arg.table = "U";
+  ZETASQL_EXPECT_OK(reader.Read(read_arg, &cursor));
+  MakeDisjointKeyRanges(recording_reader.last_read_arg().key_set, &key_ranges);
+  EXPECT_THAT(key_ranges, ElementsAre(KeyRange::All()));
+  read_arg.table = "T";
+  read_arg.index = "TByA";
+  ZETASQL_EXPECT_OK(reader.Read(read_arg, &cursor));
+  MakeDisjointKeyRanges(recording_reader.last_read_arg().key_set, &key_ranges);
+  EXPECT_THAT(key_ranges, ElementsAre(KeyRange::All()));
+
+  reader.ClearTableRestriction();
+  read_arg.index = "";
+  ZETASQL_EXPECT_OK(reader.Read(read_arg, &cursor));
+  MakeDisjointKeyRanges(recording_reader.last_read_arg().key_set, &key_ranges);
+  EXPECT_THAT(key_ranges, ElementsAre(KeyRange::All()));
+}
+
+}  // namespace
+
+}  // namespace backend
+}  // namespace emulator
+}  // namespace spanner
+}  // namespace google
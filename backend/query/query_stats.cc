@@ -0,0 +1,60 @@
+//
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "backend/query/query_stats.h"
+
+#include <cstdint>
+#include <string>
+
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "backend/access/read.h"
+
+namespace google {
+namespace spanner {
+namespace emulator {
+namespace backend {
+
+TableScanStats* QueryStats::GetTableScanStats(const std::string& table,
+                                              const std::string& index) {
+  TableScanStats& stats = table_scans[index.empty() ? table : index];
+  stats.table = table;
+  stats.index = index;
+  return &stats;
+}
+
+int64_t QueryStats::rows_scanned() const {
+  int64_t rows = 0;
+  for (const auto& [name, stats] : table_scans) {
+    rows += stats.rows_read;
+  }
+  return rows;
+}
+
+bool ProfilingRowCursor::Next() {
+  absl::Time start = absl::Now();
+  bool has_row = cursor_->Next();
+  stats_->read_time += absl::Now() - start;
+  if (has_row) {
+    ++stats_->rows_read;
+  }
+  return has_row;
+}
+
+}  // namespace backend
+}  // namespace emulator
+}  // namespace spanner
+}  // namespace google
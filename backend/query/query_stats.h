@@ -0,0 +1,135 @@
+//
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef THIRD_PARTY_CLOUD_SPANNER_EMULATOR_BACKEND_QUERY_QUERY_STATS_H_
+#define THIRD_PARTY_CLOUD_SPANNER_EMULATOR_BACKEND_QUERY_QUERY_STATS_H_
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "zetasql/public/type.h"
+#include "zetasql/public/value.h"
+#include "absl/status/status.h"
+#include "absl/time/time.h"
+#include "backend/access/read.h"
+
+namespace google {
+namespace spanner {
+namespace emulator {
+namespace backend {
+
+// Statistics of the reads of one table or index by a statement.
+struct TableScanStats {
+  // The name of the table which was read.
+  std::string table;
+
+  // The name of the index the table was read through, or empty if the base
+  // table was read.
+  std::string index;
+
+  // The number of times the table was read, e.g. once per row of the outer
+  // side of a join for the inner side.
+  int64_t num_scans = 0;
+
+  // The number of rows read from storage.
+  int64_t rows_read = 0;
+
+  // The time spent reading those rows from storage.
+  absl::Duration read_time;
+};
+
+// QueryStats collects execution statistics of a single statement, which are
+// returned for queries executed in PROFILE mode.
+//
+// Durations are wall time. Time spent reading tables is also included in the
+// evaluation time, as tables are read by the evaluator as it needs their rows.
+// A QueryStats is not thread-safe, and is only updated by the thread which
+// executes the statement and reads its result rows.
+struct QueryStats {
+  // Whether the plan of the statement was found in the query plan cache, in
+  // which case the analysis, validation and preparation times are zero.
+  bool plan_cache_hit = false;
+
+  // Time spent analyzing the SQL text into a resolved statement.
+  absl::Duration analysis_time;
+
+  // Time spent validating the resolved statement and rewriting it, e.g. to
+  // read from a secondary index.
+  absl::Duration validation_time;
+
+  // Time spent preparing the resolved statement for evaluation.
+  absl::Duration preparation_time;
+
+  // Time spent evaluating the statement, including reading its result rows for
+  // a query and writing its mutation for DML.
+  absl::Duration evaluation_time;
+
+  // Statistics of each table and index read by the statement, keyed by the
+  // name of the index if it was read, and by the name of the table otherwise.
+  std::map<std::string, TableScanStats> table_scans;
+
+  // Returns the statistics of reads of 'table' through 'index', adding them if
+  // this is the first read. The returned pointer remains valid for the life
+  // of this object.
+  TableScanStats* GetTableScanStats(const std::string& table,
+                                    const std::string& index);
+
+  // Returns the total number of rows read from storage.
+  int64_t rows_scanned() const;
+};
+
+// A RowCursor which records the rows it reads from another cursor, and the time
+// spent reading them, in the statistics of one table scan.
+class ProfilingRowCursor : public RowCursor {
+ public:
+  // 'stats' must outlive this cursor. Counts one scan in 'stats'.
+  ProfilingRowCursor(std::unique_ptr<RowCursor> cursor, TableScanStats* stats)
+      : cursor_(std::move(cursor)), stats_(stats) {
+    ++stats_->num_scans;
+  }
+
+  bool Next() override;
+
+  absl::Status Status() const override { return cursor_->Status(); }
+
+  int NumColumns() const override { return cursor_->NumColumns(); }
+
+  const std::string ColumnName(int i) const override {
+    return cursor_->ColumnName(i);
+  }
+
+  const zetasql::Value ColumnValue(int i) const override {
+    return cursor_->ColumnValue(i);
+  }
+
+  const zetasql::Type* ColumnType(int i) const override {
+    return cursor_->ColumnType(i);
+  }
+
+ private:
+  std::unique_ptr<RowCursor> cursor_;
+  TableScanStats* stats_;
+};
+
+}  // namespace backend
+}  // namespace emulator
+}  // namespace spanner
+}  // namespace google
+
+#endif  // THIRD_PARTY_CLOUD_SPANNER_EMULATOR_BACKEND_QUERY_QUERY_STATS_H_
@@ -0,0 +1,82 @@
+//
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "backend/query/query_stats.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "zetasql/public/type.h"
+#include "zetasql/public/value.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "zetasql/base/testing/status_matchers.h"
+#include "tests/common/row_cursor.h"
+
+namespace google {
+namespace spanner {
+namespace emulator {
+namespace backend {
+
+namespace {
+
+std::unique_ptr<RowCursor> MakeCursor(int num_rows) {
+  std::vector<std::vector<zetasql::Value>> rows;
+  for (int i = 0; i < num_rows; ++i) {
+    rows.push_back({zetasql::values::Int64(i)});
+  }
+  return std::make_unique<test::TestRowCursor>(
+      std::vector<std::string>{"k"},
+      std::vector<const zetasql::Type*>{zetasql::types::Int64Type()}, rows);
+}
+
+TEST(QueryStatsTest, KeysTableScansByIndexOrTable) {
+  QueryStats stats;
+  TableScanStats* table_stats = stats.GetTableScanStats("T", "");
+  TableScanStats* index_stats = stats.GetTableScanStats("T", "TByA");
+  EXPECT_NE(table_stats, index_stats);
+  EXPECT_EQ(stats.GetTableScanStats("T", ""), table_stats);
+  EXPECT_EQ(index_stats->table, "T");
+  EXPECT_EQ(index_stats->index, "TByA");
+  EXPECT_EQ(stats.table_scans.size(), 2);
+}
+
+TEST(ProfilingRowCursorTest, CountsScansAndRowsRead) {
+  QueryStats stats;
+  TableScanStats* table_stats = stats.GetTableScanStats("T", "");
+  {
+    ProfilingRowCursor cursor(MakeCursor(3), table_stats);
+    while (cursor.Next()) {
+    }
+    ZETASQL_EXPECT_OK(cursor.Status());
+  }
+  {
+    ProfilingRowCursor cursor(MakeCursor(2), table_stats);
+    ASSERT_TRUE(cursor.Next());
+    EXPECT_EQ(cursor.ColumnValue(0), zetasql::values::Int64(0));
+  }
+  EXPECT_EQ(table_stats->num_scans, 2);
+  EXPECT_EQ(table_stats->rows_read, 4);
+  EXPECT_EQ(stats.rows_scanned(), 4);
+}
+
+}  // namespace
+
+}  // namespace backend
+}  // namespace emulator
+}  // namespace spanner
+}  // namespace google
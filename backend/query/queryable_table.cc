@@ -17,6 +17,7 @@
 #include "backend/query/queryable_table.h"
 
 #include <algorithm>
+#include <atomic>
 #include <memory>
 #include <optional>
 #include <string>
@@ -28,11 +29,18 @@
 #include "zetasql/public/analyzer_output.h"
 #include "zetasql/public/evaluator_table_iterator.h"
 #include "zetasql/public/value.h"
+#include "absl/container/flat_hash_map.h"
 #include "absl/memory/memory.h"
 #include "absl/status/statusor.h"
 #include "absl/types/span.h"
 #include "backend/access/read.h"
+#include "backend/datamodel/key.h"
+#include "backend/datamodel/key_range.h"
+#include "backend/datamodel/key_set.h"
 #include "backend/query/queryable_column.h"
+#include "backend/schema/catalog/column.h"
+#include "common/errors.h"
+#include "zetasql/base/ret_check.h"
 #include "absl/status/status.h"
 
 namespace google {
@@ -40,31 +48,172 @@ namespace spanner {
 namespace emulator {
 namespace backend {
 
+namespace {
+
+// Maximum number of keys or key ranges derived from the column filters of a
+// single table scan. Filters which would produce more are ignored.
+constexpr int kMaxKeyRangesFromColumnFilters = 1000;
+
+// Returns true if 'value' can be a value of the key column 'column'.
+bool IsKeyColumnValue(const zetasql::Value& value, const Column* column) {
+  return value.is_valid() && !value.is_null() &&
+         value.type()->Equals(column->GetType());
+}
+
+// Returns a key set which contains the keys of all rows of 'table' which
+// satisfy 'filters', a map from columns of 'table' to filters on their values.
+// Keys are derived from filters on the longest prefix of the primary key which
+// has IN-list filters, followed by at most one range filter.
+KeySet KeySetFromColumnFilters(
+    const backend::Table* table,
+    const absl::flat_hash_map<const Column*, const zetasql::ColumnFilter*>&
+        filters) {
+  std::vector<Key> prefixes = {Key()};
+  for (const KeyColumn* key_column : table->primary_key()) {
+    auto it = filters.find(key_column->column());
+    if (it == filters.end()) {
+      break;
+    }
+    const zetasql::ColumnFilter* filter = it->second;
+
+    if (filter->kind() == zetasql::ColumnFilter::kInList) {
+      std::vector<zetasql::Value> values;
+      for (const zetasql::Value& value : filter->in_list()) {
+        // NULL never compares equal to a key value, so it can be skipped.
+        if (value.is_valid() && value.is_null()) {
+          continue;
+        }
+        if (!IsKeyColumnValue(value, key_column->column())) {
+          values.clear();
+          break;
+        }
+        values.push_back(value);
+      }
+      if (values.empty() ||
+          prefixes.size() * values.size() >
+              static_cast<size_t>(kMaxKeyRangesFromColumnFilters)) {
+        break;
+      }
+      std::vector<Key> extended_prefixes;
+      extended_prefixes.reserve(prefixes.size() * values.size());
+      for (const Key& prefix : prefixes) {
+        for (const zetasql::Value& value : values) {
+          extended_prefixes.push_back(prefix);
+          extended_prefixes.back().AddColumn(value);
+        }
+      }
+      prefixes = std::move(extended_prefixes);
+      continue;
+    }
+
+    // A range filter ends the prefix. Its bounds are inclusive and either may
+    // be missing. Ranges of descending columns start at their upper bound.
+    const Column* column = key_column->column();
+    if (IsKeyColumnValue(filter->lower_bound(), column) &&
+        IsKeyColumnValue(filter->upper_bound(), column) &&
+        filter->upper_bound().LessThan(filter->lower_bound())) {
+      return KeySet();
+    }
+    const zetasql::Value* start_value = &filter->lower_bound();
+    const zetasql::Value* limit_value = &filter->upper_bound();
+    if (key_column->is_descending()) {
+      std::swap(start_value, limit_value);
+    }
+    bool has_start_value = IsKeyColumnValue(*start_value, column);
+    bool has_limit_value = IsKeyColumnValue(*limit_value, column);
+    if (!has_start_value && !has_limit_value) {
+      break;
+    }
+    KeySet key_set;
+    for (const Key& prefix : prefixes) {
+      Key start_key = prefix;
+      if (has_start_value) {
+        start_key.AddColumn(*start_value);
+      }
+      Key limit_key = prefix;
+      if (has_limit_value) {
+        limit_key.AddColumn(*limit_value);
+      }
+      key_set.AddRange(KeyRange::ClosedClosed(start_key, limit_key));
+    }
+    return key_set;
+  }
+
+  if (prefixes.size() == 1 && prefixes[0].IsEmpty()) {
+    return KeySet::All();
+  }
+  // Each key in the set covers all rows whose keys start with it.
+  KeySet key_set;
+  for (const Key& prefix : prefixes) {
+    key_set.AddKey(prefix);
+  }
+  return key_set;
+}
+
 // An implementation of EvaluatorTableIterator which wraps a RowCursor.
 //
-// Used by QueryableTable::CreateEvaluatorTableIterator.
+// Used by QueryableTable::CreateEvaluatorTableIterator. The rows are read by
+// the first call to NextRow(), so that column filters set by the evaluator can
+// narrow down the keys which are read.
 class RowCursorEvaluatorTableIterator
     : public zetasql::EvaluatorTableIterator {
  public:
-  explicit RowCursorEvaluatorTableIterator(std::unique_ptr<RowCursor> cursor)
-      : cursor_(std::move(cursor)) {
-    values_.reserve(cursor_->NumColumns());
-    for (int i = 0; i < cursor_->NumColumns(); ++i) {
-      values_.push_back(zetasql::values::Null(cursor_->ColumnType(i)));
+  // 'index' is the index whose data table is 'table', if any.
+  RowCursorEvaluatorTableIterator(const backend::Table* table,
+                                  const backend::Index* index,
+                                  std::vector<const Column*> columns,
+                                  RowReader* reader)
+      : table_(table), columns_(std::move(columns)), reader_(reader) {
+    if (index != nullptr) {
+      read_arg_.table = index->indexed_table()->Name();
+      read_arg_.index = index->Name();
+    } else {
+      read_arg_.table = table_->Name();
+    }
+    read_arg_.key_set = KeySet::All();
+    values_.reserve(columns_.size());
+    for (const Column* column : columns_) {
+      read_arg_.columns.push_back(column->Name());
+      values_.push_back(zetasql::values::Null(column->GetType()));
     }
   }
 
-  int NumColumns() const override { return cursor_->NumColumns(); }
+  int NumColumns() const override { return columns_.size(); }
 
   std::string GetColumnName(int i) const override {
-    return cursor_->ColumnName(i);
+    return columns_[i]->Name();
   }
 
   const zetasql::Type* GetColumnType(int i) const override {
-    return cursor_->ColumnType(i);
+    return columns_[i]->GetType();
+  }
+
+  // The keys of 'filter_map' are indexes into the columns of this iterator.
+  absl::Status SetColumnFilterMap(
+      absl::flat_hash_map<int, std::unique_ptr<zetasql::ColumnFilter>>
+          filter_map) override {
+    ZETASQL_RET_CHECK_EQ(cursor_, nullptr)
+        << "Column filters must be set before reading rows";
+    absl::flat_hash_map<const Column*, const zetasql::ColumnFilter*> filters;
+    for (const auto& [i, filter] : filter_map) {
+      ZETASQL_RET_CHECK_LT(i, columns_.size());
+      filters[columns_[i]] = filter.get();
+    }
+    read_arg_.key_set = KeySetFromColumnFilters(table_, filters);
+    return absl::OkStatus();
   }
 
   bool NextRow() override {
+    if (cancelled_.load(std::memory_order_relaxed)) {
+      status_ = error::QueryCancelled();
+      return false;
+    }
+    if (cursor_ == nullptr) {
+      status_ = reader_->Read(read_arg_, &cursor_);
+      if (!status_.ok()) {
+        return false;
+      }
+    }
     if (cursor_->Next()) {
       for (int i = 0; i < cursor_->NumColumns(); ++i) {
         values_[i] = cursor_->ColumnValue(i);
@@ -77,13 +226,36 @@ class RowCursorEvaluatorTableIterator
 
   const zetasql::Value& GetValue(int i) const override { return values_[i]; }
 
-  absl::Status Status() const override { return cursor_->Status(); }
+  absl::Status Status() const override {
+    if (!status_.ok() || cursor_ == nullptr) {
+      return status_;
+    }
+    return cursor_->Status();
+  }
 
-  // Cancel is best-effort and not required.
-  absl::Status Cancel() override { return absl::OkStatus(); }
+  // May be called from any thread. The next call to NextRow() stops reading
+  // rows and returns false, with Status() returning CANCELLED.
+  absl::Status Cancel() override {
+    cancelled_.store(true, std::memory_order_relaxed);
+    return absl::OkStatus();
+  }
 
  private:
-  // The wrapped RowCursor.
+  // The table and columns to read.
+  const backend::Table* table_;
+  std::vector<const Column*> columns_;
+
+  // The reader which rows are read through, and the read issued to it.
+  RowReader* reader_;
+  ReadArg read_arg_;
+
+  // The status of the read.
+  absl::Status status_;
+
+  // Set by Cancel().
+  std::atomic<bool> cancelled_ = false;
+
+  // The RowCursor returned by the read, or nullptr if rows were not read yet.
   std::unique_ptr<RowCursor> cursor_;
 
   // Values of the current row. EvaluatorTableIterator::GetValue need to return
@@ -92,11 +264,15 @@ class RowCursorEvaluatorTableIterator
   std::vector<zetasql::Value> values_;
 };
 
+}  // namespace
+
 QueryableTable::QueryableTable(
     const backend::Table* table, RowReader* reader,
     std::optional<const zetasql::AnalyzerOptions> options,
     zetasql::Catalog* catalog, zetasql::TypeFactory* type_factory)
     : wrapped_table_(table), reader_(reader) {
+  auto columns =
+      std::make_shared<std::vector<std::unique_ptr<const QueryableColumn>>>();
   for (const auto* column : table->columns()) {
     std::unique_ptr<const zetasql::AnalyzerOutput> output = nullptr;
     if (options.has_value() && column->has_default_value()) {
@@ -106,9 +282,10 @@ QueryableTable::QueryableTable(
       ZETASQL_DCHECK(s.ok()) << "Failed to analyze default expression for column "
                      << column->FullName() << "\n";
     }
-    columns_.push_back(
+    columns->push_back(
         std::make_unique<const QueryableColumn>(column, std::move(output)));
   }
+  columns_ = std::move(columns);
 
   // Populate primary_key_column_indexes_.
   for (const auto& key_column : table->primary_key()) {
@@ -121,33 +298,40 @@ QueryableTable::QueryableTable(
   }
 }
 
+QueryableTable::QueryableTable(const QueryableTable& table, RowReader* reader)
+    : wrapped_table_(table.wrapped_table_),
+      index_(table.index_),
+      reader_(reader),
+      columns_(table.columns_),
+      primary_key_column_indexes_(table.primary_key_column_indexes_) {}
+
+QueryableTable::QueryableTable(const backend::Index* index, RowReader* reader)
+    : QueryableTable(index->index_data_table(), reader) {
+  index_ = index;
+}
+
 absl::StatusOr<std::unique_ptr<zetasql::EvaluatorTableIterator>>
 QueryableTable::CreateEvaluatorTableIterator(
     absl::Span<const int> column_idxs) const {
   ZETASQL_RET_CHECK_NE(reader_, nullptr);
 
-  std::vector<std::string> column_names;
+  std::vector<const Column*> columns;
+  columns.reserve(column_idxs.size());
   for (int idx : column_idxs) {
-    column_names.push_back(GetColumn(idx)->Name());
+    columns.push_back((*columns_)[idx]->wrapped_column());
   }
-
-  ReadArg read_arg;
-  read_arg.table = Name();
-  read_arg.key_set = KeySet::All();
-  read_arg.columns = column_names;
-  std::unique_ptr<RowCursor> cursor;
-  ZETASQL_RETURN_IF_ERROR(reader_->Read(read_arg, &cursor));
-  return std::make_unique<RowCursorEvaluatorTableIterator>(std::move(cursor));
+  return std::make_unique<RowCursorEvaluatorTableIterator>(
+      wrapped_table_, index_, std::move(columns), reader_);
 }
 
 const zetasql::Column* QueryableTable::FindColumnByName(
     const std::string& name) const {
   const auto* to_find = wrapped_table_->FindColumn(name);
-  auto it = std::find_if(columns_.begin(), columns_.end(),
+  auto it = std::find_if(columns_->begin(), columns_->end(),
                          [to_find](const auto& column) {
                            return column->wrapped_column() == to_find;
                          });
-  if (it == columns_.end()) {
+  if (it == columns_->end()) {
     return nullptr;
   }
   return it->get();
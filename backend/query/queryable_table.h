@@ -27,6 +27,7 @@
 #include "absl/types/span.h"
 #include "backend/access/read.h"
 #include "backend/query/queryable_column.h"
+#include "backend/schema/catalog/index.h"
 #include "backend/schema/catalog/table.h"
 #include "absl/status/status.h"
 
@@ -48,15 +49,24 @@ class QueryableTable : public zetasql::Table {
       zetasql::Catalog* catalog = nullptr,
       zetasql::TypeFactory* type_factory = nullptr);
 
+  // Constructs a table which shares the columns of 'table', including their
+  // analyzed default values, but reads data through 'reader'. This is cheap
+  // compared to constructing a table from scratch.
+  QueryableTable(const QueryableTable& table, RowReader* reader);
+
+  // Constructs a table over the data table of 'index', which reads data
+  // through the index.
+  QueryableTable(const backend::Index* index, RowReader* reader);
+
   std::string Name() const override { return wrapped_table_->Name(); }
 
   // FullName is used in debugging so it's OK to not include full path here.
   std::string FullName() const override { return Name(); }
 
-  int NumColumns() const override { return columns_.size(); }
+  int NumColumns() const override { return columns_->size(); }
 
   const zetasql::Column* GetColumn(int i) const override {
-    return columns_[i].get();
+    return (*columns_)[i].get();
   }
 
   const zetasql::Column* FindColumnByName(
@@ -70,6 +80,10 @@ class QueryableTable : public zetasql::Table {
 
   const backend::Table* wrapped_table() const { return wrapped_table_; }
 
+  // Returns the index whose data table this table wraps, or nullptr if it
+  // wraps a regular table.
+  const backend::Index* index() const { return index_; }
+
   // Override CreateEvaluatorTableIterator.
   absl::StatusOr<std::unique_ptr<zetasql::EvaluatorTableIterator>>
   CreateEvaluatorTableIterator(
@@ -79,12 +93,16 @@ class QueryableTable : public zetasql::Table {
   // The underlying Table object which backes the QueryableTable.
   const backend::Table* wrapped_table_;
 
+  // The index whose data table is wrapped_table_, if any.
+  const backend::Index* index_ = nullptr;
+
   // A RowReader which data of the table can be read from to build a
   // EvalutorTableIterator when CreateEvaluatorTableIterator is called.
   RowReader* reader_;
 
-  // The columns in the table.
-  std::vector<std::unique_ptr<const QueryableColumn>> columns_;
+  // The columns in the table, shared by all tables constructed from this one.
+  std::shared_ptr<const std::vector<std::unique_ptr<const QueryableColumn>>>
+      columns_;
 
   // A list of ordinal indexes of the primary key columns of the table.
   std::vector<int> primary_key_column_indexes_;
@@ -17,13 +17,21 @@
 #include "backend/query/queryable_table.h"
 
 #include <memory>
+#include <utility>
+#include <vector>
 
+#include "zetasql/public/evaluator_table_iterator.h"
 #include "zetasql/public/type.h"
 #include "zetasql/public/value.h"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "zetasql/base/testing/status_matchers.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
 #include "backend/access/read.h"
+#include "backend/datamodel/key.h"
+#include "backend/datamodel/key_range.h"
+#include "backend/datamodel/key_set.h"
 #include "backend/query/catalog.h"
 #include "backend/query/queryable_column.h"
 #include "tests/common/row_cursor.h"
@@ -38,6 +46,26 @@ namespace backend {
 namespace {
 
 using testing::ElementsAre;
+using testing::IsEmpty;
+using zetasql::values::Int64;
+
+// A RowReader which records the reads issued through it.
+class RecordingRowReader : public RowReader {
+ public:
+  explicit RecordingRowReader(RowReader* reader) : reader_(reader) {}
+
+  absl::Status Read(const ReadArg& read_arg,
+                    std::unique_ptr<RowCursor>* cursor) override {
+    read_args_.push_back(read_arg);
+    return reader_->Read(read_arg, cursor);
+  }
+
+  const std::vector<ReadArg>& read_args() const { return read_args_; }
+
+ private:
+  RowReader* reader_;
+  std::vector<ReadArg> read_args_;
+};
 
 class QueryableTableTest : public testing::Test {
  public:
@@ -114,6 +142,77 @@ TEST_F(QueryableTableTest, CreateEvaluatorTableIteratorWithAllColumns) {
   ASSERT_FALSE(iterator->NextRow());
 }
 
+TEST_F(QueryableTableTest, EvaluatorTableIteratorStopsOnceCancelled) {
+  QueryableTable table{schema()->FindTable("test_table"), reader()};
+  auto iterator =
+      table.CreateEvaluatorTableIterator(/*column_idxs=*/{0, 1}).value();
+  ZETASQL_ASSERT_OK(iterator->Cancel());
+  EXPECT_FALSE(iterator->NextRow());
+  EXPECT_THAT(iterator->Status(),
+              zetasql_base::testing::StatusIs(absl::StatusCode::kCancelled));
+}
+
+TEST_F(QueryableTableTest, ReadsAllKeysWithoutColumnFilters) {
+  RecordingRowReader recording_reader(reader());
+  QueryableTable table{schema()->FindTable("test_table"), &recording_reader};
+  auto iterator =
+      table.CreateEvaluatorTableIterator(/*column_idxs=*/{1}).value();
+  ASSERT_TRUE(iterator->NextRow());
+
+  ASSERT_EQ(recording_reader.read_args().size(), 1);
+  EXPECT_THAT(recording_reader.read_args()[0].key_set.ranges(),
+              ElementsAre(KeyRange::All()));
+}
+
+TEST_F(QueryableTableTest, ReadsKeysOfInListFilterOnKeyColumn) {
+  RecordingRowReader recording_reader(reader());
+  QueryableTable table{schema()->FindTable("test_table"), &recording_reader};
+  auto iterator =
+      table.CreateEvaluatorTableIterator(/*column_idxs=*/{1, 0}).value();
+  absl::flat_hash_map<int, std::unique_ptr<zetasql::ColumnFilter>> filters;
+  filters[1] = std::make_unique<zetasql::ColumnFilter>(
+      std::vector<zetasql::Value>{Int64(42), Int64(7)});
+  ZETASQL_ASSERT_OK(iterator->SetColumnFilterMap(std::move(filters)));
+  ASSERT_TRUE(iterator->NextRow());
+
+  ASSERT_EQ(recording_reader.read_args().size(), 1);
+  EXPECT_THAT(recording_reader.read_args()[0].key_set.keys(),
+              ElementsAre(Key({Int64(42)}), Key({Int64(7)})));
+  EXPECT_THAT(recording_reader.read_args()[0].key_set.ranges(), IsEmpty());
+}
+
+TEST_F(QueryableTableTest, ReadsKeyRangeOfRangeFilterOnKeyColumn) {
+  RecordingRowReader recording_reader(reader());
+  QueryableTable table{schema()->FindTable("test_table"), &recording_reader};
+  auto iterator =
+      table.CreateEvaluatorTableIterator(/*column_idxs=*/{0, 1}).value();
+  absl::flat_hash_map<int, std::unique_ptr<zetasql::ColumnFilter>> filters;
+  filters[0] = std::make_unique<zetasql::ColumnFilter>(
+      /*lower_bound=*/Int64(10), /*upper_bound=*/zetasql::Value());
+  ZETASQL_ASSERT_OK(iterator->SetColumnFilterMap(std::move(filters)));
+  ASSERT_TRUE(iterator->NextRow());
+
+  ASSERT_EQ(recording_reader.read_args().size(), 1);
+  EXPECT_THAT(recording_reader.read_args()[0].key_set.ranges(),
+              ElementsAre(KeyRange::ClosedClosed(Key({Int64(10)}), Key())));
+}
+
+TEST_F(QueryableTableTest, ReadsAllKeysWithFilterOnNonKeyColumn) {
+  RecordingRowReader recording_reader(reader());
+  QueryableTable table{schema()->FindTable("test_table"), &recording_reader};
+  auto iterator =
+      table.CreateEvaluatorTableIterator(/*column_idxs=*/{0, 1}).value();
+  absl::flat_hash_map<int, std::unique_ptr<zetasql::ColumnFilter>> filters;
+  filters[1] = std::make_unique<zetasql::ColumnFilter>(
+      std::vector<zetasql::Value>{zetasql::values::String("foo")});
+  ZETASQL_ASSERT_OK(iterator->SetColumnFilterMap(std::move(filters)));
+  ASSERT_TRUE(iterator->NextRow());
+
+  ASSERT_EQ(recording_reader.read_args().size(), 1);
+  EXPECT_THAT(recording_reader.read_args()[0].key_set.ranges(),
+              ElementsAre(KeyRange::All()));
+}
+
 }  // namespace
 
 }  // namespace backend
@@ -0,0 +1,102 @@
+//
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "backend/storage/in_memory_row.h"
+
+#include <cstdint>
+#include <utility>
+
+#include "zetasql/public/value.h"
+#include "absl/time/time.h"
+
+namespace google {
+namespace spanner {
+namespace emulator {
+namespace backend {
+
+const zetasql::Value& InMemoryRow::GetValue(int column_index,
+                                              absl::Time timestamp) const {
+  static const zetasql::Value* kInvalidValue = new zetasql::Value();
+  if (column_index < 0 || column_index >= columns_.size()) {
+    return *kInvalidValue;
+  }
+  const zetasql::Value* value = columns_[column_index].Get(timestamp);
+  return value == nullptr ? *kInvalidValue : *value;
+}
+
+int64_t InMemoryRow::ByteSize(absl::Time timestamp) const {
+  int64_t size = 0;
+  for (const VersionList<zetasql::Value>& column : columns_) {
+    const zetasql::Value* value = column.Get(timestamp);
+    if (value != nullptr && value->is_valid()) {
+      size += value->physical_byte_size();
+    }
+  }
+  return size;
+}
+
+void InMemoryRow::SetValue(int column_index, absl::Time timestamp,
+                           zetasql::Value value) {
+  if (column_index >= columns_.size()) {
+    columns_.resize(column_index + 1);
+  }
+  columns_[column_index].Set(timestamp, std::move(value));
+}
+
+void InMemoryRow::MarkExists(absl::Time timestamp) {
+  if (!Exists(timestamp)) {
+    exists_.Set(timestamp, true);
+  }
+}
+
+void InMemoryRow::Delete(absl::Time timestamp) {
+  if (!Exists(timestamp)) {
+    return;
+  }
+  exists_.Set(timestamp, false);
+  for (VersionList<zetasql::Value>& column : columns_) {
+    // Column values are marked invalid to avoid reading the value of the cell
+    // before the delete.
+    if (!column.empty()) {
+      column.Set(timestamp, zetasql::Value());
+    }
+  }
+}
+
+bool InMemoryRow::GarbageCollect(absl::Time timestamp) {
+  bool has_later_versions = exists_.HasVersionsAfter(timestamp);
+  exists_.Trim(timestamp);
+  for (VersionList<zetasql::Value>& column : columns_) {
+    has_later_versions |= column.HasVersionsAfter(timestamp);
+    column.Trim(timestamp);
+
+    // A column whose only version marks the value deleted reads the same as a
+    // column which was never set.
+    if (column.HasSingleVersionAtOrBefore(timestamp) &&
+        !column.Get(timestamp)->is_valid()) {
+      column.clear();
+    }
+  }
+  while (!columns_.empty() && columns_.back().empty()) {
+    columns_.pop_back();
+  }
+  return !has_later_versions && !Exists(timestamp);
+}
+
+}  // namespace backend
+}  // namespace emulator
+}  // namespace spanner
+}  // namespace google
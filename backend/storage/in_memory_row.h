@@ -0,0 +1,158 @@
+//
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef THIRD_PARTY_CLOUD_SPANNER_EMULATOR_BACKEND_STORAGE_IN_MEMORY_ROW_H_
+#define THIRD_PARTY_CLOUD_SPANNER_EMULATOR_BACKEND_STORAGE_IN_MEMORY_ROW_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+#include "zetasql/public/value.h"
+#include "absl/time/time.h"
+
+namespace google {
+namespace spanner {
+namespace emulator {
+namespace backend {
+
+// VersionList holds the versions of a single value, sorted by timestamp.
+//
+// Versions are stored contiguously. Writes almost always carry the latest
+// timestamp and are appended, and reads at the latest timestamp are answered
+// from the last version without a search.
+template <typename T>
+class VersionList {
+ public:
+  // Returns the version visible at the given timestamp, or nullptr if the
+  // value was first written after the timestamp.
+  const T* Get(absl::Time timestamp) const {
+    if (versions_.empty() || timestamp < versions_.front().first) {
+      return nullptr;
+    }
+    if (versions_.back().first <= timestamp) {
+      return &versions_.back().second;
+    }
+    return &std::prev(UpperBound(timestamp))->second;
+  }
+
+  // Sets the version at the given timestamp, replacing any existing version
+  // with the same timestamp.
+  void Set(absl::Time timestamp, T value) {
+    if (versions_.empty() || versions_.back().first < timestamp) {
+      versions_.emplace_back(timestamp, std::move(value));
+      return;
+    }
+    auto itr = std::prev(UpperBound(timestamp));
+    if (itr->first == timestamp) {
+      itr->second = std::move(value);
+    } else {
+      versions_.emplace(std::next(itr), timestamp, std::move(value));
+    }
+  }
+
+  // Removes the versions which are hidden at the given timestamp by a later
+  // version written at or before it.
+  void Trim(absl::Time timestamp) {
+    auto itr = UpperBound(timestamp);
+    if (itr != versions_.begin()) {
+      versions_.erase(versions_.begin(), std::prev(itr));
+    }
+  }
+
+  // Returns true if there are versions later than the given timestamp.
+  bool HasVersionsAfter(absl::Time timestamp) const {
+    return !versions_.empty() && versions_.back().first > timestamp;
+  }
+
+  bool empty() const { return versions_.empty(); }
+
+  void clear() { versions_.clear(); }
+
+  // Returns true if the list holds a single version, written at or before the
+  // given timestamp.
+  bool HasSingleVersionAtOrBefore(absl::Time timestamp) const {
+    return versions_.size() == 1 && versions_.front().first <= timestamp;
+  }
+
+ private:
+  using Version = std::pair<absl::Time, T>;
+
+  typename std::vector<Version>::iterator UpperBound(absl::Time timestamp) {
+    return std::upper_bound(
+        versions_.begin(), versions_.end(), timestamp,
+        [](absl::Time t, const Version& version) { return t < version.first; });
+  }
+  typename std::vector<Version>::const_iterator UpperBound(
+      absl::Time timestamp) const {
+    return std::upper_bound(
+        versions_.begin(), versions_.end(), timestamp,
+        [](absl::Time t, const Version& version) { return t < version.first; });
+  }
+
+  std::vector<Version> versions_;
+};
+
+// InMemoryRow holds all versions of a single row of an InMemoryStorage table.
+//
+// Columns are identified by their dense index within the table, and the
+// versions of each column are kept in a VersionList. Row existence is tracked
+// in a dedicated version list rather than as a column.
+//
+// This class is not thread-safe.
+class InMemoryRow {
+ public:
+  // Returns true if the row exists at the given timestamp.
+  bool Exists(absl::Time timestamp) const {
+    const bool* exists = exists_.Get(timestamp);
+    return exists != nullptr && *exists;
+  }
+
+  // Returns the value of the column at the given timestamp. Returns an invalid
+  // value if the column was not set or was deleted at that timestamp.
+  const zetasql::Value& GetValue(int column_index, absl::Time timestamp) const;
+
+  // Returns the approximate size in bytes of the column values visible at the
+  // given timestamp.
+  int64_t ByteSize(absl::Time timestamp) const;
+
+  // Sets the value of the column at the given timestamp.
+  void SetValue(int column_index, absl::Time timestamp, zetasql::Value value);
+
+  // Marks the row as existing at the given timestamp, unless it already does.
+  void MarkExists(absl::Time timestamp);
+
+  // Marks the row and all its column values as deleted at the given timestamp.
+  void Delete(absl::Time timestamp);
+
+  // Removes versions which are not visible at or after the given timestamp.
+  // Returns true if the row does not exist at or after the given timestamp and
+  // can be removed altogether.
+  bool GarbageCollect(absl::Time timestamp);
+
+ private:
+  VersionList<bool> exists_;
+  std::vector<VersionList<zetasql::Value>> columns_;
+};
+
+}  // namespace backend
+}  // namespace emulator
+}  // namespace spanner
+}  // namespace google
+
+#endif  // THIRD_PARTY_CLOUD_SPANNER_EMULATOR_BACKEND_STORAGE_IN_MEMORY_ROW_H_
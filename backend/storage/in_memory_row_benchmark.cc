@@ -0,0 +1,212 @@
+//
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+// Microbenchmark comparing the InMemoryRow layout with the previous layout of
+// InMemoryStorage rows, a hash map from column id to a std::map of versions
+// plus a synthetic "_exists" column.
+//
+// Usage: in_memory_row_benchmark [--rows=N] [--columns=N] [--versions=N]
+
+#include <cstdint>
+#include <cstdlib>
+#include <iterator>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "zetasql/public/value.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/flags/flag.h"
+#include "absl/flags/parse.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "backend/storage/in_memory_row.h"
+
+ABSL_FLAG(int, rows, 100000, "Number of rows in the benchmark table.");
+ABSL_FLAG(int, columns, 8, "Number of columns per row.");
+ABSL_FLAG(int, versions, 4, "Number of versions written to each column.");
+
+namespace google {
+namespace spanner {
+namespace emulator {
+namespace backend {
+namespace {
+
+constexpr char kExistsColumn[] = "_exists";
+
+// The previous row layout, reproduced as the baseline.
+class MapRow {
+ public:
+  bool Exists(absl::Time timestamp) const {
+    const zetasql::Value& value = GetValue(kExistsColumn, timestamp);
+    return value.is_valid() && value.bool_value();
+  }
+
+  const zetasql::Value& GetValue(const std::string& column_id,
+                                   absl::Time timestamp) const {
+    static const zetasql::Value* kInvalidValue = new zetasql::Value();
+    auto cell_itr = cells_.find(column_id);
+    if (cell_itr == cells_.end()) {
+      return *kInvalidValue;
+    }
+    auto value_itr = cell_itr->second.upper_bound(timestamp);
+    if (value_itr == cell_itr->second.begin()) {
+      return *kInvalidValue;
+    }
+    return std::prev(value_itr)->second;
+  }
+
+  void SetValue(const std::string& column_id, absl::Time timestamp,
+                zetasql::Value value) {
+    if (!Exists(timestamp)) {
+      cells_[kExistsColumn][timestamp] = zetasql::values::Bool(true);
+    }
+    cells_[column_id][timestamp] = std::move(value);
+  }
+
+ private:
+  absl::flat_hash_map<std::string, std::map<absl::Time, zetasql::Value>>
+      cells_;
+};
+
+struct Workload {
+  int num_rows;
+  std::vector<std::string> column_ids;
+  std::vector<absl::Time> timestamps;
+};
+
+// Runs fn once and returns the elapsed time per row.
+template <typename Fn>
+absl::Duration TimePerRow(const Workload& workload, Fn fn) {
+  absl::Time start = absl::Now();
+  fn();
+  return (absl::Now() - start) / workload.num_rows;
+}
+
+void Report(const std::string& name, absl::Duration map_row,
+            absl::Duration in_memory_row) {
+  absl::PrintF("%-24s %12s %12s %8.2fx\n", name,
+               absl::FormatDuration(map_row),
+               absl::FormatDuration(in_memory_row),
+               absl::FDivDuration(map_row, in_memory_row));
+}
+
+// Reads every column of every row at the given timestamp. The checksum keeps
+// the reads from being optimized away.
+template <typename Row, typename ColumnFn>
+int64_t ReadAll(const std::vector<Row>& rows, int num_columns,
+                absl::Time timestamp, ColumnFn column) {
+  int64_t checksum = 0;
+  for (const Row& row : rows) {
+    if (!row.Exists(timestamp)) {
+      continue;
+    }
+    for (int i = 0; i < num_columns; ++i) {
+      const zetasql::Value& value = row.GetValue(column(i), timestamp);
+      if (value.is_valid()) {
+        checksum += value.int64_value();
+      }
+    }
+  }
+  return checksum;
+}
+
+void Run(const Workload& workload) {
+  const int num_columns = workload.column_ids.size();
+  std::vector<MapRow> map_rows(workload.num_rows);
+  std::vector<InMemoryRow> in_memory_rows(workload.num_rows);
+
+  absl::Duration map_row_write = TimePerRow(workload, [&]() {
+    for (absl::Time timestamp : workload.timestamps) {
+      for (int r = 0; r < workload.num_rows; ++r) {
+        for (int c = 0; c < num_columns; ++c) {
+          map_rows[r].SetValue(workload.column_ids[c], timestamp,
+                               zetasql::values::Int64(r + c));
+        }
+      }
+    }
+  });
+  absl::Duration in_memory_row_write = TimePerRow(workload, [&]() {
+    for (absl::Time timestamp : workload.timestamps) {
+      for (int r = 0; r < workload.num_rows; ++r) {
+        in_memory_rows[r].MarkExists(timestamp);
+        for (int c = 0; c < num_columns; ++c) {
+          in_memory_rows[r].SetValue(c, timestamp,
+                                     zetasql::values::Int64(r + c));
+        }
+      }
+    }
+  });
+  Report("write all versions", map_row_write, in_memory_row_write);
+
+  struct ReadCase {
+    std::string name;
+    absl::Time timestamp;
+  };
+  const ReadCase read_cases[] = {
+      {"read latest", absl::InfiniteFuture()},
+      {"read oldest", workload.timestamps.front()},
+      {"read middle", workload.timestamps[workload.timestamps.size() / 2]},
+  };
+  for (const ReadCase& read_case : read_cases) {
+    int64_t map_row_checksum = 0;
+    int64_t in_memory_row_checksum = 0;
+    absl::Duration map_row_read = TimePerRow(workload, [&]() {
+      map_row_checksum =
+          ReadAll(map_rows, num_columns, read_case.timestamp,
+                  [&](int i) -> const std::string& {
+                    return workload.column_ids[i];
+                  });
+    });
+    absl::Duration in_memory_row_read = TimePerRow(workload, [&]() {
+      in_memory_row_checksum =
+          ReadAll(in_memory_rows, num_columns, read_case.timestamp,
+                  [](int i) { return i; });
+    });
+    if (map_row_checksum != in_memory_row_checksum) {
+      absl::PrintF("checksum mismatch for %s\n", read_case.name);
+      std::exit(EXIT_FAILURE);
+    }
+    Report(read_case.name, map_row_read, in_memory_row_read);
+  }
+}
+
+}  // namespace
+}  // namespace backend
+}  // namespace emulator
+}  // namespace spanner
+}  // namespace google
+
+int main(int argc, char** argv) {
+  absl::ParseCommandLine(argc, argv);
+  google::spanner::emulator::backend::Workload workload;
+  workload.num_rows = absl::GetFlag(FLAGS_rows);
+  for (int i = 0; i < absl::GetFlag(FLAGS_columns); ++i) {
+    workload.column_ids.push_back(absl::StrCat("test_table:column_", i));
+  }
+  absl::Time timestamp = absl::Now();
+  for (int i = 0; i < absl::GetFlag(FLAGS_versions); ++i) {
+    workload.timestamps.push_back(timestamp + absl::Seconds(i));
+  }
+
+  absl::PrintF("%-24s %12s %12s %9s\n", "per row", "map layout",
+               "dense layout", "speedup");
+  google::spanner::emulator::backend::Run(workload);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,128 @@
+//
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "backend/storage/in_memory_row.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "zetasql/public/value.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+
+namespace google {
+namespace spanner {
+namespace emulator {
+namespace backend {
+namespace {
+
+using zetasql::values::Int64;
+
+class InMemoryRowTest : public testing::Test {
+ protected:
+  const absl::Time t0_ = absl::Now();
+  const absl::Time t1_ = t0_ + absl::Seconds(1);
+  const absl::Time t2_ = t0_ + absl::Seconds(2);
+  const absl::Time t3_ = t0_ + absl::Seconds(3);
+};
+
+TEST_F(InMemoryRowTest, VersionListReturnsVersionVisibleAtTimestamp) {
+  VersionList<int> versions;
+  versions.Set(t1_, 1);
+  versions.Set(t3_, 3);
+  // Out of order writes are inserted in timestamp order.
+  versions.Set(t2_, 2);
+
+  EXPECT_EQ(versions.Get(t0_), nullptr);
+  EXPECT_EQ(*versions.Get(t1_), 1);
+  EXPECT_EQ(*versions.Get(t2_ + absl::Milliseconds(500)), 2);
+  EXPECT_EQ(*versions.Get(absl::InfiniteFuture()), 3);
+
+  // Writes at an existing timestamp replace the version.
+  versions.Set(t2_, 20);
+  EXPECT_EQ(*versions.Get(t2_), 20);
+}
+
+TEST_F(InMemoryRowTest, VersionListTrimKeepsVisibleVersions) {
+  VersionList<int> versions;
+  versions.Set(t0_, 0);
+  versions.Set(t1_, 1);
+  versions.Set(t3_, 3);
+
+  versions.Trim(t2_);
+  EXPECT_EQ(versions.Get(t0_), nullptr);
+  EXPECT_EQ(*versions.Get(t2_), 1);
+  EXPECT_EQ(*versions.Get(t3_), 3);
+  EXPECT_TRUE(versions.HasVersionsAfter(t2_));
+  EXPECT_FALSE(versions.HasVersionsAfter(t3_));
+}
+
+TEST_F(InMemoryRowTest, ReadsValuesAtTimestamp) {
+  InMemoryRow row;
+  EXPECT_FALSE(row.Exists(t0_));
+
+  row.MarkExists(t0_);
+  row.SetValue(1, t0_, Int64(1));
+  row.SetValue(1, t1_, Int64(2));
+
+  EXPECT_TRUE(row.Exists(t0_));
+  EXPECT_EQ(row.GetValue(1, t0_), Int64(1));
+  EXPECT_EQ(row.GetValue(1, t2_), Int64(2));
+
+  // Unset and unknown columns are invalid.
+  EXPECT_FALSE(row.GetValue(0, t0_).is_valid());
+  EXPECT_FALSE(row.GetValue(5, t0_).is_valid());
+  EXPECT_FALSE(row.GetValue(-1, t0_).is_valid());
+}
+
+TEST_F(InMemoryRowTest, DeleteHidesValues) {
+  InMemoryRow row;
+  row.MarkExists(t0_);
+  row.SetValue(0, t0_, Int64(1));
+  row.Delete(t1_);
+
+  EXPECT_TRUE(row.Exists(t0_));
+  EXPECT_EQ(row.GetValue(0, t0_), Int64(1));
+  EXPECT_FALSE(row.Exists(t1_));
+  EXPECT_FALSE(row.GetValue(0, t1_).is_valid());
+
+  // Reinserting the row does not bring back deleted values.
+  row.MarkExists(t2_);
+  EXPECT_TRUE(row.Exists(t2_));
+  EXPECT_FALSE(row.GetValue(0, t2_).is_valid());
+}
+
+TEST_F(InMemoryRowTest, GarbageCollect) {
+  InMemoryRow row;
+  row.MarkExists(t0_);
+  row.SetValue(0, t0_, Int64(1));
+  row.SetValue(0, t2_, Int64(2));
+
+  // The row has versions after the garbage collection timestamp.
+  EXPECT_FALSE(row.GarbageCollect(t1_));
+  EXPECT_EQ(row.GetValue(0, t1_), Int64(1));
+  EXPECT_EQ(row.GetValue(0, t2_), Int64(2));
+
+  // A deleted row can be removed once garbage collection passes the delete.
+  row.Delete(t3_);
+  EXPECT_FALSE(row.GarbageCollect(t2_));
+  EXPECT_TRUE(row.GarbageCollect(t3_));
+}
+
+}  // namespace
+}  // namespace backend
+}  // namespace emulator
+}  // namespace spanner
+}  // namespace google
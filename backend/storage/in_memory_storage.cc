@@ -16,6 +16,9 @@
 
 #include "backend/storage/in_memory_storage.h"
 
+#include <algorithm>
+#include <atomic>
+#include <iterator>
 #include <memory>
 #include <utility>
 #include <vector>
@@ -23,6 +26,8 @@
 #include "zetasql/public/value.h"
 #include "absl/status/status.h"
 #include "absl/strings/str_cat.h"
+#include "absl/synchronization/mutex.h"
+#include "zetasql/base/status_macros.h"
 #include "backend/storage/in_memory_iterator.h"
 #include "common/errors.h"
 #include "absl/status/status.h"
@@ -32,44 +37,176 @@ namespace spanner {
 namespace emulator {
 namespace backend {
 
-namespace {
+int InMemoryStorage::TableShard::ColumnIndex(const ColumnID& column_id) const {
+  auto itr = column_indexes.find(column_id);
+  return itr == column_indexes.end() ? -1 : itr->second;
+}
 
-static constexpr char kExistsColumn[] = "_exists";
+std::vector<int> InMemoryStorage::TableShard::ColumnIndexes(
+    const std::vector<ColumnID>& column_ids) const {
+  std::vector<int> indexes;
+  indexes.reserve(column_ids.size());
+  for (const ColumnID& column_id : column_ids) {
+    indexes.push_back(ColumnIndex(column_id));
+  }
+  return indexes;
+}
 
-}  // namespace
+int InMemoryStorage::TableShard::GetOrAddColumnIndex(
+    const ColumnID& column_id) {
+  return column_indexes.try_emplace(column_id, column_indexes.size())
+      .first->second;
+}
 
-zetasql::Value InMemoryStorage::GetCellValueAtTimestamp(
-    const Row& row, const ColumnID& column_id, absl::Time timestamp) const {
-  // Perform the lookup for given cell.
-  auto cell_itr = row.find(column_id);
-  if (cell_itr == row.end()) {
-    return zetasql::Value();
+absl::Status InMemoryStorage::TableShard::ValidateReadTimestamp(
+    absl::Time timestamp) const {
+  if (timestamp < gc_timestamp) {
+    return error::ReadTimestampPastVersionGCLimit(timestamp);
   }
-  const Cell& cell = cell_itr->second;
-  auto val_itr = cell.upper_bound(timestamp);
+  return absl::OkStatus();
+}
+
+absl::Status InMemoryStorage::TableShard::PinReadTimestamp(
+    absl::Time timestamp) const {
+  // Holding the table mutex keeps a sweep from advancing gc_timestamp between
+  // the check and the pin.
+  absl::ReaderMutexLock lock(&mu);
+  ZETASQL_RETURN_IF_ERROR(ValidateReadTimestamp(timestamp));
+  absl::MutexLock pin_lock(&pin_mu);
+  pinned_read_timestamps.insert(timestamp);
+  return absl::OkStatus();
+}
+
+void InMemoryStorage::TableShard::UnpinReadTimestamp(
+    absl::Time timestamp) const {
+  absl::MutexLock pin_lock(&pin_mu);
+  pinned_read_timestamps.erase(pinned_read_timestamps.find(timestamp));
+}
+
+// ShardIterator reads one row of the table per call to Next(), holding the
+// table mutex only for the duration of the call. Between calls it keeps its
+// position in the table, which remains valid unless rows have been erased from
+// the table in the meantime, in which case it seeks past the last key returned.
+// Versions visible at the read timestamp are pinned for the lifetime of the
+// iterator, so concurrent writes and garbage collection never change the rows
+// it returns.
+class InMemoryStorage::ShardIterator : public StorageIterator {
+ public:
+  ShardIterator(const TableShard* shard, absl::Time timestamp,
+                const KeyRange& key_range,
+                const std::vector<ColumnID>& column_ids)
+      : shard_(shard),
+        timestamp_(timestamp),
+        key_range_(key_range),
+        column_ids_(column_ids) {}
+
+  ~ShardIterator() override { shard_->UnpinReadTimestamp(timestamp_); }
+
+  bool Next() override {
+    if (done_) {
+      return false;
+    }
+    absl::ReaderMutexLock lock(&shard_->mu);
+    const Table& table = shard_->rows;
+
+    // Columns first written to the table after the previous call get an index
+    // which has to be picked up.
+    if (!started_ || num_table_columns_ != shard_->column_indexes.size()) {
+      column_indexes_ = shard_->ColumnIndexes(column_ids_);
+      num_table_columns_ = shard_->column_indexes.size();
+    }
 
-  // Timestamp is earlier than the time the cell was first written to.
-  if (val_itr == cell.begin()) {
-    return zetasql::Value();
+    Table::const_iterator row_itr;
+    if (!started_) {
+      row_itr = table.lower_bound(key_range_.start_key());
+      started_ = true;
+    } else if (erase_epoch_ == shard_->erase_epoch) {
+      row_itr = std::next(position_);
+    } else {
+      row_itr = table.upper_bound(key_);
+    }
+    erase_epoch_ = shard_->erase_epoch;
+
+    for (; row_itr != table.end() && row_itr->first < key_range_.limit_key();
+         ++row_itr) {
+      const InMemoryRow& row = row_itr->second;
+      if (!row.Exists(timestamp_)) {
+        continue;
+      }
+      position_ = row_itr;
+      key_ = row_itr->first;
+      values_.clear();
+      values_.reserve(column_indexes_.size());
+      for (int column_index : column_indexes_) {
+        values_.push_back(row.GetValue(column_index, timestamp_));
+      }
+      return true;
+    }
+    done_ = true;
+    return false;
   }
 
-  // Fetch the value from the column.
-  --val_itr;
-  return val_itr->second;
+  absl::Status Status() const override { return absl::OkStatus(); }
+
+  const class Key& Key() const override { return key_; }
+
+  int NumColumns() const override { return values_.size(); }
+
+  const zetasql::Value& ColumnValue(int i) const override {
+    return values_[i];
+  }
+
+ private:
+  const TableShard* shard_;
+  const absl::Time timestamp_;
+  const KeyRange key_range_;
+  const std::vector<ColumnID> column_ids_;
+
+  // Position of the current row in the table, valid while erase_epoch_ matches
+  // the erase epoch of the table.
+  Table::const_iterator position_;
+  int64_t erase_epoch_ = 0;
+  bool started_ = false;
+
+  // Indexes of the columns in the table, resolved when the table had
+  // num_table_columns_ columns.
+  std::vector<int> column_indexes_;
+  size_t num_table_columns_ = 0;
+  bool done_ = false;
+
+  // Contents of the current row.
+  class Key key_;
+  std::vector<zetasql::Value> values_;
+};
+
+const InMemoryStorage::TableShard* InMemoryStorage::FindShard(
+    const TableID& table_id) const {
+  absl::ReaderMutexLock lock(&mu_);
+  auto itr = tables_.find(table_id);
+  return itr == tables_.end() ? nullptr : itr->second.get();
 }
 
-bool InMemoryStorage::Exists(const Row& row, absl::Time timestamp) const {
-  zetasql::Value value =
-      GetCellValueAtTimestamp(row, kExistsColumn, timestamp);
-  return value.is_valid() && value.bool_value();
+InMemoryStorage::TableShard* InMemoryStorage::FindOrCreateShard(
+    const TableID& table_id) {
+  {
+    absl::ReaderMutexLock lock(&mu_);
+    auto itr = tables_.find(table_id);
+    if (itr != tables_.end()) {
+      return itr->second.get();
+    }
+  }
+  absl::MutexLock lock(&mu_);
+  std::unique_ptr<TableShard>& shard = tables_[table_id];
+  if (shard == nullptr) {
+    shard = std::make_unique<TableShard>(gc_timestamp_);
+  }
+  return shard.get();
 }
 
 absl::Status InMemoryStorage::Lookup(
     absl::Time timestamp, const TableID& table_id, const Key& key,
     const std::vector<ColumnID>& column_ids,
     std::vector<zetasql::Value>* values) const {
-  absl::MutexLock lock(&mu_);
-
   // Validate the request.
   if (!column_ids.empty() && values == nullptr) {
     return error::Internal(
@@ -81,14 +218,16 @@ absl::Status InMemoryStorage::Lookup(
   }
 
   // Lookup for given table.
-  auto table_itr = tables_.find(table_id);
-  if (table_itr == tables_.end()) {
+  const TableShard* shard = FindShard(table_id);
+  if (shard == nullptr) {
     return absl::Status(
         absl::StatusCode::kNotFound,
         absl::StrCat("Key: ", key.DebugString(), " not found for table: ",
                      table_id, " at timestamp: ", absl::FormatTime(timestamp)));
   }
-  const Table& table = table_itr->second;
+  absl::ReaderMutexLock lock(&shard->mu);
+  ZETASQL_RETURN_IF_ERROR(shard->ValidateReadTimestamp(timestamp));
+  const Table& table = shard->rows;
 
   // Lookup for given key.
   auto row_itr = table.find(key);
@@ -98,10 +237,10 @@ absl::Status InMemoryStorage::Lookup(
         absl::StrCat("Key: ", key.DebugString(), " not found for table: ",
                      table_id, " at timestamp: ", absl::FormatTime(timestamp)));
   }
-  const Row& row = row_itr->second;
+  const InMemoryRow& row = row_itr->second;
 
   // Verify if the row exists at the given timestamp.
-  if (!Exists(row, timestamp)) {
+  if (!row.Exists(timestamp)) {
     return absl::Status(
         absl::StatusCode::kNotFound,
         absl::StrCat(
@@ -115,9 +254,8 @@ absl::Status InMemoryStorage::Lookup(
   }
 
   // Fetch the value from the cell at the given timestamp.
-  for (int i = 0; i < column_ids.size(); ++i) {
-    values->emplace_back(
-        GetCellValueAtTimestamp(row, column_ids[i], timestamp));
+  for (const ColumnID& column_id : column_ids) {
+    values->push_back(row.GetValue(shard->ColumnIndex(column_id), timestamp));
   }
 
   return absl::OkStatus();
@@ -127,8 +265,6 @@ absl::Status InMemoryStorage::Read(
     absl::Time timestamp, const TableID& table_id, const KeyRange& key_range,
     const std::vector<ColumnID>& column_ids,
     std::unique_ptr<StorageIterator>* itr) const {
-  absl::MutexLock lock(&mu_);
-
   // Validate the request.
   if (!key_range.IsClosedOpen()) {
     return error::Internal(
@@ -137,7 +273,6 @@ absl::Status InMemoryStorage::Read(
                      key_range.DebugString()));
   }
 
-  std::vector<FixedRowStorageIterator::Row> rows;
   // Return an empty iterator for empty key_range.
   if (key_range.start_key() >= key_range.limit_key()) {
     *itr = std::make_unique<FixedRowStorageIterator>();
@@ -145,30 +280,71 @@ absl::Status InMemoryStorage::Read(
   }
 
   // Lookup for given table.
-  auto table_itr = tables_.find(table_id);
-  if (table_itr == tables_.end()) {
+  const TableShard* shard = FindShard(table_id);
+  if (shard == nullptr) {
     *itr = std::make_unique<FixedRowStorageIterator>();
     return absl::OkStatus();
   }
-  const Table& table = table_itr->second;
+  ZETASQL_RETURN_IF_ERROR(shard->PinReadTimestamp(timestamp));
+  *itr = std::make_unique<ShardIterator>(shard, timestamp, key_range,
+                                         column_ids);
+  return absl::OkStatus();
+}
 
-  // Lookup keys from the given key range.
-  auto row_start_itr = table.lower_bound(key_range.start_key());
-  auto row_end_itr = table.lower_bound(key_range.limit_key());
-  for (auto itr = row_start_itr; itr != row_end_itr; ++itr) {
-    const InMemoryStorage::Row& row = itr->second;
-    if (!Exists(row, timestamp)) {
-      continue;
+absl::Status InMemoryStorage::GetSplitPoints(
+    absl::Time timestamp, const TableID& table_id,
+    const std::vector<KeyRange>& key_ranges, int64_t split_size_bytes,
+    int64_t max_pieces, std::vector<Key>* split_points) const {
+  split_points->clear();
+  for (const KeyRange& key_range : key_ranges) {
+    if (!key_range.IsClosedOpen()) {
+      return error::Internal(
+          absl::StrCat("InMemoryStorage::GetSplitPoints should be called "
+                       "with ClosedOpen key ranges, found: ",
+                       key_range.DebugString()));
     }
+  }
 
-    std::vector<zetasql::Value> values;
-    values.reserve(column_ids.size());
-    for (const ColumnID& column_id : column_ids) {
-      values.emplace_back(GetCellValueAtTimestamp(row, column_id, timestamp));
-    }
-    rows.emplace_back(std::make_pair(itr->first, values));
+  const TableShard* shard = FindShard(table_id);
+  if (shard == nullptr || max_pieces <= 1) {
+    return absl::OkStatus();
   }
-  *itr = std::make_unique<FixedRowStorageIterator>(std::move(rows));
+  absl::ReaderMutexLock lock(&shard->mu);
+  ZETASQL_RETURN_IF_ERROR(shard->ValidateReadTimestamp(timestamp));
+  const Table& table = shard->rows;
+
+  // Calls fn with the key and size of each row within the key ranges. Each row
+  // counts for at least one byte, so that every piece holds at least one row.
+  auto for_each_row = [&](const auto& fn) {
+    for (const KeyRange& key_range : key_ranges) {
+      for (auto row_itr = table.lower_bound(key_range.start_key());
+           row_itr != table.end() && row_itr->first < key_range.limit_key();
+           ++row_itr) {
+        if (row_itr->second.Exists(timestamp)) {
+          fn(row_itr->first, std::max<int64_t>(
+                                 row_itr->first.LogicalSizeInBytes() +
+                                     row_itr->second.ByteSize(timestamp),
+                                 1));
+        }
+      }
+    }
+  };
+
+  // Pieces are made larger than split_size_bytes if there would otherwise be
+  // more than max_pieces of them.
+  int64_t total_size = 0;
+  for_each_row([&](const Key& key, int64_t size) { total_size += size; });
+  const int64_t piece_size = std::max<int64_t>(
+      {split_size_bytes, (total_size + max_pieces - 1) / max_pieces, 1});
+
+  int64_t current_piece_size = 0;
+  for_each_row([&](const Key& key, int64_t size) {
+    if (current_piece_size >= piece_size) {
+      split_points->push_back(key);
+      current_piece_size = 0;
+    }
+    current_piece_size += size;
+  });
   return absl::OkStatus();
 }
 
@@ -176,20 +352,19 @@ absl::Status InMemoryStorage::Write(
     absl::Time timestamp, const TableID& table_id, const Key& key,
     const std::vector<ColumnID>& column_ids,
     const std::vector<zetasql::Value>& values) {
-  absl::MutexLock lock(&mu_);
-
   // Add the table if it does not exist.
-  Table& table = tables_[table_id];
+  TableShard* shard = FindOrCreateShard(table_id);
+  absl::MutexLock lock(&shard->mu);
+  Table& table = shard->rows;
 
-  // Add the row with _exists system column if it does not exist.
-  Row& row = table[key];
-  if (!Exists(row, timestamp)) {
-    row[kExistsColumn][timestamp] = zetasql::values::Bool(true);
-  }
+  // Add the row if it does not exist.
+  InMemoryRow& row = table[key];
+  row.MarkExists(timestamp);
 
   // Add the values for the given columns.
   for (int i = 0; i < column_ids.size(); ++i) {
-    row[column_ids[i]][timestamp] = values[i];
+    row.SetValue(shard->GetOrAddColumnIndex(column_ids[i]), timestamp,
+                 values[i]);
   }
 
   return absl::OkStatus();
@@ -198,8 +373,6 @@ absl::Status InMemoryStorage::Write(
 absl::Status InMemoryStorage::Delete(absl::Time timestamp,
                                      const TableID& table_id,
                                      const KeyRange& key_range) {
-  absl::MutexLock lock(&mu_);
-
   if (!key_range.IsClosedOpen()) {
     return error::Internal(
         absl::StrCat("InMemoryStorage::Delete should be called "
@@ -210,12 +383,18 @@ absl::Status InMemoryStorage::Delete(absl::Time timestamp,
     return absl::OkStatus();
   }
 
-  // Lookup for given table.
-  auto table_itr = tables_.find(table_id);
-  if (table_itr == tables_.end()) {
-    return absl::OkStatus();
+  // Lookup for given table. Deletes never create a table shard.
+  TableShard* shard = nullptr;
+  {
+    absl::ReaderMutexLock lock(&mu_);
+    auto table_itr = tables_.find(table_id);
+    if (table_itr == tables_.end()) {
+      return absl::OkStatus();
+    }
+    shard = table_itr->second.get();
   }
-  Table& table = table_itr->second;
+  absl::MutexLock lock(&shard->mu);
+  Table& table = shard->rows;
 
   // Lookup keys from the given key range.
   auto row_start_itr = table.lower_bound(key_range.start_key());
@@ -226,23 +405,209 @@ absl::Status InMemoryStorage::Delete(absl::Time timestamp,
 
   // Mark the keys as deleted.
   for (auto itr = row_start_itr; itr != row_end_itr; ++itr) {
-    if (!Exists(itr->second, timestamp)) {
+    itr->second.Delete(timestamp);
+  }
+  return absl::OkStatus();
+}
+
+void InMemoryStorage::AppendTableRuns(absl::Time timestamp,
+                                      std::vector<RowMutation>* mutations,
+                                      std::vector<TableRun>* runs) {
+  auto by_key = [](const RowMutation& a, const RowMutation& b) {
+    return a.key < b.key;
+  };
+  auto begin = mutations->begin();
+  while (begin != mutations->end()) {
+    // Find the run of mutations to the same table. Runs are usually sorted
+    // already, and stable sorting keeps the order of mutations to the same row.
+    const TableID& table_id = begin->table_id;
+    bool has_writes = false;
+    auto end = begin;
+    for (; end != mutations->end() && end->table_id == table_id; ++end) {
+      has_writes |= end->type == RowMutation::Type::kWrite;
+    }
+    if (!std::is_sorted(begin, end, by_key)) {
+      std::stable_sort(begin, end, by_key);
+    }
+    runs->push_back(TableRun{timestamp, begin, end, has_writes});
+    begin = end;
+  }
+}
+
+void InMemoryStorage::ApplyTableRuns(const std::vector<TableRun>& runs) {
+  auto begin = runs.begin();
+  while (begin != runs.end()) {
+    const TableID& table_id = begin->begin->table_id;
+    bool has_writes = false;
+    auto end = begin;
+    for (; end != runs.end() && end->begin->table_id == table_id; ++end) {
+      has_writes |= end->has_writes;
+    }
+
+    // Deletes never create a table shard.
+    TableShard* shard = nullptr;
+    if (has_writes) {
+      shard = FindOrCreateShard(table_id);
+    } else {
+      absl::ReaderMutexLock lock(&mu_);
+      auto table_itr = tables_.find(table_id);
+      if (table_itr != tables_.end()) {
+        shard = table_itr->second.get();
+      }
+    }
+    if (shard != nullptr) {
+      absl::MutexLock lock(&shard->mu);
+      for (auto run = begin; run != end; ++run) {
+        ApplySortedMutations(run->timestamp, shard, run->begin, run->end);
+      }
+    }
+    begin = end;
+  }
+}
+
+absl::Status InMemoryStorage::ApplyBatch(absl::Time timestamp,
+                                         std::vector<RowMutation> mutations) {
+  std::vector<TableRun> runs;
+  AppendTableRuns(timestamp, &mutations, &runs);
+  ApplyTableRuns(runs);
+  return absl::OkStatus();
+}
+
+std::vector<absl::Status> InMemoryStorage::ApplyBatches(
+    std::vector<TimestampedBatch> batches) {
+  std::vector<TableRun> runs;
+  for (TimestampedBatch& batch : batches) {
+    AppendTableRuns(batch.timestamp, &batch.mutations, &runs);
+  }
+  // Bring the runs of each table together. Stable sorting keeps them in the
+  // order of their batches, i.e. by timestamp.
+  std::stable_sort(runs.begin(), runs.end(),
+                   [](const TableRun& a, const TableRun& b) {
+                     return a.begin->table_id < b.begin->table_id;
+                   });
+  ApplyTableRuns(runs);
+  return std::vector<absl::Status>(batches.size(), absl::OkStatus());
+}
+
+void InMemoryStorage::ApplySortedMutations(
+    absl::Time timestamp, TableShard* shard,
+    std::vector<RowMutation>::const_iterator begin,
+    std::vector<RowMutation>::const_iterator end) {
+  Table& table = shard->rows;
+
+  // Keys are ascending, so the position of each row is at or just after the
+  // position of the previous one. Appending to a table, the common case for
+  // bulk loads, takes amortized constant time per row.
+  auto hint = table.begin();
+  const std::vector<ColumnID>* column_ids = nullptr;
+  std::vector<int> column_indexes;
+  for (auto mutation = begin; mutation != end; ++mutation) {
+    // Advance hint to the first row not less than the mutation's key.
+    if (hint != table.end() && hint->first < mutation->key) {
+      ++hint;
+      if (hint != table.end() && hint->first < mutation->key) {
+        hint = table.lower_bound(mutation->key);
+      }
+    }
+    bool row_exists = hint != table.end() && hint->first == mutation->key;
+    if (mutation->type == RowMutation::Type::kDelete) {
+      if (row_exists) {
+        hint->second.Delete(timestamp);
+      }
       continue;
     }
 
-    for (const auto& columns : itr->second) {
-      if (columns.first == kExistsColumn) {
-        itr->second[kExistsColumn][timestamp] = zetasql::values::Bool(false);
-      } else {
-        // Column values are marked invalid zetasql::Value to avoid reading
-        // the value of the cell before the delete.
-        itr->second[columns.first][timestamp] = zetasql::Value();
+    if (!row_exists) {
+      hint = table.try_emplace(hint, mutation->key);
+    }
+    InMemoryRow& row = hint->second;
+    row.MarkExists(timestamp);
+
+    // Consecutive rows usually write the same columns, so column indexes are
+    // only resolved when the set of columns changes.
+    if (column_ids == nullptr || *column_ids != mutation->column_ids) {
+      column_ids = &mutation->column_ids;
+      column_indexes.clear();
+      for (const ColumnID& column_id : *column_ids) {
+        column_indexes.push_back(shard->GetOrAddColumnIndex(column_id));
       }
     }
+    for (int i = 0; i < column_indexes.size(); ++i) {
+      row.SetValue(column_indexes[i], timestamp, mutation->values[i]);
+    }
+  }
+}
+
+absl::Status InMemoryStorage::GarbageCollect(absl::Time timestamp) {
+  const absl::Time last_gc_timestamp = absl::FromUnixNanos(
+      last_gc_timestamp_nanos_.load(std::memory_order_relaxed));
+  if (timestamp < last_gc_timestamp + gc_interval_) {
+    return absl::OkStatus();
   }
+  // A sweep which is already running covers most of this request.
+  if (!gc_mu_.TryLock()) {
+    return absl::OkStatus();
+  }
+  GarbageCollectLocked(timestamp);
+  gc_mu_.Unlock();
   return absl::OkStatus();
 }
 
+void InMemoryStorage::GarbageCollectLocked(absl::Time timestamp) {
+  if (timestamp < last_gc_timestamp_ + gc_interval_) {
+    return;
+  }
+  last_gc_timestamp_ = timestamp;
+  last_gc_timestamp_nanos_.store(absl::ToUnixNanos(timestamp),
+                                 std::memory_order_relaxed);
+
+  // Snapshot the tables to sweep. Tables created during the sweep start out
+  // collected up to the previous sweep's timestamp.
+  std::vector<TableShard*> shards;
+  {
+    absl::ReaderMutexLock lock(&mu_);
+    shards.reserve(tables_.size());
+    for (auto& [table_id, shard] : tables_) {
+      shards.push_back(shard.get());
+    }
+  }
+
+  // Sweep one table at a time so that other tables remain available. A table
+  // is not collected past the oldest outstanding read of that table.
+  absl::Time min_gc_timestamp = timestamp;
+  for (TableShard* shard : shards) {
+    absl::MutexLock lock(&shard->mu);
+    absl::Time shard_gc_timestamp = timestamp;
+    {
+      absl::MutexLock pin_lock(&shard->pin_mu);
+      const auto& pins = shard->pinned_read_timestamps;
+      if (!pins.empty()) {
+        shard_gc_timestamp = std::min(shard_gc_timestamp, *pins.begin());
+      }
+    }
+    min_gc_timestamp = std::min(min_gc_timestamp, shard_gc_timestamp);
+    if (shard_gc_timestamp < shard->gc_timestamp) {
+      continue;
+    }
+
+    // Reads which may observe the versions about to be collected are rejected
+    // from here on.
+    shard->gc_timestamp = shard_gc_timestamp;
+    Table& table = shard->rows;
+    for (auto row_itr = table.begin(); row_itr != table.end();) {
+      if (row_itr->second.GarbageCollect(shard_gc_timestamp)) {
+        row_itr = table.erase(row_itr);
+        ++shard->erase_epoch;
+      } else {
+        ++row_itr;
+      }
+    }
+  }
+
+  absl::MutexLock lock(&mu_);
+  gc_timestamp_ = std::max(gc_timestamp_, min_gc_timestamp);
+}
+
 }  // namespace backend
 }  // namespace emulator
 }  // namespace spanner
@@ -17,11 +17,21 @@
 #ifndef THIRD_PARTY_CLOUD_SPANNER_EMULATOR_BACKEND_STORAGE_IN_MEMORY_STORAGE_H_
 #define THIRD_PARTY_CLOUD_SPANNER_EMULATOR_BACKEND_STORAGE_IN_MEMORY_STORAGE_H_
 
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <set>
+#include <vector>
+
 #include "zetasql/public/value.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/synchronization/mutex.h"
 #include "absl/time/time.h"
 #include "backend/common/ids.h"
 #include "backend/datamodel/key.h"
 #include "backend/datamodel/key_range.h"
+#include "backend/storage/in_memory_row.h"
 #include "backend/storage/iterator.h"
 #include "backend/storage/storage.h"
 #include "absl/status/status.h"
@@ -33,26 +43,53 @@ namespace backend {
 
 // InMemoryStorage implements an in-memory multi-version data store.
 //
-// Keys are stored in sorted order. Value versions for a given column are also
-// sorted in order of the timestamp written. Keys are never deleted, but are
-// marked deleted for multi-version lookup.
+// Keys are stored in sorted order. Each row keeps its columns in a dense vector,
+// indexed in the order in which columns were first written to the table, and
+// the versions of each column sorted by timestamp (see InMemoryRow). Deleted
+// keys are marked deleted for multi-version lookup, and are only removed once
+// garbage collection passes the deletion timestamp.
 //
 // Lookup and Read return invalid zetasql::Value(s) for non-existent columns.
 //
-// This class is thread-safe.
+// This class is thread-safe. Data is sharded by table: each table is guarded by
+// its own reader-writer mutex, so reads proceed concurrently with each other
+// and writes to one table do not block operations on any other table.
 class InMemoryStorage : public Storage {
  public:
+  // Default for the minimum distance between two garbage collection sweeps.
+  static constexpr absl::Duration kDefaultGarbageCollectionInterval =
+      absl::Minutes(1);
+
+  // Garbage collection requests are ignored until the requested timestamp has
+  // advanced by at least gc_interval since the previous sweep, which amortizes
+  // the cost of a sweep across many calls. Ignored requests, as well as those
+  // which arrive while another sweep is running, return without blocking.
+  explicit InMemoryStorage(
+      absl::Duration gc_interval = kDefaultGarbageCollectionInterval)
+      : gc_interval_(gc_interval) {}
+
   absl::Status Lookup(absl::Time timestamp, const TableID& table_id,
                       const Key& key, const std::vector<ColumnID>& column_ids,
                       std::vector<zetasql::Value>* values) const override
       ABSL_LOCKS_EXCLUDED(mu_);
 
+  // Rows are read lazily as the returned iterator advances, so the cost of a
+  // read is proportional to the number of rows consumed. The iterator observes
+  // the table as of the given timestamp and must not outlive this storage.
   absl::Status Read(absl::Time timestamp, const TableID& table_id,
                     const KeyRange& key_range,
                     const std::vector<ColumnID>& column_ids,
                     std::unique_ptr<StorageIterator>* itr) const override
       ABSL_LOCKS_EXCLUDED(mu_);
 
+  // Row sizes are estimated from the column values of each row, so this walks
+  // every row within the key ranges.
+  absl::Status GetSplitPoints(absl::Time timestamp, const TableID& table_id,
+                              const std::vector<KeyRange>& key_ranges,
+                              int64_t split_size_bytes, int64_t max_pieces,
+                              std::vector<Key>* split_points) const override
+      ABSL_LOCKS_EXCLUDED(mu_);
+
   absl::Status Write(absl::Time timestamp, const TableID& table_id,
                      const Key& key, const std::vector<ColumnID>& column_ids,
                      const std::vector<zetasql::Value>& values) override
@@ -62,24 +99,142 @@ class InMemoryStorage : public Storage {
                       const KeyRange& key_range) override
       ABSL_LOCKS_EXCLUDED(mu_);
 
+  absl::Status ApplyBatch(absl::Time timestamp,
+                          std::vector<RowMutation> mutations) override
+      ABSL_LOCKS_EXCLUDED(mu_);
+
+  std::vector<absl::Status> ApplyBatches(
+      std::vector<TimestampedBatch> batches) override ABSL_LOCKS_EXCLUDED(mu_);
+
+  absl::Status GarbageCollect(absl::Time timestamp) override
+      ABSL_LOCKS_EXCLUDED(mu_, gc_mu_);
+
  private:
-  using Cell = std::map<absl::Time, zetasql::Value>;
-  using Row = absl::flat_hash_map<ColumnID, Cell>;
-  using Table = std::map<Key, Row>;
-  using Tables = absl::flat_hash_map<TableID, Table>;
+  using Table = std::map<Key, InMemoryRow>;
+
+  // A single table shard along with the mutex which guards it.
+  struct TableShard {
+    explicit TableShard(absl::Time gc_timestamp) : gc_timestamp(gc_timestamp) {}
+
+    // Returns the dense index of the column within the table's rows, or -1 if
+    // the column has never been written to.
+    int ColumnIndex(const ColumnID& column_id) const
+        ABSL_SHARED_LOCKS_REQUIRED(mu);
+    std::vector<int> ColumnIndexes(const std::vector<ColumnID>& column_ids)
+        const ABSL_SHARED_LOCKS_REQUIRED(mu);
+
+    // Returns the dense index of the column, assigning the next free index if
+    // the column has never been written to.
+    int GetOrAddColumnIndex(const ColumnID& column_id)
+        ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu);
+
+    // Returns an error if reads at the given timestamp may observe versions of
+    // the table that have been garbage collected.
+    absl::Status ValidateReadTimestamp(absl::Time timestamp) const
+        ABSL_SHARED_LOCKS_REQUIRED(mu);
+
+    // Prevents garbage collection of versions of the table visible at the
+    // given timestamp until a matching call to UnpinReadTimestamp. Returns an
+    // error if such versions have already been garbage collected.
+    absl::Status PinReadTimestamp(absl::Time timestamp) const
+        ABSL_LOCKS_EXCLUDED(mu, pin_mu);
+    void UnpinReadTimestamp(absl::Time timestamp) const
+        ABSL_LOCKS_EXCLUDED(pin_mu);
+
+    mutable absl::Mutex mu;
+    Table rows ABSL_GUARDED_BY(mu);
+
+    // Dense indexes of the columns written to the table, in order of first
+    // write. Indexes are never reassigned.
+    absl::flat_hash_map<ColumnID, int> column_indexes ABSL_GUARDED_BY(mu);
+
+    // Incremented whenever rows are erased from the table, which invalidates
+    // outstanding iterators into it. Inserts do not invalidate iterators.
+    int64_t erase_epoch ABSL_GUARDED_BY(mu) = 0;
 
-  // Returns true if the given row is valid at the specified timestamp.
-  bool Exists(const Row& row, absl::Time timestamp) const
-      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+    // Timestamp up to which the table has been garbage collected. Reads at
+    // earlier timestamps are rejected.
+    absl::Time gc_timestamp ABSL_GUARDED_BY(mu);
 
-  // Returns the value for given row and column_id at the specified timestamp.
-  zetasql::Value GetCellValueAtTimestamp(const Row& row,
-                                           const ColumnID& column_id,
-                                           absl::Time timestamp) const
-      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+    // Timestamps of outstanding iterators over the table. Garbage collection
+    // of the table does not go past the oldest of these. Pins are kept per
+    // table so that concurrent reads of different tables do not contend.
+    mutable absl::Mutex pin_mu ABSL_ACQUIRED_AFTER(mu);
+    mutable std::multiset<absl::Time> pinned_read_timestamps
+        ABSL_GUARDED_BY(pin_mu);
+  };
+  using Tables = absl::flat_hash_map<TableID, std::unique_ptr<TableShard>>;
 
+  // Returns the shard for the given table, or nullptr if nothing has been
+  // written to the table yet. Shards are never removed, so the returned pointer
+  // remains valid for the lifetime of this storage.
+  const TableShard* FindShard(const TableID& table_id) const
+      ABSL_LOCKS_EXCLUDED(mu_);
+
+  // Returns the shard for the given table, creating it if it does not exist.
+  TableShard* FindOrCreateShard(const TableID& table_id)
+      ABSL_LOCKS_EXCLUDED(mu_);
+
+  // A run of mutations to a single table, sorted by key, applied at a single
+  // timestamp.
+  struct TableRun {
+    absl::Time timestamp;
+    std::vector<RowMutation>::iterator begin;
+    std::vector<RowMutation>::iterator end;
+    bool has_writes;
+  };
+
+  // Splits 'mutations' into runs of consecutive mutations to the same table,
+  // sorting each run by key, and appends them to 'runs'.
+  static void AppendTableRuns(absl::Time timestamp,
+                              std::vector<RowMutation>* mutations,
+                              std::vector<TableRun>* runs);
+
+  // Applies the runs in order. Consecutive runs to the same table are applied
+  // under a single acquisition of the table's mutex.
+  void ApplyTableRuns(const std::vector<TableRun>& runs)
+      ABSL_LOCKS_EXCLUDED(mu_);
+
+  // Applies mutations [begin, end), which all belong to the given table and are
+  // sorted by key.
+  static void ApplySortedMutations(
+      absl::Time timestamp, TableShard* shard,
+      std::vector<RowMutation>::const_iterator begin,
+      std::vector<RowMutation>::const_iterator end)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(shard->mu);
+
+  // Sweeps all tables at the given timestamp, unless the previous sweep was
+  // less than gc_interval_ ago.
+  void GarbageCollectLocked(absl::Time timestamp)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(gc_mu_) ABSL_LOCKS_EXCLUDED(mu_);
+
+  // StorageIterator which walks a table shard at a fixed timestamp.
+  class ShardIterator;
+
+  // Guards the table map. Row data, garbage collection timestamps and read
+  // pins are kept in the per-table shards. This mutex may be acquired while
+  // holding a table mutex, but not the other way around.
   mutable absl::Mutex mu_;
   Tables tables_ ABSL_GUARDED_BY(mu_);
+
+  // Oldest timestamp up to which the most recent sweep collected any table.
+  // Tables created later start out collected up to this timestamp.
+  absl::Time gc_timestamp_ ABSL_GUARDED_BY(mu_) = absl::InfinitePast();
+
+  // Timestamp requested by the most recent sweep.
+  absl::Time last_gc_timestamp_ ABSL_GUARDED_BY(gc_mu_) = absl::InfinitePast();
+
+  // Copy of last_gc_timestamp_ in Unix nanoseconds, rounded down, which lets
+  // GarbageCollect skip requests within the interval without taking any lock.
+  std::atomic<int64_t> last_gc_timestamp_nanos_{
+      absl::ToUnixNanos(absl::InfinitePast())};
+
+  // Minimum distance between two garbage collection sweeps.
+  const absl::Duration gc_interval_;
+
+  // Held for the duration of a garbage collection sweep. Acquired before any
+  // other mutex, and only ever with TryLock.
+  absl::Mutex gc_mu_ ABSL_ACQUIRED_BEFORE(mu_);
 };
 
 }  // namespace backend
@@ -16,13 +16,16 @@
 
 #include "backend/storage/in_memory_storage.h"
 
+#include <cstdint>
 #include <memory>
+#include <thread>  // NOLINT
 #include <vector>
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "zetasql/base/testing/status_matchers.h"
 #include "tests/common/proto_matchers.h"
+#include "absl/strings/str_cat.h"
 #include "absl/time/clock.h"
 #include "absl/time/time.h"
 #include "backend/datamodel/key_range.h"
@@ -702,6 +705,341 @@ TEST_F(InMemoryStorageTest,
       zetasql_base::testing::StatusIs(absl::StatusCode::kInternal));
 }
 
+TEST_F(InMemoryStorageTest, ConcurrentAccessToDifferentTables) {
+  absl::Time t0 = absl::Now();
+  constexpr int kNumTables = 4;
+  constexpr int kNumRows = 100;
+
+  // Each thread writes to and reads back from its own table while other
+  // threads do the same.
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kNumTables; ++t) {
+    threads.emplace_back([this, t, t0]() {
+      TableID table_id = absl::StrCat("test_table:", t);
+      for (int i = 0; i < kNumRows; ++i) {
+        ZETASQL_EXPECT_OK(storage_.Write(t0, table_id, Key({Int64(i)}), {kColumnID},
+                                 {Int64(t * kNumRows + i)}));
+        std::vector<zetasql::Value> values;
+        ZETASQL_EXPECT_OK(storage_.Lookup(t0, table_id, Key({Int64(i)}),
+                                  {kColumnID}, &values));
+        EXPECT_THAT(values, testing::ElementsAre(Int64(t * kNumRows + i)));
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+
+  for (int t = 0; t < kNumTables; ++t) {
+    ZETASQL_EXPECT_OK(storage_.Read(t0, absl::StrCat("test_table:", t),
+                            KeyRange::All(), {kColumnID}, &itr_));
+    int num_rows = 0;
+    while (itr_->Next()) {
+      EXPECT_EQ(itr_->ColumnValue(0), Int64(t * kNumRows + num_rows));
+      ++num_rows;
+    }
+    ZETASQL_EXPECT_OK(itr_->Status());
+    EXPECT_EQ(num_rows, kNumRows);
+  }
+}
+
+TEST_F(InMemoryStorageTest, GarbageCollectKeepsVisibleVersions) {
+  InMemoryStorage storage(/*gc_interval=*/absl::ZeroDuration());
+  absl::Time t0 = absl::Now();
+  absl::Time t1 = t0 + absl::Seconds(1);
+  absl::Time t2 = t0 + absl::Seconds(2);
+  ZETASQL_EXPECT_OK(storage.Write(t0, kTableId0, Key({Int64(1)}), {kColumnID},
+                          {String("value-0")}));
+  ZETASQL_EXPECT_OK(storage.Write(t1, kTableId0, Key({Int64(1)}), {kColumnID},
+                          {String("value-1")}));
+  ZETASQL_EXPECT_OK(storage.Write(t2, kTableId0, Key({Int64(1)}), {kColumnID},
+                          {String("value-2")}));
+
+  ZETASQL_EXPECT_OK(storage.GarbageCollect(t1 + absl::Milliseconds(500)));
+
+  // Versions visible at or after the garbage collection timestamp are kept.
+  std::vector<zetasql::Value> values;
+  ZETASQL_EXPECT_OK(storage.Lookup(t1 + absl::Milliseconds(500), kTableId0,
+                           Key({Int64(1)}), {kColumnID}, &values));
+  EXPECT_THAT(values, testing::ElementsAre(String("value-1")));
+  ZETASQL_EXPECT_OK(
+      storage.Lookup(t2, kTableId0, Key({Int64(1)}), {kColumnID}, &values));
+  EXPECT_THAT(values, testing::ElementsAre(String("value-2")));
+
+  // Reads before the garbage collection timestamp are rejected.
+  EXPECT_THAT(
+      storage.Lookup(t1, kTableId0, Key({Int64(1)}), {kColumnID}, &values),
+      zetasql_base::testing::StatusIs(absl::StatusCode::kFailedPrecondition));
+  std::unique_ptr<StorageIterator> itr;
+  EXPECT_THAT(
+      storage.Read(t0, kTableId0, KeyRange::All(), {kColumnID}, &itr),
+      zetasql_base::testing::StatusIs(absl::StatusCode::kFailedPrecondition));
+}
+
+TEST_F(InMemoryStorageTest, GarbageCollectRemovesDeletedRows) {
+  InMemoryStorage storage(/*gc_interval=*/absl::ZeroDuration());
+  const ColumnID kColumnID1 = "test_column:1";
+  absl::Time t0 = absl::Now();
+  absl::Time t1 = t0 + absl::Seconds(1);
+  absl::Time t2 = t0 + absl::Seconds(2);
+  absl::Time t3 = t0 + absl::Seconds(3);
+  ZETASQL_EXPECT_OK(storage.Write(t0, kTableId0, Key({Int64(1)}),
+                          {kColumnID, kColumnID1},
+                          {String("value-0"), String("value-1")}));
+  ZETASQL_EXPECT_OK(storage.Write(t0, kTableId0, Key({Int64(2)}), {kColumnID},
+                          {String("value-2")}));
+  ZETASQL_EXPECT_OK(storage.Delete(t1, kTableId0, KeyRange::Point(Key({Int64(1)}))));
+
+  ZETASQL_EXPECT_OK(storage.GarbageCollect(t2));
+
+  std::unique_ptr<StorageIterator> itr;
+  ZETASQL_EXPECT_OK(storage.Read(t2, kTableId0, KeyRange::All(), {kColumnID}, &itr));
+  ASSERT_TRUE(itr->Next());
+  EXPECT_EQ(itr->Key(), Key({Int64(2)}));
+  EXPECT_FALSE(itr->Next());
+  itr.reset();
+
+  // Reinserting a collected row does not resurrect its old column values.
+  ZETASQL_EXPECT_OK(storage.Write(t3, kTableId0, Key({Int64(1)}), {kColumnID},
+                          {String("value-3")}));
+  std::vector<zetasql::Value> values;
+  ZETASQL_EXPECT_OK(storage.Lookup(t3, kTableId0, Key({Int64(1)}),
+                           {kColumnID, kColumnID1}, &values));
+  EXPECT_THAT(values,
+              testing::ElementsAre(String("value-3"), zetasql::Value()));
+}
+
+TEST_F(InMemoryStorageTest, GarbageCollectIsThrottledByInterval) {
+  absl::Time t0 = absl::Now();
+  ZETASQL_EXPECT_OK(storage_.Write(t0, kTableId0, Key({Int64(1)}), {kColumnID},
+                           {String("value-0")}));
+  ZETASQL_EXPECT_OK(storage_.GarbageCollect(t0));
+
+  // A sweep shortly after the previous one is skipped.
+  ZETASQL_EXPECT_OK(storage_.GarbageCollect(t0 + absl::Seconds(1)));
+  std::vector<zetasql::Value> values;
+  ZETASQL_EXPECT_OK(
+      storage_.Lookup(t0, kTableId0, Key({Int64(1)}), {kColumnID}, &values));
+
+  ZETASQL_EXPECT_OK(storage_.GarbageCollect(
+      t0 + InMemoryStorage::kDefaultGarbageCollectionInterval));
+  EXPECT_THAT(
+      storage_.Lookup(t0, kTableId0, Key({Int64(1)}), {kColumnID}, &values),
+      zetasql_base::testing::StatusIs(absl::StatusCode::kFailedPrecondition));
+}
+
+TEST_F(InMemoryStorageTest, ReadIsNotAffectedByConcurrentChanges) {
+  InMemoryStorage storage(/*gc_interval=*/absl::ZeroDuration());
+  absl::Time t0 = absl::Now();
+  absl::Time t1 = t0 + absl::Seconds(1);
+  absl::Time t2 = t0 + absl::Seconds(2);
+  absl::Time t3 = t0 + absl::Seconds(3);
+  for (int i = 1; i <= 4; ++i) {
+    ZETASQL_EXPECT_OK(storage.Write(t0, kTableId0, Key({Int64(i)}), {kColumnID},
+                            {Int64(i)}));
+  }
+  ZETASQL_EXPECT_OK(storage.Delete(t1, kTableId0, KeyRange::Point(Key({Int64(2)}))));
+
+  std::unique_ptr<StorageIterator> itr;
+  ZETASQL_EXPECT_OK(storage.Read(t2, kTableId0, KeyRange::All(), {kColumnID}, &itr));
+  ASSERT_TRUE(itr->Next());
+  EXPECT_EQ(itr->Key(), Key({Int64(1)}));
+
+  // Modify the table and garbage collect in the middle of the read. Garbage
+  // collection does not go past the timestamp of the outstanding read, but
+  // still erases the row deleted before it.
+  ZETASQL_EXPECT_OK(storage.Write(t3, kTableId0, Key({Int64(3)}), {kColumnID},
+                          {Int64(30)}));
+  ZETASQL_EXPECT_OK(storage.Write(t3, kTableId0, Key({Int64(5)}), {kColumnID},
+                          {Int64(5)}));
+  ZETASQL_EXPECT_OK(storage.GarbageCollect(t3));
+
+  ASSERT_TRUE(itr->Next());
+  EXPECT_EQ(itr->Key(), Key({Int64(3)}));
+  EXPECT_EQ(itr->ColumnValue(0), Int64(3));
+  ASSERT_TRUE(itr->Next());
+  EXPECT_EQ(itr->Key(), Key({Int64(4)}));
+  EXPECT_FALSE(itr->Next());
+  ZETASQL_EXPECT_OK(itr->Status());
+  itr.reset();
+
+  // Once the read is done, garbage collection can proceed.
+  std::vector<zetasql::Value> values;
+  ZETASQL_EXPECT_OK(storage.GarbageCollect(t3));
+  EXPECT_THAT(
+      storage.Lookup(t2, kTableId0, Key({Int64(3)}), {kColumnID}, &values),
+      zetasql_base::testing::StatusIs(absl::StatusCode::kFailedPrecondition));
+}
+
+TEST_F(InMemoryStorageTest, ReadOnlyHoldsBackGarbageCollectionOfItsTable) {
+  InMemoryStorage storage(/*gc_interval=*/absl::ZeroDuration());
+  absl::Time t0 = absl::Now();
+  absl::Time t1 = t0 + absl::Seconds(1);
+  absl::Time t2 = t0 + absl::Seconds(2);
+  for (const TableID& table_id : {kTableId0, kTableId1}) {
+    ZETASQL_EXPECT_OK(storage.Write(t0, table_id, Key({Int64(1)}), {kColumnID},
+                            {String("value-0")}));
+    ZETASQL_EXPECT_OK(storage.Write(t1, table_id, Key({Int64(1)}), {kColumnID},
+                            {String("value-1")}));
+  }
+
+  std::unique_ptr<StorageIterator> itr;
+  ZETASQL_EXPECT_OK(storage.Read(t0, kTableId0, KeyRange::All(), {kColumnID}, &itr));
+  ZETASQL_EXPECT_OK(storage.GarbageCollect(t2));
+
+  // The outstanding read only keeps the versions of the table it reads.
+  std::vector<zetasql::Value> values;
+  ZETASQL_EXPECT_OK(
+      storage.Lookup(t0, kTableId0, Key({Int64(1)}), {kColumnID}, &values));
+  EXPECT_THAT(values, testing::ElementsAre(String("value-0")));
+  EXPECT_THAT(
+      storage.Lookup(t0, kTableId1, Key({Int64(1)}), {kColumnID}, &values),
+      zetasql_base::testing::StatusIs(absl::StatusCode::kFailedPrecondition));
+  ZETASQL_EXPECT_OK(
+      storage.Lookup(t2, kTableId1, Key({Int64(1)}), {kColumnID}, &values));
+  EXPECT_THAT(values, testing::ElementsAre(String("value-1")));
+
+  ASSERT_TRUE(itr->Next());
+  EXPECT_EQ(itr->ColumnValue(0), String("value-0"));
+  EXPECT_FALSE(itr->Next());
+}
+
+TEST_F(InMemoryStorageTest, ApplyBatch) {
+  absl::Time t0 = absl::Now();
+  absl::Time t1 = t0 + absl::Seconds(1);
+  ZETASQL_EXPECT_OK(storage_.Write(t0, kTableId0, Key({Int64(2)}), {kColumnID},
+                           {Int64(2)}));
+  ZETASQL_EXPECT_OK(storage_.Write(t0, kTableId0, Key({Int64(4)}), {kColumnID},
+                           {Int64(4)}));
+
+  auto write = [&](const TableID& table_id, int64_t key) {
+    return RowMutation{RowMutation::Type::kWrite, table_id, Key({Int64(key)}),
+                       {kColumnID}, {Int64(key * 10)}};
+  };
+  auto remove = [&](const TableID& table_id, int64_t key) {
+    return RowMutation{RowMutation::Type::kDelete, table_id, Key({Int64(key)})};
+  };
+
+  // Mutations of a table need not be sorted, and mutations of the same row are
+  // applied in order.
+  ZETASQL_EXPECT_OK(storage_.ApplyBatch(
+      t1, {write(kTableId0, 5), write(kTableId0, 1), remove(kTableId0, 2),
+           write(kTableId0, 3), remove(kTableId0, 3), write(kTableId1, 7),
+           remove(kTableId0, 4), write(kTableId0, 4)}));
+
+  std::vector<int64_t> keys;
+  std::vector<zetasql::Value> values;
+  ZETASQL_EXPECT_OK(storage_.Read(t1, kTableId0, KeyRange::All(), {kColumnID}, &itr_));
+  while (itr_->Next()) {
+    keys.push_back(itr_->Key().ColumnValue(0).int64_value());
+    values.push_back(itr_->ColumnValue(0));
+  }
+  ZETASQL_EXPECT_OK(itr_->Status());
+  EXPECT_THAT(keys, testing::ElementsAre(1, 4, 5));
+  EXPECT_THAT(values,
+              testing::ElementsAre(Int64(10), Int64(40), Int64(50)));
+  ZETASQL_EXPECT_OK(
+      storage_.Lookup(t1, kTableId1, Key({Int64(7)}), {kColumnID}, &values));
+  EXPECT_THAT(values, testing::ElementsAre(Int64(70)));
+
+  // Earlier versions are unaffected.
+  ZETASQL_EXPECT_OK(
+      storage_.Lookup(t0, kTableId0, Key({Int64(2)}), {kColumnID}, &values));
+  EXPECT_THAT(values, testing::ElementsAre(Int64(2)));
+
+  // Deletes do not create tables.
+  ZETASQL_EXPECT_OK(storage_.ApplyBatch(t1, {remove("test_table:2", 1)}));
+  ZETASQL_EXPECT_OK(storage_.Read(t1, "test_table:2", KeyRange::All(), {kColumnID},
+                          &itr_));
+  EXPECT_FALSE(itr_->Next());
+}
+
+TEST_F(InMemoryStorageTest, ApplyBatchesAppliesEachBatchAtItsTimestamp) {
+  absl::Time t0 = absl::Now();
+  absl::Time t1 = t0 + absl::Seconds(1);
+  absl::Time t2 = t0 + absl::Seconds(2);
+
+  auto write = [&](const TableID& table_id, int64_t key, int64_t value) {
+    return RowMutation{RowMutation::Type::kWrite, table_id, Key({Int64(key)}),
+                       {kColumnID}, {Int64(value)}};
+  };
+  auto remove = [&](const TableID& table_id, int64_t key) {
+    return RowMutation{RowMutation::Type::kDelete, table_id, Key({Int64(key)})};
+  };
+
+  std::vector<TimestampedBatch> batches;
+  batches.push_back(
+      {t0, {write(kTableId0, 1, 10), write(kTableId1, 1, 100)}});
+  batches.push_back({t1, {write(kTableId1, 2, 200), write(kTableId0, 1, 11)}});
+  batches.push_back({t2, {remove(kTableId0, 1)}});
+  EXPECT_THAT(storage_.ApplyBatches(std::move(batches)),
+              testing::ElementsAre(zetasql_base::testing::IsOk(),
+                                   zetasql_base::testing::IsOk(),
+                                   zetasql_base::testing::IsOk()));
+
+  std::vector<zetasql::Value> values;
+  ZETASQL_EXPECT_OK(
+      storage_.Lookup(t0, kTableId0, Key({Int64(1)}), {kColumnID}, &values));
+  EXPECT_THAT(values, testing::ElementsAre(Int64(10)));
+  ZETASQL_EXPECT_OK(
+      storage_.Lookup(t1, kTableId0, Key({Int64(1)}), {kColumnID}, &values));
+  EXPECT_THAT(values, testing::ElementsAre(Int64(11)));
+  EXPECT_THAT(
+      storage_.Lookup(t2, kTableId0, Key({Int64(1)}), {kColumnID}, &values),
+      zetasql_base::testing::StatusIs(absl::StatusCode::kNotFound));
+
+  EXPECT_THAT(
+      storage_.Lookup(t0, kTableId1, Key({Int64(2)}), {kColumnID}, &values),
+      zetasql_base::testing::StatusIs(absl::StatusCode::kNotFound));
+  ZETASQL_EXPECT_OK(
+      storage_.Lookup(t1, kTableId1, Key({Int64(2)}), {kColumnID}, &values));
+  EXPECT_THAT(values, testing::ElementsAre(Int64(200)));
+}
+
+TEST_F(InMemoryStorageTest, GetSplitPointsOfVisibleRows) {
+  absl::Time t0 = absl::Now();
+  absl::Time t1 = t0 + absl::Seconds(1);
+
+  // Rows of equal size, one of which is deleted later.
+  for (int i = 0; i < 10; ++i) {
+    ZETASQL_EXPECT_OK(storage_.Write(t0, kTableId0, Key({Int64(i)}), {kColumnID},
+                             {Int64(i)}));
+  }
+  ZETASQL_EXPECT_OK(storage_.Delete(
+      t1, kTableId0, KeyRange::ClosedOpen(Key({Int64(5)}), Key({Int64(6)}))));
+
+  // Every row is a piece of its own if pieces can be arbitrarily small.
+  std::vector<Key> split_points;
+  ZETASQL_EXPECT_OK(storage_.GetSplitPoints(t0, kTableId0, {KeyRange::All()},
+                                    /*split_size_bytes=*/1,
+                                    /*max_pieces=*/100, &split_points));
+  EXPECT_EQ(split_points.size(), 9);
+  EXPECT_EQ(split_points.front(), Key({Int64(1)}));
+
+  // Pieces grow to honor max_pieces.
+  ZETASQL_EXPECT_OK(storage_.GetSplitPoints(t0, kTableId0, {KeyRange::All()},
+                                    /*split_size_bytes=*/1,
+                                    /*max_pieces=*/5, &split_points));
+  EXPECT_THAT(split_points,
+              testing::ElementsAre(Key({Int64(2)}), Key({Int64(4)}),
+                                   Key({Int64(6)}), Key({Int64(8)})));
+
+  // Only rows within the key ranges which exist at the timestamp count.
+  ZETASQL_EXPECT_OK(storage_.GetSplitPoints(
+      t1, kTableId0,
+      {KeyRange::ClosedOpen(Key({Int64(2)}), Key({Int64(7)}))},
+      /*split_size_bytes=*/1, /*max_pieces=*/100, &split_points));
+  EXPECT_THAT(split_points,
+              testing::ElementsAre(Key({Int64(3)}), Key({Int64(4)}),
+                                   Key({Int64(6)})));
+
+  // A single piece needs no split points.
+  ZETASQL_EXPECT_OK(storage_.GetSplitPoints(t0, kTableId0, {KeyRange::All()},
+                                    /*split_size_bytes=*/1 << 20,
+                                    /*max_pieces=*/100, &split_points));
+  EXPECT_TRUE(split_points.empty());
+}
+
 }  // namespace
 
 }  // namespace backend
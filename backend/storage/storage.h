@@ -17,6 +17,9 @@
 #ifndef THIRD_PARTY_CLOUD_SPANNER_EMULATOR_BACKEND_STORAGE_STORAGE_H_
 #define THIRD_PARTY_CLOUD_SPANNER_EMULATOR_BACKEND_STORAGE_STORAGE_H_
 
+#include <cstdint>
+#include <vector>
+
 #include "zetasql/public/value.h"
 #include "absl/status/status.h"
 #include "absl/time/time.h"
@@ -31,11 +34,36 @@ namespace spanner {
 namespace emulator {
 namespace backend {
 
+// RowMutation is a write or deletion of a single row, applied as part of a
+// batch by Storage::ApplyBatch.
+struct RowMutation {
+  enum class Type {
+    kWrite,
+    kDelete,
+  };
+
+  Type type = Type::kWrite;
+  TableID table_id;
+  Key key;
+
+  // Columns and values written by a kWrite mutation. Unused by kDelete.
+  std::vector<ColumnID> column_ids;
+  std::vector<zetasql::Value> values;
+};
+
+// TimestampedBatch is a batch of mutations applied at a single timestamp, e.g.
+// the writes of one transaction commit.
+struct TimestampedBatch {
+  absl::Time timestamp;
+  std::vector<RowMutation> mutations;
+};
+
 // Storage defines the interface for a multi-version data store.
 //
-// There will be a Storage instance for each database created. The current
-// interface is grow-only, i.e. once data is added, it will not be deleted.
-// Storage is thread-safe.
+// There will be a Storage instance for each database created. Data is only
+// removed by GarbageCollect, which discards versions that are no longer visible
+// to reads at or after the garbage collection timestamp. Storage is
+// thread-safe.
 class Storage {
  public:
   virtual ~Storage() {}
@@ -59,6 +87,18 @@ class Storage {
                             const std::vector<ColumnID>& column_ids,
                             std::unique_ptr<StorageIterator>* itr) const = 0;
 
+  // Returns keys which split the rows within the given key ranges at the
+  // specified timestamp into consecutive pieces of about split_size_bytes each,
+  // but into no more than max_pieces pieces. Each returned key is the key of
+  // the first row of a piece other than the first, in sorted order. Key ranges
+  // must be sorted, disjoint and in KeyRange::ClosedOpen format.
+  virtual absl::Status GetSplitPoints(absl::Time timestamp,
+                                      const TableID& table_id,
+                                      const std::vector<KeyRange>& key_ranges,
+                                      int64_t split_size_bytes,
+                                      int64_t max_pieces,
+                                      std::vector<Key>* split_points) const = 0;
+
   // Writes column values for given key at the specified timestamp. Column value
   // will be overwritten for non-unique <timestamp, table_id, key, column_id>
   // combination.
@@ -73,6 +113,30 @@ class Storage {
   // ranges will result in INVALID_ARGUMENT.
   virtual absl::Status Delete(absl::Time timestamp, const TableID& table_id,
                               const KeyRange& key_range) = 0;
+
+  // Applies the mutations at the specified timestamp, with the same effect as
+  // calling Write or Delete (of a single key) for each of them in order. Each
+  // table is locked once for the whole batch, which makes this considerably
+  // cheaper than individual calls for large batches. Batches sorted by table
+  // and key are applied fastest.
+  virtual absl::Status ApplyBatch(absl::Time timestamp,
+                                  std::vector<RowMutation> mutations) = 0;
+
+  // Applies the batches, which must be ordered by increasing timestamp, with
+  // the same effect as calling ApplyBatch for each of them in order. Each table
+  // is locked once for all batches, which makes this cheaper than individual
+  // calls when applying the commits of several transactions at once. Returns
+  // the status of each batch, in order; a failed batch does not affect the
+  // others.
+  virtual std::vector<absl::Status> ApplyBatches(
+      std::vector<TimestampedBatch> batches) = 0;
+
+  // Discards column values and deleted rows which are not visible to reads at
+  // or after the given timestamp. Subsequent Lookup and Read calls at earlier
+  // timestamps return FAILED_PRECONDITION. The timestamp must not be later than
+  // any timestamp used for subsequent writes. Implementations may defer the
+  // work, in which case old versions stay readable until they are collected.
+  virtual absl::Status GarbageCollect(absl::Time timestamp) = 0;
 };
 
 }  // namespace backend
@@ -16,9 +16,11 @@
 
 #include "backend/transaction/flush.h"
 
+#include <utility>
 #include <vector>
 
 #include "backend/common/variant.h"
+#include "backend/storage/storage.h"
 #include "backend/transaction/commit_timestamp.h"
 
 namespace google {
@@ -28,65 +30,68 @@ namespace backend {
 
 namespace {
 
-absl::Status FlushInsert(const InsertOp& insert_op, Storage* base_storage,
-                         absl::Time commit_timestamp) {
-  const Table* table = insert_op.table;
-  const Key key = MaybeSetCommitTimestamp(table->primary_key(), insert_op.key,
-                                          commit_timestamp);
-  std::vector<ColumnID> column_ids;
-  ValueList column_values;
-  for (int i = 0; i < insert_op.columns.size(); i++) {
-    column_ids.push_back(insert_op.columns[i]->id());
-    column_values.push_back(MaybeSetCommitTimestamp(
-        insert_op.columns[i], insert_op.values[i], commit_timestamp));
+// Returns the storage mutation which writes the given columns of a row,
+// replacing pending commit timestamps in the key and values.
+RowMutation MakeWriteMutation(const Table* table, const Key& key,
+                              const std::vector<const Column*>& columns,
+                              const ValueList& values,
+                              absl::Time commit_timestamp) {
+  RowMutation mutation;
+  mutation.type = RowMutation::Type::kWrite;
+  mutation.table_id = table->id();
+  mutation.key =
+      MaybeSetCommitTimestamp(table->primary_key(), key, commit_timestamp);
+  mutation.column_ids.reserve(columns.size());
+  mutation.values.reserve(columns.size());
+  for (int i = 0; i < columns.size(); i++) {
+    mutation.column_ids.push_back(columns[i]->id());
+    mutation.values.push_back(
+        MaybeSetCommitTimestamp(columns[i], values[i], commit_timestamp));
   }
-  return base_storage->Write(commit_timestamp, table->id(), key, column_ids,
-                             column_values);
+  return mutation;
 }
 
-absl::Status FlushUpdate(const UpdateOp& update_op, Storage* base_storage,
-                         absl::Time commit_timestamp) {
-  const Table* table = update_op.table;
-  const Key key = MaybeSetCommitTimestamp(table->primary_key(), update_op.key,
-                                          commit_timestamp);
-  std::vector<ColumnID> column_ids;
-  ValueList column_values;
-  for (int i = 0; i < update_op.columns.size(); i++) {
-    column_ids.push_back(update_op.columns[i]->id());
-    column_values.push_back(MaybeSetCommitTimestamp(
-        update_op.columns[i], update_op.values[i], commit_timestamp));
-  }
-  return base_storage->Write(commit_timestamp, table->id(), key, column_ids,
-                             column_values);
-}
-
-absl::Status FlushDelete(const DeleteOp& delete_op, Storage* base_storage,
-                         absl::Time commit_timestamp) {
-  return base_storage->Delete(commit_timestamp, delete_op.table->id(),
-                              KeyRange::Point(delete_op.key));
+RowMutation MakeDeleteMutation(const DeleteOp& delete_op) {
+  RowMutation mutation;
+  mutation.type = RowMutation::Type::kDelete;
+  mutation.table_id = delete_op.table->id();
+  mutation.key = delete_op.key;
+  return mutation;
 }
 
 }  // namespace
 
-absl::Status FlushWriteOpsToStorage(const std::vector<WriteOp>& write_ops,
-                                    Storage* base_storage,
-                                    absl::Time commit_timestamp) {
+std::vector<RowMutation> MakeStorageMutations(
+    const std::vector<WriteOp>& write_ops, absl::Time commit_timestamp) {
+  std::vector<RowMutation> mutations;
+  mutations.reserve(write_ops.size());
   for (const auto& write_op : write_ops) {
-    ZETASQL_RETURN_IF_ERROR(std::visit(
+    mutations.push_back(std::visit(
         overloaded{
             [&](const InsertOp& insert_op) {
-              return FlushInsert(insert_op, base_storage, commit_timestamp);
+              return MakeWriteMutation(insert_op.table, insert_op.key,
+                                       insert_op.columns, insert_op.values,
+                                       commit_timestamp);
             },
             [&](const UpdateOp& update_op) {
-              return FlushUpdate(update_op, base_storage, commit_timestamp);
+              return MakeWriteMutation(update_op.table, update_op.key,
+                                       update_op.columns, update_op.values,
+                                       commit_timestamp);
             },
             [&](const DeleteOp& delete_op) {
-              return FlushDelete(delete_op, base_storage, commit_timestamp);
+              return MakeDeleteMutation(delete_op);
             },
         },
         write_op));
   }
-  return absl::OkStatus();
+  return mutations;
+}
+
+absl::Status FlushWriteOpsToStorage(const std::vector<WriteOp>& write_ops,
+                                    Storage* base_storage,
+                                    absl::Time commit_timestamp) {
+  return base_storage->ApplyBatch(
+      commit_timestamp, MakeStorageMutations(write_ops, commit_timestamp));
 }
 
 }  // namespace backend
@@ -17,17 +17,25 @@
 #ifndef THIRD_PARTY_CLOUD_SPANNER_EMULATOR_BACKEND_TRANSACTION_FLUSH_H_
 #define THIRD_PARTY_CLOUD_SPANNER_EMULATOR_BACKEND_TRANSACTION_FLUSH_H_
 
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/time/time.h"
 #include "backend/actions/ops.h"
+#include "backend/storage/storage.h"
 
 namespace google {
 namespace spanner {
 namespace emulator {
 namespace backend {
 
-// TODO : Add support to write multiple ops to base storage
-// atomically.
+// Returns the storage mutations which apply the write ops at the given commit
+// timestamp, replacing pending commit timestamps in keys and values.
+std::vector<RowMutation> MakeStorageMutations(
+    const std::vector<WriteOp>& write_ops, absl::Time commit_timestamp);
 
-// Flushes each of the write ops to base storage at the given timestamp. Note
+// Flushes the write ops to base storage at the given timestamp as a single
+// batch (see Storage::ApplyBatch), which locks each written table once. Note
 // that calling this function isn't thread safe and appropriate database locks
 // should be acquired.
 absl::Status FlushWriteOpsToStorage(const std::vector<WriteOp>& write_ops,
@@ -0,0 +1,116 @@
+//
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "backend/transaction/group_committer.h"
+
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "backend/storage/storage.h"
+#include "backend/transaction/flush.h"
+
+namespace google {
+namespace spanner {
+namespace emulator {
+namespace backend {
+
+absl::StatusOr<absl::Time> GroupCommitter::Commit(
+    LockHandle* handle, const std::vector<WriteOp>& write_ops) {
+  PendingCommit commit{handle, &write_ops};
+  std::vector<PendingCommit*> group;
+  {
+    absl::MutexLock lock(&mu_);
+    queue_.push_back(&commit);
+    while (writing_ && !commit.done) {
+      group_written_cvar_.Wait(&mu_);
+    }
+    if (commit.done) {
+      return commit.result;
+    }
+
+    // Lead the next group, which includes this commit.
+    writing_ = true;
+    if (window_ > absl::ZeroDuration()) {
+      mu_.AwaitWithTimeout(absl::Condition(this, &GroupCommitter::GroupIsFull),
+                           window_);
+    }
+    group.swap(queue_);
+  }
+
+  WriteGroup(group);
+
+  absl::MutexLock lock(&mu_);
+  for (PendingCommit* member : group) {
+    member->done = true;
+  }
+  writing_ = false;
+  group_written_cvar_.SignalAll();
+  return commit.result;
+}
+
+void GroupCommitter::WriteGroup(const std::vector<PendingCommit*>& group) {
+  std::vector<LockHandle*> handles;
+  handles.reserve(group.size());
+  for (const PendingCommit* commit : group) {
+    handles.push_back(commit->handle);
+  }
+  std::vector<absl::StatusOr<absl::Time>> timestamps =
+      lock_manager_->ReserveCommitTimestamps(handles);
+
+  // Transactions which could not reserve a timestamp are left out.
+  std::vector<PendingCommit*> committing;
+  std::vector<LockHandle*> committing_handles;
+  std::vector<TimestampedBatch> batches;
+  for (int i = 0; i < group.size(); ++i) {
+    group[i]->result = timestamps[i];
+    if (!timestamps[i].ok()) {
+      continue;
+    }
+    committing.push_back(group[i]);
+    committing_handles.push_back(handles[i]);
+    batches.push_back(TimestampedBatch{
+        *timestamps[i],
+        MakeStorageMutations(*group[i]->write_ops, *timestamps[i])});
+  }
+  if (committing.empty()) {
+    return;
+  }
+
+  // Timestamps were reserved in group order, so the batches are ordered by
+  // timestamp as ApplyBatches requires. Transactions are marked committed even
+  // if their write failed, so that they no longer hold up readers. A failure
+  // is only reported to the transaction it belongs to; the others keep their
+  // commit timestamp.
+  std::vector<absl::Status> write_statuses =
+      storage_->ApplyBatches(std::move(batches));
+  std::vector<absl::Status> statuses =
+      lock_manager_->MarkGroupCommitted(committing_handles);
+  for (int i = 0; i < committing.size(); ++i) {
+    statuses[i].Update(write_statuses[i]);
+    if (!statuses[i].ok()) {
+      committing[i]->result = statuses[i];
+    }
+  }
+}
+
+}  // namespace backend
+}  // namespace emulator
+}  // namespace spanner
+}  // namespace google
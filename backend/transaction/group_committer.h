@@ -0,0 +1,110 @@
+//
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef THIRD_PARTY_CLOUD_SPANNER_EMULATOR_BACKEND_TRANSACTION_GROUP_COMMITTER_H_
+#define THIRD_PARTY_CLOUD_SPANNER_EMULATOR_BACKEND_TRANSACTION_GROUP_COMMITTER_H_
+
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/status/statusor.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "backend/actions/ops.h"
+#include "backend/locking/handle.h"
+#include "backend/locking/manager.h"
+#include "backend/storage/storage.h"
+
+namespace google {
+namespace spanner {
+namespace emulator {
+namespace backend {
+
+// GroupCommitter writes the commits of concurrent read-write transactions of a
+// database to storage in groups.
+//
+// A commit which arrives while no group is being written leads the next group:
+// it waits up to the group window for more commits to join, reserves commit
+// timestamps for the whole group from the clock under one acquisition of the
+// lock manager's mutex, applies all of their writes in one storage batch and
+// marks them committed, waking readers blocked in WaitForSafeRead once for the
+// whole group. Commits which arrive while a group is being written join the
+// next group, so groups form under load even without a window.
+//
+// Transactions in a group hold their locks until the group is written, so the
+// writes of a group never conflict with each other.
+class GroupCommitter {
+ public:
+  // A group which reaches this size is written without waiting for the rest of
+  // the window.
+  static constexpr int kMaxGroupSize = 256;
+
+  // Leaders wait up to 'window' for other commits to join their group.
+  GroupCommitter(LockManager* lock_manager, Storage* storage,
+                 absl::Duration window = absl::ZeroDuration())
+      : lock_manager_(lock_manager), storage_(storage), window_(window) {}
+
+  // Writes 'write_ops' of the transaction owning 'handle' as part of a group,
+  // and returns its commit timestamp. Returns an error without writing if the
+  // transaction cannot commit, e.g. because it was wounded.
+  absl::StatusOr<absl::Time> Commit(LockHandle* handle,
+                                    const std::vector<WriteOp>& write_ops)
+      ABSL_LOCKS_EXCLUDED(mu_);
+
+ private:
+  // A commit waiting to be written.
+  struct PendingCommit {
+    LockHandle* handle;
+    const std::vector<WriteOp>* write_ops;
+
+    // The commit timestamp or error, set by the leader of the group.
+    absl::StatusOr<absl::Time> result;
+
+    // Set once the group containing the commit has been written.
+    bool done = false;
+  };
+
+  // Reserves commit timestamps for the group, writes it to storage and marks
+  // it committed, setting the result of each commit.
+  void WriteGroup(const std::vector<PendingCommit*>& group)
+      ABSL_LOCKS_EXCLUDED(mu_);
+
+  bool GroupIsFull() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    return queue_.size() >= kMaxGroupSize;
+  }
+
+  LockManager* lock_manager_;
+  Storage* storage_;
+  const absl::Duration window_;
+
+  absl::Mutex mu_;
+
+  // Commits waiting for the next group, in arrival order.
+  std::vector<PendingCommit*> queue_ ABSL_GUARDED_BY(mu_);
+
+  // True while a leader is collecting or writing a group.
+  bool writing_ ABSL_GUARDED_BY(mu_) = false;
+
+  // Signals that a group has been written.
+  absl::CondVar group_written_cvar_ ABSL_GUARDED_BY(mu_);
+};
+
+}  // namespace backend
+}  // namespace emulator
+}  // namespace spanner
+}  // namespace google
+
+#endif  // THIRD_PARTY_CLOUD_SPANNER_EMULATOR_BACKEND_TRANSACTION_GROUP_COMMITTER_H_
@@ -0,0 +1,232 @@
+//
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "backend/transaction/group_committer.h"
+
+#include <memory>
+#include <set>
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "zetasql/base/testing/status_matchers.h"
+#include "tests/common/proto_matchers.h"
+#include "absl/status/status.h"
+#include "absl/time/time.h"
+#include "backend/actions/ops.h"
+#include "backend/datamodel/key.h"
+#include "backend/datamodel/key_range.h"
+#include "backend/datamodel/value.h"
+#include "backend/locking/manager.h"
+#include "backend/storage/in_memory_storage.h"
+#include "backend/storage/storage.h"
+#include "common/clock.h"
+#include "tests/common/schema_constructor.h"
+
+namespace google {
+namespace spanner {
+namespace emulator {
+namespace backend {
+namespace {
+
+using zetasql::values::Int64;
+using zetasql::values::String;
+using zetasql_base::testing::StatusIs;
+
+// Storage which fails to apply any batch that writes the given key.
+class FailingStorage : public InMemoryStorage {
+ public:
+  explicit FailingStorage(Key failing_key)
+      : failing_key_(std::move(failing_key)) {}
+
+  std::vector<absl::Status> ApplyBatches(
+      std::vector<TimestampedBatch> batches) override {
+    std::vector<absl::Status> statuses(batches.size());
+    std::vector<TimestampedBatch> applied_batches;
+    for (int i = 0; i < batches.size(); ++i) {
+      if (WritesFailingKey(batches[i])) {
+        statuses[i] = absl::InternalError("Write failed.");
+      } else {
+        applied_batches.push_back(std::move(batches[i]));
+      }
+    }
+    InMemoryStorage::ApplyBatches(std::move(applied_batches));
+    return statuses;
+  }
+
+ private:
+  bool WritesFailingKey(const TimestampedBatch& batch) const {
+    for (const RowMutation& mutation : batch.mutations) {
+      if (mutation.key == failing_key_) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  const Key failing_key_;
+};
+
+class GroupCommitterTest : public testing::Test {
+ public:
+  GroupCommitterTest()
+      : type_factory_(std::make_unique<zetasql::TypeFactory>()),
+        schema_(test::CreateSchemaFromDDL(
+                    {
+                        R"(
+                          CREATE TABLE TestTable (
+                            Int64Col    INT64 NOT NULL,
+                            StringCol   STRING(MAX),
+                          ) PRIMARY KEY (Int64Col)
+                        )"},
+                    type_factory_.get())
+                    .value()),
+        table_(schema_->FindTable("TestTable")),
+        int64_col_(table_->FindColumn("Int64Col")),
+        string_col_(table_->FindColumn("StringCol")) {}
+
+ protected:
+  Clock clock_;
+  LockManager lock_manager_{&clock_};
+  InMemoryStorage storage_;
+
+  // The type factory must outlive the type objects that it has made.
+  std::unique_ptr<zetasql::TypeFactory> type_factory_;
+  std::unique_ptr<const Schema> schema_;
+
+  // Constants
+  const Table* table_;
+  const Column* int64_col_;
+  const Column* string_col_;
+
+  std::unique_ptr<LockHandle> LockRow(int64_t id, int64_t key) {
+    std::unique_ptr<LockHandle> handle = lock_manager_.CreateHandle(
+        TransactionID(id), TransactionPriority(id));
+    handle->EnqueueLock(LockRequest(LockMode::kExclusive, table_->id(),
+                                    KeyRange::Point(Key({Int64(key)})), {}));
+    return handle;
+  }
+
+  std::vector<WriteOp> InsertRow(int64_t key) {
+    return {InsertOp{table_,
+                     Key({Int64(key)}),
+                     {int64_col_, string_col_},
+                     {Int64(key), String("value")}}};
+  }
+
+  bool RowExists(absl::Time timestamp, int64_t key) {
+    std::vector<zetasql::Value> values;
+    return storage_
+        .Lookup(timestamp, table_->id(), Key({Int64(key)}),
+                {string_col_->id()}, &values)
+        .ok();
+  }
+};
+
+TEST_F(GroupCommitterTest, ConcurrentCommitsGetDistinctTimestamps) {
+  GroupCommitter committer(&lock_manager_, &storage_, absl::Milliseconds(10));
+  constexpr int kNumCommits = 16;
+  std::vector<std::unique_ptr<LockHandle>> handles;
+  std::vector<std::vector<WriteOp>> write_ops;
+  for (int i = 0; i < kNumCommits; ++i) {
+    handles.push_back(LockRow(i + 1, i));
+    ZETASQL_ASSERT_OK(handles.back()->Wait());
+    write_ops.push_back(InsertRow(i));
+  }
+
+  std::vector<absl::StatusOr<absl::Time>> results(kNumCommits);
+  std::vector<std::thread> threads;
+  for (int i = 0; i < kNumCommits; ++i) {
+    threads.emplace_back([&, i]() {
+      results[i] = committer.Commit(handles[i].get(), write_ops[i]);
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+
+  std::set<absl::Time> timestamps;
+  for (int i = 0; i < kNumCommits; ++i) {
+    ZETASQL_ASSERT_OK(results[i]);
+    timestamps.insert(*results[i]);
+
+    // Each write is visible from its own commit timestamp on.
+    EXPECT_FALSE(RowExists(*results[i] - absl::Nanoseconds(1), i));
+    EXPECT_TRUE(RowExists(*results[i], i));
+  }
+  EXPECT_EQ(timestamps.size(), kNumCommits);
+  EXPECT_EQ(lock_manager_.LastCommitTimestamp(), *timestamps.rbegin());
+}
+
+TEST_F(GroupCommitterTest, WoundedTransactionDoesNotCommit) {
+  GroupCommitter committer(&lock_manager_, &storage_);
+
+  // The older transaction, which has the lower priority value, wounds the
+  // younger one which holds the lock.
+  std::unique_ptr<LockHandle> younger = LockRow(/*id=*/2, /*key=*/1);
+  ZETASQL_ASSERT_OK(younger->Wait());
+  std::unique_ptr<LockHandle> older = LockRow(/*id=*/1, /*key=*/1);
+  ZETASQL_ASSERT_OK(older->Wait());
+
+  EXPECT_THAT(committer.Commit(younger.get(), InsertRow(1)),
+              StatusIs(absl::StatusCode::kAborted));
+  EXPECT_FALSE(RowExists(absl::InfiniteFuture(), 1));
+
+  ZETASQL_ASSERT_OK_AND_ASSIGN(absl::Time timestamp,
+                       committer.Commit(older.get(), InsertRow(1)));
+  EXPECT_TRUE(RowExists(timestamp, 1));
+}
+
+TEST_F(GroupCommitterTest, FailedWriteIsOnlyReportedToItsTransaction) {
+  FailingStorage storage(Key({Int64(0)}));
+  GroupCommitter committer(&lock_manager_, &storage, absl::Milliseconds(10));
+  constexpr int kNumCommits = 4;
+  std::vector<std::unique_ptr<LockHandle>> handles;
+  std::vector<std::vector<WriteOp>> write_ops;
+  for (int i = 0; i < kNumCommits; ++i) {
+    handles.push_back(LockRow(i + 1, i));
+    ZETASQL_ASSERT_OK(handles.back()->Wait());
+    write_ops.push_back(InsertRow(i));
+  }
+
+  std::vector<absl::StatusOr<absl::Time>> results(kNumCommits);
+  std::vector<std::thread> threads;
+  for (int i = 0; i < kNumCommits; ++i) {
+    threads.emplace_back([&, i]() {
+      results[i] = committer.Commit(handles[i].get(), write_ops[i]);
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+
+  // Commits grouped with the failed write still succeed.
+  EXPECT_THAT(results[0], StatusIs(absl::StatusCode::kInternal));
+  for (int i = 1; i < kNumCommits; ++i) {
+    ZETASQL_ASSERT_OK(results[i]);
+    std::vector<zetasql::Value> values;
+    ZETASQL_EXPECT_OK(storage.Lookup(*results[i], table_->id(), Key({Int64(i)}),
+                             {string_col_->id()}, &values));
+  }
+}
+
+}  // namespace
+}  // namespace backend
+}  // namespace emulator
+}  // namespace spanner
+}  // namespace google
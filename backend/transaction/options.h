@@ -25,6 +25,10 @@ namespace spanner {
 namespace emulator {
 namespace backend {
 
+// Maximum staleness of snapshot reads. Versions which are only visible to
+// reads older than this are garbage collected.
+constexpr absl::Duration kMaxStaleReadDuration = absl::Hours(1);
+
 // Types of timestamp bounds for snapshot reads.
 enum class TimestampBound {
   // Read the latest data.
@@ -16,18 +16,24 @@
 
 #include "backend/transaction/read_only_transaction.h"
 
+#include <cstdint>
 #include <memory>
 #include <utility>
 #include <vector>
 
 #include "absl/random/random.h"
 #include "absl/status/status.h"
+#include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
 #include "absl/time/time.h"
 #include "backend/access/read.h"
 #include "backend/common/ids.h"
+#include "backend/datamodel/key.h"
+#include "backend/datamodel/key_range.h"
 #include "backend/datamodel/key_set.h"
 #include "backend/locking/manager.h"
+#include "backend/schema/catalog/index.h"
+#include "backend/schema/catalog/table.h"
 #include "backend/storage/in_memory_iterator.h"
 #include "backend/storage/storage.h"
 #include "backend/transaction/options.h"
@@ -41,12 +47,6 @@ namespace spanner {
 namespace emulator {
 namespace backend {
 
-namespace {
-
-absl::Duration kMaxStaleReadDuration = absl::Hours(1);
-
-}  // namespace
-
 ReadOnlyTransaction::ReadOnlyTransaction(
     const ReadOnlyOptions& options, TransactionID transaction_id, Clock* clock,
     Storage* storage, LockManager* lock_manager,
@@ -64,16 +64,17 @@ ReadOnlyTransaction::ReadOnlyTransaction(
 absl::Status ReadOnlyTransaction::Read(const ReadArg& read_arg,
                                        std::unique_ptr<RowCursor>* cursor) {
   absl::MutexLock lock(&mu_);
-  // Wait for any concurrent schema change or read-write transactions to commit
-  // before accessing database state to perform a read.
-  lock_handle_->WaitForSafeRead(read_timestamp_);
+  ZETASQL_ASSIGN_OR_RETURN(const ResolvedReadArg resolved_read_arg,
+                   ResolveReadArg(read_arg, schema()));
+
+  // Wait for any concurrent read-write transactions writing the table to
+  // commit before accessing database state to perform a read.
+  lock_handle_->WaitForSafeRead(read_timestamp_,
+                                {resolved_read_arg.table->id()});
   if (clock_->Now() - read_timestamp_ >= kMaxStaleReadDuration) {
     return error::ReadTimestampPastVersionGCLimit(read_timestamp_);
   }
 
-  ZETASQL_ASSIGN_OR_RETURN(const ResolvedReadArg resolved_read_arg,
-                   ResolveReadArg(read_arg, schema()));
-
   std::vector<std::unique_ptr<StorageIterator>> iterators;
   for (const auto& key_range : resolved_read_arg.key_ranges) {
     std::unique_ptr<StorageIterator> itr;
@@ -87,10 +88,66 @@ absl::Status ReadOnlyTransaction::Read(const ReadArg& read_arg,
   return absl::OkStatus();
 }
 
+absl::StatusOr<std::vector<std::vector<KeyRange>>>
+ReadOnlyTransaction::PartitionRead(const ReadArg& read_arg,
+                                   int64_t partition_size_bytes,
+                                   int64_t max_partitions) {
+  absl::MutexLock lock(&mu_);
+  ZETASQL_ASSIGN_OR_RETURN(const ResolvedReadArg resolved_read_arg,
+                   ResolveReadArg(read_arg, schema()));
+  lock_handle_->WaitForSafeRead(read_timestamp_,
+                                {resolved_read_arg.table->id()});
+  if (clock_->Now() - read_timestamp_ >= kMaxStaleReadDuration) {
+    return error::ReadTimestampPastVersionGCLimit(read_timestamp_);
+  }
+
+  std::vector<Key> split_points;
+  ZETASQL_RETURN_IF_ERROR(base_storage_->GetSplitPoints(
+      read_timestamp_, resolved_read_arg.table->id(),
+      resolved_read_arg.key_ranges, partition_size_bytes, max_partitions,
+      &split_points));
+
+  // Keys of index reads only hold the index columns, so index rows are split at
+  // prefixes of their keys, which keeps rows with equal index columns in the
+  // same partition.
+  if (const Index* index = resolved_read_arg.table->owner_index();
+      index != nullptr) {
+    const int num_index_columns = index->key_columns().size();
+    std::vector<Key> prefixes;
+    for (const Key& split_point : split_points) {
+      Key prefix = split_point.Prefix(num_index_columns);
+      if (prefixes.empty() || prefixes.back() < prefix) {
+        prefixes.push_back(std::move(prefix));
+      }
+    }
+    split_points = std::move(prefixes);
+  }
+
+  // Each partition holds the rows of the key ranges between two consecutive
+  // split points, the first and last partitions being unbounded on one side.
+  // Partitions without key ranges are dropped, but there is always at least
+  // one partition.
+  std::vector<std::vector<KeyRange>> partitions;
+  Key start_key = Key::Empty();
+  for (int i = 0; i <= split_points.size(); ++i) {
+    Key limit_key = i < split_points.size() ? split_points[i] : Key::Infinity();
+    std::vector<KeyRange> partition;
+    IntersectDisjointKeyRanges(resolved_read_arg.key_ranges,
+                               {KeyRange::ClosedOpen(start_key, limit_key)},
+                               &partition);
+    if (!partition.empty() || (partitions.empty() && limit_key.IsInfinity())) {
+      partitions.push_back(std::move(partition));
+    }
+    start_key = std::move(limit_key);
+  }
+  return partitions;
+}
+
 const Schema* ReadOnlyTransaction::schema() const {
-  // Wait for any concurrent schema change or read-write transactions to commit
-  // before accessing database state to read schemas in versioned_catalog.
-  lock_handle_->WaitForSafeRead(read_timestamp_);
+  // Wait for any concurrent schema change to commit before accessing database
+  // state to read schemas in versioned_catalog. Read-write transactions do not
+  // change the schema.
+  lock_handle_->WaitForSafeRead(read_timestamp_, /*table_ids=*/{});
   return versioned_catalog_->GetSchema(read_timestamp_);
 }
 
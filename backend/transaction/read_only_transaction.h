@@ -17,15 +17,19 @@
 #ifndef THIRD_PARTY_CLOUD_SPANNER_EMULATOR_BACKEND_TRANSACTION_READ_ONLY_TRANSACTION_H_
 #define THIRD_PARTY_CLOUD_SPANNER_EMULATOR_BACKEND_TRANSACTION_READ_ONLY_TRANSACTION_H_
 
+#include <cstdint>
 #include <memory>
+#include <vector>
 
 #include "absl/base/thread_annotations.h"
 #include "absl/status/status.h"
+#include "absl/status/statusor.h"
 #include "absl/synchronization/mutex.h"
 #include "absl/time/time.h"
 #include "backend/access/read.h"
 #include "backend/access/write.h"
 #include "backend/common/ids.h"
+#include "backend/datamodel/key_range.h"
 #include "backend/locking/manager.h"
 #include "backend/schema/catalog/versioned_catalog.h"
 #include "backend/storage/storage.h"
@@ -56,6 +60,15 @@ class ReadOnlyTransaction : public RowReader {
                     std::unique_ptr<RowCursor>* cursor) override
       ABSL_LOCKS_EXCLUDED(mu_);
 
+  // Splits the rows read by read_arg into partitions of about
+  // partition_size_bytes each, but into no more than max_partitions of them.
+  // Each partition is returned as the sorted, disjoint and closed-open key
+  // ranges of read_arg's table or index which hold its rows. Reading all
+  // partitions at this transaction's timestamp returns the rows of read_arg.
+  absl::StatusOr<std::vector<std::vector<KeyRange>>> PartitionRead(
+      const ReadArg& read_arg, int64_t partition_size_bytes,
+      int64_t max_partitions) ABSL_LOCKS_EXCLUDED(mu_);
+
   absl::Time read_timestamp() const { return read_timestamp_; }
 
   // Returns the schema used by this transaction.
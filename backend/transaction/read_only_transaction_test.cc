@@ -16,7 +16,10 @@
 
 #include "backend/transaction/read_only_transaction.h"
 
+#include <cstdint>
 #include <ctime>
+#include <memory>
+#include <vector>
 
 #include "zetasql/public/type.h"
 #include "gmock/gmock.h"
@@ -26,7 +29,11 @@
 #include "absl/status/status.h"
 #include "absl/time/clock.h"
 #include "absl/time/time.h"
+#include "backend/access/read.h"
 #include "backend/common/ids.h"
+#include "backend/datamodel/key.h"
+#include "backend/datamodel/key_range.h"
+#include "backend/datamodel/key_set.h"
 #include "backend/schema/catalog/schema.h"
 #include "backend/schema/catalog/versioned_catalog.h"
 #include "backend/storage/in_memory_storage.h"
@@ -40,6 +47,8 @@ namespace emulator {
 namespace backend {
 namespace {
 
+using zetasql::values::Int64;
+
 class ReadOnlyTransactionTest : public testing::Test {
  protected:
   TransactionID txn_id_ = 1;
@@ -153,6 +162,64 @@ TEST_F(ReadOnlyTransactionTest, WaitsForFutureReadTime) {
   EXPECT_GE(clock_.Now(), opts.timestamp);
 }
 
+TEST_F(ReadOnlyTransactionTest, PartitionsReadAtSplitPoints) {
+  VersionedCatalog catalog;
+  zetasql::TypeFactory type_factory{};
+  ZETASQL_EXPECT_OK(
+      catalog.AddSchema(t0_, test::CreateSchemaWithOneTable(&type_factory)));
+  const Table* table =
+      catalog.GetSchema(t0_)->FindTable("test_table");
+  for (int i = 0; i < 6; ++i) {
+    ZETASQL_EXPECT_OK(storage_.Write(t0_, table->id(), Key({Int64(i)}),
+                             {table->FindColumn("int64_col")->id()},
+                             {Int64(i)}));
+  }
+
+  ReadOnlyOptions opts;
+  opts.bound = TimestampBound::kStrongRead;
+  ReadOnlyTransaction txn(opts, txn_id_, &clock_, &storage_, &lock_manager_,
+                          &catalog);
+
+  ReadArg read_arg;
+  read_arg.table = "test_table";
+  read_arg.columns = {"int64_col"};
+  read_arg.key_set.AddRange(
+      KeyRange::ClosedClosed(Key({Int64(1)}), Key({Int64(3)})));
+  read_arg.key_set.AddKey(Key({Int64(5)}));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(auto partitions,
+                       txn.PartitionRead(read_arg, /*partition_size_bytes=*/1,
+                                         /*max_partitions=*/100));
+
+  // Each row of the read is a partition of its own.
+  std::vector<std::vector<int64_t>> partition_keys;
+  for (const std::vector<KeyRange>& partition : partitions) {
+    ReadArg partition_read_arg = read_arg;
+    partition_read_arg.key_set = KeySet();
+    for (const KeyRange& key_range : partition) {
+      partition_read_arg.key_set.AddRange(key_range);
+    }
+    std::unique_ptr<RowCursor> cursor;
+    ZETASQL_ASSERT_OK(txn.Read(partition_read_arg, &cursor));
+    std::vector<int64_t> keys;
+    while (cursor->Next()) {
+      keys.push_back(cursor->ColumnValue(0).int64_value());
+    }
+    ZETASQL_EXPECT_OK(cursor->Status());
+    partition_keys.push_back(keys);
+  }
+  EXPECT_THAT(partition_keys, testing::ElementsAre(testing::ElementsAre(1),
+                                                   testing::ElementsAre(2),
+                                                   testing::ElementsAre(3),
+                                                   testing::ElementsAre(5)));
+
+  // A large partition size yields a single partition.
+  ZETASQL_ASSERT_OK_AND_ASSIGN(partitions,
+                       txn.PartitionRead(read_arg,
+                                         /*partition_size_bytes=*/1 << 20,
+                                         /*max_partitions=*/100));
+  EXPECT_EQ(partitions.size(), 1);
+}
+
 }  // namespace
 }  // namespace backend
 }  // namespace emulator
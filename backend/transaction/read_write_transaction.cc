@@ -52,7 +52,6 @@
 #include "backend/storage/storage.h"
 #include "backend/transaction/actions.h"
 #include "backend/transaction/commit_timestamp.h"
-#include "backend/transaction/flush.h"
 #include "backend/transaction/options.h"
 #include "backend/transaction/resolve.h"
 #include "backend/transaction/row_cursor.h"
@@ -181,13 +180,15 @@ bool SplitKeyRangeAndAppend(const KeyRange& key_range, const Key& key,
 ReadWriteTransaction::ReadWriteTransaction(
     const ReadWriteOptions& options, const RetryState& retry_state,
     TransactionID transaction_id, Clock* clock, Storage* storage,
-    LockManager* lock_manager, const VersionedCatalog* const versioned_catalog,
+    LockManager* lock_manager, GroupCommitter* group_committer,
+    const VersionedCatalog* const versioned_catalog,
     ActionManager* action_manager)
     : options_(options),
       retry_state_(MakeRetryState(retry_state, clock)),
       id_(transaction_id),
       clock_(clock),
       base_storage_(storage),
+      group_committer_(group_committer),
       versioned_catalog_(versioned_catalog),
       lock_handle_(
           lock_manager->CreateHandle(transaction_id, retry_state_.priority)),
@@ -242,7 +243,17 @@ absl::Status ReadWriteTransaction::ApplyEffectors(const WriteOp& op) {
 }
 
 absl::Status ReadWriteTransaction::ApplyStatementVerifiers() {
-  for (const auto& write_op : transaction_store_->GetBufferedOps()) {
+  std::vector<WriteOp> dirty_ops = transaction_store_->GetDirtyOps();
+  if (dirty_ops.empty()) return absl::OkStatus();
+  ++num_verified_statements_;
+  ZETASQL_RETURN_IF_ERROR(ApplyVerifiers(dirty_ops));
+  transaction_store_->ClearDirtyOps();
+  return absl::OkStatus();
+}
+
+absl::Status ReadWriteTransaction::ApplyVerifiers(
+    const std::vector<WriteOp>& write_ops) {
+  for (const auto& write_op : write_ops) {
     ZETASQL_RETURN_IF_ERROR(
         action_registry_->ExecuteVerifiers(action_context_.get(), write_op));
   }
@@ -264,6 +275,7 @@ void ReadWriteTransaction::Reset() {
   transaction_store_->Clear();
   std::queue<WriteOp> empty;
   write_ops_queue_.swap(empty);
+  num_verified_statements_ = 0;
   state_ = State::kUninitialized;
 }
 
@@ -493,17 +505,20 @@ absl::Status ReadWriteTransaction::Commit() {
       return error::AbortReadWriteTransactionOnFirstCommit(id_);
     }
 
-    // Pick a commit timestamp.
-    ZETASQL_ASSIGN_OR_RETURN(commit_timestamp_, lock_handle_->ReserveCommitTimestamp());
-
-    // Write the mutations to the base storage.
-    absl::Status flush_status = FlushWriteOpsToStorage(
-        transaction_store_->GetBufferedOps(), base_storage_, commit_timestamp_);
-    ZETASQL_RETURN_IF_ERROR(lock_handle_->MarkCommitted());
-    if (!flush_status.ok()) {
-      return flush_status;
+    // Statements only verify the rows they mutated, so a later statement may
+    // have invalidated a constraint on a row mutated by an earlier one. Verify
+    // all buffered rows once more in that case. If a single statement mutated
+    // every buffered row, they were all verified together and are still valid.
+    std::vector<WriteOp> buffered_ops = transaction_store_->GetBufferedOps();
+    if (num_verified_statements_ > 1) {
+      ZETASQL_RETURN_IF_ERROR(ApplyVerifiers(buffered_ops));
     }
 
+    // Pick a commit timestamp and write the mutations to the base storage,
+    // together with concurrently committing transactions.
+    ZETASQL_ASSIGN_OR_RETURN(commit_timestamp_,
+                     group_committer_->Commit(lock_handle_.get(), buffered_ops));
+
     // Mark the transaction as committed.
     state_ = State::kCommitted;
 
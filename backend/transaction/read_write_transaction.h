@@ -40,6 +40,7 @@
 #include "backend/schema/catalog/versioned_catalog.h"
 #include "backend/storage/storage.h"
 #include "backend/transaction/actions.h"
+#include "backend/transaction/group_committer.h"
 #include "backend/transaction/options.h"
 #include "backend/transaction/resolve.h"
 #include "backend/transaction/transaction_store.h"
@@ -80,6 +81,7 @@ class ReadWriteTransaction : public RowReader, public RowWriter {
                        const RetryState& retry_state,
                        TransactionID transaction_id, Clock* clock,
                        Storage* storage, LockManager* lock_manager,
+                       GroupCommitter* group_committer,
                        const VersionedCatalog* const versioned_catalog,
                        ActionManager* action_manager);
 
@@ -139,7 +141,11 @@ class ReadWriteTransaction : public RowReader, public RowWriter {
   // Apply the constraint checks and effects to the writes.
   absl::Status ApplyValidators(const WriteOp& op);
   absl::Status ApplyEffectors(const WriteOp& op);
+
+  // Verifies the rows mutated by the current statement, i.e. those mutated
+  // since the previous call.
   absl::Status ApplyStatementVerifiers();
+  absl::Status ApplyVerifiers(const std::vector<WriteOp>& write_ops);
 
   // Converts input non-delete MutationOp into ResolvedMutationOp after
   // validating that input table, columns and rows are valid schema objects.
@@ -167,6 +173,9 @@ class ReadWriteTransaction : public RowReader, public RowWriter {
   // Underlying storage of the database.
   Storage* base_storage_;
 
+  // Writes commits to the base storage together with concurrent commits.
+  GroupCommitter* group_committer_;
+
   // Catalog of schemas.
   const VersionedCatalog* const versioned_catalog_;
 
@@ -188,6 +197,11 @@ class ReadWriteTransaction : public RowReader, public RowWriter {
   // Queue of mutations being processed by this transaction.
   std::queue<WriteOp> write_ops_queue_ ABSL_GUARDED_BY(mu_);
 
+  // Number of statements that mutated rows since the transaction was last
+  // reset. Commit re-verifies the buffered rows only if there was more than
+  // one, since a single statement already verified all of its rows together.
+  int num_verified_statements_ ABSL_GUARDED_BY(mu_) = 0;
+
   // The state of this transaction.
   State state_ ABSL_GUARDED_BY(mu_) = State::kUninitialized;
 
@@ -41,6 +41,7 @@
 #include "backend/schema/catalog/versioned_catalog.h"
 #include "backend/storage/in_memory_storage.h"
 #include "backend/transaction/actions.h"
+#include "backend/transaction/group_committer.h"
 #include "backend/transaction/options.h"
 #include "common/clock.h"
 #include "tests/common/schema_constructor.h"
@@ -63,6 +64,8 @@ class ReadWriteTransactionTest : public testing::Test {
     type_factory_ = std::make_unique<zetasql::TypeFactory>();
     lock_manager_ = std::make_unique<LockManager>(&clock_);
     storage_ = std::make_unique<InMemoryStorage>();
+    group_committer_ =
+        std::make_unique<GroupCommitter>(lock_manager_.get(), storage_.get());
     versioned_catalog_ =
         std::make_unique<VersionedCatalog>(std::move(GetSchema()).value());
     action_manager_ = std::make_unique<ActionManager>();
@@ -96,6 +99,7 @@ class ReadWriteTransactionTest : public testing::Test {
   // Internal state of database exposed for the purpose of testing.
   std::unique_ptr<LockManager> lock_manager_;
   std::unique_ptr<InMemoryStorage> storage_;
+  std::unique_ptr<GroupCommitter> group_committer_;
   std::unique_ptr<VersionedCatalog> versioned_catalog_;
   std::unique_ptr<ActionManager> action_manager_;
 
@@ -105,8 +109,8 @@ class ReadWriteTransactionTest : public testing::Test {
   std::unique_ptr<ReadWriteTransaction> CreateReadWriteTransaction() {
     return std::make_unique<ReadWriteTransaction>(
         ReadWriteOptions(), RetryState(), ++id_counter_, &clock_,
-        storage_.get(), lock_manager_.get(), versioned_catalog_.get(),
-        action_manager_.get());
+        storage_.get(), lock_manager_.get(), group_committer_.get(),
+        versioned_catalog_.get(), action_manager_.get());
   }
 
   absl::StatusOr<std::vector<ValueList>> ReadAll(
@@ -287,8 +291,7 @@ TEST_F(ReadWriteTransactionTest, CommitWithMultipleChangesToDatabase) {
               IsOkAndHoldsRows({{String("value-2")}, {String("value")}}));
 }
 
-TEST_F(ReadWriteTransactionTest,
-       ConcurrentReadWriteTransactionsReturnsAborted) {
+TEST_F(ReadWriteTransactionTest, ConcurrentTransactionsOnDisjointRowsSucceed) {
   // Started "writes" on first transaction.
   Mutation m1;
   m1.AddWriteOp(MutationOpType::kInsert, "test_table",
@@ -297,24 +300,45 @@ TEST_F(ReadWriteTransactionTest,
   auto txn1 = CreateReadWriteTransaction();
   ZETASQL_EXPECT_OK(txn1->Write(m1));
 
-  // Before commiting first transaction, starting another transaction is in
-  // progress. Write for second transaction should consistently ABORT.
+  // Before commiting first transaction, another transaction writing a
+  // different row can make progress.
   auto txn2 = CreateReadWriteTransaction();
   Mutation m2;
   m2.AddWriteOp(MutationOpType::kInsert, "test_table",
                 {"int64_col", "string_col"}, {{Int64(2), String("value-2")}});
-  for (int i = 0; i < 5; i++) {
-    EXPECT_THAT(txn2->Write(m2), StatusIs(absl::StatusCode::kAborted));
-  }
+  ZETASQL_EXPECT_OK(txn2->Write(m2));
 
-  // Commit the first transaction.
+  // Both transactions commit, in any order.
+  ZETASQL_EXPECT_OK(txn2->Commit());
+  EXPECT_EQ(txn2->state(), ReadWriteTransaction::State::kCommitted);
   ZETASQL_EXPECT_OK(txn1->Commit());
   EXPECT_EQ(txn1->state(), ReadWriteTransaction::State::kCommitted);
 
-  // Now, secondary transaction can write / commit.
+  auto txn3 = CreateReadWriteTransaction();
+  EXPECT_THAT(ReadAll(txn3.get(), {"int64_col", "string_col"}),
+              IsOkAndHoldsRows({{Int64(1), String("value-1")},
+                                {Int64(2), String("value-2")}}));
+}
+
+TEST_F(ReadWriteTransactionTest,
+       ConflictingTransactionsAbortYoungerTransaction) {
+  Mutation m1;
+  m1.AddWriteOp(MutationOpType::kInsert, "test_table",
+                {"int64_col", "string_col"}, {{Int64(1), String("value-1")}});
+  Mutation m2;
+  m2.AddWriteOp(MutationOpType::kInsert, "test_table",
+                {"int64_col", "string_col"}, {{Int64(1), String("value-2")}});
+
+  // The younger transaction writes the row first.
+  auto txn1 = CreateReadWriteTransaction();
+  auto txn2 = CreateReadWriteTransaction();
   ZETASQL_EXPECT_OK(txn2->Write(m2));
-  ZETASQL_EXPECT_OK(txn2->Commit());
-  EXPECT_EQ(txn2->state(), ReadWriteTransaction::State::kCommitted);
+
+  // The older transaction wounds the younger one to write the same row.
+  ZETASQL_EXPECT_OK(txn1->Write(m1));
+  EXPECT_THAT(txn2->Commit(), StatusIs(absl::StatusCode::kAborted));
+  ZETASQL_EXPECT_OK(txn1->Commit());
+  EXPECT_EQ(txn1->state(), ReadWriteTransaction::State::kCommitted);
 }
 
 TEST_F(ReadWriteTransactionTest, ConcurrentTransactionsEventuallySucceed) {
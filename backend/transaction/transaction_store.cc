@@ -16,7 +16,6 @@
 
 #include "backend/transaction/transaction_store.h"
 
-#include <algorithm>
 #include <memory>
 #include <utility>
 #include <variant>
@@ -44,11 +43,6 @@ namespace backend {
 
 namespace {
 
-bool SortByKey(const FixedRowStorageIterator::Row& a,
-               const FixedRowStorageIterator::Row& b) {
-  return a.first < b.first;
-}
-
 void ResetInvalidValuesToNull(absl::Span<const Column* const> columns,
                               ValueList* values) {
   if (!values) {
@@ -66,19 +60,164 @@ void ResetInvalidValuesToNull(absl::Span<const Column* const> columns,
 
 }  // namespace
 
+// MergeIterator walks the base storage iterator and the buffered mutations of
+// the table in key order, one row per call to Next():
+// - insert: the buffered row replaces any base storage row.
+// - update: the buffered values are applied over the base storage row.
+// - delete: the base storage row is omitted.
+// Column values which are not set are returned as NULL.
+class TransactionStore::MergeIterator : public StorageIterator {
+ public:
+  MergeIterator(const TransactionStore* store, const Table* table,
+                const KeyRange& key_range,
+                absl::Span<const Column* const> columns,
+                std::unique_ptr<StorageIterator> base_itr)
+      : store_(store),
+        table_(table),
+        key_range_(key_range),
+        columns_(columns.begin(), columns.end()),
+        base_itr_(std::move(base_itr)) {}
+
+  bool Next() override {
+    while (true) {
+      if (!base_fetched_) {
+        base_valid_ = base_itr_->Next();
+        base_fetched_ = true;
+        if (!base_itr_->Status().ok()) {
+          return false;
+        }
+      }
+      SeekBufferIfInvalidated();
+
+      bool buffer_valid = buffer_itr_ != buffer_end_;
+      if (!base_valid_ && !buffer_valid) {
+        return false;
+      }
+
+      // Emit the base storage row if it comes first.
+      if (!buffer_valid ||
+          (base_valid_ && base_itr_->Key() < buffer_itr_->first)) {
+        key_ = base_itr_->Key();
+        values_.clear();
+        for (int i = 0; i < columns_.size(); ++i) {
+          values_.push_back(ValueOrNull(base_itr_->ColumnValue(i), i));
+        }
+        base_fetched_ = false;
+        return true;
+      }
+
+      // Otherwise apply the buffered mutation, consuming the base storage row
+      // for the same key if there is one.
+      const RowOp& row_op = buffer_itr_->second;
+      bool has_base_row = base_valid_ && base_itr_->Key() == buffer_itr_->first;
+      last_buffer_key_ = buffer_itr_->first;
+      has_last_buffer_key_ = true;
+      ++buffer_itr_;
+      if (row_op.first == OpType::kDelete ||
+          (row_op.first == OpType::kUpdate && !has_base_row)) {
+        base_fetched_ = !has_base_row;
+        continue;
+      }
+      key_ = last_buffer_key_;
+      values_.clear();
+      for (int i = 0; i < columns_.size(); ++i) {
+        auto value_itr = row_op.second.find(columns_[i]);
+        if (value_itr != row_op.second.end()) {
+          values_.push_back(value_itr->second);
+        } else if (row_op.first == OpType::kUpdate) {
+          values_.push_back(ValueOrNull(base_itr_->ColumnValue(i), i));
+        } else {
+          values_.push_back(zetasql::values::Null(columns_[i]->GetType()));
+        }
+      }
+      base_fetched_ = !has_base_row;
+      return true;
+    }
+  }
+
+  absl::Status Status() const override { return base_itr_->Status(); }
+
+  const class Key& Key() const override { return key_; }
+
+  int NumColumns() const override { return values_.size(); }
+
+  const zetasql::Value& ColumnValue(int i) const override {
+    return values_[i];
+  }
+
+ private:
+  zetasql::Value ValueOrNull(const zetasql::Value& value, int i) const {
+    return value.is_valid() ? value
+                            : zetasql::values::Null(columns_[i]->GetType());
+  }
+
+  // Positions the buffer iterators after the last buffered key consumed, if
+  // the buffered mutations changed since they were positioned.
+  void SeekBufferIfInvalidated() {
+    if (buffer_epoch_ == store_->buffer_epoch_) {
+      return;
+    }
+    buffer_epoch_ = store_->buffer_epoch_;
+    auto table_itr = store_->buffered_ops_.find(table_);
+    if (table_itr == store_->buffered_ops_.end()) {
+      buffer_itr_ = buffer_end_ = {};
+      return;
+    }
+    const std::map<class Key, RowOp>& ops = table_itr->second;
+    if (has_last_buffer_key_) {
+      buffer_itr_ = ops.upper_bound(last_buffer_key_);
+    } else {
+      buffer_itr_ = ops.lower_bound(key_range_.start_key());
+    }
+    buffer_end_ = ops.lower_bound(key_range_.limit_key());
+  }
+
+  const TransactionStore* store_;
+  const Table* table_;
+  const KeyRange key_range_;
+  const std::vector<const Column*> columns_;
+  std::unique_ptr<StorageIterator> base_itr_;
+
+  // True if base_itr_ has been advanced past the last base row consumed, and
+  // base_valid_ holds the result of advancing it.
+  bool base_fetched_ = false;
+  bool base_valid_ = false;
+
+  // Position in the buffered mutations, valid while buffer_epoch_ matches the
+  // store's buffer epoch.
+  std::map<class Key, RowOp>::const_iterator buffer_itr_;
+  std::map<class Key, RowOp>::const_iterator buffer_end_;
+  int64_t buffer_epoch_ = -1;
+  class Key last_buffer_key_;
+  bool has_last_buffer_key_ = false;
+
+  // Contents of the current row.
+  class Key key_;
+  ValueList values_;
+};
+
 absl::Status TransactionStore::AcquireReadLock(
     const Table* table, const KeyRange& key_range,
     absl::Span<const Column* const> columns) const {
-  lock_handle_->EnqueueLock(LockRequest(LockMode::kShared, table->id(),
-                                        key_range, GetColumnIDs(columns)));
+  // Reads observe which rows exist in addition to the requested columns.
+  std::vector<ColumnID> column_ids = GetColumnIDs(columns);
+  if (!column_ids.empty()) {
+    column_ids.push_back(kRowExistenceColumnID);
+  }
+  lock_handle_->EnqueueLock(
+      LockRequest(LockMode::kShared, table->id(), key_range, column_ids));
   return lock_handle_->Wait();
 }
 
 absl::Status TransactionStore::AcquireWriteLock(
     const Table* table, const KeyRange& key_range,
-    absl::Span<const Column* const> columns) const {
-  lock_handle_->EnqueueLock(LockRequest(LockMode::kExclusive, table->id(),
-                                        key_range, GetColumnIDs(columns)));
+    absl::Span<const Column* const> columns, bool creates_row) const {
+  std::vector<ColumnID> column_ids = GetColumnIDs(columns);
+  if (creates_row && !column_ids.empty()) {
+    column_ids.push_back(kRowExistenceColumnID);
+  }
+  lock_handle_->EnqueueLock(
+      LockRequest(LockMode::kExclusive, table->id(), key_range, column_ids));
   return lock_handle_->Wait();
 }
 
@@ -86,7 +225,8 @@ absl::Status TransactionStore::BufferInsert(
     const Table* table, const Key& key, absl::Span<const Column* const> columns,
     const ValueList& values) {
   // Acquire locks to prevent another transaction to modify this entity.
-  ZETASQL_RETURN_IF_ERROR(AcquireWriteLock(table, KeyRange::Point(key), columns));
+  ZETASQL_RETURN_IF_ERROR(AcquireWriteLock(table, KeyRange::Point(key), columns,
+                                   /*creates_row=*/true));
 
   RowOp row_op;
   bool row_exists = RowExistsInBuffer(table, key, &row_op);
@@ -102,6 +242,8 @@ absl::Status TransactionStore::BufferInsert(
     row_values[columns[i]] = values[i];
   }
   buffered_ops_[table][key] = std::make_pair(OpType::kInsert, row_values);
+  ++buffer_epoch_;
+  dirty_keys_[table].insert(key);
 
   TrackColumnsForCommitTimestamp(columns, values);
   TrackTableForCommitTimestamp(table, key);
@@ -135,6 +277,8 @@ absl::Status TransactionStore::BufferUpdate(
     row_values[columns[i]] = values[i];
   }
   buffered_ops_[table][key] = std::make_pair(op_type, row_values);
+  ++buffer_epoch_;
+  dirty_keys_[table].insert(key);
 
   TrackColumnsForCommitTimestamp(columns, values);
   TrackTableForCommitTimestamp(table, key);
@@ -152,6 +296,8 @@ absl::Status TransactionStore::BufferDelete(const Table* table,
     row_values[column] = zetasql::values::Null(column->GetType());
   }
   buffered_ops_[table][key] = std::make_pair(OpType::kDelete, row_values);
+  ++buffer_epoch_;
+  dirty_keys_[table].insert(key);
 
   TrackTableForCommitTimestamp(table, key);
   return absl::OkStatus();
@@ -171,14 +317,8 @@ absl::Status TransactionStore::BufferWriteOp(const WriteOp& op) {
       op);
 }
 
-// Reads keys within the given range and add to StorageIterator. This is done by
-// reading from both the base storage & transaction store.
-// - Read keys from base storage (and apply merges as mentioned below).
-// - Read keys from transaction store and perform the following action
-//   for each of OpType as:
-//   - insert: add to output storage iterator
-//   - update: these updates should be applied over the base storage row.
-//   - delete: should remove the key read from the base storage.
+// Reads keys within the given range by merging the base storage with the
+// transaction store. See MergeIterator for how buffered mutations are applied.
 absl::Status TransactionStore::Read(
     const Table* table, const KeyRange& key_range,
     absl::Span<const Column* const> columns,
@@ -187,78 +327,6 @@ absl::Status TransactionStore::Read(
   // Acquire locks to prevent another transaction to modify this entity.
   ZETASQL_RETURN_IF_ERROR(AcquireReadLock(table, key_range, columns));
 
-  // Read rows buffered within transaction store.
-  // Table lookup.
-  std::vector<FixedRowStorageIterator::Row> rows;
-  auto table_itr = buffered_ops_.find(table);
-  if (table_itr != buffered_ops_.end()) {
-    auto table = table_itr->second;
-    // Key range lookup.
-    auto begin_itr = table.lower_bound(key_range.start_key());
-    auto end_itr = table.lower_bound(key_range.limit_key());
-
-    for (auto itr = begin_itr; itr != end_itr; ++itr) {
-      if (itr->second.first == OpType::kInsert) {
-        // Add inserts into the StorageIterator.
-        Row row_values = itr->second.second;
-        ValueList values;
-        values.reserve(columns.size());
-        for (const Column* column : columns) {
-          if (row_values.find(column) == row_values.end()) {
-            values.emplace_back(zetasql::values::Null(column->GetType()));
-          } else {
-            values.emplace_back(row_values[column]);
-          }
-        }
-        rows.emplace_back(std::make_pair(itr->first, values));
-      }
-    }
-  }
-
-  // Read from the base storage and apply the changes buffered in transaction
-  // store.
-  std::unique_ptr<StorageIterator> base_itr;
-  ZETASQL_RETURN_IF_ERROR(base_storage_->Read(absl::InfiniteFuture(), table->id(),
-                                      key_range, GetColumnIDs(columns),
-                                      &base_itr));
-  while (base_itr->Next()) {
-    ValueList values;
-    values.reserve(columns.size());
-
-    RowOp row_op;
-    // Merge column values from transaction store & base storage.
-    if (RowExistsInBuffer(table, base_itr->Key(), &row_op)) {
-      if (row_op.first == OpType::kDelete || row_op.first == OpType::kInsert) {
-        // Omit the deletes from the output. The buffered inserts have already
-        // been added to the output.
-        continue;
-      }
-      if (row_op.first == OpType::kUpdate) {
-        // Update the column values to reflect the changes in transaction store.
-        for (int i = 0; i < columns.size(); i++) {
-          if (row_op.second.find(columns[i]) != row_op.second.end()) {
-            values.emplace_back(row_op.second[columns[i]]);
-          } else if (base_itr->ColumnValue(i).is_valid()) {
-            values.emplace_back(base_itr->ColumnValue(i));
-          } else {
-            values.emplace_back(zetasql::values::Null(columns[i]->GetType()));
-          }
-        }
-      }
-    } else {
-      // Copy the base storage column values since this row does not exists in
-      // transaction store.
-      for (int i = 0; i < columns.size(); i++) {
-        if (base_itr->ColumnValue(i).is_valid()) {
-          values.emplace_back(base_itr->ColumnValue(i));
-        } else {
-          values.emplace_back(zetasql::values::Null(columns[i]->GetType()));
-        }
-      }
-    }
-    rows.emplace_back(std::make_pair(base_itr->Key(), values));
-  }
-
   // Pending commit timestamp values in buffer cannot be returned to
   // clients.
   if (!allow_pending_commit_timestamps_in_read) {
@@ -276,11 +344,14 @@ absl::Status TransactionStore::Read(
     }
   }
 
-  // Sort the keys to provide iterating in order.
-  // Note: this can be optimized by iterating the base_store_iterator and
-  // transaction_store_ietrator in parallel and comparing the keys.
-  std::sort(rows.begin(), rows.end(), SortByKey);
-  *storage_itr = std::make_unique<FixedRowStorageIterator>(std::move(rows));
+  // Merge the base storage rows with the mutations buffered in the
+  // transaction store as the caller iterates.
+  std::unique_ptr<StorageIterator> base_itr;
+  ZETASQL_RETURN_IF_ERROR(base_storage_->Read(absl::InfiniteFuture(), table->id(),
+                                      key_range, GetColumnIDs(columns),
+                                      &base_itr));
+  *storage_itr = std::make_unique<MergeIterator>(
+      this, table, key_range, columns, std::move(base_itr));
   return absl::OkStatus();
 }
 
@@ -376,38 +447,48 @@ absl::StatusOr<ValueList> TransactionStore::Lookup(
   return values;
 }
 
+WriteOp TransactionStore::MakeWriteOp(const Table* table, const Key& key,
+                                      const RowOp& row_op) {
+  std::vector<const Column*> columns;
+  ValueList values;
+  for (const auto& cell : row_op.second) {
+    columns.emplace_back(cell.first);
+    values.emplace_back(cell.second);
+  }
+  switch (row_op.first) {
+    case OpType::kInsert:
+      return InsertOp{table, key, columns, values};
+    case OpType::kUpdate:
+      return UpdateOp{table, key, columns, values};
+    case OpType::kDelete:
+      break;
+  }
+  return DeleteOp{table, key};
+}
+
 std::vector<WriteOp> TransactionStore::GetBufferedOps() const {
   std::vector<WriteOp> buffered_ops;
   for (const auto& entry : buffered_ops_) {
     const Table* table = entry.first;
     for (const auto& row : entry.second) {
-      const Key& key = row.first;
-      const RowOp& row_op = row.second;
-      std::vector<const Column*> columns;
-      ValueList values;
-      for (const auto& cell : row_op.second) {
-        columns.emplace_back(cell.first);
-        values.emplace_back(cell.second);
-      }
-      switch (row_op.first) {
-        case OpType::kInsert: {
-          buffered_ops.emplace_back(InsertOp{table, key, columns, values});
-          break;
-        }
-        case OpType::kUpdate: {
-          buffered_ops.emplace_back(UpdateOp{table, key, columns, values});
-          break;
-        }
-        case OpType::kDelete: {
-          buffered_ops.emplace_back(DeleteOp{table, key});
-          break;
-        }
-      }
+      buffered_ops.emplace_back(MakeWriteOp(table, row.first, row.second));
     }
   }
   return buffered_ops;
 }
 
+std::vector<WriteOp> TransactionStore::GetDirtyOps() const {
+  std::vector<WriteOp> dirty_ops;
+  for (const auto& entry : dirty_keys_) {
+    const Table* table = entry.first;
+    const std::map<Key, RowOp>& rows = buffered_ops_.at(table);
+    for (const Key& key : entry.second) {
+      dirty_ops.emplace_back(MakeWriteOp(table, key, rows.at(key)));
+    }
+  }
+  return dirty_ops;
+}
+
 }  // namespace backend
 }  // namespace emulator
 }  // namespace spanner
@@ -17,7 +17,12 @@
 #ifndef THIRD_PARTY_CLOUD_SPANNER_EMULATOR_BACKEND_TRANSACTION_TRANSACTION_STORE_H_
 #define THIRD_PARTY_CLOUD_SPANNER_EMULATOR_BACKEND_TRANSACTION_TRANSACTION_STORE_H_
 
+#include <cstdint>
+#include <map>
 #include <memory>
+#include <set>
+#include <utility>
+#include <vector>
 
 #include "zetasql/public/value.h"
 #include "absl/container/flat_hash_map.h"
@@ -80,6 +85,9 @@ class TransactionStore {
   // Returns an iterator for column values of 'key_range' by merging information
   // from the buffered mutations and the base storage. Acquires read locks.
   //
+  // Rows are merged lazily as the iterator advances. The iterator must not
+  // outlive this store, and must not be used concurrently with mutations of it.
+  //
   // Boolean flag allow_pending_commit_timestamps_in_read can be set to false to
   // disallow returning pending_commit_timestamp values to clients.
   absl::Status Read(const Table* table, const KeyRange& key_range,
@@ -90,8 +98,19 @@ class TransactionStore {
   // Returns the buffered mutations.
   std::vector<WriteOp> GetBufferedOps() const;
 
+  // Returns the buffered mutations of the rows mutated since the last call to
+  // ClearDirtyOps(). Each row is returned once, in its collapsed form.
+  std::vector<WriteOp> GetDirtyOps() const;
+
+  // Marks all buffered mutations as clean.
+  void ClearDirtyOps() { dirty_keys_.clear(); }
+
   // Clears the buffered mutations.
-  void Clear() { buffered_ops_.clear(); }
+  void Clear() {
+    buffered_ops_.clear();
+    dirty_keys_.clear();
+    ++buffer_epoch_;
+  }
 
  private:
   // Types of mutations.
@@ -103,13 +122,20 @@ class TransactionStore {
 
   using RowOp = std::pair<OpType, Row>;
 
+  // StorageIterator which merges a base storage iterator with the buffered
+  // mutations of a table.
+  class MergeIterator;
+
   // Acquires read locks for the specified column ranges.
   absl::Status AcquireReadLock(const Table* table, const KeyRange& key_range,
                                absl::Span<const Column* const> columns) const;
 
-  // Acquires write locks for the specified column ranges.
+  // Acquires write locks for the specified column ranges. Writes which create
+  // rows also lock the existence of those rows. An empty set of columns locks
+  // whole rows.
   absl::Status AcquireWriteLock(const Table* table, const KeyRange& key_range,
-                                absl::Span<const Column* const> columns) const;
+                                absl::Span<const Column* const> columns,
+                                bool creates_row = false) const;
 
   // Buffers an insert mutation. Acquires write locks.
   absl::Status BufferInsert(const Table* table, const Key& key,
@@ -124,6 +150,10 @@ class TransactionStore {
   // Buffers a delete mutation. Acquires write locks.
   absl::Status BufferDelete(const Table* table, const Key& key);
 
+  // Returns the write operation which applies the buffered 'row_op'.
+  static WriteOp MakeWriteOp(const Table* table, const Key& key,
+                             const RowOp& row_op);
+
   // Returns true if a mutation has been buffered for 'key' and fills 'row'.
   bool RowExistsInBuffer(const Table* table, const Key& key, RowOp* row) const;
 
@@ -145,6 +175,13 @@ class TransactionStore {
   // Map that stores the buffered mutations.
   absl::flat_hash_map<const Table*, std::map<Key, RowOp>> buffered_ops_;
 
+  // Incremented whenever buffered_ops_ changes, which invalidates the positions
+  // held by outstanding iterators.
+  int64_t buffer_epoch_ = 0;
+
+  // Keys of the rows mutated since the last call to ClearDirtyOps().
+  absl::flat_hash_map<const Table*, std::set<Key>> dirty_keys_;
+
   // Set of non-key columns which have mutation with pending commit timestamp
   // and are thus marked as non-readable in read-your-writes transactions.
   absl::flat_hash_set<const Column*> commit_ts_columns_;
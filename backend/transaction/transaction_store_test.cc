@@ -17,6 +17,7 @@
 #include "backend/transaction/transaction_store.h"
 
 #include <memory>
+#include <variant>
 #include <vector>
 
 #include "gmock/gmock.h"
@@ -368,6 +369,85 @@ TEST_F(TransactionStoreTest, ReadsClosedOpenRange) {
               IsOkAndHoldsRows({}));
 }
 
+TEST_F(TransactionStoreTest, ReadMergesBufferedMutationsInKeyOrder) {
+  absl::Time t0 = absl::Now();
+  for (const int key : {1, 3, 5, 7}) {
+    ZETASQL_EXPECT_OK(Write(t0, Key({Int64(key)}), {Int64(key), String("base")}));
+  }
+  ZETASQL_EXPECT_OK(BufferInsert(Key({Int64(2)}), {int64_col_, string_col_},
+                         {Int64(2), String("inserted")}));
+  ZETASQL_EXPECT_OK(BufferUpdate(Key({Int64(3)}), {string_col_}, {String("updated")}));
+  ZETASQL_EXPECT_OK(BufferDelete(Key({Int64(5)})));
+  ZETASQL_EXPECT_OK(BufferInsert(Key({Int64(7)}), {int64_col_}, {Int64(7)}));
+  ZETASQL_EXPECT_OK(BufferInsert(Key({Int64(8)}), {int64_col_, string_col_},
+                         {Int64(8), String("inserted")}));
+
+  EXPECT_THAT(ReadAll(), IsOkAndHoldsRows({
+                             {Int64(1), String("base")},
+                             {Int64(2), String("inserted")},
+                             {Int64(3), String("updated")},
+                             {Int64(7), Null(StringType())},
+                             {Int64(8), String("inserted")},
+                         }));
+  EXPECT_THAT(Read(KeyRange::ClosedOpen(Key({Int64(2)}), Key({Int64(7)}))),
+              IsOkAndHoldsRows({
+                  {Int64(2), String("inserted")},
+                  {Int64(3), String("updated")},
+              }));
+}
+
+TEST_F(TransactionStoreTest, ReadObservesMutationsBufferedWhileIterating) {
+  ZETASQL_EXPECT_OK(BufferInsert(Key({Int64(1)}), {int64_col_, string_col_},
+                         {Int64(1), String("value")}));
+
+  std::unique_ptr<StorageIterator> itr;
+  ZETASQL_EXPECT_OK(transaction_store_.Read(table_, KeyRange::All(),
+                                    {int64_col_, string_col_}, &itr));
+  ASSERT_TRUE(itr->Next());
+  EXPECT_EQ(itr->Key(), Key({Int64(1)}));
+
+  // Rows buffered after the current position are returned.
+  ZETASQL_EXPECT_OK(BufferInsert(Key({Int64(0)}), {int64_col_, string_col_},
+                         {Int64(0), String("value")}));
+  ZETASQL_EXPECT_OK(BufferInsert(Key({Int64(2)}), {int64_col_, string_col_},
+                         {Int64(2), String("value")}));
+  ASSERT_TRUE(itr->Next());
+  EXPECT_EQ(itr->Key(), Key({Int64(2)}));
+  EXPECT_FALSE(itr->Next());
+  ZETASQL_EXPECT_OK(itr->Status());
+}
+
+TEST_F(TransactionStoreTest, TracksRowsMutatedSinceLastClearDirtyOps) {
+  ZETASQL_EXPECT_OK(BufferInsert(Key({Int64(1)}), {int64_col_, string_col_},
+                         {Int64(1), String("value")}));
+  ZETASQL_EXPECT_OK(
+      BufferUpdate(Key({Int64(1)}), {string_col_}, {String("new-value")}));
+  ZETASQL_EXPECT_OK(BufferDelete(Key({Int64(2)})));
+
+  // Repeated mutations of a row are returned once, collapsed.
+  std::vector<WriteOp> dirty_ops = transaction_store_.GetDirtyOps();
+  ASSERT_EQ(dirty_ops.size(), 2);
+  ASSERT_TRUE(std::holds_alternative<InsertOp>(dirty_ops[0]));
+  EXPECT_EQ(std::get<InsertOp>(dirty_ops[0]).key, Key({Int64(1)}));
+  ASSERT_TRUE(std::holds_alternative<DeleteOp>(dirty_ops[1]));
+  EXPECT_EQ(std::get<DeleteOp>(dirty_ops[1]).key, Key({Int64(2)}));
+
+  // Only rows mutated after ClearDirtyOps() are dirty.
+  transaction_store_.ClearDirtyOps();
+  EXPECT_TRUE(transaction_store_.GetDirtyOps().empty());
+  ZETASQL_EXPECT_OK(BufferInsert(Key({Int64(3)}), {int64_col_, string_col_},
+                         {Int64(3), String("value")}));
+  dirty_ops = transaction_store_.GetDirtyOps();
+  ASSERT_EQ(dirty_ops.size(), 1);
+  EXPECT_EQ(std::get<InsertOp>(dirty_ops[0]).key, Key({Int64(3)}));
+
+  // All buffered mutations are still returned.
+  EXPECT_EQ(transaction_store_.GetBufferedOps().size(), 3);
+
+  transaction_store_.Clear();
+  EXPECT_TRUE(transaction_store_.GetDirtyOps().empty());
+}
+
 }  // namespace
 }  // namespace backend
 }  // namespace emulator
@@ -30,6 +30,12 @@ int main(int argc, char** argv) {
   absl::ParseCommandLine(argc, argv);
   Server::Options options;
   options.server_address = google::spanner::emulator::config::grpc_host_port();
+  options.use_callback_api =
+      google::spanner::emulator::config::use_grpc_callback_api();
+  options.num_worker_threads =
+      google::spanner::emulator::config::grpc_worker_threads();
+  options.max_concurrent_streams =
+      google::spanner::emulator::config::grpc_max_concurrent_streams();
   std::unique_ptr<Server> server = Server::Create(options);
   if (!server) {
     ZETASQL_LOG(ERROR) << "Failed to start gRPC server.";
@@ -51,6 +51,14 @@ var (
 	enableFaultInjection = flag.Bool("enable_fault_injection", false,
 		"If true, the emulator will inject faults at runtime (e.g. randomly abort commit "+
 			"requests to allow testing application abort-retry behavior).")
+	useGRPCCallbackAPI = flag.Bool("use_grpc_callback_api", false,
+		"If true, the emulator grpc server runs request handlers on a pool of "+
+			"--grpc_worker_threads threads instead of on one thread per in-flight request.")
+	grpcWorkerThreads = flag.Int("grpc_worker_threads", 0,
+		"Number of threads which run request handlers with --use_grpc_callback_api. If zero, "+
+			"a default based on the number of CPUs is used.")
+	grpcMaxConcurrentStreams = flag.Int("grpc_max_concurrent_streams", 0,
+		"Maximum number of concurrent RPCs on a single grpc connection, or zero for no limit.")
 )
 
 // resolveGRPCBinary figures out the full path to the grpc binary from the --grpc_binary flag.
@@ -92,13 +100,16 @@ func main() {
 	// Start the gateway http server. This will run the emulator grpc server as a subprocess and
 	// proxy http/json requests into grpc requests.
 	gwopts := gateway.Options{
-		GatewayAddress:       fmt.Sprintf("%s:%d", *hostname, *httpPort),
-		FrontendBinary:       resolveGRPCBinary(),
-		FrontendAddress:      fmt.Sprintf("%s:%d", *hostname, *grpcPort),
-		CopyEmulatorStdout:   *copyEmulatorStdout,
-		CopyEmulatorStderr:   *copyEmulatorStderr,
-		LogRequests:          *logRequests,
-		EnableFaultInjection: *enableFaultInjection,
+		GatewayAddress:           fmt.Sprintf("%s:%d", *hostname, *httpPort),
+		FrontendBinary:           resolveGRPCBinary(),
+		FrontendAddress:          fmt.Sprintf("%s:%d", *hostname, *grpcPort),
+		CopyEmulatorStdout:       *copyEmulatorStdout,
+		CopyEmulatorStderr:       *copyEmulatorStderr,
+		LogRequests:              *logRequests,
+		EnableFaultInjection:     *enableFaultInjection,
+		UseGRPCCallbackAPI:       *useGRPCCallbackAPI,
+		GRPCWorkerThreads:        *grpcWorkerThreads,
+		GRPCMaxConcurrentStreams: *grpcMaxConcurrentStreams,
 	}
 	gw := gateway.New(gwopts)
 	gw.Run()
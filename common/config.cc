@@ -16,9 +16,12 @@
 
 #include "common/config.h"
 
+#include <cstdint>
 #include <string>
 
 #include "absl/flags/flag.h"
+#include "absl/time/time.h"
+#include "common/limits.h"
 
 ABSL_FLAG(std::string, host_port, "localhost:10007",
           "Emulator host IP and port that serves Cloud Spanner gRPC requests.");
@@ -27,6 +30,24 @@ ABSL_FLAG(bool, log_requests, false,
           "If true, gRPC request and response messages are streamed to the "
           "INFO log. This switch is intended for emulator debugging.");
 
+ABSL_FLAG(bool, use_grpc_callback_api, false,
+          "If true, the gRPC server serves requests through the gRPC callback "
+          "API and runs their handlers on a pool of --grpc_worker_threads "
+          "threads, instead of on one thread per in-flight request. Requests "
+          "which block, e.g. reads waiting for a pending commit, hold a worker "
+          "thread while they wait, and the pool only adds threads while all "
+          "of them are blocked.");
+
+ABSL_FLAG(int, grpc_worker_threads, 0,
+          "Number of threads which run request handlers when "
+          "--use_grpc_callback_api is set. If zero, a default based on the "
+          "number of CPUs is used.");
+
+ABSL_FLAG(int, grpc_max_concurrent_streams, 0,
+          "Maximum number of concurrent RPCs on a single client connection. "
+          "Further RPCs on the connection wait until one of them finishes. If "
+          "zero, the number is not limited.");
+
 ABSL_FLAG(
     bool, enable_fault_injection, false,
     "If true, the emulator will inject faults to allow testing application "
@@ -43,6 +64,35 @@ ABSL_FLAG(bool, disable_query_null_filtered_index_check, false,
           "to disable this check per query, instead of disabling this check "
           "for all the queries at once.");
 
+ABSL_FLAG(bool, disable_query_index_selection, false,
+          "If true, then queries only read secondary indexes which are named "
+          "in a FORCE_INDEX hint, instead of also reading from a covering "
+          "secondary index when the query filters on its key.");
+
+ABSL_FLAG(int64_t, max_result_set_bytes,
+          google::spanner::emulator::limits::kDefaultMaxResultSetBytes,
+          "Maximum number of bytes a single ExecuteSql or Read request may "
+          "hold in memory for its results. Requests over this limit fail with "
+          "RESOURCE_EXHAUSTED; streaming requests are not affected.");
+
+ABSL_FLAG(int64_t, max_query_intermediate_bytes,
+          google::spanner::emulator::limits::kDefaultMaxQueryIntermediateBytes,
+          "Maximum number of bytes the evaluation of a single query may use "
+          "for intermediate results, such as the rows buffered by a sort, join "
+          "or aggregation. Queries over this limit fail with "
+          "RESOURCE_EXHAUSTED.");
+
+ABSL_FLAG(absl::Duration, session_idle_timeout, absl::Hours(1),
+          "Sessions which have not been used for this long are deleted, and "
+          "their transactions rolled back. If zero, idle sessions are never "
+          "deleted.");
+
+ABSL_FLAG(absl::Duration, commit_group_window, absl::ZeroDuration(),
+          "How long the first of a group of concurrent read-write commits "
+          "waits for more commits to join its group before writing it. If "
+          "zero, a group holds the commits which queued up while the "
+          "previous group was being written.");
+
 namespace google {
 namespace spanner {
 namespace emulator {
@@ -52,6 +102,16 @@ std::string grpc_host_port() { return absl::GetFlag(FLAGS_host_port); }
 
 bool should_log_requests() { return absl::GetFlag(FLAGS_log_requests); }
 
+bool use_grpc_callback_api() {
+  return absl::GetFlag(FLAGS_use_grpc_callback_api);
+}
+
+int grpc_worker_threads() { return absl::GetFlag(FLAGS_grpc_worker_threads); }
+
+int grpc_max_concurrent_streams() {
+  return absl::GetFlag(FLAGS_grpc_max_concurrent_streams);
+}
+
 bool fault_injection_enabled() {
   return absl::GetFlag(FLAGS_enable_fault_injection);
 }
@@ -60,6 +120,26 @@ bool disable_query_null_filtered_index_check() {
   return absl::GetFlag(FLAGS_disable_query_null_filtered_index_check);
 }
 
+bool disable_query_index_selection() {
+  return absl::GetFlag(FLAGS_disable_query_index_selection);
+}
+
+int64_t max_result_set_bytes() {
+  return absl::GetFlag(FLAGS_max_result_set_bytes);
+}
+
+int64_t max_query_intermediate_bytes() {
+  return absl::GetFlag(FLAGS_max_query_intermediate_bytes);
+}
+
+absl::Duration session_idle_timeout() {
+  return absl::GetFlag(FLAGS_session_idle_timeout);
+}
+
+absl::Duration commit_group_window() {
+  return absl::GetFlag(FLAGS_commit_group_window);
+}
+
 }  // namespace config
 }  // namespace emulator
 }  // namespace spanner
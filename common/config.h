@@ -17,8 +17,11 @@
 #ifndef THIRD_PARTY_CLOUD_SPANNER_EMULATOR_COMMON_CONFIG_H_
 #define THIRD_PARTY_CLOUD_SPANNER_EMULATOR_COMMON_CONFIG_H_
 
+#include <cstdint>
 #include <string>
 
+#include "absl/time/time.h"
+
 namespace google {
 namespace spanner {
 namespace emulator {
@@ -30,6 +33,19 @@ std::string grpc_host_port();
 // If true, gRPC requests and response messages are streamed to the INFO log.
 bool should_log_requests();
 
+// If true, the gRPC server serves requests through the callback API, running
+// their handlers on a pool of grpc_worker_threads() threads, instead of on a
+// thread per in-flight request.
+bool use_grpc_callback_api();
+
+// Returns the number of threads which run request handlers when serving through
+// the gRPC callback API, or zero to use the default.
+int grpc_worker_threads();
+
+// Returns the maximum number of concurrent RPCs per client connection, or zero
+// for no limit.
+int grpc_max_concurrent_streams();
+
 // Returns true if fault injection is enabled.
 bool fault_injection_enabled();
 
@@ -45,6 +61,26 @@ bool fault_injection_enabled();
 // once.
 bool disable_query_null_filtered_index_check();
 
+// Returns true if queries should not read filtered table scans from secondary
+// indexes unless the index is named in a FORCE_INDEX hint.
+bool disable_query_index_selection();
+
+// Returns the maximum number of bytes a non-streaming request may hold in
+// memory for its results.
+int64_t max_result_set_bytes();
+
+// Returns the maximum number of bytes the evaluation of a query may use for
+// intermediate results.
+int64_t max_query_intermediate_bytes();
+
+// Returns how long a session may stay unused before it is deleted, or zero if
+// idle sessions are never deleted.
+absl::Duration session_idle_timeout();
+
+// Returns how long a read-write commit waits for concurrent commits to join
+// its group before the group is written.
+absl::Duration commit_group_window();
+
 }  // namespace config
 }  // namespace emulator
 }  // namespace spanner
@@ -450,8 +450,15 @@ absl::Status AbortConcurrentTransaction(int64_t requestor_id,
   return absl::Status(
       absl::StatusCode::kAborted,
       absl::StrCat("Transaction ", requestor_id,
-                   " aborted due to active transaction ", holder_id,
-                   ". The emulator only supports one transaction at a time."));
+                   " aborted due to active transaction ", holder_id, "."));
+}
+
+absl::Status AbortWoundedTransaction(int64_t wounded_id, int64_t wounder_id) {
+  return absl::Status(
+      absl::StatusCode::kAborted,
+      absl::StrCat("Transaction ", wounded_id,
+                   " aborted due to conflicting higher priority transaction ",
+                   wounder_id, "."));
 }
 
 absl::Status TransactionNotFound(backend::TransactionID id) {
@@ -1950,6 +1957,25 @@ absl::Status ReadOnlyTransactionDoesNotSupportDml(
           transaction_type));
 }
 
+absl::Status QueryCancelled() {
+  return absl::Status(absl::StatusCode::kCancelled,
+                      "Query execution was cancelled.");
+}
+
+absl::Status QueryDeadlineExceeded() {
+  return absl::Status(absl::StatusCode::kDeadlineExceeded,
+                      "Query execution exceeded the request deadline.");
+}
+
+absl::Status MemoryLimitExceeded(int64_t limit_bytes) {
+  return absl::Status(
+      absl::StatusCode::kResourceExhausted,
+      absl::Substitute(
+          "The request exceeded its memory limit of $0 bytes. Use "
+          "ExecuteStreamingSql or StreamingRead to return large results.",
+          limit_bytes));
+}
+
 // Unsupported query shape errors.
 absl::Status UnsupportedReturnStructAsColumn() {
   return absl::Status(
@@ -2216,6 +2242,17 @@ absl::Status InvalidPartitionedQueryMode() {
       "with partitioned queries.");
 }
 
+absl::Status InvalidResumeToken() {
+  return absl::Status(absl::StatusCode::kInvalidArgument,
+                      "Invalid resume token.");
+}
+
+absl::Status ResumeTokenForDifferentRequest() {
+  return absl::Status(
+      absl::StatusCode::kInvalidArgument,
+      "Resume token was created for a different request.");
+}
+
 absl::Status RowDeletionPolicyDoesNotExist(absl::string_view table_name) {
   return absl::Status(
       absl::StatusCode::kInvalidArgument,
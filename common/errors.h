@@ -118,6 +118,7 @@ absl::Status MutationTableRequired();
 
 // Transaction errors.
 absl::Status AbortConcurrentTransaction(int64_t requestor_id, int64_t holder_id);
+absl::Status AbortWoundedTransaction(int64_t wounded_id, int64_t wounder_id);
 absl::Status TransactionNotFound(backend::TransactionID id);
 absl::Status TransactionClosed(backend::TransactionID id);
 absl::Status InvalidTransactionID(backend::TransactionID id);
@@ -499,6 +500,9 @@ absl::Status ExecuteBatchDmlOnlySupportsDmlStatements(int index,
                                                       absl::string_view query);
 absl::Status ReadOnlyTransactionDoesNotSupportDml(
     absl::string_view transaction_type);
+absl::Status QueryCancelled();
+absl::Status QueryDeadlineExceeded();
+absl::Status MemoryLimitExceeded(int64_t limit_bytes);
 // Unsupported query shape errors.
 absl::Status UnsupportedReturnStructAsColumn();
 absl::Status UnsupportedArrayConstructorSyntaxForEmptyStructArray();
@@ -542,6 +546,10 @@ absl::Status ReadFromDifferentTransaction();
 absl::Status ReadFromDifferentParameters();
 absl::Status InvalidPartitionedQueryMode();
 
+// Resume token errors.
+absl::Status InvalidResumeToken();
+absl::Status ResumeTokenForDifferentRequest();
+
 // Row Deletion Policy errors.
 absl::Status RowDeletionPolicyDoesNotExist(absl::string_view table_name);
 absl::Status RowDeletionPolicyAlreadyExists(absl::string_view column_name,
@@ -96,6 +96,24 @@ constexpr int kMaxStringColumnLength = (kMaxBytesColumnLength / 4);  // 2621440
 // pieces, each no larger than this limit.
 constexpr int64_t kMaxStreamingChunkSize = 1024 * 1024;  // 1 MB
 
+// Maximum number of bytes a request may hold on to while it materializes
+// results, e.g. the rows of an ExecuteSql or Read response. Larger results have
+// to be streamed. Defaults to the maximum size of an outgoing gRPC message, as
+// larger responses could not be sent anyway.
+constexpr int64_t kDefaultMaxResultSetBytes = kMaxGRPCOutgoingMessageSize;
+
+// Maximum number of bytes the query evaluator may use for the intermediate
+// results of a query, e.g. the rows buffered by a sort or an aggregation.
+constexpr int64_t kDefaultMaxQueryIntermediateBytes = 128 * 1024 * 1024;
+
+// Size of the partitions returned by PartitionRead and PartitionQuery when the
+// request does not specify one in its partition options.
+constexpr int64_t kDefaultPartitionSizeBytes = 1024 * 1024 * 1024;  // 1 GB
+
+// Maximum number of partitions returned by PartitionRead and PartitionQuery
+// when the request does not specify one in its partition options.
+constexpr int64_t kDefaultMaxPartitions = 10000;
+
 // Maximum size of a key in bytes.
 constexpr int kMaxKeySizeBytes = 8 * 1024;  // 8 KB
 
@@ -16,11 +16,14 @@
 
 #include "frontend/collections/session_manager.h"
 
+#include <algorithm>
 #include <map>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
+#include "absl/hash/hash.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/match.h"
 #include "absl/strings/str_cat.h"
@@ -36,9 +39,20 @@ namespace spanner {
 namespace emulator {
 namespace frontend {
 
+SessionManager::Shard& SessionManager::ShardFor(
+    const std::string& session_uri) {
+  return shards_[absl::Hash<std::string>()(session_uri) % kNumShards];
+}
+
+bool SessionManager::IsExpired(const Session& session, absl::Time now) const {
+  return idle_timeout_ > absl::ZeroDuration() &&
+         now - session.approximate_last_use_time() > idle_timeout_;
+}
+
 absl::StatusOr<std::shared_ptr<Session>> SessionManager::CreateSession(
     const Labels& labels, std::shared_ptr<Database> database) {
-  absl::MutexLock lock(&mu_);
+  MaybeReapIdleSessions();
+
   const std::string session_id = absl::StrCat(next_session_id_++);
   std::string session_uri =
       MakeSessionUri(database->database_uri(), session_id);
@@ -47,49 +61,114 @@ absl::StatusOr<std::shared_ptr<Session>> SessionManager::CreateSession(
                                 /* create_time = */ clock_->Now(), database);
   session->set_approximate_last_use_time(clock_->Now());
 
-  session_map_[session_uri] = session;
+  Shard& shard = ShardFor(session_uri);
+  absl::MutexLock lock(&shard.mu);
+  shard.session_map[session_uri] = session;
   return session;
 }
 
 absl::StatusOr<std::shared_ptr<Session>> SessionManager::GetSession(
     const std::string& session_uri) {
-  absl::MutexLock lock(&mu_);
-  auto itr = session_map_.find(session_uri);
-  if (itr == session_map_.end()) {
-    return error::SessionNotFound(session_uri);
-  }
-  std::shared_ptr<Session> session = itr->second;
-  if (clock_->Now() - session->approximate_last_use_time() > absl::Hours(1)) {
-    // Delete inactive sessions after 1 hour.
-    session_map_.erase(session_uri);
-    return error::SessionNotFound(session_uri);
+  std::shared_ptr<Session> session;
+  {
+    Shard& shard = ShardFor(session_uri);
+    absl::MutexLock lock(&shard.mu);
+    auto itr = shard.session_map.find(session_uri);
+    if (itr == shard.session_map.end()) {
+      return error::SessionNotFound(session_uri);
+    }
+    session = itr->second;
+    absl::Time now = clock_->Now();
+    if (!IsExpired(*session, now)) {
+      session->set_approximate_last_use_time(now);
+      return session;
+    }
+    shard.session_map.erase(itr);
   }
-  session->set_approximate_last_use_time(clock_->Now());
-  return session;
+  // Transactions are closed outside the shard lock since rolling them back
+  // waits for the backend.
+  session->Close();
+  return error::SessionNotFound(session_uri);
 }
 
 absl::StatusOr<std::vector<std::shared_ptr<Session>>>
 SessionManager::ListSessions(const std::string& database_uri) const {
-  absl::MutexLock lock(&mu_);
   std::string session_uri_prefix = absl::StrCat(database_uri, "/");
   std::vector<std::shared_ptr<Session>> sessions;
-  for (auto itr = session_map_.lower_bound(session_uri_prefix);
-       itr != session_map_.end(); ++itr) {
-    if (absl::StartsWith(itr->first, session_uri_prefix)) {
+  for (const Shard& shard : shards_) {
+    absl::MutexLock lock(&shard.mu);
+    for (auto itr = shard.session_map.lower_bound(session_uri_prefix);
+         itr != shard.session_map.end() &&
+         absl::StartsWith(itr->first, session_uri_prefix);
+         ++itr) {
       sessions.push_back(itr->second);
-    } else {
-      return sessions;
     }
   }
+  std::sort(sessions.begin(), sessions.end(),
+            [](const std::shared_ptr<Session>& a,
+               const std::shared_ptr<Session>& b) {
+              return a->session_uri() < b->session_uri();
+            });
   return sessions;
 }
 
 absl::Status SessionManager::DeleteSession(const std::string& session_uri) {
-  absl::MutexLock lock(&mu_);
-  session_map_.erase(session_uri);
+  std::shared_ptr<Session> session;
+  {
+    Shard& shard = ShardFor(session_uri);
+    absl::MutexLock lock(&shard.mu);
+    auto itr = shard.session_map.find(session_uri);
+    if (itr == shard.session_map.end()) {
+      return absl::OkStatus();
+    }
+    session = std::move(itr->second);
+    shard.session_map.erase(itr);
+  }
+  session->Close();
   return absl::OkStatus();
 }
 
+int SessionManager::ReapIdleSessions() {
+  if (idle_timeout_ <= absl::ZeroDuration()) {
+    return 0;
+  }
+  std::vector<std::shared_ptr<Session>> expired;
+  absl::Time now = clock_->Now();
+  for (Shard& shard : shards_) {
+    absl::MutexLock lock(&shard.mu);
+    for (auto itr = shard.session_map.begin();
+         itr != shard.session_map.end();) {
+      if (IsExpired(*itr->second, now)) {
+        expired.push_back(std::move(itr->second));
+        itr = shard.session_map.erase(itr);
+      } else {
+        ++itr;
+      }
+    }
+  }
+  for (const std::shared_ptr<Session>& session : expired) {
+    session->Close();
+  }
+  return expired.size();
+}
+
+void SessionManager::MaybeReapIdleSessions() {
+  if (idle_timeout_ <= absl::ZeroDuration()) {
+    return;
+  }
+  // Only one thread sweeps at a time; others skip the sweep instead of
+  // waiting for it.
+  if (!reap_mu_.TryLock()) {
+    return;
+  }
+  absl::Time now = clock_->Now();
+  if (now - last_reap_time_ >= reap_interval_) {
+    last_reap_time_ = now;
+    ReapIdleSessions();
+  }
+  reap_mu_.Unlock();
+}
+
 }  // namespace frontend
 }  // namespace emulator
 }  // namespace spanner
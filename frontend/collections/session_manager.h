@@ -17,13 +17,23 @@
 #ifndef STORAGE_CLOUD_SPANNER_EMULATOR_FRONTEND_SESSION_MANAGER_H_
 #define STORAGE_CLOUD_SPANNER_EMULATOR_FRONTEND_SESSION_MANAGER_H_
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
 #include "common/clock.h"
 #include "frontend/entities/database.h"
 #include "frontend/entities/session.h"
-#include "absl/status/status.h"
 
 namespace google {
 namespace spanner {
@@ -31,40 +41,92 @@ namespace emulator {
 namespace frontend {
 
 // Session manager manages the set of active sessions in the emulator.
+//
+// Every RPC looks up its session, so sessions are spread over shards by the
+// hash of their URI, each guarded by its own mutex, so that RPCs on different
+// sessions do not contend.
+//
+// Sessions which have not been used for longer than the idle timeout are
+// deleted, and their transactions closed. Expired sessions are found lazily
+// when they are looked up, and swept by CreateSession at most once per
+// kMaxReapInterval (or idle timeout, if shorter), so that sessions leaked by
+// clients do not accumulate.
 class SessionManager {
  public:
-  explicit SessionManager(Clock* clock) : clock_(clock) {}
+  // The default time after which unused sessions are deleted.
+  static constexpr absl::Duration kDefaultIdleTimeout = absl::Hours(1);
+
+  // The longest time between sweeps of idle sessions by CreateSession.
+  static constexpr absl::Duration kMaxReapInterval = absl::Minutes(1);
+
+  // An 'idle_timeout' of zero disables deletion of idle sessions.
+  explicit SessionManager(Clock* clock,
+                          absl::Duration idle_timeout = kDefaultIdleTimeout)
+      : clock_(clock),
+        idle_timeout_(idle_timeout),
+        reap_interval_(std::min(idle_timeout, kMaxReapInterval)) {}
 
   // Creates a session attached to the given database.
   absl::StatusOr<std::shared_ptr<Session>> CreateSession(
       const Labels& labels, std::shared_ptr<Database> database)
-      ABSL_LOCKS_EXCLUDED(mu_);
+      ABSL_LOCKS_EXCLUDED(reap_mu_);
 
   // Returns a session with the given URI.
   absl::StatusOr<std::shared_ptr<Session>> GetSession(
-      const std::string& session_uri) ABSL_LOCKS_EXCLUDED(mu_);
+      const std::string& session_uri);
 
-  // Deletes a session with the given URI.
-  absl::Status DeleteSession(const std::string& session_uri)
-      ABSL_LOCKS_EXCLUDED(mu_);
+  // Deletes a session with the given URI, closing its transactions.
+  absl::Status DeleteSession(const std::string& session_uri);
 
-  // Lists sessions attached to the given database URI.
+  // Lists sessions attached to the given database URI, ordered by URI.
   absl::StatusOr<std::vector<std::shared_ptr<Session>>> ListSessions(
-      const std::string& database_uri) const ABSL_LOCKS_EXCLUDED(mu_);
+      const std::string& database_uri) const;
+
+  // Deletes all sessions which have been idle for longer than the idle timeout,
+  // closing their transactions. Returns the number of deleted sessions.
+  int ReapIdleSessions();
 
  private:
+  // A partition of the sessions.
+  struct Shard {
+    // Mutex to guard state below.
+    mutable absl::Mutex mu;
+
+    // Map from session URI to session objects.
+    std::map<std::string, std::shared_ptr<Session>> session_map
+        ABSL_GUARDED_BY(mu);
+  };
+
+  static constexpr int kNumShards = 16;
+
+  // Returns the shard which holds the session with the given URI.
+  Shard& ShardFor(const std::string& session_uri);
+
+  // Returns true if 'session' has been idle for longer than the idle timeout.
+  bool IsExpired(const Session& session, absl::Time now) const;
+
+  // Calls ReapIdleSessions if no sweep started in the last reap_interval_.
+  void MaybeReapIdleSessions() ABSL_LOCKS_EXCLUDED(reap_mu_);
+
   // System-wide clock.
   Clock* clock_;
 
-  // Mutex to guard state below.
-  mutable absl::Mutex mu_;
+  // The time after which unused sessions are deleted, or zero if never.
+  const absl::Duration idle_timeout_;
+
+  // The minimum time between sweeps of idle sessions by CreateSession.
+  const absl::Duration reap_interval_;
 
   // Counter for session ids.
-  int next_session_id_ ABSL_GUARDED_BY(mu_) = 0;
+  std::atomic<int64_t> next_session_id_{0};
+
+  std::array<Shard, kNumShards> shards_;
+
+  // Mutex held by the thread sweeping idle sessions, and guarding state below.
+  absl::Mutex reap_mu_;
 
-  // Map from session URI to session objects.
-  std::map<std::string, std::shared_ptr<Session>> session_map_
-      ABSL_GUARDED_BY(mu_);
+  // The time of the last sweep of idle sessions.
+  absl::Time last_reap_time_ ABSL_GUARDED_BY(reap_mu_) = absl::InfinitePast();
 };
 
 }  // namespace frontend
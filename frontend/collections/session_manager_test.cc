@@ -17,12 +17,14 @@
 #include "frontend/collections/session_manager.h"
 
 #include <memory>
+#include <vector>
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "zetasql/base/testing/status_matchers.h"
 #include "tests/common/proto_matchers.h"
 #include "absl/strings/match.h"
+#include "absl/time/clock.h"
 #include "absl/time/time.h"
 #include "common/clock.h"
 #include "frontend/collections/database_manager.h"
@@ -138,6 +140,88 @@ TEST_F(SessionManagerTest, ListSessionsWithSimilarPrefix) {
   }
 }
 
+TEST_F(SessionManagerTest, ListSessionsOrdersSessionsByUri) {
+  for (int i = 0; i < 20; i++) {
+    ZETASQL_ASSERT_OK(session_manager_.CreateSession(test_labels_, database_));
+  }
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      std::vector<std::shared_ptr<Session>> actual,
+      session_manager_.ListSessions(database_->database_uri()));
+  ASSERT_EQ(actual.size(), 20);
+  for (int i = 1; i < actual.size(); i++) {
+    EXPECT_LT(actual[i - 1]->session_uri(), actual[i]->session_uri());
+  }
+}
+
+TEST_F(SessionManagerTest, ReapIdleSessionsDeletesExpiredSessions) {
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::shared_ptr<Session> idle,
+                       session_manager_.CreateSession(test_labels_, database_));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::shared_ptr<Session> active,
+                       session_manager_.CreateSession(test_labels_, database_));
+  idle->set_approximate_last_use_time(absl::Now() - absl::Hours(1.5));
+
+  EXPECT_EQ(session_manager_.ReapIdleSessions(), 1);
+  EXPECT_THAT(session_manager_.GetSession(idle->session_uri()),
+              zetasql_base::testing::StatusIs(absl::StatusCode::kNotFound));
+  ZETASQL_EXPECT_OK(session_manager_.GetSession(active->session_uri()));
+}
+
+TEST_F(SessionManagerTest, CreateSessionReapsIdleSessions) {
+  SessionManager session_manager(&clock_, absl::Milliseconds(10));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::shared_ptr<Session> idle,
+                       session_manager.CreateSession(test_labels_, database_));
+  absl::SleepFor(absl::Milliseconds(20));
+
+  // ListSessions does not check for expiry, so only the sweep by CreateSession
+  // deletes the idle session.
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::shared_ptr<Session> created,
+                       session_manager.CreateSession(test_labels_, database_));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      std::vector<std::shared_ptr<Session>> sessions,
+      session_manager.ListSessions(database_->database_uri()));
+  ASSERT_EQ(sessions.size(), 1);
+  EXPECT_EQ(sessions[0]->session_uri(), created->session_uri());
+}
+
+TEST_F(SessionManagerTest, ReapingIdleSessionClosesItsTransactions) {
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::shared_ptr<Session> session,
+                       session_manager_.CreateSession(test_labels_, database_));
+  google::spanner::v1::TransactionOptions options;
+  options.mutable_read_write();
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      std::shared_ptr<Transaction> txn,
+      session->CreateMultiUseTransaction(
+          options, Session::TransactionActivation::kInitializeAndActivate));
+  session->set_approximate_last_use_time(absl::Now() - absl::Hours(1.5));
+
+  EXPECT_EQ(session_manager_.ReapIdleSessions(), 1);
+  EXPECT_TRUE(txn->IsClosed());
+}
+
+TEST_F(SessionManagerTest, DeleteSessionClosesItsTransactions) {
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::shared_ptr<Session> session,
+                       session_manager_.CreateSession(test_labels_, database_));
+  google::spanner::v1::TransactionOptions options;
+  options.mutable_read_write();
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      std::shared_ptr<Transaction> txn,
+      session->CreateMultiUseTransaction(
+          options, Session::TransactionActivation::kInitializeAndActivate));
+
+  ZETASQL_EXPECT_OK(session_manager_.DeleteSession(session->session_uri()));
+  EXPECT_TRUE(txn->IsClosed());
+}
+
+TEST_F(SessionManagerTest, ZeroIdleTimeoutKeepsIdleSessions) {
+  SessionManager session_manager(&clock_, absl::ZeroDuration());
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::shared_ptr<Session> session,
+                       session_manager.CreateSession(test_labels_, database_));
+  session->set_approximate_last_use_time(absl::Now() - absl::Hours(100));
+
+  EXPECT_EQ(session_manager.ReapIdleSessions(), 0);
+  ZETASQL_EXPECT_OK(session_manager.GetSession(session->session_uri()));
+}
+
 }  // namespace frontend
 }  // namespace emulator
 }  // namespace spanner
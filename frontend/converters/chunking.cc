@@ -17,12 +17,18 @@
 #include "frontend/converters/chunking.h"
 
 #include <algorithm>
+#include <deque>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <utility>
 #include <vector>
 
 #include "absl/memory/memory.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/substitute.h"
 #include "common/errors.h"
+#include "zetasql/base/ret_check.h"
 #include "zetasql/base/status_macros.h"
 
 namespace google {
@@ -72,6 +78,8 @@ int64_t RemovePartialUTF8(absl::string_view string, int64_t available) {
   return available;
 }
 
+}  // namespace
+
 // Constructs a set of PartialResultSets. Data will be chunked as necessary to
 // comply with the Cloud Spanner streaming chunk size limit. Only Strings and
 // Lists need to be chunked (Structs are not a valid column type and will return
@@ -80,7 +88,7 @@ class ResultSetBuilder {
  public:
   explicit ResultSetBuilder(
       int64_t max_chunk_size,
-      std::vector<google::spanner::v1::PartialResultSet>* results)
+      std::deque<google::spanner::v1::PartialResultSet>* results)
       : max_chunk_size_(max_chunk_size), results_(results) {
     if (results_->empty()) {
       results_->emplace_back();
@@ -143,6 +151,31 @@ class ResultSetBuilder {
     return absl::OkStatus();
   }
 
+  // Returns the estimated size of the current chunk.
+  int64_t current_chunk_size() const { return current_chunk_size_; }
+
+  // Adds a new partial result set to results. If list(s) are currently being
+  // processed it will create corresponding list(s) in the new chunk. The
+  // current result set will have chunked_value set to true if a list was
+  // currently being processed or if a string is split up.
+  void StartNewResultSet() {
+    if (IsListOpen()) {
+      // Always mark as chunked if inside a list.
+      results_->back().set_chunked_value(true);
+    }
+    size_t stack_depth = stack_.size() - 1;
+    stack_.clear();
+
+    results_->emplace_back();
+    stack_.push_back(results_->back().mutable_values());
+    for (int i = 0; i < stack_depth; ++i) {
+      auto list = stack_.back()->Add()->mutable_list_value();
+      stack_.push_back(list->mutable_values());
+    }
+    // Reset the size of the current result set.
+    current_chunk_size_ = results_->back().ByteSizeLong();
+  }
+
  private:
   ResultSetBuilder(const ResultSetBuilder&) = delete;
   ResultSetBuilder& operator=(const ResultSetBuilder&) = delete;
@@ -243,28 +276,6 @@ class ResultSetBuilder {
   // Removes a list from the stack.
   void FinishList() { stack_.pop_back(); }
 
-  // Adds a new partial result set to results. If list(s) are currently being
-  // processed it will create corresponding list(s) in the new chunk. The
-  // current result set will have chunked_value set to true if a list was
-  // currently being processed or if a string is split up.
-  void StartNewResultSet() {
-    if (IsListOpen()) {
-      // Always mark as chunked if inside a list.
-      results_->back().set_chunked_value(true);
-    }
-    size_t stack_depth = stack_.size() - 1;
-    stack_.clear();
-
-    results_->emplace_back();
-    stack_.push_back(results_->back().mutable_values());
-    for (int i = 0; i < stack_depth; ++i) {
-      auto list = stack_.back()->Add()->mutable_list_value();
-      stack_.push_back(list->mutable_values());
-    }
-    // Reset the size of the current result set.
-    current_chunk_size_ = results_->back().ByteSizeLong();
-  }
-
   // The size of the current chunk that is being appended to. This is an
   // estimate of the current chunk size. This estimate should work fine in
   // practice since the max chunk size is 1MB and the default message size limit
@@ -276,8 +287,10 @@ class ResultSetBuilder {
   // The maximum allowed size of a chunk.
   int64_t max_chunk_size_;
 
-  // The list of PartialResultSets that store the resulting chunks.
-  std::vector<::google::spanner::v1::PartialResultSet>* results_;
+  // The list of PartialResultSets that store the resulting chunks. Chunks
+  // before the last one are complete, and may be removed by the owner of the
+  // list.
+  std::deque<::google::spanner::v1::PartialResultSet>* results_;
 
   // The list stack is used to track nested lists. When a result set is chunked
   // all current lists need to be truncated and matching versions created in the
@@ -285,12 +298,10 @@ class ResultSetBuilder {
   std::vector<google::protobuf::RepeatedPtrField<protobuf::Value>*> stack_;
 };
 
-}  // namespace
-
 absl::StatusOr<std::vector<google::spanner::v1::PartialResultSet>>
 ChunkResultSet(const google::spanner::v1::ResultSet& set,
                int64_t max_chunk_size) {
-  std::vector<google::spanner::v1::PartialResultSet> results;
+  std::deque<google::spanner::v1::PartialResultSet> results;
   results.emplace_back();
   *results.front().mutable_metadata() = set.metadata();
 
@@ -300,7 +311,63 @@ ChunkResultSet(const google::spanner::v1::ResultSet& set,
       ZETASQL_RETURN_IF_ERROR(builder.AddValue(value));
     }
   }
-  return results;
+  return std::vector<google::spanner::v1::PartialResultSet>(
+      std::make_move_iterator(results.begin()),
+      std::make_move_iterator(results.end()));
+}
+
+PartialResultSetEncoder::PartialResultSetEncoder(
+    const google::spanner::v1::ResultSetMetadata& metadata,
+    int64_t max_chunk_size, ResumeTokenFn resume_token_fn)
+    : max_chunk_size_(max_chunk_size),
+      resume_token_fn_(std::move(resume_token_fn)) {
+  chunks_.emplace_back();
+  *chunks_.front().mutable_metadata() = metadata;
+  builder_ = std::make_unique<ResultSetBuilder>(max_chunk_size, &chunks_);
+}
+
+PartialResultSetEncoder::~PartialResultSetEncoder() = default;
+
+absl::Status PartialResultSetEncoder::AddRow(
+    absl::Span<const protobuf::Value> row) {
+  // Close the current chunk at this row boundary once it is half full, so that
+  // most chunks end between rows and can carry a resume token. Only rows larger
+  // than half a chunk end up split across chunks.
+  if (num_rows_ > 0 && builder_->current_chunk_size() >= max_chunk_size_ / 2) {
+    ZETASQL_RETURN_IF_ERROR(SetResumeToken(&chunks_.back()));
+    builder_->StartNewResultSet();
+  }
+  for (const auto& value : row) {
+    ZETASQL_RETURN_IF_ERROR(builder_->AddValue(value));
+  }
+  ++num_rows_;
+  return absl::OkStatus();
+}
+
+std::vector<google::spanner::v1::PartialResultSet>
+PartialResultSetEncoder::TakeCompleteChunks() {
+  std::vector<google::spanner::v1::PartialResultSet> complete_chunks;
+  while (chunks_.size() > 1) {
+    complete_chunks.push_back(std::move(chunks_.front()));
+    chunks_.pop_front();
+  }
+  return complete_chunks;
+}
+
+absl::StatusOr<google::spanner::v1::PartialResultSet>
+PartialResultSetEncoder::Finish() && {
+  ZETASQL_RET_CHECK_EQ(chunks_.size(), 1) << "complete chunks were not taken";
+  ZETASQL_RETURN_IF_ERROR(SetResumeToken(&chunks_.back()));
+  return std::move(chunks_.back());
+}
+
+absl::Status PartialResultSetEncoder::SetResumeToken(
+    google::spanner::v1::PartialResultSet* chunk) {
+  if (resume_token_fn_ != nullptr) {
+    ZETASQL_ASSIGN_OR_RETURN(*chunk->mutable_resume_token(),
+                     resume_token_fn_(num_rows_));
+  }
+  return absl::OkStatus();
 }
 
 }  // namespace frontend
@@ -17,6 +17,11 @@
 #ifndef THIRD_PARTY_CLOUD_SPANNER_EMULATOR_FRONTEND_CONVERTERS_CHUNKING_H_
 #define THIRD_PARTY_CLOUD_SPANNER_EMULATOR_FRONTEND_CONVERTERS_CHUNKING_H_
 
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
 #include <vector>
 
 #include "google/protobuf/struct.pb.h"
@@ -24,6 +29,7 @@
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
 #include "absl/status/status.h"
+#include "absl/types/span.h"
 
 namespace google {
 namespace spanner {
@@ -36,6 +42,61 @@ namespace frontend {
 absl::StatusOr<std::vector<google::spanner::v1::PartialResultSet>>
 ChunkResultSet(const google::spanner::v1::ResultSet& set, int64_t max_chunk_size);
 
+class ResultSetBuilder;
+
+// Incrementally chunks the rows of a result set into PartialResultSets as they
+// are produced, so that chunks can be streamed before the whole result set is
+// known. Chunks are closed at a row boundary once they are at least half of
+// max_chunk_size; only rows larger than that are split across chunks. Each
+// chunk which ends at a row boundary carries the resume token returned by
+// resume_token_fn for the number of rows added so far, if one is provided.
+//
+// Only the first chunk carries the result set metadata. Typical usage:
+//
+//   PartialResultSetEncoder encoder(metadata, limits::kMaxStreamingChunkSize);
+//   for (each row) {
+//     ZETASQL_RETURN_IF_ERROR(encoder.AddRow(row));
+//     for (auto& chunk : encoder.TakeCompleteChunks()) { send(chunk); }
+//   }
+//   ZETASQL_ASSIGN_OR_RETURN(auto last_chunk, std::move(encoder).Finish());
+class PartialResultSetEncoder {
+ public:
+  // Returns the resume token for a chunk ending after the first num_rows rows.
+  using ResumeTokenFn =
+      std::function<absl::StatusOr<std::string>(int64_t num_rows)>;
+
+  PartialResultSetEncoder(
+      const google::spanner::v1::ResultSetMetadata& metadata,
+      int64_t max_chunk_size, ResumeTokenFn resume_token_fn = nullptr);
+  ~PartialResultSetEncoder();
+
+  // Appends one row of values to the result set.
+  absl::Status AddRow(absl::Span<const protobuf::Value> row);
+
+  // Removes and returns the chunks which will not receive any more values.
+  std::vector<google::spanner::v1::PartialResultSet> TakeCompleteChunks();
+
+  // Returns the last chunk of the result set. All other chunks must have been
+  // taken with TakeCompleteChunks.
+  absl::StatusOr<google::spanner::v1::PartialResultSet> Finish() &&;
+
+  // Returns the number of rows added so far.
+  int64_t num_rows() const { return num_rows_; }
+
+ private:
+  // Sets the resume token of 'chunk', which ends after the rows added so far.
+  absl::Status SetResumeToken(google::spanner::v1::PartialResultSet* chunk);
+
+  const int64_t max_chunk_size_;
+  const ResumeTokenFn resume_token_fn_;
+  int64_t num_rows_ = 0;
+
+  // Chunks of the result set which have not been taken yet. The last chunk is
+  // the one being built.
+  std::deque<google::spanner::v1::PartialResultSet> chunks_;
+  std::unique_ptr<ResultSetBuilder> builder_;
+};
+
 }  // namespace frontend
 }  // namespace emulator
 }  // namespace spanner
@@ -28,12 +28,15 @@
 #include "zetasql/base/testing/status_matchers.h"
 #include "tests/common/proto_matchers.h"
 #include "absl/random/random.h"
+#include "absl/strings/str_cat.h"
 #include "absl/time/time.h"
 #include "common/limits.h"
 #include "frontend/converters/reads.h"
 #include "tests/common/chunking.h"
 #include "tests/common/row_cursor.h"
 #include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "zetasql/base/status_macros.h"
 
 namespace google {
 namespace spanner {
@@ -710,6 +713,155 @@ TEST(ChunkingTest, RandomChunking) {
   }
 }
 
+// Encodes the rows of 'result' with a PartialResultSetEncoder whose resume
+// tokens are the number of rows before them.
+absl::StatusOr<std::vector<PartialResultSet>> EncodeResultSet(
+    const ResultSet& result, int64_t max_chunk_size) {
+  PartialResultSetEncoder encoder(
+      result.metadata(), max_chunk_size,
+      [](int64_t num_rows) -> absl::StatusOr<std::string> {
+        return absl::StrCat(num_rows);
+      });
+  std::vector<PartialResultSet> results;
+  for (const auto& row : result.rows()) {
+    ZETASQL_RETURN_IF_ERROR(encoder.AddRow(row.values()));
+    for (auto& chunk : encoder.TakeCompleteChunks()) {
+      results.push_back(std::move(chunk));
+    }
+  }
+  ZETASQL_ASSIGN_OR_RETURN(PartialResultSet last_chunk, std::move(encoder).Finish());
+  results.push_back(std::move(last_chunk));
+  return results;
+}
+
+TEST(PartialResultSetEncoderTest, ClosesChunksAtRowBoundaries) {
+  // Each of the first two rows fills half of a chunk.
+  const size_t kChunkSize = 28;
+
+  ResultSet result = PARSE_TEXT_PROTO(R"(
+    metadata {}
+    rows { values { string_value: "abcdefghij" } values { bool_value: true } }
+    rows { values { string_value: "klmnopqrst" } values { bool_value: true } }
+    rows { values { string_value: "uvwxyz" } values { bool_value: false } }
+  )");
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::vector<PartialResultSet> results,
+                       EncodeResultSet(result, kChunkSize));
+
+  std::vector<std::string> expected_results(3);
+  expected_results[0] = R"(
+    metadata {}
+    values { string_value: "abcdefghij" }
+    values { bool_value: true }
+    resume_token: "1"
+  )";
+  expected_results[1] = R"(
+    values { string_value: "klmnopqrst" }
+    values { bool_value: true }
+    resume_token: "2"
+  )";
+  expected_results[2] = R"(
+    values { string_value: "uvwxyz" }
+    values { bool_value: false }
+    resume_token: "3"
+  )";
+
+  EXPECT_THAT(results,
+              testing::ElementsAre(test::EqualsProto(expected_results[0]),
+                                   test::EqualsProto(expected_results[1]),
+                                   test::EqualsProto(expected_results[2])));
+}
+
+TEST(PartialResultSetEncoderTest, SplitsRowsLargerThanChunk) {
+  const size_t kChunkSize = 18;
+
+  ResultSet result = PARSE_TEXT_PROTO(R"(
+    metadata {}
+    rows { values { string_value: "abcdefghijklmnopqrstuvwxyz" } }
+  )");
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::vector<PartialResultSet> results,
+                       EncodeResultSet(result, kChunkSize));
+
+  // Only the chunk ending at the row boundary has a resume token.
+  std::vector<std::string> expected_results(2);
+  expected_results[0] = R"(
+    metadata {}
+    values { string_value: "abcdefghijklmnop" }
+    chunked_value: true
+  )";
+  expected_results[1] = R"(
+    values { string_value: "qrstuvwxyz" }
+    resume_token: "1"
+  )";
+
+  EXPECT_THAT(results,
+              testing::ElementsAre(test::EqualsProto(expected_results[0]),
+                                   test::EqualsProto(expected_results[1])));
+}
+
+TEST(PartialResultSetEncoderTest, ReturnsMetadataForEmptyResultSet) {
+  ResultSet result = PARSE_TEXT_PROTO(R"(metadata {})");
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::vector<PartialResultSet> results,
+                       EncodeResultSet(result, /*max_chunk_size=*/28));
+
+  EXPECT_THAT(results, testing::ElementsAre(test::EqualsProto(R"(
+                metadata {}
+                resume_token: "0"
+              )")));
+}
+
+TEST(PartialResultSetEncoderTest, RandomEncoding) {
+  int64_t time = absl::ToUnixNanos(absl::Now());
+  std::seed_seq seed({time});
+  absl::BitGen gen(seed);
+  ZETASQL_LOG(INFO) << "Testing random encoding with seed: " << time;
+
+  const int kNumColumns = 4;
+  const int kNumRowsMax = 50;
+  const int kChunkSizeMin = 40;
+  const int kChunkSizeMax = 1000;
+  for (int i = 0; i < 50; ++i) {
+    const size_t kChunkSize = absl::Uniform<size_t>(
+        absl::IntervalClosedClosed, gen, kChunkSizeMin, kChunkSizeMax);
+    const int kNumRows =
+        absl::Uniform<int>(absl::IntervalClosedClosed, gen, 1, kNumRowsMax);
+
+    // Generate random result set, one row at a time. Random rows have a
+    // varying number of values, so they are cut or padded to kNumColumns.
+    ResultSet result;
+    result.mutable_metadata();
+    for (int row = 0; row < kNumRows; ++row) {
+      ZETASQL_ASSERT_OK_AND_ASSIGN(
+          ResultSet row_result,
+          backend::test::GenerateRandomResultSet(&gen, 3 * kNumColumns));
+      auto* values = result.add_rows()->mutable_values();
+      values->Swap(row_result.mutable_rows(0)->mutable_values());
+      if (values->size() > kNumColumns) {
+        values->DeleteSubrange(kNumColumns, values->size() - kNumColumns);
+      }
+      while (values->size() < kNumColumns) {
+        values->Add()->set_bool_value(true);
+      }
+    }
+
+    // Encode and merge the resulting chunks, which should be equal to the
+    // original result.
+    ZETASQL_ASSERT_OK_AND_ASSIGN(std::vector<PartialResultSet> results,
+                         EncodeResultSet(result, kChunkSize));
+    ZETASQL_ASSERT_OK_AND_ASSIGN(
+        ResultSet merged_result,
+        backend::test::MergePartialResultSets(results, kNumColumns));
+    EXPECT_THAT(merged_result, test::EqualsProto(result));
+
+    // Resume tokens are only set on chunks which end at a row boundary.
+    for (const auto& chunk : results) {
+      if (!chunk.resume_token().empty()) {
+        EXPECT_FALSE(chunk.chunked_value());
+      }
+    }
+    EXPECT_EQ(results.back().resume_token(), absl::StrCat(kNumRows));
+  }
+}
+
 }  // namespace
 
 }  // namespace frontend
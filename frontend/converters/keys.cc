@@ -18,6 +18,7 @@
 
 #include "zetasql/public/value.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
 #include "backend/schema/catalog/column.h"
 #include "backend/schema/catalog/index.h"
 #include "backend/schema/catalog/table.h"
@@ -70,6 +71,16 @@ absl::StatusOr<backend::Key> KeyFromProtoInternal(
   return key;
 }
 
+// Converts the column values of a key to a list of values.
+absl::StatusOr<google::protobuf::ListValue> KeyColumnsToProto(
+    const backend::Key& key) {
+  google::protobuf::ListValue list_pb;
+  for (const zetasql::Value& value : key.column_values()) {
+    ZETASQL_ASSIGN_OR_RETURN(*list_pb.add_values(), ValueToProto(value));
+  }
+  return list_pb;
+}
+
 }  // namespace
 
 absl::StatusOr<backend::Key> KeyFromProto(
@@ -117,6 +128,40 @@ absl::StatusOr<backend::KeyRange> KeyRangeFromProto(
   return backend::KeyRange(start_type, start_key, limit_type, limit_key);
 }
 
+absl::StatusOr<spanner_api::KeyRange> KeyRangeToProto(
+    const backend::KeyRange& range) {
+  if (!range.IsClosedOpen()) {
+    return error::Internal(absl::StrCat(
+        "KeyRangeToProto should be called with a ClosedOpen key range, found: ",
+        range.DebugString()));
+  }
+  spanner_api::KeyRange range_pb;
+
+  // A prefix limit start key excludes all keys with its prefix.
+  const backend::Key& start_key = range.start_key();
+  if (start_key.IsPrefixLimit()) {
+    ZETASQL_ASSIGN_OR_RETURN(*range_pb.mutable_start_open(),
+                     KeyColumnsToProto(start_key));
+  } else {
+    ZETASQL_ASSIGN_OR_RETURN(*range_pb.mutable_start_closed(),
+                     KeyColumnsToProto(start_key));
+  }
+
+  // A prefix limit key includes all keys with its prefix, which for the empty
+  // prefix of Key::Infinity() is every key.
+  const backend::Key& limit_key = range.limit_key();
+  if (limit_key.IsInfinity()) {
+    range_pb.mutable_end_closed();
+  } else if (limit_key.IsPrefixLimit()) {
+    ZETASQL_ASSIGN_OR_RETURN(*range_pb.mutable_end_closed(),
+                     KeyColumnsToProto(limit_key));
+  } else {
+    ZETASQL_ASSIGN_OR_RETURN(*range_pb.mutable_end_open(),
+                     KeyColumnsToProto(limit_key));
+  }
+  return range_pb;
+}
+
 absl::StatusOr<backend::KeySet> KeySetFromProto(
     const spanner_api::KeySet& key_set_pb, const backend::Table& table) {
   backend::KeySet key_set;
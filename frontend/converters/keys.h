@@ -38,6 +38,13 @@ absl::StatusOr<backend::Key> KeyFromProto(
 absl::StatusOr<backend::KeyRange> KeyRangeFromProto(
     const google::spanner::v1::KeyRange& range_pb, const backend::Table& table);
 
+// Converts a closed-open backend KeyRange, such as those returned by
+// backend::MakeDisjointKeyRanges, to a Cloud Spanner key range proto. Prefix
+// limit keys become closed prefix endpoints, Key::Infinity() an empty closed
+// end.
+absl::StatusOr<google::spanner::v1::KeyRange> KeyRangeToProto(
+    const backend::KeyRange& range);
+
 // Converts a Cloud Spanner key set proto to a backend KeySet.
 absl::StatusOr<backend::KeySet> KeySetFromProto(
     const google::spanner::v1::KeySet& key_set_pb, const backend::Table& table);
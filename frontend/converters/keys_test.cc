@@ -16,10 +16,20 @@
 
 #include "frontend/converters/keys.h"
 
+#include <memory>
+
+#include "google/spanner/v1/keys.pb.h"
+#include "zetasql/public/type.h"
+#include "zetasql/public/value.h"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "zetasql/base/testing/status_matchers.h"
 #include "tests/common/proto_matchers.h"
+#include "absl/status/status.h"
+#include "backend/datamodel/key.h"
+#include "backend/datamodel/key_range.h"
+#include "backend/schema/catalog/schema.h"
+#include "tests/common/schema_constructor.h"
 
 namespace google {
 namespace spanner {
@@ -28,7 +38,64 @@ namespace frontend {
 
 namespace {
 
-class KeyConversionTest : public testing::Test {};
+using test::EqualsProto;
+using zetasql::values::Int64;
+using zetasql_base::testing::IsOkAndHolds;
+
+class KeyConversionTest : public testing::Test {
+ protected:
+  const backend::Table* table() const {
+    return schema_->FindTable("test_table");
+  }
+
+ private:
+  zetasql::TypeFactory type_factory_;
+  std::unique_ptr<const backend::Schema> schema_ =
+      test::CreateSchemaWithOneTable(&type_factory_);
+};
+
+TEST_F(KeyConversionTest, ConvertsClosedOpenKeyRangeToProto) {
+  EXPECT_THAT(KeyRangeToProto(backend::KeyRange::ClosedOpen(
+                  backend::Key({Int64(1)}), backend::Key({Int64(3)}))),
+              IsOkAndHolds(EqualsProto(R"pb(
+                start_closed { values { string_value: "1" } }
+                end_open { values { string_value: "3" } }
+              )pb")));
+  EXPECT_THAT(KeyRangeToProto(backend::KeyRange::All()),
+              IsOkAndHolds(EqualsProto(R"pb(
+                start_closed {}
+                end_closed {}
+              )pb")));
+}
+
+TEST_F(KeyConversionTest, ConvertsPrefixLimitKeysToProto) {
+  EXPECT_THAT(KeyRangeToProto(backend::KeyRange::OpenClosed(
+                                  backend::Key({Int64(1)}),
+                                  backend::Key({Int64(3)}))
+                                  .ToClosedOpen()),
+              IsOkAndHolds(EqualsProto(R"pb(
+                start_open { values { string_value: "1" } }
+                end_closed { values { string_value: "3" } }
+              )pb")));
+}
+
+TEST_F(KeyConversionTest, RoundTripsKeyRange) {
+  backend::KeyRange range = backend::KeyRange::ClosedClosed(
+                                backend::Key({Int64(1)}),
+                                backend::Key({Int64(3)}))
+                                .ToClosedOpen();
+  ZETASQL_ASSERT_OK_AND_ASSIGN(google::spanner::v1::KeyRange range_pb,
+                       KeyRangeToProto(range));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(backend::KeyRange parsed_range,
+                       KeyRangeFromProto(range_pb, *table()));
+  EXPECT_EQ(parsed_range.ToClosedOpen(), range);
+}
+
+TEST_F(KeyConversionTest, RejectsKeyRangeWhichIsNotClosedOpen) {
+  EXPECT_THAT(KeyRangeToProto(backend::KeyRange::ClosedClosed(
+                  backend::Key({Int64(1)}), backend::Key({Int64(3)}))),
+              zetasql_base::testing::StatusIs(absl::StatusCode::kInternal));
+}
 
 }  // namespace
 
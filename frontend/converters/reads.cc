@@ -16,7 +16,10 @@
 
 #include "frontend/converters/reads.h"
 
+#include <cstdint>
+#include <functional>
 #include <limits>
+#include <utility>
 #include <vector>
 
 #include "google/protobuf/struct.pb.h"
@@ -28,6 +31,7 @@
 #include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
 #include "backend/access/write.h"
+#include "backend/common/memory_tracker.h"
 #include "backend/datamodel/key.h"
 #include "backend/datamodel/key_range.h"
 #include "backend/datamodel/key_set.h"
@@ -57,19 +61,6 @@ namespace spanner_api = ::google::spanner::v1;
 
 namespace {
 
-absl::Status ResultSetMetadataToProto(backend::RowCursor* cursor,
-                                      v1::ResultSetMetadata* metadata_pb) {
-  for (int i = 0; i < cursor->NumColumns(); ++i) {
-    auto* field_pb = metadata_pb->mutable_row_type()->add_fields();
-    field_pb->set_name(cursor->ColumnName(i));
-    ZETASQL_RETURN_IF_ERROR(
-        TypeToProto(cursor->ColumnType(i), field_pb->mutable_type()))
-        << " when converting column " << cursor->ColumnName(i) << " of type "
-        << cursor->ColumnType(i) << " at position " << i << " in row cursor";
-  }
-  return absl::OkStatus();
-}
-
 absl::Status ValidateStaleness(absl::Duration staleness) {
   if (staleness < absl::ZeroDuration()) {
     return error::StalenessMustBeNonNegative();
@@ -221,8 +212,22 @@ absl::Status ReadArgFromProto(const backend::Schema& schema,
   return absl::OkStatus();
 }
 
+absl::Status ResultSetMetadataToProto(backend::RowCursor* cursor,
+                                      v1::ResultSetMetadata* metadata_pb) {
+  for (int i = 0; i < cursor->NumColumns(); ++i) {
+    auto* field_pb = metadata_pb->mutable_row_type()->add_fields();
+    field_pb->set_name(cursor->ColumnName(i));
+    ZETASQL_RETURN_IF_ERROR(
+        TypeToProto(cursor->ColumnType(i), field_pb->mutable_type()))
+        << " when converting column " << cursor->ColumnName(i) << " of type "
+        << cursor->ColumnType(i) << " at position " << i << " in row cursor";
+  }
+  return absl::OkStatus();
+}
+
 absl::Status RowCursorToResultSetProto(backend::RowCursor* cursor, int limit,
-                                       spanner_api::ResultSet* result_pb) {
+                                       spanner_api::ResultSet* result_pb,
+                                       backend::MemoryTracker* memory_tracker) {
   ZETASQL_RETURN_IF_ERROR(
       ResultSetMetadataToProto(cursor, result_pb->mutable_metadata()));
 
@@ -234,13 +239,16 @@ absl::Status RowCursorToResultSetProto(backend::RowCursor* cursor, int limit,
       ZETASQL_ASSIGN_OR_RETURN(*row_pb->add_values(),
                        ValueToProto(cursor->ColumnValue(i)));
     }
+    if (memory_tracker != nullptr) {
+      ZETASQL_RETURN_IF_ERROR(memory_tracker->Allocate(row_pb->ByteSizeLong()));
+    }
     ++row_count;
     if (limit > 0 && limit == row_count) {
       break;
     }
   }
 
-  return absl::OkStatus();
+  return cursor->Status();
 }
 
 absl::StatusOr<std::vector<spanner_api::PartialResultSet>>
@@ -250,6 +258,34 @@ RowCursorToPartialResultSetProtos(backend::RowCursor* cursor, int limit) {
   return ChunkResultSet(result_set, limits::kMaxStreamingChunkSize);
 }
 
+absl::StatusOr<spanner_api::PartialResultSet>
+StreamRowCursorToPartialResultSetProtos(
+    backend::RowCursor* cursor, int64_t limit,
+    const std::function<absl::Status(spanner_api::PartialResultSet*)>& send,
+    int64_t* num_rows, PartialResultSetEncoder::ResumeTokenFn resume_token_fn) {
+  spanner_api::ResultSetMetadata metadata;
+  ZETASQL_RETURN_IF_ERROR(ResultSetMetadataToProto(cursor, &metadata));
+
+  PartialResultSetEncoder encoder(metadata, limits::kMaxStreamingChunkSize,
+                                  std::move(resume_token_fn));
+  std::vector<protobuf::Value> row(cursor->NumColumns());
+  while ((limit <= 0 || encoder.num_rows() < limit) && cursor->Next()) {
+    for (int i = 0; i < cursor->NumColumns(); ++i) {
+      ZETASQL_ASSIGN_OR_RETURN(row[i], ValueToProto(cursor->ColumnValue(i)));
+    }
+    ZETASQL_RETURN_IF_ERROR(encoder.AddRow(row));
+    for (auto& chunk : encoder.TakeCompleteChunks()) {
+      ZETASQL_RETURN_IF_ERROR(send(&chunk));
+    }
+  }
+  ZETASQL_RETURN_IF_ERROR(cursor->Status());
+
+  if (num_rows != nullptr) {
+    *num_rows = encoder.num_rows();
+  }
+  return std::move(encoder).Finish();
+}
+
 }  // namespace frontend
 }  // namespace emulator
 }  // namespace spanner
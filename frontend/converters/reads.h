@@ -17,6 +17,10 @@
 #ifndef THIRD_PARTY_CLOUD_SPANNER_EMULATOR_FRONTEND_CONVERTERS_READS_H_
 #define THIRD_PARTY_CLOUD_SPANNER_EMULATOR_FRONTEND_CONVERTERS_READS_H_
 
+#include <cstdint>
+#include <functional>
+#include <vector>
+
 #include "google/spanner/v1/mutation.pb.h"
 #include "google/spanner/v1/result_set.pb.h"
 #include "google/spanner/v1/spanner.pb.h"
@@ -26,8 +30,10 @@
 #include "backend/access/read.h"
 #include "backend/access/write.h"
 #include "backend/common/ids.h"
+#include "backend/common/memory_tracker.h"
 #include "backend/schema/catalog/schema.h"
 #include "backend/transaction/options.h"
+#include "frontend/converters/chunking.h"
 #include "absl/status/status.h"
 
 namespace google {
@@ -43,14 +49,23 @@ absl::Status ReadArgFromProto(const backend::Schema& schema,
                               const google::spanner::v1::ReadRequest& request,
                               backend::ReadArg* read_arg);
 
+// Converts the column names and types of a RowCursor to a ResultSetMetadata
+// proto.
+absl::Status ResultSetMetadataToProto(
+    backend::RowCursor* cursor,
+    google::spanner::v1::ResultSetMetadata* metadata_pb);
+
 // Converts a RowCursor to a ResultSet proto.
 //
 // Only handles the types and values supported by Cloud Spanner. Invalid types
 // or values not supported by Cloud Spanner will return errors. If limit > 0,
-// will only convert first limit numbers of rows into result_pb.
+// will only convert first limit numbers of rows into result_pb. If
+// 'memory_tracker' is not null, the rows added to result_pb are accounted for
+// in it, and conversion stops with its error once it runs out of memory.
 absl::Status RowCursorToResultSetProto(
     backend::RowCursor* cursor, int limit,
-    google::spanner::v1::ResultSet* result_pb);
+    google::spanner::v1::ResultSet* result_pb,
+    backend::MemoryTracker* memory_tracker = nullptr);
 
 // Converts a RowCursor to a set of one or more PartialResultSet protos.
 //
@@ -62,6 +77,24 @@ absl::Status RowCursorToResultSetProto(
 absl::StatusOr<std::vector<google::spanner::v1::PartialResultSet>>
 RowCursorToPartialResultSetProtos(backend::RowCursor* cursor, int limit);
 
+// Converts a RowCursor to one or more PartialResultSet protos while reading it,
+// so that only about one streaming chunk of rows is held in memory at once.
+//
+// Every proto except the last is passed to 'send' as soon as it is complete,
+// and the last one is returned so that the caller can add stats to it before
+// sending it. The first proto carries the result set metadata, and may also be
+// the last one. If limit > 0, will only convert first limit numbers of rows. If
+// 'num_rows' is not null, it is set to the number of rows converted. If
+// 'resume_token_fn' is provided, protos which end at a row boundary carry the
+// resume token it returns for the number of rows converted so far.
+absl::StatusOr<google::spanner::v1::PartialResultSet>
+StreamRowCursorToPartialResultSetProtos(
+    backend::RowCursor* cursor, int64_t limit,
+    const std::function<absl::Status(google::spanner::v1::PartialResultSet*)>&
+        send,
+    int64_t* num_rows = nullptr,
+    PartialResultSetEncoder::ResumeTokenFn resume_token_fn = nullptr);
+
 }  // namespace frontend
 }  // namespace emulator
 }  // namespace spanner
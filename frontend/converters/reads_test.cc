@@ -16,7 +16,9 @@
 
 #include "frontend/converters/reads.h"
 
+#include <cstdint>
 #include <memory>
+#include <string>
 #include <vector>
 
 #include "google/spanner/v1/mutation.pb.h"
@@ -29,9 +31,12 @@
 #include "zetasql/base/testing/status_matchers.h"
 #include "tests/common/proto_matchers.h"
 #include "absl/status/status.h"
+#include "backend/common/memory_tracker.h"
 #include "backend/datamodel/key_range.h"
 #include "backend/datamodel/key_set.h"
 #include "backend/schema/catalog/schema.h"
+#include "common/limits.h"
+#include "tests/common/chunking.h"
 #include "tests/common/row_cursor.h"
 #include "tests/common/schema_constructor.h"
 #include "absl/status/status.h"
@@ -297,6 +302,67 @@ TEST_F(AccessProtosTest, CanConvertRowCursorToPartialResultSetWithLimit) {
                               )"));
 }
 
+TEST_F(AccessProtosTest, StreamsRowCursorToPartialResultSetsWhileReading) {
+  // Each row is half a streaming chunk, so the rows span several chunks.
+  std::vector<std::vector<Value>> rows;
+  for (int i = 0; i < 4; ++i) {
+    rows.push_back(
+        {Int64(i), String(std::string(limits::kMaxStreamingChunkSize / 2,
+                                      static_cast<char>('a' + i)))});
+  }
+  TestRowCursor cursor({"int64", "string"}, {Int64Type(), StringType()}, rows);
+
+  std::vector<PartialResultSet> results;
+  auto send = [&results](PartialResultSet* result) {
+    results.push_back(*result);
+    return absl::OkStatus();
+  };
+  int64_t num_rows = 0;
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      PartialResultSet last_result,
+      StreamRowCursorToPartialResultSetProtos(&cursor, 0, send, &num_rows));
+  EXPECT_EQ(num_rows, 4);
+  ASSERT_FALSE(results.empty());
+  results.push_back(last_result);
+
+  // Only the first result carries metadata.
+  EXPECT_TRUE(results.front().has_metadata());
+  for (int i = 1; i < static_cast<int>(results.size()); ++i) {
+    EXPECT_FALSE(results[i].has_metadata());
+  }
+
+  TestRowCursor expected_cursor({"int64", "string"},
+                                {Int64Type(), StringType()}, rows);
+  ResultSet expected;
+  ZETASQL_ASSERT_OK(RowCursorToResultSetProto(&expected_cursor, 0, &expected));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(ResultSet merged,
+                       backend::test::MergePartialResultSets(results, 2));
+  EXPECT_THAT(merged, test::EqualsProto(expected));
+}
+
+TEST_F(AccessProtosTest, StreamsEmptyRowCursorAsOnePartialResultSet) {
+  TestRowCursor cursor({"int64"}, {Int64Type()}, {});
+  int num_sent = 0;
+  auto send = [&num_sent](PartialResultSet* result) {
+    ++num_sent;
+    return absl::OkStatus();
+  };
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      PartialResultSet last_result,
+      StreamRowCursorToPartialResultSetProtos(&cursor, 0, send));
+  EXPECT_EQ(num_sent, 0);
+  EXPECT_THAT(last_result, test::EqualsProto(
+                               R"(metadata {
+                                    row_type {
+                                      fields {
+                                        name: "int64"
+                                        type { code: INT64 }
+                                      }
+                                    }
+                                  }
+                               )"));
+}
+
 TEST_F(AccessProtosTest, CanConvertEmptyRowCursorToResultSet) {
   const zetasql::Type* struct_array;
   ZETASQL_EXPECT_OK(type_factory_->MakeStructTypeFromVector(
@@ -377,6 +443,28 @@ TEST_F(AccessProtosTest, CanConvertEmptyRowCursorToResultSet) {
                              )"));
 }
 
+TEST_F(AccessProtosTest, CannotConvertRowCursorToResultSetOverMemoryLimit) {
+  TestRowCursor cursor({"string"}, {StringType()},
+                       {{String(std::string(100, 'a'))},
+                        {String(std::string(100, 'b'))}});
+  ResultSet result_pb;
+  backend::MemoryTracker memory_tracker(/*limit_bytes=*/150);
+  EXPECT_THAT(
+      RowCursorToResultSetProto(&cursor, 0, &result_pb, &memory_tracker),
+      StatusIs(absl::StatusCode::kResourceExhausted));
+  EXPECT_EQ(result_pb.rows_size(), 2);
+
+  // Rows within the limit are converted.
+  TestRowCursor small_cursor({"string"}, {StringType()},
+                             {{String(std::string(100, 'a'))}});
+  result_pb.Clear();
+  backend::MemoryTracker small_memory_tracker(/*limit_bytes=*/150);
+  ZETASQL_EXPECT_OK(RowCursorToResultSetProto(&small_cursor, 0, &result_pb,
+                                      &small_memory_tracker));
+  EXPECT_EQ(result_pb.rows_size(), 1);
+  EXPECT_GT(small_memory_tracker.used_bytes(), 100);
+}
+
 TEST_F(AccessProtosTest, CannotConvertInvalidRowCursorToResultSet) {
   ResultSet result_pb;
 
@@ -0,0 +1,78 @@
+//
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "frontend/converters/resume_token.h"
+
+#include <cstdint>
+#include <string>
+
+#include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/io/zero_copy_stream_impl_lite.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/escaping.h"
+#include "common/errors.h"
+#include "farmhash.h"
+#include "zetasql/base/ret_check.h"
+
+namespace google {
+namespace spanner {
+namespace emulator {
+namespace frontend {
+
+absl::StatusOr<std::string> ResumeTokenToString(
+    const ResumeToken& resume_token) {
+  std::string binary_string, token_string;
+  ZETASQL_RET_CHECK(resume_token.SerializeToString(&binary_string))
+      << "Failed to serialize proto: " << resume_token.ShortDebugString();
+  absl::WebSafeBase64Escape(binary_string, &token_string);
+  return token_string;
+}
+
+absl::StatusOr<ResumeToken> ResumeTokenFromString(const std::string& token) {
+  std::string binary_string;
+  if (!absl::WebSafeBase64Unescape(token, &binary_string)) {
+    return error::InvalidResumeToken();
+  }
+
+  ResumeToken resume_token;
+  if (!resume_token.ParseFromString(binary_string) ||
+      resume_token.row_count() < 0) {
+    return error::InvalidResumeToken();
+  }
+  return resume_token;
+}
+
+uint64_t ReadRequestFingerprint(
+    const google::spanner::v1::ReadRequest& request) {
+  google::spanner::v1::ReadRequest copy = request;
+  copy.clear_resume_token();
+  copy.clear_transaction();
+  std::string serialized_request;
+  {
+    // Serialize the request deterministically, flushing the output stream
+    // before computing the fingerprint.
+    google::protobuf::io::StringOutputStream stream(&serialized_request);
+    google::protobuf::io::CodedOutputStream output(&stream);
+    output.SetSerializationDeterministic(true);
+    copy.SerializeToCodedStream(&output);
+  }
+  return farmhash::Fingerprint64(serialized_request);
+}
+
+}  // namespace frontend
+}  // namespace emulator
+}  // namespace spanner
+}  // namespace google
@@ -0,0 +1,50 @@
+//
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef THIRD_PARTY_CLOUD_SPANNER_EMULATOR_FRONTEND_CONVERTERS_RESUME_TOKEN_H_
+#define THIRD_PARTY_CLOUD_SPANNER_EMULATOR_FRONTEND_CONVERTERS_RESUME_TOKEN_H_
+
+#include <cstdint>
+#include <string>
+
+#include "google/spanner/v1/spanner.pb.h"
+#include "absl/status/statusor.h"
+#include "frontend/proto/resume_token.pb.h"
+
+namespace google {
+namespace spanner {
+namespace emulator {
+namespace frontend {
+
+// Converts a resume token into a byte string.
+absl::StatusOr<std::string> ResumeTokenToString(
+    const ResumeToken& resume_token);
+
+// Converts a byte string into a resume token.
+absl::StatusOr<ResumeToken> ResumeTokenFromString(const std::string& token);
+
+// Returns a fingerprint of a read request which ignores its resume token and
+// transaction selector, so that a resumed request has the same fingerprint as
+// the original one, even if it selects by ID the transaction which the original
+// one began.
+uint64_t ReadRequestFingerprint(const google::spanner::v1::ReadRequest& request);
+
+}  // namespace frontend
+}  // namespace emulator
+}  // namespace spanner
+}  // namespace google
+
+#endif  // THIRD_PARTY_CLOUD_SPANNER_EMULATOR_FRONTEND_CONVERTERS_RESUME_TOKEN_H_
@@ -0,0 +1,93 @@
+//
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "frontend/converters/resume_token.h"
+
+#include <string>
+
+#include "google/spanner/v1/spanner.pb.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "zetasql/base/testing/status_matchers.h"
+#include "tests/common/proto_matchers.h"
+#include "absl/status/status.h"
+#include "absl/strings/escaping.h"
+
+namespace google {
+namespace spanner {
+namespace emulator {
+namespace frontend {
+
+namespace {
+
+using test::EqualsProto;
+using zetasql_base::testing::IsOkAndHolds;
+using zetasql_base::testing::StatusIs;
+
+TEST(ResumeTokenTest, RoundTripsThroughString) {
+  ResumeToken resume_token = PARSE_TEXT_PROTO(R"(
+    request_fingerprint: 1234
+    row_count: 5
+    last_key: "\x01\x80\x00\x00\x00\x00\x00\x00\x05"
+    read_timestamp_micros: 1600000000000000
+    transaction_id: 7
+  )");
+  ZETASQL_ASSERT_OK_AND_ASSIGN(std::string token, ResumeTokenToString(resume_token));
+  EXPECT_THAT(ResumeTokenFromString(token),
+              IsOkAndHolds(EqualsProto(resume_token)));
+}
+
+TEST(ResumeTokenTest, RejectsInvalidTokens) {
+  EXPECT_THAT(ResumeTokenFromString("not a token!"),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+
+  // Missing row count.
+  ResumeToken resume_token = PARSE_TEXT_PROTO(R"(request_fingerprint: 1234)");
+  EXPECT_THAT(ResumeTokenFromString(absl::WebSafeBase64Escape(
+                  resume_token.SerializePartialAsString())),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST(ResumeTokenTest, FingerprintIgnoresResumeTokenAndTransaction) {
+  google::spanner::v1::ReadRequest request = PARSE_TEXT_PROTO(R"(
+    session: "session"
+    table: "T"
+    columns: "k"
+    key_set { all: true }
+  )");
+  google::spanner::v1::ReadRequest resumed_request = request;
+  resumed_request.set_resume_token("token");
+  EXPECT_EQ(ReadRequestFingerprint(request),
+            ReadRequestFingerprint(resumed_request));
+
+  google::spanner::v1::ReadRequest begin_request = request;
+  begin_request.mutable_transaction()->mutable_begin()->mutable_read_only();
+  resumed_request.mutable_transaction()->set_id("transaction");
+  EXPECT_EQ(ReadRequestFingerprint(begin_request),
+            ReadRequestFingerprint(resumed_request));
+
+  google::spanner::v1::ReadRequest other_request = request;
+  other_request.set_table("U");
+  EXPECT_NE(ReadRequestFingerprint(request),
+            ReadRequestFingerprint(other_request));
+}
+
+}  // namespace
+
+}  // namespace frontend
+}  // namespace emulator
+}  // namespace spanner
+}  // namespace google
@@ -277,6 +277,22 @@ absl::StatusOr<std::shared_ptr<Transaction>> Session::FindOrInitTransaction(
   return txn;
 }
 
+void Session::Close() {
+  absl::MutexLock lock(&mu_);
+  // The active transaction is normally also in transaction_map_, unless too
+  // many transactions were created after it.
+  if (active_transaction_ != nullptr &&
+      transaction_map_.find(active_transaction_->id()) ==
+          transaction_map_.end()) {
+    active_transaction_->Close();
+  }
+  active_transaction_.reset();
+  for (auto& [id, txn] : transaction_map_) {
+    txn->Close();
+  }
+  transaction_map_.clear();
+}
+
 }  // namespace frontend
 }  // namespace emulator
 }  // namespace spanner
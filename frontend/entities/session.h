@@ -117,6 +117,10 @@ class Session {
   absl::StatusOr<std::shared_ptr<Transaction>> FindOrInitTransaction(
       const google::spanner::v1::TransactionSelector& selector);
 
+  // Closes all transactions of this session, rolling back those which are not
+  // yet committed. Called once the session is deleted or expires.
+  void Close() ABSL_LOCKS_EXCLUDED(mu_);
+
  private:
   // Create a transaction based on the provided options.
   absl::StatusOr<std::unique_ptr<Transaction>> CreateTransaction(
@@ -17,12 +17,14 @@
 #include "frontend/entities/transaction.h"
 
 #include <cstddef>
+#include <cstdint>
 #include <functional>
 #include <memory>
 #include <optional>
 #include <string>
 #include <utility>
 #include <variant>
+#include <vector>
 
 #include "google/spanner/v1/spanner.pb.h"
 #include "zetasql/public/value.h"
@@ -139,12 +141,12 @@ bool Transaction::HasState(
 }
 
 bool Transaction::IsRolledback() const {
-  mu_.AssertHeld();
+  mu_.AssertReaderHeld();
   return HasState(backend::ReadWriteTransaction::State::kRolledback);
 }
 
 bool Transaction::IsInvalid() const {
-  mu_.AssertHeld();
+  mu_.AssertReaderHeld();
   return HasState(backend::ReadWriteTransaction::State::kInvalid);
 }
 
@@ -154,7 +156,7 @@ bool Transaction::IsAborted() const {
 }
 
 bool Transaction::IsCommitted() const {
-  mu_.AssertHeld();
+  mu_.AssertReaderHeld();
   return HasState(backend::ReadWriteTransaction::State::kCommitted);
 }
 
@@ -184,7 +186,7 @@ backend::TransactionID Transaction::id() const {
 
 absl::Status Transaction::Read(const backend::ReadArg& read_arg,
                                std::unique_ptr<backend::RowCursor>* cursor) {
-  mu_.AssertHeld();
+  mu_.AssertReaderHeld();
   switch (type_) {
     case kReadOnly: {
       return read_only()->Read(read_arg, cursor);
@@ -200,7 +202,7 @@ absl::Status Transaction::Read(const backend::ReadArg& read_arg,
 
 absl::StatusOr<backend::QueryResult> Transaction::ExecuteSql(
     const backend::Query& query) {
-  mu_.AssertHeld();
+  mu_.AssertReaderHeld();
   switch (type_) {
     case kReadOnly: {
       return query_engine_->ExecuteSql(
@@ -227,6 +229,18 @@ absl::StatusOr<backend::QueryResult> Transaction::ExecuteSql(
   }
 }
 
+absl::StatusOr<std::vector<std::vector<backend::KeyRange>>>
+Transaction::PartitionRead(const backend::ReadArg& read_arg,
+                           int64_t partition_size_bytes,
+                           int64_t max_partitions) {
+  mu_.AssertReaderHeld();
+  if (type_ != kReadOnly) {
+    return error::PartitionReadNeedsReadOnlyTxn();
+  }
+  return read_only()->PartitionRead(read_arg, partition_size_bytes,
+                                    max_partitions);
+}
+
 absl::Status Transaction::Write(const backend::Mutation& mutation) {
   mu_.AssertHeld();
   if (type_ == kReadWrite) {
@@ -368,6 +382,16 @@ Transaction::DMLErrorHandlingMode Transaction::DMLErrorType() const {
 
 absl::Status Transaction::GuardedCall(OpType op,
                                       const std::function<absl::Status()>& fn) {
+  // Reads and queries of a read-only transaction neither change its state nor
+  // record their status, so they only share the lock. This lets the partitions
+  // returned by PartitionRead and PartitionQuery execute in parallel.
+  if (type_ == kReadOnly && (op == OpType::kRead || op == OpType::kSql)) {
+    absl::ReaderMutexLock lock(&mu_);
+    ZETASQL_RETURN_IF_ERROR(status_);
+    const absl::Status call_status = fn();
+    return absl::Status(call_status.code(), call_status.message());
+  }
+
   absl::MutexLock lock(&mu_);
 
   // Cannot reuse a transaction that previously encountered an error.
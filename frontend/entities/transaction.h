@@ -17,9 +17,11 @@
 #ifndef THIRD_PARTY_CLOUD_SPANNER_EMULATOR_FRONTEND_ENTITIES_TRANSACTIONS_H_
 #define THIRD_PARTY_CLOUD_SPANNER_EMULATOR_FRONTEND_ENTITIES_TRANSACTIONS_H_
 
+#include <cstdint>
 #include <memory>
 #include <optional>
 #include <variant>
+#include <vector>
 
 #include "google/protobuf/empty.pb.h"
 #include "google/spanner/v1/result_set.pb.h"
@@ -31,6 +33,7 @@
 #include "absl/types/optional.h"
 #include "absl/types/variant.h"
 #include "backend/common/ids.h"
+#include "backend/datamodel/key_range.h"
 #include "backend/query/query_engine.h"
 #include "backend/schema/catalog/schema.h"
 #include "backend/transaction/read_only_transaction.h"
@@ -137,6 +140,12 @@ class Transaction {
   // Calls ExecuteSql using the backend transaction and query engine.
   absl::StatusOr<backend::QueryResult> ExecuteSql(const backend::Query& query);
 
+  // Calls PartitionRead using the backend transaction, which must be
+  // read-only.
+  absl::StatusOr<std::vector<std::vector<backend::KeyRange>>> PartitionRead(
+      const backend::ReadArg& read_arg, int64_t partition_size_bytes,
+      int64_t max_partitions);
+
   // Calls Write using the backend transaction.
   absl::Status Write(const backend::Mutation& mutation);
 
@@ -179,7 +188,8 @@ class Transaction {
   // Returns true if the current transaction is a PartitionedDmlTransaction.
   bool IsPartitionedDml() const { return type_ == kPartitionedDml; }
 
-  // All transaction methods should be called inside GuardedCall.
+  // All transaction methods should be called inside GuardedCall. Reads and
+  // queries of read-only transactions may run concurrently.
   absl::Status GuardedCall(OpType op, const std::function<absl::Status()>& fn)
       ABSL_LOCKS_EXCLUDED(mu_);
 
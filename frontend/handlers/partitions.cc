@@ -14,8 +14,10 @@
 // limitations under the License.
 //
 
+#include <cstdint>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "google/protobuf/struct.pb.h"
 #include "google/spanner/v1/keys.pb.h"
@@ -24,13 +26,19 @@
 #include "google/spanner/v1/type.pb.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "backend/access/read.h"
+#include "backend/datamodel/key_range.h"
+#include "backend/datamodel/key_set.h"
 #include "backend/query/query_engine.h"
 #include "common/config.h"
 #include "common/errors.h"
+#include "common/limits.h"
+#include "frontend/converters/keys.h"
 #include "frontend/converters/partition.h"
 #include "frontend/converters/query.h"
 #include "frontend/converters/reads.h"
 #include "frontend/entities/session.h"
+#include "frontend/entities/transaction.h"
 #include "frontend/proto/partition_token.pb.h"
 #include "frontend/server/handler.h"
 #include "zetasql/base/status_macros.h"
@@ -94,10 +102,13 @@ absl::StatusOr<PartitionToken> CreatePartitionTokenForRead(
   return partition_token;
 }
 
-// Create a partition token for the given partition query request.
+// Create a partition token for the given partition query request. The rows of
+// the partition are those of root_table with keys in partitioned_key_set, or
+// all rows of the query if root_table is empty.
 absl::StatusOr<PartitionToken> CreatePartitionTokenForQuery(
     const google::spanner::v1::PartitionQueryRequest& request,
-    const backend::TransactionID& txn_id, bool empty_partition) {
+    const backend::TransactionID& txn_id, const std::string& root_table,
+    const google::spanner::v1::KeySet& partitioned_key_set) {
   if (request.sql().empty()) {
     return error::MissingRequiredFieldError("sql");
   }
@@ -110,10 +121,48 @@ absl::StatusOr<PartitionToken> CreatePartitionTokenForQuery(
   *query_params->mutable_params() = request.params();
   *query_params->mutable_param_types() = request.param_types();
 
-  partition_token.set_empty_query_partition(empty_partition);
+  if (root_table.empty()) {
+    partition_token.set_empty_query_partition(false);
+  } else {
+    query_params->set_root_table(root_table);
+    *partition_token.mutable_partitioned_key_set() = partitioned_key_set;
+  }
   return partition_token;
 }
 
+// Splits the rows of read_arg into key sets of the partitions requested by
+// partition_options.
+absl::StatusOr<std::vector<spanner_api::KeySet>> PartitionKeySets(
+    const backend::ReadArg& read_arg,
+    const spanner_api::PartitionOptions& partition_options,
+    Transaction* txn) {
+  const int64_t partition_size_bytes =
+      partition_options.partition_size_bytes() > 0
+          ? partition_options.partition_size_bytes()
+          : limits::kDefaultPartitionSizeBytes;
+  const int64_t max_partitions = partition_options.max_partitions() > 0
+                                     ? partition_options.max_partitions()
+                                     : limits::kDefaultMaxPartitions;
+
+  std::vector<std::vector<backend::KeyRange>> partitions;
+  ZETASQL_RETURN_IF_ERROR(txn->GuardedCall(
+      Transaction::OpType::kRead, [&]() -> absl::Status {
+        ZETASQL_ASSIGN_OR_RETURN(partitions,
+                         txn->PartitionRead(read_arg, partition_size_bytes,
+                                            max_partitions));
+        return absl::OkStatus();
+      }));
+
+  std::vector<spanner_api::KeySet> key_sets(partitions.size());
+  for (int i = 0; i < partitions.size(); ++i) {
+    for (const backend::KeyRange& key_range : partitions[i]) {
+      ZETASQL_ASSIGN_OR_RETURN(*key_sets[i].add_ranges(),
+                       KeyRangeToProto(key_range));
+    }
+  }
+  return key_sets;
+}
+
 }  //  namespace
 
 // Creates a set of partition tokens for executing parallel read operations.
@@ -142,25 +191,27 @@ absl::Status PartitionRead(RequestContext* ctx,
     ZETASQL_ASSIGN_OR_RETURN(*response->mutable_transaction(), txn->ToProto());
   }
 
-  // Add two partitions to result set, with first partition being empty.
+  // Split the rows of the read at the read timestamp of the transaction. Each
+  // partition reads the key ranges of its rows instead of the requested key
+  // set.
+  spanner_api::ReadRequest read_request;
+  read_request.set_table(request->table());
+  read_request.set_index(request->index());
+  *read_request.mutable_columns() = request->columns();
+  *read_request.mutable_key_set() = request->key_set();
+  backend::ReadArg read_arg;
+  ZETASQL_RETURN_IF_ERROR(ReadArgFromProto(*txn->schema(), read_request, &read_arg));
   ZETASQL_ASSIGN_OR_RETURN(
-      auto empty_partition_token,
-      CreatePartitionTokenForRead(*request, txn->id(), spanner_api::KeySet()));
-  spanner_api::Partition empty_partition;
-  ZETASQL_ASSIGN_OR_RETURN(*empty_partition.mutable_partition_token(),
-                   PartitionTokenToString(empty_partition_token));
-
-  // Second partition contains full result set for requested key_set.
-  ZETASQL_ASSIGN_OR_RETURN(
-      auto full_partition_token,
-      CreatePartitionTokenForRead(*request, txn->id(), request->key_set()));
-  spanner_api::Partition full_partition;
-  ZETASQL_ASSIGN_OR_RETURN(*full_partition.mutable_partition_token(),
-                   PartitionTokenToString(full_partition_token));
-
-  *response->mutable_partitions()->Add() = empty_partition;
-  *response->mutable_partitions()->Add() = full_partition;
+      std::vector<spanner_api::KeySet> key_sets,
+      PartitionKeySets(read_arg, request->partition_options(), txn.get()));
 
+  for (const spanner_api::KeySet& key_set : key_sets) {
+    ZETASQL_ASSIGN_OR_RETURN(auto partition_token,
+                     CreatePartitionTokenForRead(*request, txn->id(), key_set));
+    ZETASQL_ASSIGN_OR_RETURN(
+        *response->add_partitions()->mutable_partition_token(),
+        PartitionTokenToString(partition_token));
+  }
   return absl::OkStatus();
 }
 REGISTER_GRPC_HANDLER(Spanner, PartitionRead);
@@ -197,30 +248,34 @@ absl::Status PartitionQuery(RequestContext* ctx,
       QueryFromProto(request->sql(), request->params(), request->param_types(),
                      txn->query_engine()->type_factory()
                      ));
+  std::string root_table;
   ZETASQL_RETURN_IF_ERROR(txn->query_engine()->IsPartitionable(
       query,
       backend::QueryContext{
-          .schema = txn->schema(), .reader = nullptr, .writer = nullptr}));
-
-  // Add two partitions to result set, with first partition being empty.
-  ZETASQL_ASSIGN_OR_RETURN(auto empty_partition_token,
-                   CreatePartitionTokenForQuery(*request, txn->id(),
-                                                /*empty_partition =*/true));
-  spanner_api::Partition empty_partition;
-  ZETASQL_ASSIGN_OR_RETURN(*empty_partition.mutable_partition_token(),
-                   PartitionTokenToString(empty_partition_token));
-
-  // Second partition contains full result set for requested query.
-  ZETASQL_ASSIGN_OR_RETURN(auto full_partition_token,
-                   CreatePartitionTokenForQuery(*request, txn->id(),
-                                                /*empty_partition =*/false));
-  spanner_api::Partition full_partition;
-  ZETASQL_ASSIGN_OR_RETURN(*full_partition.mutable_partition_token(),
-                   PartitionTokenToString(full_partition_token));
-
-  *response->mutable_partitions()->Add() = empty_partition;
-  *response->mutable_partitions()->Add() = full_partition;
+          .schema = txn->schema(), .reader = nullptr, .writer = nullptr},
+      &root_table));
 
+  // Rows of a query are partitioned by the keys of its root table. Queries
+  // without one, which are only partitionable if the partitionability check is
+  // disabled, are returned as a single partition.
+  std::vector<spanner_api::KeySet> key_sets(1);
+  if (!root_table.empty()) {
+    backend::ReadArg read_arg;
+    read_arg.table = root_table;
+    read_arg.key_set = backend::KeySet::All();
+    ZETASQL_ASSIGN_OR_RETURN(
+        key_sets,
+        PartitionKeySets(read_arg, request->partition_options(), txn.get()));
+  }
+
+  for (const spanner_api::KeySet& key_set : key_sets) {
+    ZETASQL_ASSIGN_OR_RETURN(
+        auto partition_token,
+        CreatePartitionTokenForQuery(*request, txn->id(), root_table, key_set));
+    ZETASQL_ASSIGN_OR_RETURN(
+        *response->add_partitions()->mutable_partition_token(),
+        PartitionTokenToString(partition_token));
+  }
   return absl::OkStatus();
 }
 REGISTER_GRPC_HANDLER(Spanner, PartitionQuery);
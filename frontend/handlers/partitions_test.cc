@@ -15,6 +15,7 @@
 //
 
 #include <string>
+#include <vector>
 
 #include "google/spanner/v1/mutation.pb.h"
 #include "google/spanner/v1/spanner.pb.h"
@@ -24,6 +25,7 @@
 #include "zetasql/base/testing/status_matchers.h"
 #include "tests/common/proto_matchers.h"
 #include "absl/status/status.h"
+#include "absl/status/statusor.h"
 #include "common/errors.h"
 #include "tests/common/test_env.h"
 
@@ -34,6 +36,8 @@ namespace frontend {
 
 namespace {
 
+using ::testing::SizeIs;
+using ::testing::UnorderedElementsAre;
 using ::zetasql_base::testing::StatusIs;
 
 namespace spanner_api = ::google::spanner::v1;
@@ -44,6 +48,50 @@ class PartitionApiTest : public test::ServerTest {
     ZETASQL_ASSERT_OK(CreateTestInstance());
     ZETASQL_ASSERT_OK(CreateTestDatabase());
     ZETASQL_ASSERT_OK_AND_ASSIGN(test_session_uri_, CreateTestSession());
+    ZETASQL_ASSERT_OK(PopulateTestDatabase());
+  }
+
+  absl::Status PopulateTestDatabase() {
+    spanner_api::CommitRequest commit_request = PARSE_TEXT_PROTO(R"(
+      single_use_transaction { read_write {} }
+      mutations {
+        insert {
+          table: "test_table"
+          columns: "int64_col"
+          columns: "string_col"
+          values {
+            values { string_value: "1" }
+            values { string_value: "row_1" }
+          }
+          values {
+            values { string_value: "2" }
+            values { string_value: "row_2" }
+          }
+          values {
+            values { string_value: "3" }
+            values { string_value: "row_3" }
+          }
+        }
+      }
+    )");
+    *commit_request.mutable_session() = test_session_uri_;
+
+    spanner_api::CommitResponse commit_response;
+    return Commit(commit_request, &commit_response);
+  }
+
+  // Begins a read only transaction and returns a selector for it.
+  absl::StatusOr<spanner_api::TransactionSelector> BeginReadOnlyTransaction() {
+    spanner_api::BeginTransactionRequest txn_request = PARSE_TEXT_PROTO(R"(
+      options { read_only {} }
+    )");
+    txn_request.set_session(test_session_uri_);
+
+    spanner_api::Transaction txn_response;
+    ZETASQL_RETURN_IF_ERROR(BeginTransaction(txn_request, &txn_response));
+    spanner_api::TransactionSelector selector;
+    selector.set_id(txn_response.id());
+    return selector;
   }
 
   std::string test_session_uri_;
@@ -141,6 +189,80 @@ TEST_F(PartitionApiTest, CannotReadUsingInvalidPartitionOptions) {
               StatusIs(absl::StatusCode::kInvalidArgument));
 }
 
+TEST_F(PartitionApiTest, PartitionsReadAtRowBoundaries) {
+  ZETASQL_ASSERT_OK_AND_ASSIGN(spanner_api::TransactionSelector selector,
+                       BeginReadOnlyTransaction());
+
+  spanner_api::PartitionReadRequest partition_read_request = PARSE_TEXT_PROTO(
+      R"(
+        table: "test_table"
+        columns: "int64_col"
+        key_set { all: true }
+        partition_options { partition_size_bytes: 1 }
+      )");
+  partition_read_request.set_session(test_session_uri_);
+  *partition_read_request.mutable_transaction() = selector;
+
+  spanner_api::PartitionResponse partition_read_response;
+  ZETASQL_ASSERT_OK(
+      PartitionRead(partition_read_request, &partition_read_response));
+  ASSERT_THAT(partition_read_response.partitions(), SizeIs(3));
+
+  // Each partition reads a different row of the table.
+  std::vector<std::string> rows;
+  for (const auto& partition : partition_read_response.partitions()) {
+    spanner_api::ReadRequest read_request = PARSE_TEXT_PROTO(R"(
+      table: "test_table"
+      columns: "int64_col"
+      key_set { all: true }
+    )");
+    read_request.set_session(test_session_uri_);
+    *read_request.mutable_transaction() = selector;
+    read_request.set_partition_token(partition.partition_token());
+
+    spanner_api::ResultSet read_response;
+    ZETASQL_ASSERT_OK(Read(read_request, &read_response));
+    ASSERT_THAT(read_response.rows(), SizeIs(1));
+    rows.push_back(read_response.rows(0).values(0).string_value());
+  }
+  EXPECT_THAT(rows, UnorderedElementsAre("1", "2", "3"));
+}
+
+TEST_F(PartitionApiTest, PartitionsQueryAtRowBoundariesOfRootTable) {
+  ZETASQL_ASSERT_OK_AND_ASSIGN(spanner_api::TransactionSelector selector,
+                       BeginReadOnlyTransaction());
+
+  spanner_api::PartitionQueryRequest partition_query_request =
+      PARSE_TEXT_PROTO(R"(
+        sql: "SELECT int64_col FROM test_table WHERE int64_col > 1"
+        partition_options { partition_size_bytes: 1 }
+      )");
+  partition_query_request.set_session(test_session_uri_);
+  *partition_query_request.mutable_transaction() = selector;
+
+  spanner_api::PartitionResponse partition_query_response;
+  ZETASQL_ASSERT_OK(
+      PartitionQuery(partition_query_request, &partition_query_response));
+  ASSERT_THAT(partition_query_response.partitions(), SizeIs(3));
+
+  // The filter is applied within each partition of the table.
+  std::vector<std::string> rows;
+  for (const auto& partition : partition_query_response.partitions()) {
+    spanner_api::ExecuteSqlRequest sql_request;
+    sql_request.set_sql(partition_query_request.sql());
+    sql_request.set_session(test_session_uri_);
+    *sql_request.mutable_transaction() = selector;
+    sql_request.set_partition_token(partition.partition_token());
+
+    spanner_api::ResultSet sql_response;
+    ZETASQL_ASSERT_OK(ExecuteSql(sql_request, &sql_response));
+    for (const auto& row : sql_response.rows()) {
+      rows.push_back(row.values(0).string_value());
+    }
+  }
+  EXPECT_THAT(rows, UnorderedElementsAre("2", "3"));
+}
+
 }  // namespace
 
 }  // namespace frontend
@@ -14,26 +14,40 @@
 // limitations under the License.
 //
 
+#include <chrono>  // NOLINT(build/c++11)
+#include <cstdint>
 #include <memory>
+#include <optional>
 #include <string>
 #include <utility>
 #include <variant>
 #include <vector>
 
 #include "google/protobuf/struct.pb.h"
+#include "google/spanner/v1/query_plan.pb.h"
 #include "google/spanner/v1/result_set.pb.h"
 #include "google/spanner/v1/spanner.pb.h"
 #include "google/spanner/v1/transaction.pb.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/cord.h"
+#include "absl/strings/str_cat.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
 #include "absl/types/optional.h"
 #include "absl/types/variant.h"
 #include "backend/access/read.h"
+#include "backend/common/memory_tracker.h"
+#include "backend/datamodel/key_set.h"
+#include "backend/query/query_cancellation.h"
 #include "backend/query/query_engine.h"
+#include "backend/query/query_stats.h"
+#include "backend/schema/catalog/schema.h"
+#include "common/config.h"
 #include "common/constants.h"
 #include "common/errors.h"
 #include "frontend/common/protos.h"
+#include "frontend/converters/keys.h"
 #include "frontend/converters/partition.h"
 #include "frontend/converters/query.h"
 #include "frontend/converters/reads.h"
@@ -44,6 +58,7 @@
 #include "frontend/proto/partition_token.pb.h"
 #include "frontend/server/handler.h"
 #include "frontend/server/request_context.h"
+#include "grpcpp/server_context.h"
 #include "farmhash.h"
 #include "absl/status/status.h"
 #include "zetasql/base/status_macros.h"
@@ -135,25 +150,125 @@ absl::Status ValidatePartitionToken(
   return absl::OkStatus();
 }
 
+// Restricts 'query' to the rows of the partition of 'partition_token', if the
+// token partitions the rows of a root table of the query.
+absl::Status SetQueryPartition(const PartitionToken& partition_token,
+                               const backend::Schema& schema,
+                               backend::Query* query) {
+  const std::string& root_table = partition_token.query_params().root_table();
+  if (root_table.empty() || !partition_token.has_partitioned_key_set()) {
+    return absl::OkStatus();
+  }
+  const backend::Table* table = schema.FindTable(root_table);
+  if (table == nullptr) {
+    return error::TableNotFound(root_table);
+  }
+  ZETASQL_ASSIGN_OR_RETURN(
+      backend::KeySet key_set,
+      KeySetFromProto(partition_token.partitioned_key_set(), *table));
+  query->partition = backend::QueryPartition{.root_table = root_table,
+                                             .key_set = std::move(key_set)};
+  return absl::OkStatus();
+}
+
 bool IsDmlResult(const backend::QueryResult& result) {
   return result.rows == nullptr;
 }
 
-void AddQueryStatsFromQueryResult(const backend::QueryResult& result,
-                                  google::protobuf::Struct* stats) {
-  (*stats->mutable_fields())["rows_returned"].set_string_value(
-      absl::StrCat(result.num_output_rows));
-  (*stats->mutable_fields())["elapsed_time"].set_string_value(
-      absl::FormatDuration(result.elapsed_time));
+// Sets the execution stats of a plan node, in the format Cloud Spanner uses:
+// each stat is a struct of its total and its unit.
+void SetPlanNodeExecutionStats(int64_t rows, absl::Duration latency,
+                               int64_t num_executions,
+                               spanner_api::PlanNode* node) {
+  auto* fields = node->mutable_execution_stats()->mutable_fields();
+  auto* rows_fields = (*fields)["rows"].mutable_struct_value()->mutable_fields();
+  (*rows_fields)["total"].set_string_value(absl::StrCat(rows));
+  (*rows_fields)["unit"].set_string_value("rows");
+  auto* latency_fields =
+      (*fields)["latency"].mutable_struct_value()->mutable_fields();
+  (*latency_fields)["total"].set_string_value(
+      absl::StrCat(absl::ToDoubleMilliseconds(latency)));
+  (*latency_fields)["unit"].set_string_value("msecs");
+  (*(*fields)["execution_summary"].mutable_struct_value()->mutable_fields())
+      ["num_executions"]
+          .set_string_value(absl::StrCat(num_executions));
+}
+
+// Adds stats for PROFILE mode. Query stats hold the time spent in each phase of
+// executing the statement, and the query plan has a node for the result and a
+// child scan node for each table or index the statement read. The plan does
+// not otherwise reflect how the statement was evaluated.
+void AddQueryStats(int64_t rows_returned, absl::Duration elapsed_time,
+                   absl::Duration serialization_time,
+                   const backend::QueryStats& query_stats,
+                   spanner_api::ResultSetStats* stats) {
+  auto* fields = stats->mutable_query_stats()->mutable_fields();
+  auto set_duration = [fields](const std::string& name,
+                               absl::Duration duration) {
+    (*fields)[name].set_string_value(absl::FormatDuration(duration));
+  };
+  (*fields)["rows_returned"].set_string_value(absl::StrCat(rows_returned));
+  (*fields)["rows_scanned"].set_string_value(
+      absl::StrCat(query_stats.rows_scanned()));
+  (*fields)["query_plan_cache_hit"].set_string_value(
+      query_stats.plan_cache_hit ? "true" : "false");
+  set_duration("elapsed_time", elapsed_time);
+  set_duration("query_plan_creation_time", query_stats.analysis_time +
+                                               query_stats.validation_time +
+                                               query_stats.preparation_time);
+  set_duration("analysis_time", query_stats.analysis_time);
+  set_duration("validation_time", query_stats.validation_time);
+  set_duration("preparation_time", query_stats.preparation_time);
+  set_duration("evaluation_time", query_stats.evaluation_time);
+  set_duration("serialization_time", serialization_time);
+
+  spanner_api::QueryPlan* query_plan = stats->mutable_query_plan();
+  spanner_api::PlanNode* result_node = query_plan->add_plan_nodes();
+  result_node->set_index(0);
+  result_node->set_kind(spanner_api::PlanNode::RELATIONAL);
+  result_node->set_display_name("Serialize Result");
+  SetPlanNodeExecutionStats(rows_returned, elapsed_time, /*num_executions=*/1,
+                            result_node);
+  for (const auto& [name, scan_stats] : query_stats.table_scans) {
+    spanner_api::PlanNode* scan_node = query_plan->add_plan_nodes();
+    scan_node->set_index(query_plan->plan_nodes_size() - 1);
+    scan_node->set_kind(spanner_api::PlanNode::RELATIONAL);
+    scan_node->set_display_name("Scan");
+    auto* metadata = scan_node->mutable_metadata()->mutable_fields();
+    (*metadata)["scan_type"].set_string_value(
+        scan_stats.index.empty() ? "TableScan" : "IndexScan");
+    (*metadata)["scan_target"].set_string_value(name);
+    SetPlanNodeExecutionStats(scan_stats.rows_read, scan_stats.read_time,
+                              scan_stats.num_scans, scan_node);
+    result_node->add_child_links()->set_child_index(scan_node->index());
+  }
+}
+
+// Returns a cancellation which fires once the deadline of the RPC of 'ctx'
+// passes or its client cancels it.
+backend::QueryCancellation QueryCancellationFromContext(RequestContext* ctx) {
+  grpc::ServerContextBase* grpc_context = ctx->grpc();
+  if (grpc_context == nullptr) {
+    return backend::QueryCancellation();
+  }
+  absl::Time deadline = absl::InfiniteFuture();
+  if (grpc_context->deadline() !=
+      std::chrono::system_clock::time_point::max()) {
+    deadline = absl::FromChrono(grpc_context->deadline());
+  }
+  return backend::QueryCancellation(
+      deadline, [grpc_context] { return grpc_context->IsCancelled(); });
 }
 
 absl::StatusOr<backend::QueryResult> ExecuteQuery(
     const spanner_api::ExecuteBatchDmlRequest_Statement& statement,
+    const backend::QueryCancellation& cancellation,
     std::shared_ptr<Transaction> txn) {
-  ZETASQL_ASSIGN_OR_RETURN(const backend::Query query,
+  ZETASQL_ASSIGN_OR_RETURN(backend::Query query,
                    QueryFromProto(statement.sql(), statement.params(),
                                   statement.param_types(),
                                   txn->query_engine()->type_factory()));
+  query.cancellation = cancellation;
   return txn->ExecuteSql(query);
 }
 
@@ -256,10 +371,27 @@ absl::Status ExecuteSql(RequestContext* ctx,
         }
 
         // Convert and execute provided SQL statement.
-        ZETASQL_ASSIGN_OR_RETURN(const backend::Query query,
+        ZETASQL_ASSIGN_OR_RETURN(backend::Query query,
                          QueryFromProto(request->sql(), request->params(),
                                         request->param_types(),
                                         txn->query_engine()->type_factory()));
+        query.cancellation = QueryCancellationFromContext(ctx);
+        backend::MemoryTracker memory_tracker(config::max_result_set_bytes());
+        query.memory_tracker = &memory_tracker;
+        backend::QueryStats query_stats;
+        if (request->query_mode() == spanner_api::ExecuteSqlRequest::PROFILE) {
+          query.stats = &query_stats;
+        }
+        std::optional<PartitionToken> partition_token;
+        if (!request->partition_token().empty()) {
+          ZETASQL_ASSIGN_OR_RETURN(
+              partition_token,
+              PartitionTokenFromString(request->partition_token()));
+          ZETASQL_RETURN_IF_ERROR(ValidatePartitionToken(*partition_token, request));
+          ZETASQL_RETURN_IF_ERROR(
+              SetQueryPartition(*partition_token, *txn->schema(), &query));
+        }
+        absl::Time start_time = absl::Now();
         auto maybe_result = txn->ExecuteSql(query);
         if (!maybe_result.ok()) {
           absl::Status error = maybe_result.status();
@@ -278,6 +410,7 @@ absl::Status ExecuteSql(RequestContext* ctx,
                            txn->ToProto());
         }
 
+        absl::Duration serialization_time;
         if (IsDmlResult(result)) {
           if (txn->IsPartitionedDml()) {
             response->mutable_stats()->set_row_count_lower_bound(
@@ -289,26 +422,26 @@ absl::Status ExecuteSql(RequestContext* ctx,
           // Set empty row type.
           response->mutable_metadata()->mutable_row_type();
         } else {
-          ZETASQL_RETURN_IF_ERROR(RowCursorToResultSetProto(result.rows.get(),
-                                                    /*limit=*/0, response));
+          // Rows are evaluated as they are converted, so the time spent
+          // evaluating them is not counted as serialization.
+          absl::Time serialization_start = absl::Now();
+          absl::Duration evaluation_time = query_stats.evaluation_time;
+          ZETASQL_RETURN_IF_ERROR(RowCursorToResultSetProto(
+              result.rows.get(), /*limit=*/0, response, &memory_tracker));
+          serialization_time =
+              absl::Now() - serialization_start -
+              (query_stats.evaluation_time - evaluation_time);
         }
 
-        if (!request->partition_token().empty()) {
-          ZETASQL_ASSIGN_OR_RETURN(
-              auto partition_token,
-              PartitionTokenFromString(request->partition_token()));
-          ZETASQL_RETURN_IF_ERROR(ValidatePartitionToken(partition_token, request));
-          if (partition_token.empty_query_partition()) {
-            response->clear_rows();
-          }
+        if (partition_token.has_value() &&
+            partition_token->empty_query_partition()) {
+          response->clear_rows();
         }
 
-        // Add basic stats for PROFILE mode. We do this to interoperate with
-        // REPL applications written for Cloud Spanner. The profile will not
-        // contain statistics for plan nodes.
         if (request->query_mode() == spanner_api::ExecuteSqlRequest::PROFILE) {
-          AddQueryStatsFromQueryResult(
-              result, response->mutable_stats()->mutable_query_stats());
+          AddQueryStats(response->rows_size(), absl::Now() - start_time,
+                        serialization_time, query_stats,
+                        response->mutable_stats());
         }
 
         // Reject requests for PLAN mode. The emulator uses ZetaSQL reference
@@ -327,11 +460,13 @@ absl::Status ExecuteSql(RequestContext* ctx,
 }
 REGISTER_GRPC_HANDLER(Spanner, ExecuteSql);
 
-// Executes a SQL statement, returning all results as a stream.
+// Executes a SQL statement, returning all results as a stream. Query results
+// are evaluated as they are streamed, so only about one chunk of rows is held
+// in memory at once.
 //
-// resume_tokens is not supported in the emulator. This implementation does not
-// limit the size of the response and therefore, chunked_value will always be
-// false.
+// resume_tokens is not supported for queries in the emulator: the order of rows
+// of a query without ORDER BY is deliberately randomized by the evaluator, so a
+// re-executed query cannot skip the rows which were already returned.
 absl::Status ExecuteStreamingSql(
     RequestContext* ctx, const spanner_api::ExecuteSqlRequest* request,
     ServerStream<spanner_api::PartialResultSet>* stream) {
@@ -399,10 +534,28 @@ absl::Status ExecuteStreamingSql(
         }
 
         // Convert and execute provided SQL statement.
-        ZETASQL_ASSIGN_OR_RETURN(const backend::Query query,
+        ZETASQL_ASSIGN_OR_RETURN(backend::Query query,
                          QueryFromProto(request->sql(), request->params(),
                                         request->param_types(),
                                         txn->query_engine()->type_factory()));
+        query.cancellation = QueryCancellationFromContext(ctx);
+        backend::MemoryTracker memory_tracker(config::max_result_set_bytes());
+        query.memory_tracker = &memory_tracker;
+        backend::QueryStats query_stats;
+        if (request->query_mode() == spanner_api::ExecuteSqlRequest::PROFILE) {
+          query.stats = &query_stats;
+        }
+        bool empty_query_partition = false;
+        if (!request->partition_token().empty()) {
+          ZETASQL_ASSIGN_OR_RETURN(
+              auto partition_token,
+              PartitionTokenFromString(request->partition_token()));
+          ZETASQL_RETURN_IF_ERROR(ValidatePartitionToken(partition_token, request));
+          ZETASQL_RETURN_IF_ERROR(
+              SetQueryPartition(partition_token, *txn->schema(), &query));
+          empty_query_partition = partition_token.empty_query_partition();
+        }
+        absl::Time start_time = absl::Now();
         auto maybe_result = txn->ExecuteSql(query);
         if (!maybe_result.ok()) {
           absl::Status error = maybe_result.status();
@@ -415,69 +568,73 @@ absl::Status ExecuteStreamingSql(
         }
         backend::QueryResult& result = maybe_result.value();
 
-        std::vector<spanner_api::PartialResultSet> responses;
+        // Reject requests for PLAN mode. The emulator uses ZetaSQL reference
+        // implementation which performs an unoptimized execution of the SQL
+        // query. The plan chosen by ZetaSQL will have no relation to those
+        // generated by Cloud Spanner, so we reject the PLAN mode completely.
+        if (request->query_mode() == spanner_api::ExecuteSqlRequest::PLAN) {
+          return error::EmulatorDoesNotSupportQueryPlans();
+        }
+
+        // Populates transaction metadata in the first response, which is the
+        // one carrying the result set metadata, and sends the response.
+        spanner_api::ResultSetMetadata metadata;
+        auto send = [&](spanner_api::PartialResultSet* response)
+            -> absl::Status {
+          if (response->has_metadata()) {
+            if (ShouldReturnTransaction(request->transaction())) {
+              ZETASQL_ASSIGN_OR_RETURN(
+                  *response->mutable_metadata()->mutable_transaction(),
+                  txn->ToProto());
+            }
+            metadata = response->metadata();
+          }
+          stream->Send(*response);
+          return absl::OkStatus();
+        };
+
+        spanner_api::PartialResultSet last_response;
+        int64_t rows_returned = 0;
+        absl::Duration serialization_time;
         if (IsDmlResult(result)) {
-          responses.emplace_back();
           if (txn->IsPartitionedDml()) {
-            responses.back().mutable_stats()->set_row_count_lower_bound(
+            last_response.mutable_stats()->set_row_count_lower_bound(
                 result.modified_row_count);
           } else {
-            responses.back().mutable_stats()->set_row_count_exact(
+            last_response.mutable_stats()->set_row_count_exact(
                 result.modified_row_count);
           }
           // Set empty row type.
-          responses.back().mutable_metadata()->mutable_row_type();
+          last_response.mutable_metadata()->mutable_row_type();
+        } else if (empty_query_partition) {
+          // Return only metadata, without evaluating the query.
+          ZETASQL_RETURN_IF_ERROR(ResultSetMetadataToProto(
+              result.rows.get(), last_response.mutable_metadata()));
         } else {
-          ZETASQL_ASSIGN_OR_RETURN(responses, RowCursorToPartialResultSetProtos(
-                                          result.rows.get(), /*limit=*/0));
-        }
-
-        if (!request->partition_token().empty()) {
-          ZETASQL_ASSIGN_OR_RETURN(
-              auto partition_token,
-              PartitionTokenFromString(request->partition_token()));
-          ZETASQL_RETURN_IF_ERROR(ValidatePartitionToken(partition_token, request));
-          if (partition_token.empty_query_partition()) {
-            // Clear all partial responses except the first one. Return only
-            // metadata in the first partial response.
-            responses.resize(1);
-            responses.front().clear_values();
-            responses.front().clear_chunked_value();
-          }
+          // Rows are evaluated as they are streamed to the client, so the
+          // serialization time also includes sending them.
+          absl::Time serialization_start = absl::Now();
+          absl::Duration evaluation_time = query_stats.evaluation_time;
+          ZETASQL_ASSIGN_OR_RETURN(last_response,
+                           StreamRowCursorToPartialResultSetProtos(
+                               result.rows.get(), /*limit=*/0, send,
+                               &rows_returned));
+          serialization_time =
+              absl::Now() - serialization_start -
+              (query_stats.evaluation_time - evaluation_time);
         }
 
-        // Populate transaction metadata.
-        if (ShouldReturnTransaction(request->transaction())) {
-          ZETASQL_ASSIGN_OR_RETURN(
-              *responses.front().mutable_metadata()->mutable_transaction(),
-              txn->ToProto());
-        }
-
-        // Add basic stats for PROFILE mode. We do this to interoperate with
-        // REPL applications written for Cloud Spanner. The profile will not
-        // contain statistics for plan nodes.
         if (request->query_mode() == spanner_api::ExecuteSqlRequest::PROFILE) {
-          AddQueryStatsFromQueryResult(
-              result, responses.front().mutable_stats()->mutable_query_stats());
-        }
-
-        // Reject requests for PLAN mode. The emulator uses ZetaSQL reference
-        // implementation which performs an unoptimized execution of the SQL
-        // query. The plan chosen by ZetaSQL will have no relation to those
-        // generated by Cloud Spanner, so we reject the PLAN mode completely.
-        if (request->query_mode() == spanner_api::ExecuteSqlRequest::PLAN) {
-          return error::EmulatorDoesNotSupportQueryPlans();
-        }
-
-        // Send results back to client.
-        for (const auto& response : responses) {
-          stream->Send(response);
+          AddQueryStats(rows_returned, absl::Now() - start_time,
+                        serialization_time, query_stats,
+                        last_response.mutable_stats());
         }
+        ZETASQL_RETURN_IF_ERROR(send(&last_response));
 
         if (is_dml_query) {
           spanner_api::ResultSet replay_result;
-          *replay_result.mutable_stats() = responses[0].stats();
-          *replay_result.mutable_metadata() = responses[0].metadata();
+          *replay_result.mutable_stats() = last_response.stats();
+          *replay_result.mutable_metadata() = metadata;
           txn->SetDmlReplayOutcome(replay_result);
         }
         return absl::OkStatus();
@@ -548,6 +705,8 @@ absl::Status ExecuteBatchDml(RequestContext* ctx,
       return error::CannotReadOrQueryAfterCommitOrRollback();
     }
 
+    const backend::QueryCancellation cancellation =
+        QueryCancellationFromContext(ctx);
     for (int index = 0; index < request->statements_size(); ++index) {
       const auto& statement = request->statements(index);
       if (!backend::IsDMLQuery(statement.sql())) {
@@ -558,7 +717,7 @@ absl::Status ExecuteBatchDml(RequestContext* ctx,
         return absl::OkStatus();
       }
 
-      const auto maybe_result = ExecuteQuery(statement, txn);
+      const auto maybe_result = ExecuteQuery(statement, cancellation, txn);
       if (!maybe_result.ok() &&
           maybe_result.status().code() != absl::StatusCode::kAborted) {
         absl::Status error = maybe_result.status();
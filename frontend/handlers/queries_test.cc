@@ -32,6 +32,7 @@
 #include "common/errors.h"
 #include "frontend/converters/types.h"
 #include "frontend/converters/values.h"
+#include "frontend/server/server.h"
 #include "tests/common/test_env.h"
 
 namespace google {
@@ -49,7 +50,13 @@ using test::proto::Partially;
 using zetasql_base::testing::StatusIs;
 
 class QueryApiTest : public test::ServerTest {
+ public:
+  QueryApiTest() = default;
+
  protected:
+  explicit QueryApiTest(const Server::Options& options)
+      : test::ServerTest(options) {}
+
   void SetUp() override {
     ZETASQL_ASSERT_OK(CreateTestInstance());
     ZETASQL_ASSERT_OK(CreateTestDatabase());
@@ -306,6 +313,62 @@ TEST_F(QueryApiTest, ExecuteStreamingSqlWithParameters) {
                             )")));
 }
 
+TEST_F(QueryApiTest, ReturnsStatsInProfileMode) {
+  spanner_api::ExecuteSqlRequest request = PARSE_TEXT_PROTO(
+      R"(
+        transaction { single_use { read_only { strong: true } } }
+        query_mode: PROFILE
+        sql: "SELECT string_col FROM test_table WHERE int64_col > 1"
+      )");
+  request.set_session(test_session_uri_);
+
+  spanner_api::ResultSet response;
+  ZETASQL_ASSERT_OK(ExecuteSql(request, &response));
+  const auto& query_stats = response.stats().query_stats().fields();
+  EXPECT_EQ(query_stats.at("rows_returned").string_value(), "2");
+  EXPECT_EQ(query_stats.at("rows_scanned").string_value(), "3");
+  for (const char* name :
+       {"elapsed_time", "query_plan_creation_time", "analysis_time",
+        "validation_time", "preparation_time", "evaluation_time",
+        "serialization_time", "query_plan_cache_hit"}) {
+    EXPECT_TRUE(query_stats.contains(name)) << name;
+  }
+  EXPECT_THAT(response.stats().query_plan(),
+              Partially(EqualsProto(R"(
+                plan_nodes {
+                  index: 0
+                  kind: RELATIONAL
+                  display_name: "Serialize Result"
+                  child_links { child_index: 1 }
+                }
+                plan_nodes {
+                  index: 1
+                  kind: RELATIONAL
+                  display_name: "Scan"
+                  metadata {
+                    fields {
+                      key: "scan_target"
+                      value { string_value: "test_table" }
+                    }
+                    fields {
+                      key: "scan_type"
+                      value { string_value: "TableScan" }
+                    }
+                  }
+                }
+              )")));
+
+  // The streaming case returns the same stats with its last response.
+  std::vector<spanner_api::PartialResultSet> streaming_response;
+  ZETASQL_ASSERT_OK(ExecuteStreamingSql(request, &streaming_response));
+  ASSERT_FALSE(streaming_response.empty());
+  const auto& streaming_stats = streaming_response.back().stats();
+  EXPECT_EQ(
+      streaming_stats.query_stats().fields().at("rows_scanned").string_value(),
+      "3");
+  EXPECT_EQ(streaming_stats.query_plan().plan_nodes_size(), 2);
+}
+
 TEST_F(QueryApiTest, RejectsPlanMode) {
   spanner_api::ExecuteSqlRequest request = PARSE_TEXT_PROTO(
       R"(
@@ -330,6 +393,55 @@ TEST_F(QueryApiTest, RejectsPlanMode) {
   }
 }
 
+// Runs queries against a server which serves through the gRPC callback API.
+class CallbackApiQueryApiTest : public QueryApiTest {
+ public:
+  CallbackApiQueryApiTest()
+      : QueryApiTest(Server::Options{.use_callback_api = true,
+                                     .num_worker_threads = 2}) {}
+};
+
+TEST_F(CallbackApiQueryApiTest, ExecuteSql) {
+  spanner_api::ExecuteSqlRequest request = PARSE_TEXT_PROTO(
+      R"(
+        transaction { single_use { read_only { strong: true } } }
+        sql: "SELECT int64_col FROM test_table ORDER BY int64_col"
+      )");
+  request.set_session(test_session_uri_);
+
+  spanner_api::ResultSet response;
+  ZETASQL_ASSERT_OK(ExecuteSql(request, &response));
+  EXPECT_THAT(response, Partially(EqualsProto(
+                            R"(
+                              rows { values { string_value: "1" } }
+                              rows { values { string_value: "2" } }
+                              rows { values { string_value: "3" } }
+                            )")));
+}
+
+TEST_F(CallbackApiQueryApiTest, ExecuteStreamingSql) {
+  spanner_api::ExecuteSqlRequest request = PARSE_TEXT_PROTO(
+      R"(
+        transaction { single_use { read_only { strong: true } } }
+        sql: "SELECT int64_col FROM test_table ORDER BY int64_col"
+      )");
+  request.set_session(test_session_uri_);
+
+  std::vector<spanner_api::PartialResultSet> response;
+  ZETASQL_ASSERT_OK(ExecuteStreamingSql(request, &response));
+  EXPECT_THAT(response, ElementsAre(Partially(EqualsProto(
+                            R"(
+                              values { string_value: "1" }
+                              values { string_value: "2" }
+                              values { string_value: "3" }
+                            )"))));
+
+  // Errors are returned as the status of the stream.
+  request.set_sql("SELECT * FROM missing_table");
+  EXPECT_THAT(ExecuteStreamingSql(request, &response),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
 }  // namespace
 
 }  // namespace frontend
@@ -16,18 +16,41 @@
 
 #include "frontend/converters/reads.h"
 
+#include <algorithm>
+#include <cstdint>
 #include <memory>
+#include <string>
+#include <utility>
+#include <vector>
 
 #include "google/spanner/v1/result_set.pb.h"
 #include "google/spanner/v1/spanner.pb.h"
 #include "google/spanner/v1/transaction.pb.h"
+#include "zetasql/public/type.h"
+#include "zetasql/public/value.h"
+#include "absl/strings/match.h"
+#include "absl/time/time.h"
+#include "backend/access/read.h"
 #include "backend/common/ids.h"
+#include "backend/common/memory_tracker.h"
+#include "backend/datamodel/key.h"
+#include "backend/datamodel/key_encoding.h"
+#include "backend/datamodel/key_range.h"
+#include "backend/datamodel/key_set.h"
+#include "backend/schema/catalog/table.h"
+#include "backend/transaction/resolve.h"
+#include "common/config.h"
 #include "common/errors.h"
 #include "frontend/common/protos.h"
+#include "frontend/converters/resume_token.h"
+#include "frontend/converters/time.h"
 #include "frontend/entities/session.h"
 #include "frontend/entities/transaction.h"
+#include "frontend/proto/resume_token.pb.h"
 #include "frontend/server/handler.h"
 #include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "zetasql/base/ret_check.h"
 #include "zetasql/base/status_macros.h"
 
 namespace google {
@@ -59,6 +82,122 @@ absl::Status ValidateTransactionSelectorForRead(
   return absl::OkStatus();
 }
 
+// Returns true if the selector runs each request in a transaction of its own,
+// whose read timestamp a resumed request has to reuse.
+bool IsSingleUse(const spanner_api::TransactionSelector& selector) {
+  return selector.selector_case() != spanner_api::TransactionSelector::kBegin &&
+         selector.selector_case() != spanner_api::TransactionSelector::kId;
+}
+
+// Columns of a read which make up the primary key of the table (or index) it
+// reads, in key order.
+struct ReadKeyColumns {
+  std::vector<int> indexes;
+  std::vector<const zetasql::Type*> types;
+  std::vector<bool> is_descending;
+};
+
+// Appends the key columns of 'table' which 'read_arg' does not read to its
+// columns, so that the key of every row read can be recovered.
+ReadKeyColumns AddKeyColumnsToRead(const backend::Table* table,
+                                   backend::ReadArg* read_arg) {
+  ReadKeyColumns key_columns;
+  for (const backend::KeyColumn* key_column : table->primary_key()) {
+    const std::string& name = key_column->column()->Name();
+    // Column names are case-insensitive in Cloud Spanner.
+    auto itr = std::find_if(read_arg->columns.begin(), read_arg->columns.end(),
+                            [&](const std::string& column_name) {
+                              return absl::EqualsIgnoreCase(column_name, name);
+                            });
+    key_columns.indexes.push_back(itr - read_arg->columns.begin());
+    if (itr == read_arg->columns.end()) {
+      read_arg->columns.push_back(name);
+    }
+    key_columns.types.push_back(key_column->column()->GetType());
+    key_columns.is_descending.push_back(key_column->is_descending());
+  }
+  return key_columns;
+}
+
+// Restricts 'read_arg', which reads the given canonical key ranges, to the rows
+// after 'last_key'.
+void ResumeReadAfterKey(const std::vector<backend::KeyRange>& key_ranges,
+                        const backend::Key& last_key,
+                        backend::ReadArg* read_arg) {
+  std::vector<backend::KeyRange> remaining_ranges;
+  backend::IntersectDisjointKeyRanges(
+      key_ranges,
+      {backend::KeyRange::ClosedOpen(last_key.ToPrefixLimit(),
+                                     backend::Key::Infinity())},
+      &remaining_ranges);
+  read_arg->key_set = backend::KeySet();
+  for (const backend::KeyRange& key_range : remaining_ranges) {
+    read_arg->key_set.AddRange(key_range);
+  }
+}
+
+// RowCursor which returns the first num_columns columns of another cursor and
+// keeps the keys of the last two rows, which the remaining columns complete.
+// These are the rows a resume token can end after, as PartialResultSetEncoder
+// asks for a token either before or after adding the current row.
+class KeyedRowCursor : public backend::RowCursor {
+ public:
+  KeyedRowCursor(std::unique_ptr<backend::RowCursor> cursor, int num_columns,
+                 ReadKeyColumns key_columns)
+      : cursor_(std::move(cursor)),
+        num_columns_(num_columns),
+        key_columns_(std::move(key_columns)) {}
+
+  bool Next() override {
+    if (!cursor_->Next()) {
+      return false;
+    }
+    previous_key_ = std::move(current_key_);
+    current_key_ = backend::Key();
+    for (int i = 0; i < key_columns_.indexes.size(); ++i) {
+      current_key_.AddColumn(cursor_->ColumnValue(key_columns_.indexes[i]),
+                             key_columns_.is_descending[i]);
+    }
+    ++num_rows_;
+    return true;
+  }
+
+  absl::Status Status() const override { return cursor_->Status(); }
+
+  int NumColumns() const override { return num_columns_; }
+
+  const std::string ColumnName(int i) const override {
+    return cursor_->ColumnName(i);
+  }
+
+  const zetasql::Value ColumnValue(int i) const override {
+    return cursor_->ColumnValue(i);
+  }
+
+  const zetasql::Type* ColumnType(int i) const override {
+    return cursor_->ColumnType(i);
+  }
+
+  // Returns the key of the row ending the first num_rows rows, which must be
+  // the current or the previous row.
+  absl::StatusOr<const backend::Key*> KeyOfRow(int64_t num_rows) const {
+    ZETASQL_RET_CHECK_GT(num_rows, 0);
+    if (num_rows == num_rows_) {
+      return &current_key_;
+    }
+    ZETASQL_RET_CHECK_EQ(num_rows, num_rows_ - 1);
+    return &previous_key_;
+  }
+
+ private:
+  std::unique_ptr<backend::RowCursor> cursor_;
+  const int num_columns_;
+  const ReadKeyColumns key_columns_;
+  int64_t num_rows_ = 0;
+  backend::Key current_key_;
+  backend::Key previous_key_;
+};
+
 }  //  namespace
 
 // Reads rows from the database, returning all results in a single reply.
@@ -102,17 +241,21 @@ absl::Status Read(RequestContext* ctx, const spanner_api::ReadRequest* request,
                        txn->ToProto());
     }
 
-    // Convert read results to proto.
-    return RowCursorToResultSetProto(cursor.get(), request->limit(), response);
+    // Convert read results to proto, within the memory limit of the request.
+    backend::MemoryTracker memory_tracker(config::max_result_set_bytes());
+    return RowCursorToResultSetProto(cursor.get(), request->limit(), response,
+                                     &memory_tracker);
   });
 }
 REGISTER_GRPC_HANDLER(Spanner, Read);
 
 // Reads rows from the database, returning all results as a stream.
 //
-// StreamingReads do not support resume_tokens in the emulator. This
-// implementation does not limit the size of the response and therefore,
-// chunked_value will always be false.
+// Responses which end at a row boundary carry a resume token recording the key
+// of the last row returned so far, and either the read timestamp of a
+// single-use transaction or the ID of any other transaction. A request resumed
+// with such a token reads the rows after that key at the same timestamp or in
+// the same transaction, so rows written in the meantime do not shift it.
 absl::Status StreamingRead(
     RequestContext* ctx, const spanner_api::ReadRequest* request,
     ServerStream<spanner_api::PartialResultSet>* stream) {
@@ -120,10 +263,35 @@ absl::Status StreamingRead(
   ZETASQL_ASSIGN_OR_RETURN(std::shared_ptr<Session> session,
                    GetSession(ctx, request->session()));
 
-  // Get underlying transaction.
+  // Validate the resume token against the request before doing any work.
+  ResumeToken resume_token;
+  resume_token.set_request_fingerprint(ReadRequestFingerprint(*request));
+  resume_token.set_row_count(0);
+  if (!request->resume_token().empty()) {
+    ZETASQL_ASSIGN_OR_RETURN(ResumeToken request_resume_token,
+                     ResumeTokenFromString(request->resume_token()));
+    if (request_resume_token.request_fingerprint() !=
+        resume_token.request_fingerprint()) {
+      return error::ResumeTokenForDifferentRequest();
+    }
+    resume_token = std::move(request_resume_token);
+  }
+
+  // Get underlying transaction. A resumed single-use transaction reads at the
+  // timestamp of the original one.
   ZETASQL_RETURN_IF_ERROR(ValidateTransactionSelectorForRead(request->transaction()));
+  const bool single_use = IsSingleUse(request->transaction());
+  spanner_api::TransactionSelector selector = request->transaction();
+  if (single_use && resume_token.has_read_timestamp_micros()) {
+    ZETASQL_ASSIGN_OR_RETURN(
+        *selector.mutable_single_use()
+             ->mutable_read_only()
+             ->mutable_read_timestamp(),
+        TimestampToProto(
+            absl::FromUnixMicros(resume_token.read_timestamp_micros())));
+  }
   ZETASQL_ASSIGN_OR_RETURN(std::shared_ptr<Transaction> txn,
-                   session->FindOrInitTransaction(request->transaction()));
+                   session->FindOrInitTransaction(selector));
 
   // Wrap all operations on this transaction so they are atomic.
   return txn->GuardedCall(Transaction::OpType::kRead, [&]() -> absl::Status {
@@ -138,33 +306,100 @@ absl::Status StreamingRead(
       ZETASQL_ASSIGN_OR_RETURN(absl::Time read_timestamp, txn->GetReadTimestamp());
       ZETASQL_RETURN_IF_ERROR(ValidateReadTimestampNotTooFarInFuture(
           read_timestamp, ctx->env()->clock()->Now()));
+      if (single_use) {
+        resume_token.set_read_timestamp_micros(
+            absl::ToUnixMicros(read_timestamp));
+      }
     }
 
-    // Parse read request.
+    // A read in a transaction other than a single-use one can only be resumed
+    // in that transaction, which the resumed request may select by ID even if
+    // the original one began it.
+    if (!request->resume_token().empty()) {
+      const bool same_transaction =
+          single_use ? !resume_token.has_transaction_id()
+                     : resume_token.has_transaction_id() &&
+                           resume_token.transaction_id() == txn->id();
+      if (!same_transaction) {
+        return error::ResumeTokenForDifferentRequest();
+      }
+    }
+    if (!single_use) {
+      resume_token.set_transaction_id(txn->id());
+    }
+
+    // Parse read request. The primary key columns are read as well, so that
+    // resume tokens can record the key of the last row returned.
     backend::ReadArg read_arg;
     ZETASQL_RETURN_IF_ERROR(ReadArgFromProto(*txn->schema(), *request, &read_arg));
+    ZETASQL_ASSIGN_OR_RETURN(backend::ResolvedReadArg resolved_read_arg,
+                     backend::ResolveReadArg(read_arg, txn->schema()));
+    const int num_columns = read_arg.columns.size();
+    ReadKeyColumns key_columns =
+        AddKeyColumnsToRead(resolved_read_arg.table, &read_arg);
+
+    // Skip the rows up to the last one returned before the resume token.
+    if (resume_token.has_last_key()) {
+      absl::StatusOr<backend::Key> last_key =
+          backend::DecodeKey(resume_token.last_key(), key_columns.types,
+                             key_columns.is_descending);
+      if (!last_key.ok()) {
+        return error::InvalidResumeToken();
+      }
+      ResumeReadAfterKey(resolved_read_arg.key_ranges, *last_key, &read_arg);
+    }
 
     // Execute read on backend.
-    std::unique_ptr<backend::RowCursor> cursor;
-    ZETASQL_RETURN_IF_ERROR(txn->Read(read_arg, &cursor));
+    std::unique_ptr<backend::RowCursor> backend_cursor;
+    ZETASQL_RETURN_IF_ERROR(txn->Read(read_arg, &backend_cursor));
+    KeyedRowCursor cursor(std::move(backend_cursor), num_columns,
+                          std::move(key_columns));
 
-    // Convert read results to protos.
-    ZETASQL_ASSIGN_OR_RETURN(
-        std::vector<spanner_api::PartialResultSet> responses,
-        RowCursorToPartialResultSetProtos(cursor.get(), request->limit()));
+    // Populates transaction metadata in the first response, which is the one
+    // carrying the result set metadata, and sends the response.
+    auto send = [&](spanner_api::PartialResultSet* response) -> absl::Status {
+      if (response->has_metadata() &&
+          ShouldReturnTransaction(request->transaction())) {
+        ZETASQL_ASSIGN_OR_RETURN(*response->mutable_metadata()->mutable_transaction(),
+                         txn->ToProto());
+      }
+      stream->Send(*response);
+      return absl::OkStatus();
+    };
 
-    // Populate transaction metadata.
-    if (ShouldReturnTransaction(request->transaction())) {
-      ZETASQL_ASSIGN_OR_RETURN(
-          *responses.front().mutable_metadata()->mutable_transaction(),
-          txn->ToProto());
+    // Rows returned before the resume token count towards the limit. If those
+    // already reached it, only the result set metadata is returned.
+    const int64_t resumed_row_count = resume_token.row_count();
+    int64_t limit = request->limit();
+    if (limit > 0 && resumed_row_count >= limit) {
+      spanner_api::PartialResultSet last_response;
+      ZETASQL_RETURN_IF_ERROR(
+          ResultSetMetadataToProto(&cursor, last_response.mutable_metadata()));
+      return send(&last_response);
     }
-
-    // Send results back to client.
-    for (const auto& response : responses) {
-      stream->Send(response);
+    if (limit > 0) {
+      limit -= resumed_row_count;
     }
-    return absl::OkStatus();
+
+    // Convert read results to protos and send them back to the client as they
+    // are read. A token sent before any row keeps the key it was resumed from.
+    auto resume_token_fn =
+        [&](int64_t num_rows) -> absl::StatusOr<std::string> {
+      ResumeToken next_resume_token = resume_token;
+      next_resume_token.set_row_count(resumed_row_count + num_rows);
+      if (num_rows > 0) {
+        ZETASQL_ASSIGN_OR_RETURN(const backend::Key* last_key,
+                         cursor.KeyOfRow(num_rows));
+        ZETASQL_ASSIGN_OR_RETURN(*next_resume_token.mutable_last_key(),
+                         backend::EncodeKey(*last_key));
+      }
+      return ResumeTokenToString(next_resume_token);
+    };
+    ZETASQL_ASSIGN_OR_RETURN(spanner_api::PartialResultSet last_response,
+                     StreamRowCursorToPartialResultSetProtos(
+                         &cursor, limit, send, /*num_rows=*/nullptr,
+                         resume_token_fn));
+    return send(&last_response);
   });
 }
 REGISTER_GRPC_HANDLER(Spanner, StreamingRead);
@@ -15,6 +15,7 @@
 //
 
 
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -27,10 +28,21 @@
 #include "zetasql/base/testing/status_matchers.h"
 #include "tests/common/proto_matchers.h"
 #include "absl/status/status.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/substitute.h"
+#include "backend/datamodel/key.h"
+#include "backend/datamodel/key_encoding.h"
+#include "zetasql/public/value.h"
+#include "common/limits.h"
 #include "frontend/common/protos.h"
+#include "frontend/converters/resume_token.h"
+#include "frontend/proto/resume_token.pb.h"
+#include "frontend/server/server.h"
 #include "tests/common/proto_matchers.h"
 #include "tests/common/test_env.h"
+#include "grpcpp/client_context.h"
 #include "grpcpp/server_context.h"
+#include "grpcpp/support/sync_stream.h"
 #include "absl/status/status.h"
 #include "zetasql/base/status_macros.h"
 
@@ -40,12 +52,19 @@ namespace emulator {
 namespace frontend {
 namespace {
 
+using ::zetasql::values::Int64;
 using ::zetasql_base::testing::StatusIs;
 
 namespace spanner_api = ::google::spanner::v1;
 
 class ReadApiTest : public test::ServerTest {
+ public:
+  ReadApiTest() = default;
+
  protected:
+  explicit ReadApiTest(const Server::Options& options)
+      : test::ServerTest(options) {}
+
   void SetUp() override {
     ZETASQL_ASSERT_OK(CreateTestInstance());
     ZETASQL_ASSERT_OK(CreateTestDatabase());
@@ -82,6 +101,40 @@ class ReadApiTest : public test::ServerTest {
     return Commit(commit_request, &commit_response);
   }
 
+  absl::Status InsertRow(int64_t key) {
+    spanner_api::CommitRequest commit_request =
+        PARSE_TEXT_PROTO(absl::Substitute(R"(
+      single_use_transaction { read_write {} }
+      mutations {
+        insert {
+          table: "test_table"
+          columns: "int64_col"
+          columns: "string_col"
+          values {
+            values { string_value: "$0" }
+            values { string_value: "row_$0" }
+          }
+        }
+      }
+    )", key));
+    *commit_request.mutable_session() = test_session_uri_;
+
+    spanner_api::CommitResponse commit_response;
+    return Commit(commit_request, &commit_response);
+  }
+
+  // Returns a resume token for 'read_request' after the row with the given key.
+  absl::StatusOr<std::string> ResumeTokenAfterRow(
+      const spanner_api::ReadRequest& read_request, int64_t row_count,
+      int64_t key) {
+    ResumeToken resume_token;
+    resume_token.set_request_fingerprint(ReadRequestFingerprint(read_request));
+    resume_token.set_row_count(row_count);
+    ZETASQL_ASSIGN_OR_RETURN(*resume_token.mutable_last_key(),
+                     backend::EncodeKey(backend::Key({Int64(key)})));
+    return ResumeTokenToString(resume_token);
+  }
+
   std::string test_session_uri_;
 };
 
@@ -154,11 +207,11 @@ TEST_F(ReadApiTest, CanReadUsingAnAlreadyStartedTransaction) {
                                       values { string_value: "row_2" }
                                     })"));
 
-  // StreamingRead
+  // StreamingRead. The response also carries a resume token.
   std::vector<spanner_api::PartialResultSet> streaming_read_response;
   ZETASQL_EXPECT_OK(StreamingRead(read_request, &streaming_read_response));
   EXPECT_THAT(streaming_read_response,
-              testing::ElementsAre(test::EqualsProto(
+              testing::ElementsAre(test::proto::Partially(test::EqualsProto(
                   R"(metadata {
                        row_type {
                          fields {
@@ -176,7 +229,7 @@ TEST_F(ReadApiTest, CanReadUsingAnAlreadyStartedTransaction) {
                      values { string_value: "2" }
                      values { string_value: "row_2" }
                      chunked_value: false
-                  )")));
+                  )"))));
 }
 
 TEST_F(ReadApiTest, CanPerformStrongReadUsingSingleUseTransaction) {
@@ -346,6 +399,275 @@ TEST_F(ReadApiTest, CannotReadUsingInvalidTransaction) {
               StatusIs(absl::StatusCode::kNotFound));
 }
 
+TEST_F(ReadApiTest, StreamingReadResumesAfterResumeToken) {
+  spanner_api::ReadRequest read_request = PARSE_TEXT_PROTO(R"(
+    table: "test_table"
+    columns: "int64_col"
+    key_set { all: true }
+  )");
+  read_request.set_session(test_session_uri_);
+
+  // A resume token after the first row returns the remaining rows.
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      *read_request.mutable_resume_token(),
+      ResumeTokenAfterRow(read_request, /*row_count=*/1, /*key=*/1));
+
+  std::vector<spanner_api::PartialResultSet> response;
+  ZETASQL_ASSERT_OK(StreamingRead(read_request, &response));
+  ASSERT_EQ(response.size(), 1);
+  EXPECT_THAT(response[0], test::proto::Partially(test::EqualsProto(R"(
+                values { string_value: "2" }
+                values { string_value: "3" }
+              )")));
+  EXPECT_EQ(response[0].values_size(), 2);
+
+  // The last response carries a resume token after all rows.
+  ZETASQL_ASSERT_OK_AND_ASSIGN(ResumeToken resume_token,
+                       ResumeTokenFromString(response[0].resume_token()));
+  EXPECT_EQ(resume_token.row_count(), 3);
+  EXPECT_THAT(backend::EncodeKey(backend::Key({Int64(3)})),
+              zetasql_base::testing::IsOkAndHolds(resume_token.last_key()));
+}
+
+TEST_F(ReadApiTest, StreamingReadResumeIsNotShiftedByEarlierRows) {
+  spanner_api::ReadRequest read_request = PARSE_TEXT_PROTO(R"(
+    table: "test_table"
+    columns: "string_col"
+    key_set { all: true }
+  )");
+  read_request.set_session(test_session_uri_);
+
+  // A row inserted before the resume point after the token was returned does
+  // not cause rows to be returned twice. The token is taken from a read which
+  // does not read the key column.
+  ZETASQL_ASSERT_OK_AND_ASSIGN(
+      *read_request.mutable_resume_token(),
+      ResumeTokenAfterRow(read_request, /*row_count=*/1, /*key=*/1));
+  ZETASQL_ASSERT_OK(InsertRow(0));
+
+  std::vector<spanner_api::PartialResultSet> response;
+  ZETASQL_ASSERT_OK(StreamingRead(read_request, &response));
+  ASSERT_EQ(response.size(), 1);
+  EXPECT_THAT(response[0], test::proto::Partially(test::EqualsProto(R"(
+                metadata {
+                  row_type {
+                    fields {
+                      name: "string_col"
+                      type { code: STRING }
+                    }
+                  }
+                }
+                values { string_value: "row_2" }
+                values { string_value: "row_3" }
+              )")));
+  EXPECT_EQ(response[0].values_size(), 2);
+}
+
+TEST_F(ReadApiTest, StreamingReadResumesSingleUseReadAtItsTimestamp) {
+  spanner_api::ReadRequest read_request = PARSE_TEXT_PROTO(R"(
+    transaction { single_use { read_only { strong: true } } }
+    table: "test_table"
+    columns: "int64_col"
+    key_set { all: true }
+  )");
+  read_request.set_session(test_session_uri_);
+
+  std::vector<spanner_api::PartialResultSet> response;
+  ZETASQL_ASSERT_OK(StreamingRead(read_request, &response));
+  ASSERT_EQ(response.size(), 1);
+  ZETASQL_ASSERT_OK_AND_ASSIGN(ResumeToken resume_token,
+                       ResumeTokenFromString(response[0].resume_token()));
+  EXPECT_TRUE(resume_token.has_read_timestamp_micros());
+
+  // A row committed after the original read is not visible to the resumed one.
+  ZETASQL_ASSERT_OK(InsertRow(4));
+  *read_request.mutable_resume_token() = response[0].resume_token();
+  response.clear();
+  ZETASQL_ASSERT_OK(StreamingRead(read_request, &response));
+  ASSERT_EQ(response.size(), 1);
+  EXPECT_EQ(response[0].values_size(), 0);
+}
+
+TEST_F(ReadApiTest, StreamingReadResumesInTransactionBegunInline) {
+  spanner_api::ReadRequest read_request = PARSE_TEXT_PROTO(R"(
+    transaction { begin { read_only { strong: true } } }
+    table: "test_table"
+    columns: "int64_col"
+    key_set { all: true }
+  )");
+  read_request.set_session(test_session_uri_);
+
+  std::vector<spanner_api::PartialResultSet> response;
+  ZETASQL_ASSERT_OK(StreamingRead(read_request, &response));
+  ASSERT_EQ(response.size(), 1);
+  const std::string transaction_id =
+      response[0].metadata().transaction().id();
+  ASSERT_FALSE(transaction_id.empty());
+
+  // Resume after the first row, selecting the transaction by its ID.
+  ZETASQL_ASSERT_OK_AND_ASSIGN(ResumeToken resume_token,
+                       ResumeTokenFromString(response[0].resume_token()));
+  resume_token.set_row_count(1);
+  ZETASQL_ASSERT_OK_AND_ASSIGN(*resume_token.mutable_last_key(),
+                       backend::EncodeKey(backend::Key({Int64(1)})));
+  ZETASQL_ASSERT_OK_AND_ASSIGN(*read_request.mutable_resume_token(),
+                       ResumeTokenToString(resume_token));
+  read_request.mutable_transaction()->set_id(transaction_id);
+  response.clear();
+  ZETASQL_ASSERT_OK(StreamingRead(read_request, &response));
+  ASSERT_EQ(response.size(), 1);
+  EXPECT_THAT(response[0], test::proto::Partially(test::EqualsProto(R"(
+                values { string_value: "2" }
+                values { string_value: "3" }
+              )")));
+  EXPECT_EQ(response[0].values_size(), 2);
+
+  // The token cannot resume the read in another transaction.
+  spanner_api::BeginTransactionRequest txn_request = PARSE_TEXT_PROTO(R"(
+    options { read_only {} }
+  )");
+  txn_request.set_session(test_session_uri_);
+  spanner_api::Transaction txn_response;
+  ZETASQL_ASSERT_OK(BeginTransaction(txn_request, &txn_response));
+  read_request.mutable_transaction()->set_id(txn_response.id());
+  EXPECT_THAT(StreamingRead(read_request, &response),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST_F(ReadApiTest, StreamingReadRejectsResumeTokenOfOtherRequest) {
+  spanner_api::ReadRequest read_request = PARSE_TEXT_PROTO(R"(
+    table: "test_table"
+    columns: "int64_col"
+    key_set { all: true }
+  )");
+  read_request.set_session(test_session_uri_);
+
+  ResumeToken resume_token;
+  resume_token.set_request_fingerprint(ReadRequestFingerprint(read_request));
+  resume_token.set_row_count(1);
+  read_request.add_columns("string_col");
+  ZETASQL_ASSERT_OK_AND_ASSIGN(*read_request.mutable_resume_token(),
+                       ResumeTokenToString(resume_token));
+
+  std::vector<spanner_api::PartialResultSet> response;
+  EXPECT_THAT(StreamingRead(read_request, &response),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+
+  read_request.set_resume_token("not a token!");
+  EXPECT_THAT(StreamingRead(read_request, &response),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+// Runs reads against a server which serves through the gRPC callback API.
+class CallbackApiReadApiTest : public ReadApiTest {
+ public:
+  static constexpr int kNumWorkerThreads = 2;
+
+  CallbackApiReadApiTest()
+      : ReadApiTest(Server::Options{.use_callback_api = true,
+                                    .num_worker_threads = kNumWorkerThreads}) {}
+
+ protected:
+  // Inserts a row which takes a full streaming chunk to return.
+  absl::Status InsertLargeRow(int64_t key) {
+    spanner_api::CommitRequest commit_request = PARSE_TEXT_PROTO(R"(
+      single_use_transaction { read_write {} }
+      mutations {
+        insert {
+          table: "test_table"
+          columns: "int64_col"
+          columns: "string_col"
+        }
+      }
+    )");
+    *commit_request.mutable_session() = test_session_uri_;
+    auto* values =
+        commit_request.mutable_mutations(0)->mutable_insert()->add_values();
+    values->add_values()->set_string_value(absl::StrCat(key));
+    values->add_values()->set_string_value(
+        std::string(limits::kMaxStreamingChunkSize, 'x'));
+
+    spanner_api::CommitResponse commit_response;
+    return Commit(commit_request, &commit_response);
+  }
+};
+
+TEST_F(CallbackApiReadApiTest, StalledStreamsDoNotHoldWorkers) {
+  // Each stream returns far more data than gRPC flow control lets the server
+  // send before the client reads it.
+  constexpr int kNumLargeRows = 64;
+  for (int i = 0; i < kNumLargeRows; ++i) {
+    ZETASQL_ASSERT_OK(InsertLargeRow(100 + i));
+  }
+
+  spanner_api::ReadRequest read_request = PARSE_TEXT_PROTO(R"(
+    transaction { single_use { read_only { strong: true } } }
+    table: "test_table"
+    columns: "int64_col"
+    columns: "string_col"
+    key_set { all: true }
+  )");
+  read_request.set_session(test_session_uri_);
+
+  // Start more streams than there are workers, and stop reading from them
+  // after their first response. Each of them gets to send one regardless.
+  std::vector<std::unique_ptr<grpc::ClientContext>> contexts;
+  std::vector<
+      std::unique_ptr<grpc::ClientReader<spanner_api::PartialResultSet>>>
+      readers;
+  for (int i = 0; i < kNumWorkerThreads + 1; ++i) {
+    contexts.push_back(std::make_unique<grpc::ClientContext>());
+    readers.push_back(test_env()->spanner_client()->StreamingRead(
+        contexts.back().get(), read_request));
+  }
+  for (int i = 0; i < readers.size(); ++i) {
+    spanner_api::PartialResultSet response;
+    ASSERT_TRUE(readers[i]->Read(&response));
+  }
+
+  // A read-write transaction still reads and commits while the streams are
+  // stalled.
+  spanner_api::BeginTransactionRequest txn_request = PARSE_TEXT_PROTO(R"(
+    options { read_write {} }
+  )");
+  txn_request.set_session(test_session_uri_);
+  spanner_api::Transaction txn_response;
+  ZETASQL_ASSERT_OK(BeginTransaction(txn_request, &txn_response));
+
+  spanner_api::ReadRequest txn_read_request = PARSE_TEXT_PROTO(R"(
+    table: "test_table"
+    columns: "string_col"
+    key_set { keys { values { string_value: "1" } } }
+  )");
+  txn_read_request.set_session(test_session_uri_);
+  txn_read_request.mutable_transaction()->set_id(txn_response.id());
+  spanner_api::ResultSet txn_read_response;
+  ZETASQL_ASSERT_OK(Read(txn_read_request, &txn_read_response));
+
+  spanner_api::CommitRequest commit_request = PARSE_TEXT_PROTO(R"(
+    mutations {
+      insert {
+        table: "test_table"
+        columns: "int64_col"
+        columns: "string_col"
+        values {
+          values { string_value: "4" }
+          values { string_value: "row_4" }
+        }
+      }
+    }
+  )");
+  commit_request.set_session(test_session_uri_);
+  commit_request.set_transaction_id(txn_response.id());
+  spanner_api::CommitResponse commit_response;
+  ZETASQL_EXPECT_OK(Commit(commit_request, &commit_response));
+
+  for (int i = 0; i < readers.size(); ++i) {
+    contexts[i]->TryCancel();
+    readers[i]->Finish();
+  }
+}
+
 }  // namespace
 
 }  // namespace frontend
@@ -20,6 +20,7 @@
 #include <memory>
 
 #include "common/clock.h"
+#include "common/config.h"
 #include "frontend/collections/database_manager.h"
 #include "frontend/collections/instance_manager.h"
 #include "frontend/collections/operation_manager.h"
@@ -38,7 +39,8 @@ class ServerEnv {
         database_manager_(new DatabaseManager(clock_.get())),
         instance_manager_(new InstanceManager()),
         operation_manager_(new OperationManager()),
-        session_manager_(new SessionManager(clock_.get())) {}
+        session_manager_(new SessionManager(clock_.get(),
+                                            config::session_idle_timeout())) {}
 
   Clock* clock() { return clock_.get(); }
   DatabaseManager* database_manager() { return database_manager_.get(); }
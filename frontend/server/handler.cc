@@ -16,10 +16,13 @@
 
 #include "frontend/server/handler.h"
 
+#include <algorithm>
 #include <map>
 #include <memory>
 #include <string>
+#include <tuple>
 #include <utility>
+#include <vector>
 
 #include "absl/container/flat_hash_map.h"
 #include "absl/synchronization/mutex.h"
@@ -55,6 +58,17 @@ class HandlerRegistry {
     return itr->second.get();
   }
 
+  // Retrieves all handlers in the registry.
+  std::vector<GRPCHandlerBase*> GetHandlers() {
+    absl::MutexLock lock(&mu_);
+    std::vector<GRPCHandlerBase*> handlers;
+    handlers.reserve(handler_map_.size());
+    for (const auto& [name, handler] : handler_map_) {
+      handlers.push_back(handler.get());
+    }
+    return handlers;
+  }
+
  private:
   // Mutex to guard state below.
   absl::Mutex mu_;
@@ -81,6 +95,16 @@ GRPCHandlerBase* GetHandler(const std::string& service_name,
   return GetHandlerRegistry()->GetHandler(service_name, method_name);
 }
 
+std::vector<GRPCHandlerBase*> GetHandlers() {
+  std::vector<GRPCHandlerBase*> handlers = GetHandlerRegistry()->GetHandlers();
+  std::sort(handlers.begin(), handlers.end(),
+            [](GRPCHandlerBase* a, GRPCHandlerBase* b) {
+              return std::tie(a->service_name(), a->method_name()) <
+                     std::tie(b->service_name(), b->method_name());
+            });
+  return handlers;
+}
+
 }  // namespace frontend
 }  // namespace emulator
 }  // namespace spanner
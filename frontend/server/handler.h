@@ -17,9 +17,14 @@
 #ifndef THIRD_PARTY_CLOUD_SPANNER_EMULATOR_FRONTEND_SERVER_HANDLER_H_
 #define THIRD_PARTY_CLOUD_SPANNER_EMULATOR_FRONTEND_SERVER_HANDLER_H_
 
+#include <string>
+#include <vector>
+
 #include "zetasql/base/logging.h"
 #include "absl/status/status.h"
+#include "absl/time/clock.h"
 #include "common/config.h"
+#include "frontend/server/latency_histogram.h"
 #include "frontend/server/request_context.h"
 #include "grpcpp/grpcpp.h"
 #include "grpcpp/support/sync_stream.h"
@@ -63,9 +68,17 @@ class GRPCHandlerBase {
   const std::string& service_name() { return service_name_; }
   const std::string& method_name() { return method_name_; }
 
+  // Latencies of all invocations of the handler, including failed ones. Logged
+  // with each response when requests are logged.
+  const LatencyHistogram& latency() const { return latency_; }
+
+ protected:
+  void RecordLatency(absl::Duration latency) { latency_.Record(latency); }
+
  private:
   const std::string service_name_;
   const std::string method_name_;
+  LatencyHistogram latency_;
 };
 
 // UnaryGRPCHandler handles unary gRPC methods.
@@ -88,12 +101,15 @@ class UnaryGRPCHandler final : public GRPCHandlerBase {
       ZETASQL_LOG(INFO) << "Request[" << service_name() << "." << method_name() << "]\n"
                 << request->DebugString();
     }
+    absl::Time start = absl::Now();
     absl::Status status = fn_(ctx, request, response);
+    RecordLatency(absl::Now() - start);
     if (config::should_log_requests()) {
       ZETASQL_LOG(INFO) << "Response[" << service_name() << "." << method_name()
                 << "]\n"
                 << response->DebugString() << "\n"
-                << (status.ok() ? "OK" : "Error: " + status.ToString());
+                << (status.ok() ? "OK" : "Error: " + status.ToString()) << "\n"
+                << "Latency: " << latency().ToString();
     }
     return status;
   }
@@ -123,11 +139,14 @@ class ServerStreamingGRPCHandler final : public GRPCHandlerBase {
                 << request->DebugString();
     }
     ServerStream<ResponseT> stream(writer);
+    absl::Time start = absl::Now();
     absl::Status status = fn_(ctx, request, &stream);
+    RecordLatency(absl::Now() - start);
     if (config::should_log_requests()) {
       ZETASQL_LOG(INFO) << "Response[" << service_name() << "." << method_name()
                 << "]\n"
-                << (status.ok() ? "OK" : "Error: " + status.ToString());
+                << (status.ok() ? "OK" : "Error: " + status.ToString()) << "\n"
+                << "Latency: " << latency().ToString();
     }
 
     return status;
@@ -178,6 +197,21 @@ class HandlerRegisterer {
 GRPCHandlerBase* GetHandler(const std::string& service_name,
                             const std::string& method_name);
 
+// Returns the handler for a method within a service by name, if it is a
+// 'HandlerT' (e.g. UnaryGRPCHandler<RequestT, ResponseT>), or nullptr.
+//
+// Handlers are registered at static initialization time and never removed, so
+// callers may resolve a handler once and keep the pointer instead of looking it
+// up on every call.
+template <typename HandlerT>
+HandlerT* GetTypedHandler(const std::string& service_name,
+                          const std::string& method_name) {
+  return dynamic_cast<HandlerT*>(GetHandler(service_name, method_name));
+}
+
+// Returns all registered handlers, ordered by service and method name.
+std::vector<GRPCHandlerBase*> GetHandlers();
+
 }  // namespace frontend
 }  // namespace emulator
 }  // namespace spanner
@@ -16,6 +16,9 @@
 
 #include "frontend/server/handler.h"
 
+#include <string>
+#include <vector>
+
 #include "google/spanner/v1/result_set.pb.h"
 #include "google/spanner/v1/spanner.pb.h"
 #include "gmock/gmock.h"
@@ -108,6 +111,40 @@ TEST(HandlerRegisterer, ReturnsNullptrForUnrecognizedHandlers) {
   ASSERT_EQ(nullptr, GetHandler("UnknownServer", "UnknownMethod"));
 }
 
+TEST(HandlerRegisterer, ReturnsTypedHandlersOnlyForMatchingTypes) {
+  EXPECT_NE(nullptr,
+            (GetTypedHandler<
+                UnaryGRPCHandler<google::spanner::v1::CreateSessionRequest,
+                                 google::spanner::v1::Session>>(
+                "Spanner", "CreateSession")));
+  EXPECT_EQ(nullptr,
+            (GetTypedHandler<
+                UnaryGRPCHandler<google::spanner::v1::GetSessionRequest,
+                                 google::spanner::v1::Session>>(
+                "Spanner", "CreateSession")));
+}
+
+TEST(HandlerRegisterer, ListsHandlersByServiceAndMethodName) {
+  std::vector<std::string> names;
+  for (GRPCHandlerBase* handler : GetHandlers()) {
+    names.push_back(handler->service_name() + "." + handler->method_name());
+  }
+  EXPECT_THAT(names, testing::ElementsAre("Spanner.CreateSession",
+                                          "Spanner.StreamingRead"));
+}
+
+TEST(GRPCHandler, RecordsLatencyOfEachInvocation) {
+  UnaryGRPCHandler<google::spanner::v1::CreateSessionRequest,
+                   google::spanner::v1::Session>
+      handler("Spanner", "CreateSession", CreateSession);
+  RequestContext ctx(nullptr, nullptr);
+  google::spanner::v1::CreateSessionRequest request;
+  google::spanner::v1::Session response;
+  ZETASQL_EXPECT_OK(handler.Run(&ctx, &request, &response));
+  ZETASQL_EXPECT_OK(handler.Run(&ctx, &request, &response));
+  EXPECT_EQ(2, handler.latency().count());
+}
+
 }  // namespace
 
 }  // namespace frontend
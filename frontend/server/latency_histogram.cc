@@ -0,0 +1,100 @@
+//
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "frontend/server/latency_histogram.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <string>
+
+#include "absl/strings/str_cat.h"
+#include "absl/time/time.h"
+
+namespace google {
+namespace spanner {
+namespace emulator {
+namespace frontend {
+
+int LatencyHistogram::BucketFor(absl::Duration latency) {
+  int64_t micros = absl::ToInt64Microseconds(latency);
+  int bucket = 0;
+  while (micros > 0 && bucket < kNumBuckets - 1) {
+    micros >>= 1;
+    ++bucket;
+  }
+  return bucket;
+}
+
+absl::Duration LatencyHistogram::BucketUpperBound(int bucket) {
+  return absl::Microseconds(int64_t{1} << bucket);
+}
+
+void LatencyHistogram::Record(absl::Duration latency) {
+  buckets_[BucketFor(latency)].fetch_add(1, std::memory_order_relaxed);
+  sum_micros_.fetch_add(absl::ToInt64Microseconds(latency),
+                        std::memory_order_relaxed);
+}
+
+int64_t LatencyHistogram::count() const {
+  int64_t count = 0;
+  for (const auto& bucket : buckets_) {
+    count += bucket.load(std::memory_order_relaxed);
+  }
+  return count;
+}
+
+int64_t LatencyHistogram::bucket_count(int bucket) const {
+  return buckets_[bucket].load(std::memory_order_relaxed);
+}
+
+absl::Duration LatencyHistogram::sum() const {
+  return absl::Microseconds(sum_micros_.load(std::memory_order_relaxed));
+}
+
+absl::Duration LatencyHistogram::Percentile(double percentile) const {
+  int64_t count = this->count();
+  if (count == 0) {
+    return absl::ZeroDuration();
+  }
+  // The rank of the latency at 'percentile', counting from 1.
+  int64_t rank = std::max<int64_t>(
+      1, static_cast<int64_t>(std::ceil(count * percentile / 100)));
+  int64_t seen = 0;
+  for (int bucket = 0; bucket < kNumBuckets; ++bucket) {
+    seen += bucket_count(bucket);
+    if (seen >= rank) {
+      return BucketUpperBound(bucket);
+    }
+  }
+  return BucketUpperBound(kNumBuckets - 1);
+}
+
+std::string LatencyHistogram::ToString() const {
+  int64_t count = this->count();
+  if (count == 0) {
+    return "count=0";
+  }
+  return absl::StrCat("count=", count,
+                      " mean=", absl::FormatDuration(sum() / count),
+                      " p50<=", absl::FormatDuration(Percentile(50)),
+                      " p99<=", absl::FormatDuration(Percentile(99)));
+}
+
+}  // namespace frontend
+}  // namespace emulator
+}  // namespace spanner
+}  // namespace google
@@ -0,0 +1,85 @@
+//
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef THIRD_PARTY_CLOUD_SPANNER_EMULATOR_FRONTEND_SERVER_LATENCY_HISTOGRAM_H_
+#define THIRD_PARTY_CLOUD_SPANNER_EMULATOR_FRONTEND_SERVER_LATENCY_HISTOGRAM_H_
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#include "absl/time/time.h"
+
+namespace google {
+namespace spanner {
+namespace emulator {
+namespace frontend {
+
+// LatencyHistogram counts latencies in buckets whose bounds grow by powers of
+// two, from 1us up to about 35 minutes.
+//
+// Recording is lock-free so that every RPC can record its latency without
+// contending with concurrent RPCs of the same method. Reads are not atomic with
+// respect to concurrent recordings, so counts read while RPCs are in flight may
+// be slightly inconsistent with each other.
+class LatencyHistogram {
+ public:
+  // Bucket 0 counts latencies below 1us, and bucket i > 0 counts latencies in
+  // [2^(i-1)us, 2^i us). The last bucket also counts all longer latencies.
+  static constexpr int kNumBuckets = 32;
+
+  LatencyHistogram() = default;
+  LatencyHistogram(const LatencyHistogram&) = delete;
+  LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+  void Record(absl::Duration latency);
+
+  // Number of recorded latencies.
+  int64_t count() const;
+
+  // Number of recorded latencies in 'bucket'.
+  int64_t bucket_count(int bucket) const;
+
+  // Sum of recorded latencies.
+  absl::Duration sum() const;
+
+  // Returns an upper bound of the latency below which 'percentile' (in
+  // [0, 100]) of the recorded latencies fall, i.e. the upper bound of the
+  // bucket containing that percentile. Returns zero if nothing was recorded.
+  absl::Duration Percentile(double percentile) const;
+
+  // Returns a one-line summary of the histogram, e.g.
+  //   "count=10 mean=1.5ms p50<=2ms p99<=4.096ms".
+  std::string ToString() const;
+
+  // Returns the bucket which counts 'latency'.
+  static int BucketFor(absl::Duration latency);
+
+  // Returns the exclusive upper bound of 'bucket'.
+  static absl::Duration BucketUpperBound(int bucket);
+
+ private:
+  std::array<std::atomic<int64_t>, kNumBuckets> buckets_{};
+  std::atomic<int64_t> sum_micros_{0};
+};
+
+}  // namespace frontend
+}  // namespace emulator
+}  // namespace spanner
+}  // namespace google
+
+#endif  // THIRD_PARTY_CLOUD_SPANNER_EMULATOR_FRONTEND_SERVER_LATENCY_HISTOGRAM_H_
@@ -0,0 +1,70 @@
+//
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "frontend/server/latency_histogram.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/time/time.h"
+
+namespace google {
+namespace spanner {
+namespace emulator {
+namespace frontend {
+
+namespace {
+
+TEST(LatencyHistogramTest, BucketsGrowByPowersOfTwo) {
+  EXPECT_EQ(0, LatencyHistogram::BucketFor(absl::Nanoseconds(500)));
+  EXPECT_EQ(1, LatencyHistogram::BucketFor(absl::Microseconds(1)));
+  EXPECT_EQ(2, LatencyHistogram::BucketFor(absl::Microseconds(2)));
+  EXPECT_EQ(2, LatencyHistogram::BucketFor(absl::Microseconds(3)));
+  EXPECT_EQ(10, LatencyHistogram::BucketFor(absl::Milliseconds(1)));
+  EXPECT_EQ(LatencyHistogram::kNumBuckets - 1,
+            LatencyHistogram::BucketFor(absl::Hours(10)));
+
+  for (int bucket = 0; bucket < LatencyHistogram::kNumBuckets - 1; ++bucket) {
+    EXPECT_EQ(bucket + 1, LatencyHistogram::BucketFor(
+                              LatencyHistogram::BucketUpperBound(bucket)));
+  }
+}
+
+TEST(LatencyHistogramTest, ReportsCountSumAndPercentiles) {
+  LatencyHistogram histogram;
+  EXPECT_EQ(0, histogram.count());
+  EXPECT_EQ(absl::ZeroDuration(), histogram.Percentile(50));
+  EXPECT_EQ("count=0", histogram.ToString());
+
+  for (int i = 0; i < 99; ++i) {
+    histogram.Record(absl::Microseconds(100));
+  }
+  histogram.Record(absl::Milliseconds(10));
+
+  EXPECT_EQ(100, histogram.count());
+  EXPECT_EQ(absl::Microseconds(99 * 100 + 10000), histogram.sum());
+  EXPECT_EQ(absl::Microseconds(128), histogram.Percentile(50));
+  EXPECT_EQ(absl::Microseconds(128), histogram.Percentile(99));
+  EXPECT_EQ(absl::Microseconds(16384), histogram.Percentile(100));
+  EXPECT_EQ("count=100 mean=199us p50<=128us p99<=128us",
+            histogram.ToString());
+}
+
+}  // namespace
+
+}  // namespace frontend
+}  // namespace emulator
+}  // namespace spanner
+}  // namespace google
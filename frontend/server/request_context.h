@@ -27,21 +27,24 @@ namespace emulator {
 namespace frontend {
 
 // RequestContext encapsulates the state passed to a gRPC method handler.
+//
+// The gRPC context is that of either the synchronous or the callback API,
+// depending on how the server serves requests.
 class RequestContext {
  public:
-  RequestContext(ServerEnv* env, grpc::ServerContext* grpc)
+  RequestContext(ServerEnv* env, grpc::ServerContextBase* grpc)
       : env_(env), grpc_(grpc) {}
 
   // Accessors.
   ServerEnv* env() { return env_; }
-  grpc::ServerContext* grpc() { return grpc_; }
+  grpc::ServerContextBase* grpc() { return grpc_; }
 
  private:
   // Server environment shared by all requests.
   ServerEnv* env_;
 
   // gRPC context specific to a single request.
-  grpc::ServerContext* grpc_;
+  grpc::ServerContextBase* grpc_;
 };
 
 // Checks if an instance exists. Returns the Instance entity or an error:
@@ -16,8 +16,12 @@
 
 #include "frontend/server/server.h"
 
+#include <algorithm>
+#include <deque>
 #include <memory>
+#include <optional>
 #include <string>
+#include <thread>  // NOLINT(build/c++11)
 #include <utility>
 
 #include "zetasql/base/logging.h"
@@ -33,13 +37,17 @@
 #include "google/spanner/v1/spanner.grpc.pb.h"
 #include "google/spanner/v1/transaction.pb.h"
 #include "absl/memory/memory.h"
+#include "absl/status/status.h"
+#include "absl/synchronization/mutex.h"
 #include "common/constants.h"
 #include "common/errors.h"
 #include "common/limits.h"
 #include "frontend/common/status.h"
 #include "frontend/server/handler.h"
 #include "frontend/server/request_context.h"
+#include "frontend/server/worker_pool.h"
 #include "grpcpp/server_builder.h"
+#include "grpcpp/support/server_callback.h"
 #include "grpcpp/support/status.h"
 
 namespace google {
@@ -57,6 +65,12 @@ namespace spanner_api = ::google::spanner::v1;
 
 namespace {
 
+// The default number of worker threads when serving through the callback API.
+// Handlers block while they wait for locks or pending commits, so the default
+// allows for several blocked requests per CPU.
+constexpr int kDefaultWorkerThreadsPerCpu = 4;
+constexpr int kMinDefaultWorkerThreads = 32;
+
 void MaybeAddTrailingMetadata(const absl::Status& status, RequestContext* ctx) {
   if (!status.ok()) {
     // Check for ResourceInfo within the returned status and append it as extra
@@ -73,54 +87,250 @@ void MaybeAddTrailingMetadata(const absl::Status& status, RequestContext* ctx) {
 
 }  // namespace
 
-// Invokes the given unary gRPC method on the given service by looking up the
-// handler registry. Returns INTERNAL error if the handler could not be found.
+// The type of the handler registered for a gRPC method with the given request
+// and response types. Methods served through the synchronous API declare server
+// streaming responses as grpc::ServerWriter<ResponseT>.
+template <typename RequestT, typename ResponseT>
+struct HandlerFor {
+  using type = UnaryGRPCHandler<RequestT, ResponseT>;
+};
+
 template <typename RequestT, typename ResponseT>
-absl::Status Invoke(const std::string& service_name,
-                    const std::string& method_name,
-                    grpc::ServerContext* grpc_ctx, ServerEnv* env,
+struct HandlerFor<RequestT, grpc::ServerWriter<ResponseT>> {
+  using type = ServerStreamingGRPCHandler<RequestT, ResponseT>;
+};
+
+// Returns an INTERNAL error for a method without a registered handler.
+absl::Status HandlerNotFound(const char* service_name,
+                             const char* method_name) {
+  return error::Internal(absl::StrCat("Could not find handler for ",
+                                      service_name, ".", method_name));
+}
+
+// Invokes 'handler', the handler of a unary gRPC method. Returns INTERNAL error
+// if no handler was registered for the method.
+template <typename RequestT, typename ResponseT>
+absl::Status Invoke(UnaryGRPCHandler<RequestT, ResponseT>* handler,
+                    const char* service_name, const char* method_name,
+                    grpc::ServerContextBase* grpc_ctx, ServerEnv* env,
                     const RequestT* request, ResponseT* response) {
-  GRPCHandlerBase* handler = GetHandler(service_name, method_name);
-  if (!handler) {
-    return error::Internal(absl::StrCat("Could not find handler for ",
-                                        service_name, ".", method_name));
+  if (handler == nullptr) {
+    return HandlerNotFound(service_name, method_name);
   }
   RequestContext ctx(env, grpc_ctx);
-  absl::Status status =
-      dynamic_cast<UnaryGRPCHandler<RequestT, ResponseT>*>(handler)->Run(
-          &ctx, request, response);
+  absl::Status status = handler->Run(&ctx, request, response);
   MaybeAddTrailingMetadata(status, &ctx);
   return status;
 }
 
-// Invokes the given server streaming gRPC method on the given service by
-// looking up the handler registry. Returns INTERNAL error if the handler could
-// not be found.
+// Invokes 'handler', the handler of a server streaming gRPC method. Returns
+// INTERNAL error if no handler was registered for the method.
 template <typename RequestT, typename ResponseT>
-absl::Status Invoke(const std::string& service_name,
-                    const std::string& method_name,
-                    grpc::ServerContext* grpc_ctx, ServerEnv* env,
+absl::Status Invoke(ServerStreamingGRPCHandler<RequestT, ResponseT>* handler,
+                    const char* service_name, const char* method_name,
+                    grpc::ServerContextBase* grpc_ctx, ServerEnv* env,
                     const RequestT* request,
-                    grpc::ServerWriter<ResponseT>* writer) {
-  GRPCHandlerBase* handler = GetHandler(service_name, method_name);
-  if (!handler) {
-    return error::Internal(absl::StrCat("Could not find handler for ",
-                                        service_name, ".", method_name));
+                    grpc::ServerWriterInterface<ResponseT>* writer) {
+  if (handler == nullptr) {
+    return HandlerNotFound(service_name, method_name);
   }
   RequestContext ctx(env, grpc_ctx);
-  absl::Status status =
-      dynamic_cast<ServerStreamingGRPCHandler<RequestT, ResponseT>*>(handler)
-          ->Run(&ctx, request, writer);
+  absl::Status status = handler->Run(&ctx, request, writer);
   MaybeAddTrailingMetadata(status, &ctx);
   return status;
 }
 
+// Invokes the given unary gRPC method served through the callback API on a
+// thread of 'workers', and finishes the RPC once the handler returns.
+template <typename RequestT, typename ResponseT>
+grpc::ServerUnaryReactor* InvokeOnWorker(
+    UnaryGRPCHandler<RequestT, ResponseT>* handler, const char* service_name,
+    const char* method_name, grpc::CallbackServerContext* grpc_ctx,
+    ServerEnv* env, WorkerPool* workers, const RequestT* request,
+    ResponseT* response) {
+  grpc::ServerUnaryReactor* reactor = grpc_ctx->DefaultReactor();
+  workers->Schedule([=] {
+    reactor->Finish(ToGRPCStatus(Invoke(handler, service_name, method_name,
+                                        grpc_ctx, env, request, response)));
+  });
+  return reactor;
+}
+
+// Runs the handler of a server streaming gRPC method served through the
+// callback API on a thread of a WorkerPool, and finishes the RPC once the
+// handler returns and all its responses have been sent.
+//
+// The handler writes responses through a grpc::ServerWriterInterface, as it
+// does for the synchronous API. Writes do not wait for gRPC to send the
+// response: they are queued on the reactor, which starts the next write from
+// OnWriteDone. A slow client therefore does not hold a worker, at the cost of
+// keeping the responses it has yet to receive in memory.
+template <typename RequestT, typename ResponseT>
+class ServerStreamingReactor final
+    : public grpc::ServerWriteReactor<ResponseT> {
+ public:
+  // Returns a reactor for the RPC, which deletes itself once the RPC is done.
+  static ServerStreamingReactor* Start(
+      ServerStreamingGRPCHandler<RequestT, ResponseT>* handler,
+      const char* service_name, const char* method_name,
+      grpc::CallbackServerContext* grpc_ctx, ServerEnv* env,
+      WorkerPool* workers, const RequestT* request) {
+    auto* reactor = new ServerStreamingReactor();
+    workers->Schedule([=] {
+      absl::Status status = Invoke(handler, service_name, method_name, grpc_ctx,
+                                   env, request, &reactor->writer_);
+      reactor->FinishAfterWrites(ToGRPCStatus(status));
+    });
+    return reactor;
+  }
+
+  void OnWriteDone(bool ok) override {
+    absl::ReleasableMutexLock lock(&mu_);
+    if (!ok) {
+      // The client is gone, so the remaining responses are dropped.
+      write_failed_ = true;
+      queue_.clear();
+    }
+    if (!queue_.empty()) {
+      PopNextWrite();
+      lock.Release();
+      StartCurrentWrite();
+      return;
+    }
+    writing_ = false;
+    if (status_.has_value()) {
+      grpc::Status status = *status_;
+      lock.Release();
+      this->Finish(std::move(status));
+    }
+  }
+
+  void OnDone() override { delete this; }
+
+ private:
+  // Queues the responses written by the handler on the reactor.
+  class Writer final : public grpc::ServerWriterInterface<ResponseT> {
+   public:
+    explicit Writer(ServerStreamingReactor* reactor) : reactor_(reactor) {}
+
+    // Initial metadata is sent along with the first response.
+    void SendInitialMetadata() override {}
+
+    bool Write(const ResponseT& msg, grpc::WriteOptions options) override {
+      return reactor_->QueueWrite(msg, options);
+    }
+
+   private:
+    ServerStreamingReactor* reactor_;
+  };
+
+  // A response along with the options it was written with.
+  struct PendingWrite {
+    ResponseT msg;
+    grpc::WriteOptions options;
+  };
+
+  ServerStreamingReactor() : writer_(this) {}
+
+  // Queues a response, starting to write it right away unless another write is
+  // in flight. Returns false if the stream is broken.
+  bool QueueWrite(const ResponseT& msg, grpc::WriteOptions options)
+      ABSL_LOCKS_EXCLUDED(mu_) {
+    absl::ReleasableMutexLock lock(&mu_);
+    if (write_failed_) {
+      return false;
+    }
+    queue_.push_back(PendingWrite{msg, options});
+    if (!writing_) {
+      writing_ = true;
+      PopNextWrite();
+      lock.Release();
+      StartCurrentWrite();
+    }
+    return true;
+  }
+
+  // Finishes the RPC with 'status' once the queued responses have been sent.
+  void FinishAfterWrites(grpc::Status status) ABSL_LOCKS_EXCLUDED(mu_) {
+    absl::ReleasableMutexLock lock(&mu_);
+    status_ = status;
+    if (!writing_) {
+      lock.Release();
+      this->Finish(std::move(status));
+    }
+  }
+
+  // Makes the oldest queued response the one to write next.
+  void PopNextWrite() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    current_write_ = std::move(queue_.front());
+    queue_.pop_front();
+  }
+
+  // Starts writing current_write_. Writes are started without holding the
+  // mutex, in case gRPC completes them inline.
+  void StartCurrentWrite() ABSL_LOCKS_EXCLUDED(mu_) {
+    this->StartWrite(&current_write_.msg, current_write_.options);
+  }
+
+  Writer writer_;
+
+  absl::Mutex mu_;
+
+  // Responses waiting for the write in flight to complete, oldest first.
+  std::deque<PendingWrite> queue_ ABSL_GUARDED_BY(mu_);
+
+  // True while a write is in flight.
+  bool writing_ ABSL_GUARDED_BY(mu_) = false;
+
+  // Set once a write has failed, after which responses are dropped.
+  bool write_failed_ ABSL_GUARDED_BY(mu_) = false;
+
+  // Status of the RPC, set once the handler has returned.
+  std::optional<grpc::Status> status_ ABSL_GUARDED_BY(mu_);
+
+  // Response being written, which gRPC requires to outlive the write. Only
+  // accessed by whoever started the write in flight.
+  PendingWrite current_write_;
+};
+
+// The methods below resolve their handler the first time they are called and
+// keep it in a function-local static, so serving an RPC needs neither a lookup
+// by name nor a dynamic_cast. Handlers are all registered at static
+// initialization time, before the server starts.
 #define DEFINE_GRPC_METHOD(ServiceName, MethodName, RequestType, ResponseType) \
   grpc::Status MethodName(grpc::ServerContext* grpc_ctx,                       \
                           const RequestType* request, ResponseType* response)  \
       override {                                                               \
-    return ToGRPCStatus(                                                       \
-        Invoke(#ServiceName, #MethodName, grpc_ctx, env_, request, response)); \
+    using HandlerType = HandlerFor<RequestType, ResponseType>::type;           \
+    static HandlerType* const handler =                                        \
+        GetTypedHandler<HandlerType>(#ServiceName, #MethodName);               \
+    return ToGRPCStatus(Invoke(handler, #ServiceName, #MethodName, grpc_ctx,   \
+                               env_, request, response));                      \
+  }
+
+#define DEFINE_CALLBACK_GRPC_METHOD(ServiceName, MethodName, RequestType,      \
+                                    ResponseType)                              \
+  grpc::ServerUnaryReactor* MethodName(grpc::CallbackServerContext* grpc_ctx,  \
+                                       const RequestType* request,             \
+                                       ResponseType* response) override {      \
+    using HandlerType = UnaryGRPCHandler<RequestType, ResponseType>;           \
+    static HandlerType* const handler =                                        \
+        GetTypedHandler<HandlerType>(#ServiceName, #MethodName);               \
+    return InvokeOnWorker(handler, #ServiceName, #MethodName, grpc_ctx, env_,  \
+                          workers_, request, response);                        \
+  }
+
+#define DEFINE_CALLBACK_GRPC_STREAMING_METHOD(ServiceName, MethodName,         \
+                                              RequestType, ResponseType)       \
+  grpc::ServerWriteReactor<ResponseType>* MethodName(                          \
+      grpc::CallbackServerContext* grpc_ctx, const RequestType* request)       \
+      override {                                                               \
+    using HandlerType = ServerStreamingGRPCHandler<RequestType, ResponseType>; \
+    static HandlerType* const handler =                                        \
+        GetTypedHandler<HandlerType>(#ServiceName, #MethodName);               \
+    return ServerStreamingReactor<RequestType, ResponseType>::Start(           \
+        handler, #ServiceName, #MethodName, grpc_ctx, env_, workers_,          \
+        request);                                                              \
   }
 
 // Implementation of the Spanner gRPC service.
@@ -281,17 +491,220 @@ class OperationsService : public operations_api::Operations::Service {
   ServerEnv* const env_;
 };
 
-Server::Server(std::unique_ptr<ServerEnv> env)
-    : env_(std::move(env)),
-      database_admin_service_(new DatabaseAdminService(env_.get())),
-      instance_admin_service_(new InstanceAdminService(env_.get())),
-      operations_service_(new OperationsService(env_.get())),
-      spanner_service_(new SpannerService(env_.get())) {}
+// Implementation of the Spanner gRPC service on the callback API.
+class CallbackSpannerService : public spanner_api::Spanner::CallbackService {
+ public:
+  CallbackSpannerService(ServerEnv* env, WorkerPool* workers)
+      : env_(env), workers_(workers) {}
+
+  // Sessions.
+  DEFINE_CALLBACK_GRPC_METHOD(Spanner, CreateSession,
+                              spanner_api::CreateSessionRequest,
+                              spanner_api::Session)
+  DEFINE_CALLBACK_GRPC_METHOD(Spanner, GetSession,
+                              spanner_api::GetSessionRequest,
+                              spanner_api::Session)
+  DEFINE_CALLBACK_GRPC_METHOD(Spanner, ListSessions,
+                              spanner_api::ListSessionsRequest,
+                              spanner_api::ListSessionsResponse)
+  DEFINE_CALLBACK_GRPC_METHOD(Spanner, DeleteSession,
+                              spanner_api::DeleteSessionRequest,
+                              protobuf_api::Empty)
+  DEFINE_CALLBACK_GRPC_METHOD(Spanner, BatchCreateSessions,
+                              spanner_api::BatchCreateSessionsRequest,
+                              spanner_api::BatchCreateSessionsResponse)
+
+  // Reads.
+  DEFINE_CALLBACK_GRPC_METHOD(Spanner, Read, spanner_api::ReadRequest,
+                              spanner_api::ResultSet);
+  DEFINE_CALLBACK_GRPC_STREAMING_METHOD(Spanner, StreamingRead,
+                                        spanner_api::ReadRequest,
+                                        spanner_api::PartialResultSet);
+
+  // Queries.
+  DEFINE_CALLBACK_GRPC_METHOD(Spanner, ExecuteSql,
+                              spanner_api::ExecuteSqlRequest,
+                              spanner_api::ResultSet);
+  DEFINE_CALLBACK_GRPC_STREAMING_METHOD(Spanner, ExecuteStreamingSql,
+                                        spanner_api::ExecuteSqlRequest,
+                                        spanner_api::PartialResultSet);
+  DEFINE_CALLBACK_GRPC_METHOD(Spanner, ExecuteBatchDml,
+                              spanner_api::ExecuteBatchDmlRequest,
+                              spanner_api::ExecuteBatchDmlResponse);
+
+  // Partitions.
+  DEFINE_CALLBACK_GRPC_METHOD(Spanner, PartitionRead,
+                              spanner_api::PartitionReadRequest,
+                              spanner_api::PartitionResponse);
+  DEFINE_CALLBACK_GRPC_METHOD(Spanner, PartitionQuery,
+                              spanner_api::PartitionQueryRequest,
+                              spanner_api::PartitionResponse);
+
+  // Transactions.
+  DEFINE_CALLBACK_GRPC_METHOD(Spanner, BeginTransaction,
+                              spanner_api::BeginTransactionRequest,
+                              spanner_api::Transaction);
+  DEFINE_CALLBACK_GRPC_METHOD(Spanner, Commit, spanner_api::CommitRequest,
+                              spanner_api::CommitResponse);
+  DEFINE_CALLBACK_GRPC_METHOD(Spanner, Rollback, spanner_api::RollbackRequest,
+                              protobuf_api::Empty);
+
+ private:
+  ServerEnv* const env_;
+  WorkerPool* const workers_;
+};
+
+// Implementation of the DatabaseAdmin gRPC service on the callback API.
+class CallbackDatabaseAdminService
+    : public database_api::DatabaseAdmin::CallbackService {
+ public:
+  CallbackDatabaseAdminService(ServerEnv* env, WorkerPool* workers)
+      : env_(env), workers_(workers) {}
+
+  // Databases.
+  DEFINE_CALLBACK_GRPC_METHOD(DatabaseAdmin, ListDatabases,
+                              database_api::ListDatabasesRequest,
+                              database_api::ListDatabasesResponse);
+  DEFINE_CALLBACK_GRPC_METHOD(DatabaseAdmin, CreateDatabase,
+                              database_api::CreateDatabaseRequest,
+                              operations_api::Operation);
+  DEFINE_CALLBACK_GRPC_METHOD(DatabaseAdmin, GetDatabase,
+                              database_api::GetDatabaseRequest,
+                              database_api::Database);
+  DEFINE_CALLBACK_GRPC_METHOD(DatabaseAdmin, DropDatabase,
+                              database_api::DropDatabaseRequest,
+                              protobuf_api::Empty);
+
+  // Schema.
+  DEFINE_CALLBACK_GRPC_METHOD(DatabaseAdmin, UpdateDatabaseDdl,
+                              database_api::UpdateDatabaseDdlRequest,
+                              operations_api::Operation);
+  DEFINE_CALLBACK_GRPC_METHOD(DatabaseAdmin, GetDatabaseDdl,
+                              database_api::GetDatabaseDdlRequest,
+                              database_api::GetDatabaseDdlResponse);
+
+  // Policies.
+  DEFINE_CALLBACK_GRPC_METHOD(InstanceAdmin, SetIamPolicy,
+                              iam_api::SetIamPolicyRequest, iam_api::Policy);
+  DEFINE_CALLBACK_GRPC_METHOD(InstanceAdmin, GetIamPolicy,
+                              iam_api::GetIamPolicyRequest, iam_api::Policy);
+  DEFINE_CALLBACK_GRPC_METHOD(InstanceAdmin, TestIamPermissions,
+                              iam_api::TestIamPermissionsRequest,
+                              iam_api::TestIamPermissionsResponse);
+
+ private:
+  ServerEnv* const env_;
+  WorkerPool* const workers_;
+};
+
+// Implementation of the InstanceAdmin gRPC service on the callback API.
+class CallbackInstanceAdminService
+    : public instance_api::InstanceAdmin::CallbackService {
+ public:
+  CallbackInstanceAdminService(ServerEnv* env, WorkerPool* workers)
+      : env_(env), workers_(workers) {}
+
+  // Instance configs.
+  DEFINE_CALLBACK_GRPC_METHOD(InstanceAdmin, ListInstanceConfigs,
+                              instance_api::ListInstanceConfigsRequest,
+                              instance_api::ListInstanceConfigsResponse);
+  DEFINE_CALLBACK_GRPC_METHOD(InstanceAdmin, GetInstanceConfig,
+                              instance_api::GetInstanceConfigRequest,
+                              instance_api::InstanceConfig);
+
+  // Instances.
+  DEFINE_CALLBACK_GRPC_METHOD(InstanceAdmin, ListInstances,
+                              instance_api::ListInstancesRequest,
+                              instance_api::ListInstancesResponse);
+  DEFINE_CALLBACK_GRPC_METHOD(InstanceAdmin, GetInstance,
+                              instance_api::GetInstanceRequest,
+                              instance_api::Instance);
+  DEFINE_CALLBACK_GRPC_METHOD(InstanceAdmin, CreateInstance,
+                              instance_api::CreateInstanceRequest,
+                              operations_api::Operation);
+  DEFINE_CALLBACK_GRPC_METHOD(InstanceAdmin, UpdateInstance,
+                              instance_api::UpdateInstanceRequest,
+                              operations_api::Operation);
+  DEFINE_CALLBACK_GRPC_METHOD(InstanceAdmin, DeleteInstance,
+                              instance_api::DeleteInstanceRequest,
+                              protobuf_api::Empty);
+
+  // Policies.
+  DEFINE_CALLBACK_GRPC_METHOD(InstanceAdmin, SetIamPolicy,
+                              iam_api::SetIamPolicyRequest, iam_api::Policy);
+  DEFINE_CALLBACK_GRPC_METHOD(InstanceAdmin, GetIamPolicy,
+                              iam_api::GetIamPolicyRequest, iam_api::Policy);
+  DEFINE_CALLBACK_GRPC_METHOD(InstanceAdmin, TestIamPermissions,
+                              iam_api::TestIamPermissionsRequest,
+                              iam_api::TestIamPermissionsResponse);
+
+ private:
+  ServerEnv* const env_;
+  WorkerPool* const workers_;
+};
+
+// Implementation of the Operations gRPC service on the callback API.
+class CallbackOperationsService
+    : public operations_api::Operations::CallbackService {
+ public:
+  CallbackOperationsService(ServerEnv* env, WorkerPool* workers)
+      : env_(env), workers_(workers) {}
+
+  DEFINE_CALLBACK_GRPC_METHOD(Operations, ListOperations,
+                              operations_api::ListOperationsRequest,
+                              operations_api::ListOperationsResponse);
+  DEFINE_CALLBACK_GRPC_METHOD(Operations, GetOperation,
+                              operations_api::GetOperationRequest,
+                              operations_api::Operation);
+  DEFINE_CALLBACK_GRPC_METHOD(Operations, DeleteOperation,
+                              operations_api::DeleteOperationRequest,
+                              protobuf_api::Empty);
+  DEFINE_CALLBACK_GRPC_METHOD(Operations, CancelOperation,
+                              operations_api::CancelOperationRequest,
+                              protobuf_api::Empty);
+  DEFINE_CALLBACK_GRPC_METHOD(Operations, WaitOperation,
+                              operations_api::WaitOperationRequest,
+                              operations_api::Operation);
+
+ private:
+  ServerEnv* const env_;
+  WorkerPool* const workers_;
+};
+
+Server::Server(std::unique_ptr<ServerEnv> env, const Options& options)
+    : env_(std::move(env)) {
+  if (options.use_callback_api) {
+    int num_worker_threads = options.num_worker_threads;
+    if (num_worker_threads <= 0) {
+      num_worker_threads =
+          std::max<int>(kMinDefaultWorkerThreads,
+                        kDefaultWorkerThreadsPerCpu *
+                            std::thread::hardware_concurrency());
+    }
+    worker_pool_ = std::make_unique<WorkerPool>(num_worker_threads);
+    database_admin_service_ = std::make_unique<CallbackDatabaseAdminService>(
+        env_.get(), worker_pool_.get());
+    instance_admin_service_ = std::make_unique<CallbackInstanceAdminService>(
+        env_.get(), worker_pool_.get());
+    operations_service_ = std::make_unique<CallbackOperationsService>(
+        env_.get(), worker_pool_.get());
+    spanner_service_ = std::make_unique<CallbackSpannerService>(
+        env_.get(), worker_pool_.get());
+  } else {
+    database_admin_service_ =
+        std::make_unique<DatabaseAdminService>(env_.get());
+    instance_admin_service_ =
+        std::make_unique<InstanceAdminService>(env_.get());
+    operations_service_ = std::make_unique<OperationsService>(env_.get());
+    spanner_service_ = std::make_unique<SpannerService>(env_.get());
+  }
+}
 
 // Server lifecycle methods.
 std::unique_ptr<Server> Server::Create(const Server::Options& options) {
   auto env = std::make_unique<ServerEnv>();
-  std::unique_ptr<Server> server = absl::WrapUnique(new Server(std::move(env)));
+  std::unique_ptr<Server> server =
+      absl::WrapUnique(new Server(std::move(env), options));
   ::grpc::ServerBuilder builder;
 
   // Configure server address.
@@ -305,6 +718,10 @@ std::unique_ptr<Server> Server::Create(const Server::Options& options) {
                              limits::kMaxGRPCOutgoingMessageSize);
   builder.AddChannelArgument(GRPC_ARG_MAX_RECEIVE_MESSAGE_LENGTH,
                              limits::kMaxGRPCIncomingMessageSize);
+  if (options.max_concurrent_streams > 0) {
+    builder.AddChannelArgument(GRPC_ARG_MAX_CONCURRENT_STREAMS,
+                               options.max_concurrent_streams);
+  }
 
   // Configure services exported on this server.
   builder.RegisterService(server->spanner_service_.get())
@@ -21,6 +21,7 @@
 #include <string>
 
 #include "frontend/server/environment.h"
+#include "frontend/server/worker_pool.h"
 #include "grpcpp/impl/service_type.h"
 #include "grpcpp/server.h"
 #include "grpcpp/support/status.h"
@@ -54,6 +55,21 @@ class Server {
  public:
   struct Options {
     std::string server_address;
+
+    // If true, requests are served through the gRPC callback API and their
+    // handlers run on a pool of 'num_worker_threads' threads, which only grows
+    // while all of them are blocked (see WorkerPool). Streaming responses are
+    // sent without holding a thread. Otherwise, each in-flight request runs on
+    // a thread of the synchronous gRPC server.
+    bool use_callback_api = false;
+
+    // The number of threads of the pool, or zero for a default based on the
+    // number of CPUs.
+    int num_worker_threads = 0;
+
+    // The maximum number of concurrent RPCs per client connection, or zero for
+    // no limit.
+    int max_concurrent_streams = 0;
   };
 
   // Returns an initialized Server, or nullptr if the initialization failed.
@@ -73,7 +89,7 @@ class Server {
 
  private:
   // Constructor is only used by the factory function
-  explicit Server(std::unique_ptr<ServerEnv> env);
+  Server(std::unique_ptr<ServerEnv> env, const Options& options);
 
   // Address of the gRPC server.
   std::string host_;
@@ -82,6 +98,11 @@ class Server {
   // Environment shared by all handlers.
   std::unique_ptr<ServerEnv> env_;
 
+  // Runs request handlers when serving through the callback API, null
+  // otherwise. Declared before the services and the gRPC server, so that it is
+  // destroyed after the gRPC server has finished all requests.
+  std::unique_ptr<WorkerPool> worker_pool_;
+
   // Services implemented by this gRPC server.
   std::unique_ptr<grpc::Service> database_admin_service_;
   std::unique_ptr<grpc::Service> instance_admin_service_;
@@ -0,0 +1,152 @@
+//
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "frontend/server/worker_pool.h"
+
+#include <cstdint>
+#include <functional>
+#include <thread>  // NOLINT(build/c++11)
+#include <utility>
+#include <vector>
+
+#include "zetasql/base/logging.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+
+namespace google {
+namespace spanner {
+namespace emulator {
+namespace frontend {
+
+WorkerPool::WorkerPool(int num_threads, absl::Duration starvation_delay)
+    : num_threads_(num_threads), starvation_delay_(starvation_delay) {
+  ZETASQL_CHECK_GT(num_threads, 0);
+  {
+    absl::MutexLock lock(&mu_);
+    for (int i = 0; i < num_threads; ++i) {
+      StartThread();
+    }
+  }
+  monitor_ = std::thread(&WorkerPool::Monitor, this);
+}
+
+WorkerPool::~WorkerPool() {
+  {
+    absl::MutexLock lock(&mu_);
+    stopping_ = true;
+  }
+  monitor_.join();
+
+  // No thread is started once the monitor has returned.
+  absl::flat_hash_map<std::thread::id, std::thread> threads;
+  {
+    absl::MutexLock lock(&mu_);
+    threads.swap(threads_);
+  }
+  for (auto& [id, thread] : threads) {
+    thread.join();
+  }
+}
+
+void WorkerPool::Schedule(std::function<void()> fn) {
+  absl::MutexLock lock(&mu_);
+  queue_.push_back(std::move(fn));
+}
+
+void WorkerPool::StartThread() {
+  ++num_running_;
+  std::thread thread(&WorkerPool::Work, this);
+  const std::thread::id id = thread.get_id();
+  threads_.emplace(id, std::move(thread));
+}
+
+bool WorkerPool::HasWorkOrStopping() const {
+  return !queue_.empty() || stopping_;
+}
+
+bool WorkerPool::IsBusy() const { return !queue_.empty() && num_idle_ == 0; }
+
+bool WorkerPool::NeedsMonitor() const {
+  return IsBusy() || !exited_threads_.empty() || stopping_;
+}
+
+void WorkerPool::Work() {
+  absl::MutexLock lock(&mu_);
+  while (true) {
+    if (queue_.empty()) {
+      // Threads beyond num_threads_ exit once there is nothing left to run.
+      if (stopping_ || num_running_ > num_threads_) {
+        break;
+      }
+      ++num_idle_;
+      mu_.Await(absl::Condition(this, &WorkerPool::HasWorkOrStopping));
+      --num_idle_;
+      continue;
+    }
+    std::function<void()> fn = std::move(queue_.front());
+    queue_.pop_front();
+    ++num_dequeued_;
+    mu_.Unlock();
+    fn();
+    fn = nullptr;
+    mu_.Lock();
+  }
+  --num_running_;
+  exited_threads_.push_back(std::this_thread::get_id());
+}
+
+void WorkerPool::JoinExitedThreads() {
+  std::vector<std::thread> exited_threads;
+  for (const std::thread::id& id : exited_threads_) {
+    auto itr = threads_.find(id);
+    exited_threads.push_back(std::move(itr->second));
+    threads_.erase(itr);
+  }
+  exited_threads_.clear();
+  if (exited_threads.empty()) {
+    return;
+  }
+  mu_.Unlock();
+  for (std::thread& thread : exited_threads) {
+    thread.join();
+  }
+  mu_.Lock();
+}
+
+void WorkerPool::Monitor() {
+  absl::MutexLock lock(&mu_);
+  while (!stopping_) {
+    mu_.Await(absl::Condition(this, &WorkerPool::NeedsMonitor));
+    JoinExitedThreads();
+    if (stopping_ || !IsBusy()) {
+      continue;
+    }
+
+    // The pool is starved if no queued closure gets picked up within
+    // starvation_delay_.
+    const int64_t num_dequeued = num_dequeued_;
+    mu_.AwaitWithTimeout(absl::Condition(&stopping_), starvation_delay_);
+    if (!stopping_ && IsBusy() && num_dequeued_ == num_dequeued) {
+      StartThread();
+    }
+  }
+}
+
+}  // namespace frontend
+}  // namespace emulator
+}  // namespace spanner
+}  // namespace google
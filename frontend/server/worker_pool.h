@@ -0,0 +1,125 @@
+//
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef THIRD_PARTY_CLOUD_SPANNER_EMULATOR_FRONTEND_SERVER_WORKER_POOL_H_
+#define THIRD_PARTY_CLOUD_SPANNER_EMULATOR_FRONTEND_SERVER_WORKER_POOL_H_
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+
+namespace google {
+namespace spanner {
+namespace emulator {
+namespace frontend {
+
+// WorkerPool runs closures on a pool of threads, in the order they are
+// scheduled.
+//
+// The server runs the handlers of RPCs served through the gRPC callback API on
+// a WorkerPool, so the number of threads does not grow with the number of
+// in-flight RPCs. A closure which blocks (e.g. a read waiting for a lock) holds
+// its thread until it returns, and may be waiting for a closure which is still
+// queued (e.g. the commit releasing that lock). So that such closures cannot
+// stall each other, the pool starts an extra thread whenever closures have
+// been queued for starvation_delay without any thread picking one up. Threads
+// beyond num_threads exit once the queue is empty.
+class WorkerPool {
+ public:
+  // Default for the time closures wait for a thread before the pool grows.
+  static constexpr absl::Duration kDefaultStarvationDelay =
+      absl::Milliseconds(100);
+
+  // Starts 'num_threads' threads, which must be positive.
+  explicit WorkerPool(
+      int num_threads,
+      absl::Duration starvation_delay = kDefaultStarvationDelay);
+
+  // Runs all closures scheduled so far, then stops the threads.
+  ~WorkerPool();
+
+  WorkerPool(const WorkerPool&) = delete;
+  WorkerPool& operator=(const WorkerPool&) = delete;
+
+  // Schedules 'fn' to run on one of the threads of the pool.
+  void Schedule(std::function<void()> fn) ABSL_LOCKS_EXCLUDED(mu_);
+
+  // Returns the number of threads the pool keeps when it is not starved.
+  int num_threads() const { return num_threads_; }
+
+ private:
+  // Runs scheduled closures until the pool is stopped, or until the queue is
+  // empty if the pool has more than num_threads_ threads.
+  void Work() ABSL_LOCKS_EXCLUDED(mu_);
+
+  // Starts a thread whenever the pool is starved, and joins the threads which
+  // have exited, until the pool is stopped.
+  void Monitor() ABSL_LOCKS_EXCLUDED(mu_);
+
+  // Starts a thread running Work().
+  void StartThread() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Joins the threads which have returned from Work(), releasing the mutex
+  // while doing so.
+  void JoinExitedThreads() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  bool HasWorkOrStopping() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  // Returns true if closures are queued and no thread is waiting for one.
+  bool IsBusy() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  bool NeedsMonitor() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  const int num_threads_;
+  const absl::Duration starvation_delay_;
+
+  absl::Mutex mu_;
+
+  // Closures waiting for a thread, oldest first.
+  std::deque<std::function<void()>> queue_ ABSL_GUARDED_BY(mu_);
+
+  // Number of closures taken off the queue so far.
+  int64_t num_dequeued_ ABSL_GUARDED_BY(mu_) = 0;
+
+  // Number of threads running Work(), and how many of them wait for closures.
+  int num_running_ ABSL_GUARDED_BY(mu_) = 0;
+  int num_idle_ ABSL_GUARDED_BY(mu_) = 0;
+
+  // Set once the pool is being destroyed.
+  bool stopping_ ABSL_GUARDED_BY(mu_) = false;
+
+  // Threads running Work(), and those which have returned from it but have
+  // not been joined yet.
+  absl::flat_hash_map<std::thread::id, std::thread> threads_
+      ABSL_GUARDED_BY(mu_);
+  std::vector<std::thread::id> exited_threads_ ABSL_GUARDED_BY(mu_);
+
+  std::thread monitor_;
+};
+
+}  // namespace frontend
+}  // namespace emulator
+}  // namespace spanner
+}  // namespace google
+
+#endif  // THIRD_PARTY_CLOUD_SPANNER_EMULATOR_FRONTEND_SERVER_WORKER_POOL_H_
@@ -0,0 +1,82 @@
+//
+// Copyright 2020 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "frontend/server/worker_pool.h"
+
+#include <atomic>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/synchronization/notification.h"
+#include "absl/time/time.h"
+
+namespace google {
+namespace spanner {
+namespace emulator {
+namespace frontend {
+
+namespace {
+
+TEST(WorkerPoolTest, RunsScheduledClosuresBeforeDestruction) {
+  std::atomic<int> num_runs = 0;
+  {
+    WorkerPool pool(/*num_threads=*/2);
+    EXPECT_EQ(pool.num_threads(), 2);
+    for (int i = 0; i < 100; ++i) {
+      pool.Schedule([&num_runs] { ++num_runs; });
+    }
+  }
+  EXPECT_EQ(num_runs, 100);
+}
+
+TEST(WorkerPoolTest, RunsClosuresConcurrently) {
+  WorkerPool pool(/*num_threads=*/2);
+
+  // The first closure only returns once the second one runs, which requires a
+  // second thread.
+  absl::Notification second_ran;
+  absl::Notification first_done;
+  pool.Schedule([&] {
+    second_ran.WaitForNotification();
+    first_done.Notify();
+  });
+  pool.Schedule([&] { second_ran.Notify(); });
+  first_done.WaitForNotification();
+}
+
+TEST(WorkerPoolTest, StartsThreadWhenStarved) {
+  WorkerPool pool(/*num_threads=*/1,
+                  /*starvation_delay=*/absl::Milliseconds(10));
+
+  // The first closure holds the only thread until the second one runs, which
+  // requires the pool to start another thread.
+  absl::Notification second_ran;
+  absl::Notification first_done;
+  pool.Schedule([&] {
+    second_ran.WaitForNotification();
+    first_done.Notify();
+  });
+  pool.Schedule([&] { second_ran.Notify(); });
+  first_done.WaitForNotification();
+  EXPECT_EQ(pool.num_threads(), 1);
+}
+
+}  // namespace
+
+}  // namespace frontend
+}  // namespace emulator
+}  // namespace spanner
+}  // namespace google
@@ -39,13 +39,16 @@ import (
 
 // Options encapsulates options for the emulator gateway.
 type Options struct {
-	GatewayAddress       string
-	FrontendBinary       string
-	FrontendAddress      string
-	CopyEmulatorStdout   bool
-	CopyEmulatorStderr   bool
-	LogRequests          bool
-	EnableFaultInjection bool
+	GatewayAddress           string
+	FrontendBinary           string
+	FrontendAddress          string
+	CopyEmulatorStdout       bool
+	CopyEmulatorStderr       bool
+	LogRequests              bool
+	EnableFaultInjection     bool
+	UseGRPCCallbackAPI       bool
+	GRPCWorkerThreads        int
+	GRPCMaxConcurrentStreams int
 }
 
 // Gateway implements the emulator gateway server.
@@ -71,6 +74,17 @@ func (gw *Gateway) Run() {
 	if gw.opts.EnableFaultInjection {
 		emulatorArgs = append(emulatorArgs, "--enable_fault_injection")
 	}
+	if gw.opts.UseGRPCCallbackAPI {
+		emulatorArgs = append(emulatorArgs, "--use_grpc_callback_api")
+	}
+	if gw.opts.GRPCWorkerThreads > 0 {
+		emulatorArgs = append(emulatorArgs,
+			fmt.Sprintf("--grpc_worker_threads=%d", gw.opts.GRPCWorkerThreads))
+	}
+	if gw.opts.GRPCMaxConcurrentStreams > 0 {
+		emulatorArgs = append(emulatorArgs,
+			fmt.Sprintf("--grpc_max_concurrent_streams=%d", gw.opts.GRPCMaxConcurrentStreams))
+	}
 
 	cmd := exec.Command(gw.opts.FrontendBinary, emulatorArgs...)
 
@@ -55,9 +55,10 @@ absl::Status ReadFromClientReader(
 
 }  // namespace
 
-TestEnv::TestEnv() {
+TestEnv::TestEnv(const frontend::Server::Options& options) {
   // Set up gRPC server in a detached thread.
-  server_thread_ = std::make_unique<std::thread>(&TestEnv::SetupServer, this);
+  server_thread_ =
+      std::make_unique<std::thread>(&TestEnv::SetupServer, this, options);
   WaitForServerReady();
   SetupClientStubs();
 }
@@ -67,8 +68,7 @@ TestEnv::~TestEnv() {
   server_thread_->join();
 }
 
-void TestEnv::SetupServer() {
-  frontend::Server::Options options;
+void TestEnv::SetupServer(frontend::Server::Options options) {
   options.server_address = "localhost:0";
   server_ = frontend::Server::Create(options);
   ZETASQL_CHECK(server_ != nullptr);  // Crash ok
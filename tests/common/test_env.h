@@ -59,7 +59,11 @@ class TestEnv {
   using SpannerStub = v1::Spanner::Stub;
 
  public:
-  TestEnv();
+  TestEnv() : TestEnv(frontend::Server::Options()) {}
+
+  // Serves with the given options, except that the server always listens on an
+  // unused localhost port.
+  explicit TestEnv(const frontend::Server::Options& options);
   ~TestEnv();
 
   DatabaseAdminStub* database_admin_client() const {
@@ -72,7 +76,7 @@ class TestEnv {
   SpannerStub* spanner_client() const { return spanner_client_.get(); }
 
  private:
-  void SetupServer();
+  void SetupServer(frontend::Server::Options options);
   void SetupClientStubs();
   void WaitForServerReady();
 
@@ -90,9 +94,14 @@ class TestEnv {
 // can inherit from this class to run integration tests.
 class ServerTest : public testing::Test {
  public:
+  ServerTest() = default;
+
   TestEnv* test_env() { return &test_env_; }
 
  protected:
+  explicit ServerTest(const frontend::Server::Options& options)
+      : test_env_(options) {}
+
   const std::string test_project_name_ = "test-project";
   const std::string test_project_uri_ = MakeProjectUri(test_project_name_);
   const std::string test_instance_name_ = "test-instance";
@@ -209,6 +218,13 @@ class ServerTest : public testing::Test {
     return test_env()->spanner_client()->PartitionRead(&ctx, request, response);
   }
 
+  absl::Status PartitionQuery(const spanner_api::PartitionQueryRequest& request,
+                              spanner_api::PartitionResponse* response) {
+    grpc::ClientContext ctx;
+    return test_env()->spanner_client()->PartitionQuery(&ctx, request,
+                                                        response);
+  }
+
   absl::Status ExecuteSql(const spanner_api::ExecuteSqlRequest& request,
                           spanner_api::ResultSet* response) {
     grpc::ClientContext ctx;
@@ -166,7 +166,7 @@ TEST_F(BatchDmlTest, MixDmlAndBatchDmlInTransactionSucceeds) {
               IsOkAndHoldsRows({{1, "Levin", 27}, {2, "Mark", 27}}));
 }
 
-TEST_F(BatchDmlTest, ConcurrentTransactionWithBatchDmlNotAllowed) {
+TEST_F(BatchDmlTest, ConcurrentTransactionsWithBatchDmlOnDisjointRows) {
   auto txn1 = Transaction(Transaction::ReadWriteOptions());
   auto txn2 = Transaction(Transaction::ReadWriteOptions());
 
@@ -177,32 +177,15 @@ TEST_F(BatchDmlTest, ConcurrentTransactionWithBatchDmlNotAllowed) {
   ZETASQL_ASSERT_OK(result);
   ZETASQL_ASSERT_OK(ToUtilStatus(result.value().status));
 
-  // Subsequent transactions will abort.
+  // Transactions which touch disjoint rows do not conflict.
   result = BatchDmlTransaction(
       txn2,
       {SqlStatement("INSERT Users(ID, Name, Age) VALUES (2, 'Mark', 37)")});
-  // The Status can come from the call Status or the `BatchDmlResult`
-  auto status = !result.ok() ? result.status() : ToUtilStatus(result->status);
-  EXPECT_THAT(status, StatusIs(in_prod_env() ? absl::StatusCode::kOk
-                                             : absl::StatusCode::kAborted));
-  // Commit first transaction succeeds.
-  ZETASQL_EXPECT_OK(CommitTransaction(txn1, {}));
-
-  if (status.code() == absl::StatusCode::kAborted) {
-    // A real application should use the Transaction runner which restarts the
-    // transaction after ABORTED; we have to do it ourselves.
-    txn2 = MakeReadWriteTransaction(txn2);
-
-    // Subsequent txn2 can now make progress.
-    result = BatchDmlTransaction(
-        txn2,
-        {SqlStatement("INSERT Users(ID, Name, Age) VALUES (2, 'Mark', 37)")});
-    // The Status can come from the call Status or the `BatchDmlResult`
-    auto status = !result.ok() ? result.status() : ToUtilStatus(result->status);
-    EXPECT_THAT(status, StatusIs(absl::StatusCode::kOk));
-  }
+  ZETASQL_ASSERT_OK(result);
+  ZETASQL_ASSERT_OK(ToUtilStatus(result.value().status));
 
-  // Commit second transaction succeeds.
+  // Both transactions commit.
+  ZETASQL_EXPECT_OK(CommitTransaction(txn1, {}));
   ZETASQL_EXPECT_OK(CommitTransaction(txn2, {}));
 }
 